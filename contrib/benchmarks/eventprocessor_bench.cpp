@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Updates the event processors of many units, each with a few pending events, with the
+ * pairing heap EventProcessor of the framework and with the former std::multimap one.
+ * The events stand for the ones of the units: periodic relocation notifications, delayed
+ * spells followed by other casts, and long despawn/invite timers.
+ * Reports the update time and the allocations of each processor.
+ */
+
+#include "Utilities/EventProcessor.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <vector>
+
+static std::atomic<uint64> s_allocations(0);
+
+void* operator new(std::size_t size)
+{
+    ++s_allocations;
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    free(p);
+}
+
+// The EventProcessor before the pairing heap, for comparison
+class MultimapEvent
+{
+    public:
+        virtual ~MultimapEvent() {}
+        virtual bool Execute(uint64 /*e_time*/, uint32 /*p_time*/) { return true; }
+};
+
+class MultimapEventProcessor
+{
+    public:
+        MultimapEventProcessor() : m_time(0) {}
+        ~MultimapEventProcessor()
+        {
+            for (std::multimap<uint64, MultimapEvent*>::iterator itr = m_events.begin(); itr != m_events.end(); ++itr)
+                delete itr->second;
+        }
+
+        void Update(uint32 p_time)
+        {
+            m_time += p_time;
+
+            std::multimap<uint64, MultimapEvent*>::iterator i;
+            while (((i = m_events.begin()) != m_events.end()) && i->first <= m_time)
+            {
+                MultimapEvent* event = i->second;
+                m_events.erase(i);
+                if (event->Execute(m_time, p_time))
+                    delete event;
+            }
+        }
+
+        void AddEvent(MultimapEvent* event, uint64 e_time, bool /*set_addtime*/ = true)
+        {
+            m_events.insert(std::pair<uint64, MultimapEvent*>(e_time, event));
+        }
+
+        uint64 CalculateTime(uint64 t_offset) const { return m_time + t_offset; }
+
+    private:
+        uint64 m_time;
+        std::multimap<uint64, MultimapEvent*> m_events;
+};
+
+enum EventKind
+{
+    EVENT_RELOCATION,                                       // re-added every few hundred ms
+    EVENT_SPELL,                                            // replaced by another cast once executed
+    EVENT_LONG                                              // minutes, replaced once executed
+};
+
+static uint32 NextRandom(uint32& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static uint32 EventDelay(EventKind kind, uint32& random)
+{
+    switch (kind)
+    {
+        case EVENT_RELOCATION: return 200 + NextRandom(random) % 800;
+        case EVENT_SPELL:      return 500 + NextRandom(random) % 2500;
+        default:               return 60000 + NextRandom(random) % 540000;
+    }
+}
+
+template <class Base, class Processor>
+class BenchEvent : public Base
+{
+    public:
+        BenchEvent(Processor& processor, EventKind kind, uint32 random, uint64& executed) :
+            m_processor(processor), m_kind(kind), m_random(random), m_executed(executed) {}
+
+        bool Execute(uint64 /*e_time*/, uint32 /*p_time*/) override
+        {
+            ++m_executed;
+            uint32 delay = EventDelay(m_kind, m_random);
+            if (m_kind == EVENT_RELOCATION)
+            {
+                m_processor.AddEvent(this, m_processor.CalculateTime(delay), false);
+                return false;
+            }
+
+            m_processor.AddEvent(new BenchEvent(m_processor, m_kind, m_random, m_executed), m_processor.CalculateTime(delay));
+            return true;
+        }
+
+    private:
+        Processor& m_processor;
+        EventKind m_kind;
+        uint32 m_random;
+        uint64& m_executed;
+};
+
+struct Options
+{
+    Options() : units(100000), events(3), ticks(600), diff(100), rounds(3) {}
+
+    int units;
+    int events;                                             // pending per unit
+    int ticks;
+    uint32 diff;                                            // ms, the units are updated with a jitter around it
+    int rounds;
+};
+
+struct Result
+{
+    double setup;
+    double update;
+    uint64 allocations;                                     // during the updates
+    uint64 executed;
+};
+
+template <class Base, class Processor>
+static Result Run(Options const& options)
+{
+    typedef BenchEvent<Base, Processor> Event;
+    Result result;
+    result.executed = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<Processor> > units;
+    units.reserve(options.units);
+    for (int i = 0; i < options.units; ++i)
+    {
+        units.emplace_back(new Processor());
+        Processor& processor = *units.back();
+        uint32 random = 2463534242u + i;
+        for (int e = 0; e < options.events; ++e)
+        {
+            EventKind kind = EventKind(e % 3);
+            processor.AddEvent(new Event(processor, kind, NextRandom(random), result.executed), processor.CalculateTime(EventDelay(kind, random)));
+        }
+    }
+    std::chrono::steady_clock::time_point updateStart = std::chrono::steady_clock::now();
+    result.setup = std::chrono::duration<double>(updateStart - start).count();
+
+    uint64 allocations = s_allocations;
+    uint32 jitter = 1;
+    for (int tick = 0; tick < options.ticks; ++tick)
+        for (std::size_t i = 0; i < units.size(); ++i)
+            units[i]->Update(options.diff - options.diff / 4 + NextRandom(jitter) % (options.diff / 2 + 1));
+
+    result.update = std::chrono::duration<double>(std::chrono::steady_clock::now() - updateStart).count();
+    result.allocations = s_allocations - allocations;
+    return result;
+}
+
+static void Usage(char const* name)
+{
+    printf("Usage: %s [-u units] [-e events per unit] [-t ticks] [-d tick diff ms] [-r rounds]\n", name);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "u:e:t:d:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'u': options.units = atoi(optarg); break;
+            case 'e': options.events = atoi(optarg); break;
+            case 't': options.ticks = atoi(optarg); break;
+            case 'd': options.diff = strtoul(optarg, nullptr, 10); break;
+            case 'r': options.rounds = atoi(optarg); break;
+            default: Usage(argv[0]);
+        }
+    }
+    if (options.units <= 0 || options.events < 0 || options.ticks <= 0 || options.diff == 0 || options.rounds <= 0)
+        Usage(argv[0]);
+
+    printf("%d units, %d pending events each, %d ticks of %u ms (EventProcessor is %zu bytes)\n",
+        options.units, options.events, options.ticks, options.diff, sizeof(EventProcessor));
+    for (int round = 0; round < options.rounds; ++round)
+    {
+        Result multimap = Run<MultimapEvent, MultimapEventProcessor>(options);
+        Result heap = Run<BasicEvent, EventProcessor>(options);
+        if (multimap.executed != heap.executed)
+        {
+            fprintf(stderr, "Executed events differ: %llu multimap, %llu heap\n",
+                (unsigned long long)multimap.executed, (unsigned long long)heap.executed);
+            return 1;
+        }
+
+        printf("round %d multimap: setup %.3f s, update %.3f s (%.1f ns/unit update), %llu allocations, %llu events executed\n",
+            round + 1, multimap.setup, multimap.update, multimap.update * 1e9 / (double(options.units) * options.ticks),
+            (unsigned long long)multimap.allocations, (unsigned long long)multimap.executed);
+        printf("round %d heap    : setup %.3f s, update %.3f s (%.1f ns/unit update), %llu allocations, %llu events executed\n",
+            round + 1, heap.setup, heap.update, heap.update * 1e9 / (double(options.units) * options.ticks),
+            (unsigned long long)heap.allocations, (unsigned long long)heap.executed);
+    }
+
+    return 0;
+}
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Looks up the spell tables of SpellMgr as the fights do: on each hit, the proc event, the
+ * spell bonus and the threat entry of the auras of the units, walking their rank chain; on
+ * each aura applied, the spell groups of the auras already there for the stacking rules.
+ * Runs the lookups on the maps SpellMgr loads, and on the SpellIdIndex and SpellIdRangeIndex
+ * of the server compiled from them.
+ * Reports the time of each, and checks that they find the same data.
+ */
+
+#include "Spells/SpellIdIndex.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The entries, with the sizes of the SpellMgr ones
+struct ProcEvent { uint32 schoolMask; uint32 spellFamilyMask[3]; uint32 procFlags; uint32 procEx; float ppmRate; float customChance; uint32 cooldown; };
+struct Bonus { float direct; float dot; float ap; float apDot; };
+struct Threat { int32_t threat; float multiplier; float ap; };
+struct ChainNode { uint32 prev; uint32 first; uint32 req; uint8_t rank; };
+
+struct Tables
+{
+    std::unordered_map<uint32, ProcEvent> procEvents;
+    std::unordered_map<uint32, Bonus> bonuses;
+    std::map<uint32, Threat> threats;
+    std::unordered_map<uint32, ChainNode> chains;
+    std::multimap<uint32, uint32> groups;                   // spell group of the first rank
+};
+
+struct Options
+{
+    Options() : spells(30000), units(2000), auras(20), hits(2000000), rounds(3) {}
+
+    int spells;                                             // highest spell id
+    int units;
+    int auras;                                              // per unit
+    int hits;
+    int rounds;
+};
+
+static uint32 NextRandom(uint32& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static void Load(Options const& options, Tables& tables)
+{
+    uint32 random = 88675123u;
+    for (uint32 id = 1; id < uint32(options.spells); ++id)
+    {
+        uint32 roll = NextRandom(random) % 100;
+        if (roll < 6)
+            tables.procEvents[id] = ProcEvent { id, { id, 0, 0 }, roll, 0, 0.0f, 0.0f, 0 };
+        if (roll >= 4 && roll < 9)
+            tables.bonuses[id] = Bonus { roll * 0.01f, 0.0f, 0.0f, 0.0f };
+        if (roll >= 8 && roll < 10)
+            tables.threats[id] = Threat { int32_t(roll), 1.0f, 0.0f };
+    }
+    // Rank chains of up to 10 ranks, over a third of the spells
+    for (uint32 id = 1; id + 10 < uint32(options.spells);)
+    {
+        uint32 ranks = 2 + NextRandom(random) % 9;
+        if (NextRandom(random) % 3 == 0)
+        {
+            for (uint32 rank = 0; rank < ranks; ++rank)
+                tables.chains[id + rank] = ChainNode { rank ? id + rank - 1 : 0, id, 0, uint8_t(rank + 1) };
+            if (NextRandom(random) % 4 == 0)
+                tables.groups.insert(std::make_pair(id, 1 + NextRandom(random) % 60));
+        }
+        id += ranks;
+    }
+}
+
+// Lookups as SpellMgr does them, on its maps or on its indexes
+struct MapLookup
+{
+    explicit MapLookup(Tables const& tables) : tables(tables) {}
+
+    ProcEvent const* GetProcEvent(uint32 id) const
+    {
+        std::unordered_map<uint32, ProcEvent>::const_iterator itr = tables.procEvents.find(id);
+        return itr != tables.procEvents.end() ? &itr->second : nullptr;
+    }
+    Bonus const* GetBonus(uint32 id) const
+    {
+        std::unordered_map<uint32, Bonus>::const_iterator itr = tables.bonuses.find(id);
+        return itr != tables.bonuses.end() ? &itr->second : nullptr;
+    }
+    Threat const* GetThreat(uint32 id) const
+    {
+        std::map<uint32, Threat>::const_iterator itr = tables.threats.find(id);
+        return itr != tables.threats.end() ? &itr->second : nullptr;
+    }
+    ChainNode const* GetChainNode(uint32 id) const
+    {
+        std::unordered_map<uint32, ChainNode>::const_iterator itr = tables.chains.find(id);
+        return itr != tables.chains.end() ? &itr->second : nullptr;
+    }
+    uint32 SumGroups(uint32 first) const
+    {
+        uint32 sum = 0;
+        std::pair<std::multimap<uint32, uint32>::const_iterator, std::multimap<uint32, uint32>::const_iterator> bounds = tables.groups.equal_range(first);
+        for (std::multimap<uint32, uint32>::const_iterator itr = bounds.first; itr != bounds.second; ++itr)
+            sum += itr->second;
+        return sum;
+    }
+
+    Tables const& tables;
+};
+
+struct IndexLookup
+{
+    explicit IndexLookup(Tables const& tables)
+    {
+        procEvents.Build(tables.procEvents);
+        bonuses.Build(tables.bonuses);
+        threats.Build(tables.threats);
+        chains.Build(tables.chains);
+        groups.Build(tables.groups);
+    }
+
+    ProcEvent const* GetProcEvent(uint32 id) const { return procEvents.Find(id); }
+    Bonus const* GetBonus(uint32 id) const { return bonuses.Find(id); }
+    Threat const* GetThreat(uint32 id) const { return threats.Find(id); }
+    ChainNode const* GetChainNode(uint32 id) const { return chains.Find(id); }
+    uint32 SumGroups(uint32 first) const
+    {
+        uint32 sum = 0;
+        SpellIdRangeIndex<uint32>::Bounds bounds = groups.Find(first);
+        for (uint32 const* itr = bounds.first; itr != bounds.second; ++itr)
+            sum += *itr;
+        return sum;
+    }
+
+    SpellIdIndex<ProcEvent> procEvents;
+    SpellIdIndex<Bonus> bonuses;
+    SpellIdIndex<Threat> threats;
+    SpellIdIndex<ChainNode> chains;
+    SpellIdRangeIndex<uint32> groups;
+};
+
+struct Result
+{
+    double elapsed;
+    uint64_t checksum;                                      // of the data found
+};
+
+template <class Lookup>
+static Result Fight(Options const& options, Tables const& tables, std::vector<uint32> const& auras)
+{
+    Lookup lookup(tables);
+    uint32 random = 2463534242u;
+    Result result;
+    result.checksum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int hit = 0; hit < options.hits; ++hit)
+    {
+        uint32 const* unitAuras = &auras[(NextRandom(random) % options.units) * options.auras];
+        // Unit::ProcDamageAndSpell: the proc event of each aura of the victim
+        for (int a = 0; a < options.auras; ++a)
+        {
+            uint32 id = unitAuras[a];
+            ProcEvent const* procEvent = lookup.GetProcEvent(id);
+            if (!procEvent)
+            {
+                // Ranks of a chain share the proc event of the first one in the custom ranks
+                if (ChainNode const* node = lookup.GetChainNode(id))
+                    procEvent = lookup.GetProcEvent(node->first);
+            }
+            if (procEvent)
+                result.checksum += procEvent->procFlags;
+        }
+
+        // The spell of the hit: bonus, threat, and the stacking of its aura
+        uint32 spell = unitAuras[NextRandom(random) % options.auras];
+        if (Bonus const* bonus = lookup.GetBonus(spell))
+            result.checksum += uint64_t(bonus->direct * 100);
+        if (Threat const* threat = lookup.GetThreat(spell))
+            result.checksum += threat->threat;
+        ChainNode const* node = lookup.GetChainNode(spell);
+        result.checksum = result.checksum * 31 + lookup.SumGroups(node ? node->first : spell);
+    }
+    result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+static void Usage(char const* name)
+{
+    printf("Usage: %s [-s spells] [-u units] [-a auras per unit] [-n hits] [-r rounds]\n", name);
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:u:a:n:r:")) != -1)
+    {
+        switch (opt)
+        {
+            case 's': options.spells = atoi(optarg); break;
+            case 'u': options.units = atoi(optarg); break;
+            case 'a': options.auras = atoi(optarg); break;
+            case 'n': options.hits = atoi(optarg); break;
+            case 'r': options.rounds = atoi(optarg); break;
+            default: Usage(argv[0]);
+        }
+    }
+    if (options.spells <= 20 || options.units <= 0 || options.auras <= 0 || options.hits <= 0 || options.rounds <= 0)
+        Usage(argv[0]);
+
+    Tables tables;
+    Load(options, tables);
+
+    // Auras of the units, spells of the whole table
+    std::vector<uint32> auras(options.units * options.auras);
+    uint32 random = 521288629u;
+    for (std::size_t i = 0; i < auras.size(); ++i)
+        auras[i] = 1 + NextRandom(random) % (options.spells - 1);
+
+    printf("%d spells (%zu proc events, %zu bonuses, %zu threats, %zu chain nodes, %zu groups), %d units with %d auras, %d hits\n",
+        options.spells, tables.procEvents.size(), tables.bonuses.size(), tables.threats.size(), tables.chains.size(),
+        tables.groups.size(), options.units, options.auras, options.hits);
+    for (int round = 0; round < options.rounds; ++round)
+    {
+        Result maps = Fight<MapLookup>(options, tables, auras);
+        Result indexes = Fight<IndexLookup>(options, tables, auras);
+        if (maps.checksum != indexes.checksum)
+        {
+            fprintf(stderr, "The lookups found different data\n");
+            return 1;
+        }
+
+        printf("round %d maps   : %.3f s (%.0f ns/hit)\n", round + 1, maps.elapsed, maps.elapsed * 1e9 / options.hits);
+        printf("round %d indexes: %.3f s (%.0f ns/hit)\n", round + 1, indexes.elapsed, indexes.elapsed * 1e9 / options.hits);
+    }
+
+    return 0;
+}
@@ -16,7 +16,10 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <atomic>
+#include <chrono>
 #include <list>
+#include <thread>
 #include "MMapCommon.h"
 #include "MapBuilder.h"
 
@@ -227,17 +230,19 @@ namespace MMAP
 {
     MapBuilder::MapBuilder(float maxWalkableAngle, bool skipLiquid,
                            bool skipContinents, bool skipJunkMaps, bool skipBattlegrounds,
-                           bool debugOutput, bool bigBaseUnit, bool quick, const char* offMeshFilePath) :
+                           bool debugOutput, bool bigBaseUnit, bool quick, const char* offMeshFilePath, int threads) :
         m_terrainBuilder(NULL),
         m_debugOutput(debugOutput),
+        m_offMeshFilePath(offMeshFilePath),
+        m_skipLiquid(skipLiquid),
         m_skipContinents(skipContinents),
         m_skipJunkMaps(skipJunkMaps),
         m_skipBattlegrounds(skipBattlegrounds),
+        m_quick(quick),
         m_maxWalkableAngle(maxWalkableAngle),
         m_bigBaseUnit(bigBaseUnit),
-        m_quick(quick),
-        m_rcContext(NULL),
-        m_offMeshFilePath(offMeshFilePath)
+        m_threads(threads),
+        m_rcContext(NULL)
     {
         m_terrainBuilder = new TerrainBuilder(skipLiquid, quick);
 
@@ -414,7 +419,7 @@ namespace MMAP
             return;
         }
 
-        buildTile(mapID, tileX, tileY, navMesh);
+        buildTile(mapID, tileX, tileY, *navMesh->getParams(), m_terrainBuilder, m_rcContext);
         dtFreeNavMesh(navMesh);
     }
 
@@ -422,6 +427,7 @@ namespace MMAP
     void MapBuilder::buildMap(uint32 mapID)
     {
         printf("Building map %03u:\n", mapID);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
         set<uint32>* tiles = getTileList(mapID);
 
@@ -452,6 +458,7 @@ namespace MMAP
 
         // now start building mmtiles for each tile
         printf("We have %u tiles.                          \n", (unsigned int)tiles->size());
+        vector<uint32> tileIds;
         for (set<uint32>::iterator it = tiles->begin(); it != tiles->end(); ++it)
         {
             uint32 tileX, tileY;
@@ -462,29 +469,71 @@ namespace MMAP
             if (shouldSkipTile(mapID, tileX, tileY))
                 continue;
 
-            buildTile(mapID, tileX, tileY, navMesh);
+            tileIds.push_back(*it);
         }
 
+        buildTiles(mapID, tileIds, *navMesh->getParams());
+
         dtFreeNavMesh(navMesh);
 
-        printf("Complete!                               \n\n");
+        float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        printf("Complete! Map %03u: %u tiles in %.1f s (%i threads)           \n\n", mapID, (unsigned int)tileIds.size(), elapsed, m_threads);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::buildTiles(uint32 mapID, vector<uint32> const& tileIds, dtNavMeshParams const& navMeshParams)
+    {
+        if (m_threads <= 1 || tileIds.size() <= 1)
+        {
+            for (vector<uint32>::const_iterator it = tileIds.begin(); it != tileIds.end(); ++it)
+            {
+                uint32 tileX, tileY;
+                StaticMapTree::unpackTileID((*it), tileX, tileY);
+                buildTile(mapID, tileX, tileY, navMeshParams, m_terrainBuilder, m_rcContext);
+            }
+            return;
+        }
+
+        // Each tile is built from the terrain and models around its own grid, and written to its own file.
+        // The threads take the next tile to build in the list, with their own TerrainBuilder (loaded
+        // vmaps, heights of the current grid) and Recast context.
+        std::atomic<size_t> nextTile(0);
+        vector<std::thread> threads;
+        for (int i = 0; i < m_threads && size_t(i) < tileIds.size(); ++i)
+        {
+            threads.push_back(std::thread([this, mapID, &tileIds, &navMeshParams, &nextTile]()
+            {
+                TerrainBuilder terrainBuilder(m_skipLiquid, m_quick);
+                rcContext context(false);
+                for (size_t index = nextTile++; index < tileIds.size(); index = nextTile++)
+                {
+                    uint32 tileX, tileY;
+                    StaticMapTree::unpackTileID(tileIds[index], tileX, tileY);
+                    buildTile(mapID, tileX, tileY, navMeshParams, &terrainBuilder, &context);
+                }
+            }));
+        }
+
+        for (vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+            it->join();
     }
 
     /**************************************************************************/
-    void MapBuilder::buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh* navMesh)
+    void MapBuilder::buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMeshParams const& navMeshParams,
+                               TerrainBuilder* terrainBuilder, rcContext* context)
     {
         printf("Building map %03u, tile [%02u,%02u]\n", mapID, tileX, tileY);
 
         MeshData meshData;
 
         // get heightmap data
-        m_terrainBuilder->loadMap(mapID, tileX, tileY, meshData);
+        terrainBuilder->loadMap(mapID, tileX, tileY, meshData);
 
         // remove unused vertices
         TerrainBuilder::cleanVertices(meshData.solidVerts, meshData.solidTris);
         TerrainBuilder::cleanVertices(meshData.liquidVerts, meshData.liquidTris);
 
-        m_terrainBuilder->loadVMap(mapID, tileY, tileX, meshData); // get model data
+        terrainBuilder->loadVMap(mapID, tileY, tileX, meshData); // get model data
         //TerrainBuilder::cleanVertices(meshData.solidVerts, meshData.solidTris);
 
         // if there is no data, give up now
@@ -502,11 +551,11 @@ namespace MMAP
         float bmin[3], bmax[3];
         getTileBounds(tileX, tileY, allVerts.getCArray(), allVerts.size() / 3, bmin, bmax);
 
-        m_terrainBuilder->loadOffMeshConnections(mapID, tileX, tileY, meshData, m_offMeshFilePath);
+        terrainBuilder->loadOffMeshConnections(mapID, tileX, tileY, meshData, m_offMeshFilePath);
 
         // build navmesh tile
-        buildMoveMapTile(mapID, tileX, tileY, meshData, bmin, bmax, navMesh);
-        m_terrainBuilder->unloadVMap(mapID, tileY, tileX);
+        buildMoveMapTile(mapID, tileX, tileY, meshData, bmin, bmax, navMeshParams, terrainBuilder, context);
+        terrainBuilder->unloadVMap(mapID, tileY, tileX);
     }
 
     /**************************************************************************/
@@ -577,7 +626,8 @@ namespace MMAP
     /**************************************************************************/
     void MapBuilder::buildMoveMapTile(uint32 mapID, uint32 tileX, uint32 tileY,
                                       MeshData& meshData, float bmin[3], float bmax[3],
-                                      dtNavMesh* navMesh)
+                                      dtNavMeshParams const& navMeshParams,
+                                      TerrainBuilder* terrainBuilder, rcContext* context)
     {
         // console output
         char tileString[10];
@@ -683,7 +733,7 @@ namespace MMAP
                 // NOSTALRIUS - MMAPS TILE GENERATION
                 /// 1. Alloc heightfield for walkable areas
                 tile.solid = rcAllocHeightfield();
-                if (!tile.solid || !rcCreateHeightfield(m_rcContext, *tile.solid, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
+                if (!tile.solid || !rcCreateHeightfield(context, *tile.solid, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
                 {
                     printf("%sFailed building heightfield!            \n", tileString);
                     continue;
@@ -692,12 +742,12 @@ namespace MMAP
                 /// 2. Generate heightfield for water. Put all liquid geometry there
                 // We need to build liquid heighfield to set poly swim flag under.
                 liquidsTile.solid = rcAllocHeightfield();
-                if (!liquidsTile.solid || !rcCreateHeightfield(m_rcContext, *liquidsTile.solid, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
+                if (!liquidsTile.solid || !rcCreateHeightfield(context, *liquidsTile.solid, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
                 {
                     printf("%sFailed building liquids heightfield!            \n", tileString);
                     continue;
                 }
-                rcRasterizeTriangles(m_rcContext, lVerts, lVertCount, lTris, lTriAreas, lTriCount, *liquidsTile.solid, 0);
+                rcRasterizeTriangles(context, lVerts, lVertCount, lTris, lTriAreas, lTriCount, *liquidsTile.solid, 0);
 
                 /// 3. Mark all triangles with correct flags:
                 // Can't use rcMarkWalkableTriangles. We need something really more specific.
@@ -748,9 +798,9 @@ namespace MMAP
                             for (int v = 0; v < 3; ++v) // Coordinate
                                 verts[3*c + v] = (5*tVerts[tri[c]*3 + v] + tVerts[tri[(c+1)%3]*3 + v] + tVerts[tri[(c+2)%3]*3 + v]) / 7;
                         // A triangle is undermap if all corners are undermap
-                        bool undermap1 = m_terrainBuilder->IsUnderMap(&verts[0]);
-                        bool undermap2 = m_terrainBuilder->IsUnderMap(&verts[3]);
-                        bool undermap3 = m_terrainBuilder->IsUnderMap(&verts[6]);
+                        bool undermap1 = terrainBuilder->IsUnderMap(&verts[0]);
+                        bool undermap2 = terrainBuilder->IsUnderMap(&verts[3]);
+                        bool undermap3 = terrainBuilder->IsUnderMap(&verts[6]);
 
                         if ((undermap1 + undermap2 + undermap3) == 3)
                         {
@@ -760,7 +810,7 @@ namespace MMAP
                     }
                 }
                 /// 4. Every triangle is correctly marked now, we can rasterize everything
-                rcRasterizeTriangles(m_rcContext, tVerts, tVertCount, tTris, areas, tTriCount, *tile.solid, 0);
+                rcRasterizeTriangles(context, tVerts, tVertCount, tTris, areas, tTriCount, *tile.solid, 0);
                 delete [] areas;
 
                 /// 5. Don't walk over too high Obstacles.
@@ -768,17 +818,17 @@ namespace MMAP
                 // But for terrain->vmap->terrain kind of obstacles, it's harder to climb.
                 // (Why? No idea, ask Blizzard. Empirically confirmed on retail)
                 // 5.1 walkableClimbTerrain >= walkableClimbModelTransition so do it first
-                rcFilterLowHangingWalkableObstacles(m_rcContext, walkableClimbTerrain, *tile.solid);
+                rcFilterLowHangingWalkableObstacles(context, walkableClimbTerrain, *tile.solid);
                 // 5.2 maps <-> vmaps transition
                 filterLedgeSpans(tileCfg.walkableHeight, walkableClimbModelTransition, walkableClimbTerrain, *tile.solid);
-                //rcFilterLedgeSpans(m_rcContext, tileCfg.walkableHeight, walkableClimbTerrain, *tile.solid); // Default recast code
+                //rcFilterLedgeSpans(context, tileCfg.walkableHeight, walkableClimbTerrain, *tile.solid); // Default recast code
 
                 /// 6. Now we are happy because we have the correct flags.
                 // Set's cleanup tmp flags used by the generator, so we don't have a too
                 // complicated navmesh in the end.
                 // (We dont care if a poly comes from Terrain or Model at runtime)
                 filterRemoveUselessAreas(*tile.solid);
-                rcFilterWalkableLowHeightSpans(m_rcContext, tileCfg.walkableHeight, *tile.solid);
+                rcFilterWalkableLowHeightSpans(context, tileCfg.walkableHeight, *tile.solid);
 
 
                 /// 7. Let's process water now.
@@ -790,33 +840,33 @@ namespace MMAP
                 /// 8. Now let's move on with the last and more generic steps of navmesh generation.
                 // compact heightfield spans
                 tile.chf = rcAllocCompactHeightfield();
-                if (!tile.chf || !rcBuildCompactHeightfield(m_rcContext, tileCfg.walkableHeight, walkableClimbTerrain, *tile.solid, *tile.chf))
+                if (!tile.chf || !rcBuildCompactHeightfield(context, tileCfg.walkableHeight, walkableClimbTerrain, *tile.solid, *tile.chf))
                 {
                     printf("%sFailed compacting heightfield!            \n", tileString);
                     continue;
                 }
 
                 // build polymesh intermediates
-                if (!rcErodeWalkableArea(m_rcContext, config.walkableRadius, *tile.chf))
+                if (!rcErodeWalkableArea(context, config.walkableRadius, *tile.chf))
                 {
                     printf("%sFailed eroding area!                    \n", tileString);
                     continue;
                 }
 
-                if (!rcBuildDistanceField(m_rcContext, *tile.chf))
+                if (!rcBuildDistanceField(context, *tile.chf))
                 {
                     printf("%sFailed building distance field!         \n", tileString);
                     continue;
                 }
 
-                if (!rcBuildRegions(m_rcContext, *tile.chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea))
+                if (!rcBuildRegions(context, *tile.chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea))
                 {
                     printf("%sFailed building regions!                \n", tileString);
                     continue;
                 }
 
                 tile.cset = rcAllocContourSet();
-                if (!tile.cset || !rcBuildContours(m_rcContext, *tile.chf, tileCfg.maxSimplificationError, tileCfg.maxEdgeLen, *tile.cset))
+                if (!tile.cset || !rcBuildContours(context, *tile.chf, tileCfg.maxSimplificationError, tileCfg.maxEdgeLen, *tile.cset))
                 {
                     printf("%sFailed building contours!               \n", tileString);
                     continue;
@@ -824,14 +874,14 @@ namespace MMAP
 
                 // build polymesh
                 tile.pmesh = rcAllocPolyMesh();
-                if (!tile.pmesh || !rcBuildPolyMesh(m_rcContext, *tile.cset, tileCfg.maxVertsPerPoly, *tile.pmesh))
+                if (!tile.pmesh || !rcBuildPolyMesh(context, *tile.cset, tileCfg.maxVertsPerPoly, *tile.pmesh))
                 {
                     printf("%sFailed building polymesh!               \n", tileString);
                     continue;
                 }
 
                 tile.dmesh = rcAllocPolyMeshDetail();
-                if (!tile.dmesh || !rcBuildPolyMeshDetail(m_rcContext, *tile.pmesh, *tile.chf, tileCfg.detailSampleDist, tileCfg.detailSampleMaxError, *tile.dmesh))
+                if (!tile.dmesh || !rcBuildPolyMeshDetail(context, *tile.pmesh, *tile.chf, tileCfg.detailSampleDist, tileCfg.detailSampleMaxError, *tile.dmesh))
                 {
                     printf("%sFailed building polymesh detail!        \n", tileString);
                     continue;
@@ -891,7 +941,7 @@ namespace MMAP
             printf("%s alloc iv.polyMesh FAILED!          \r", tileString);
             return;
         }
-        rcMergePolyMeshes(m_rcContext, pmmerge, nmerge, *iv.polyMesh);
+        rcMergePolyMeshes(context, pmmerge, nmerge, *iv.polyMesh);
 
         iv.polyMeshDetail = rcAllocPolyMeshDetail();
         if (!iv.polyMeshDetail)
@@ -902,7 +952,7 @@ namespace MMAP
             delete[] dmmerge;
             return;
         }
-        rcMergePolyMeshDetails(m_rcContext, dmmerge, nmerge, *iv.polyMeshDetail);
+        rcMergePolyMeshDetails(context, dmmerge, nmerge, *iv.polyMeshDetail);
 
         // free things up
         delete [] pmmerge;
@@ -969,8 +1019,8 @@ namespace MMAP
         params.walkableHeight = agentHeight;  // agent height
         params.walkableRadius = agentRadius;  // agent radius
         params.walkableClimb = agentMaxClimbTerrain;    // keep less that walkableHeight (aka agent height)!
-        params.tileX = (((bmin[0] + bmax[0]) / 2) - navMesh->getParams()->orig[0]) / GRID_SIZE;
-        params.tileY = (((bmin[2] + bmax[2]) / 2) - navMesh->getParams()->orig[2]) / GRID_SIZE;
+        params.tileX = (((bmin[0] + bmax[0]) / 2) - navMeshParams.orig[0]) / GRID_SIZE;
+        params.tileY = (((bmin[2] + bmax[2]) / 2) - navMeshParams.orig[2]) / GRID_SIZE;
         params.tileLayer = 0;
         params.buildBvTree = true;
         rcVcopy(params.bmin, bmin);
@@ -982,6 +1032,16 @@ namespace MMAP
         unsigned char* navData = NULL;
         int navDataSize = 0;
 
+        // addTile writes the links into the tile data: with a navmesh of its own, the tile always gets
+        // the same refs, whatever the tiles built before it or by the other threads
+        dtNavMesh* navMesh = dtAllocNavMesh();
+        if (!navMesh || dtStatusFailed(navMesh->init(&navMeshParams)))
+        {
+            printf("%s Failed creating navmesh!                \n", tileString);
+            dtFreeNavMesh(navMesh);
+            return;
+        }
+
         do
         {
             // these values are checked within dtCreateNavMeshData - handle them here
@@ -1056,7 +1116,7 @@ namespace MMAP
 
             // write header
             MmapTileHeader header;
-            header.usesLiquids = m_terrainBuilder->usesLiquids();
+            header.usesLiquids = terrainBuilder->usesLiquids();
             header.size = uint32(navDataSize);
             fwrite(&header, sizeof(MmapTileHeader), 1, file);
 
@@ -1083,6 +1143,8 @@ namespace MMAP
             navMesh->removeTile(tileRef, NULL, NULL);
         }
         while (0);
+
+        dtFreeNavMesh(navMesh);
     }
 
     /**************************************************************************/
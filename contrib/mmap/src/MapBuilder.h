@@ -68,7 +68,8 @@ namespace MMAP
                        bool debugOutput         = false,
                        bool bigBaseUnit         = false,
                        bool quick               = false,
-                       const char* offMeshFilePath = NULL);
+                       const char* offMeshFilePath = NULL,
+                       int threads              = 1);
 
             ~MapBuilder();
 
@@ -91,7 +92,11 @@ namespace MMAP
 
             void buildNavMesh(uint32 mapID, dtNavMesh*& navMesh);
 
-            void buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh* navMesh);
+            // builds the tiles of a map, on m_threads threads
+            void buildTiles(uint32 mapID, vector<uint32> const& tileIds, dtNavMeshParams const& navMeshParams);
+
+            void buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMeshParams const& navMeshParams,
+                           TerrainBuilder* terrainBuilder, rcContext* context);
 
             // move map building
             void buildMoveMapTile(uint32 mapID,
@@ -100,7 +105,9 @@ namespace MMAP
                                   MeshData& meshData,
                                   float bmin[3],
                                   float bmax[3],
-                                  dtNavMesh* navMesh);
+                                  dtNavMeshParams const& navMeshParams,
+                                  TerrainBuilder* terrainBuilder,
+                                  rcContext* context);
 
             void getTileBounds(uint32 tileX, uint32 tileY,
                                float* verts, int vertCount,
@@ -117,6 +124,7 @@ namespace MMAP
             bool m_debugOutput;
 
             const char* m_offMeshFilePath;
+            bool m_skipLiquid;
             bool m_skipContinents;
             bool m_skipJunkMaps;
             bool m_skipBattlegrounds;
@@ -125,7 +133,11 @@ namespace MMAP
             float m_maxWalkableAngle;
             bool m_bigBaseUnit;
 
+            // tiles built concurrently by buildMap
+            int m_threads;
+
             // build performance - not really used for now
+            // m_terrainBuilder and m_rcContext are used by the main thread only
             rcContext* m_rcContext;
             uint32 m_lastMapTriangle;
     };
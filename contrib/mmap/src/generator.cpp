@@ -72,10 +72,12 @@ void printUsage()
     printf("--debugOutput [true|false] : create debugging files for use with RecastDemo\n");
     printf("--bigBaseUnit [true|false] : Generate tile/map using bigger basic unit.\n");
     printf("--quick : Does not remove undermap positions ... But generates way more quickly.\n");
+    printf("--threads [#] : Number of tiles built at the same time (default 1).\n");
     printf("--silent : Make script friendly. No wait for user input, error, completion.\n");
     printf("--offMeshInput [file.*] : Path to file containing off mesh connections data.\n\n");
     printf("Exemple:\nmovemapgen (generate all mmap with default arg\n"
         "movemapgen 0 (generate map 0)\n"
+        "movemapgen --threads 8 (generate all mmap, 8 tiles at a time)\n"
         "movemapgen --tile 34,46 (builds only tile 34,46 of map 0)\n\n");
     printf("Please read readme file for more information and exemples.\n");
 }
@@ -93,6 +95,7 @@ bool handleArgs(int argc, char** argv,
                 bool& silent,
                 bool& bigBaseUnit,
                 bool &quick,
+                int& threads,
                 char*& offMeshInputPath)
 {
     char* param = NULL;
@@ -218,6 +221,18 @@ bool handleArgs(int argc, char** argv,
             else
                 printf("invalid option for '--bigBaseUnit', using default false\n");
         }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            param = argv[++i];
+            if (!param)
+                return false;
+
+            int count = atoi(param);
+            if (count > 0)
+                threads = count;
+            else
+                printf("invalid option for '--threads', using default 1\n");
+        }
         else if (strcmp(argv[i], "--offMeshInput") == 0)
         {
             param = argv[++i];
@@ -267,12 +282,13 @@ int main(int argc, char** argv)
          silent = false,
          bigBaseUnit = false,
          quick = false;
+    int threads = 1;
     char* offMeshInputPath = NULL;
 
     bool validParam = handleArgs(argc, argv, mapnum,
                                  tileX, tileY, maxAngle,
                                  skipLiquid, skipContinents, skipJunkMaps, skipBattlegrounds,
-                                 debugOutput, silent, bigBaseUnit, quick, offMeshInputPath);
+                                 debugOutput, silent, bigBaseUnit, quick, threads, offMeshInputPath);
 
     if (!validParam)
         return silent ? -1 : finish("You have specified invalid parameters (use -? for more help)", -1);
@@ -293,7 +309,7 @@ int main(int argc, char** argv)
         return silent ? -3 : finish("Press any key to close...", -3);
 
     MapBuilder builder(maxAngle, skipLiquid, skipContinents, skipJunkMaps,
-                       skipBattlegrounds, debugOutput, bigBaseUnit, quick, offMeshInputPath);
+                       skipBattlegrounds, debugOutput, bigBaseUnit, quick, offMeshInputPath, threads);
 
     if (tileX > -1 && tileY > -1 && mapnum >= 0)
         builder.buildSingleTile(mapnum, tileX, tileY);
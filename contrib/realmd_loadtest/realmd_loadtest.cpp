@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Replays full 1.12.1 logins (logon challenge, SRP6 proof, realm list) against a realmd,
+ * from several concurrent clients, and reports the logins per second and their latency.
+ */
+
+#include <openssl/bn.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::vector<unsigned char> Bytes;
+
+enum LoginStage
+{
+    STAGE_CONNECT,
+    STAGE_CHALLENGE,
+    STAGE_PROOF,
+    STAGE_REALM_LIST,
+    STAGE_DONE
+};
+
+static char const* StageNames[] = { "connect", "logon challenge", "logon proof", "realm list" };
+
+struct Options
+{
+    Options() : host("127.0.0.1"), port(3724), account("LOADTEST"), password("LOADTEST"), logins(1000), clients(16), accounts(0), printSql(false) {}
+
+    std::string host;
+    int port;
+    std::string account;
+    std::string password;
+    int logins;
+    int clients;
+    int accounts;                                           // 0: always 'account', else account1 .. accountN
+    bool printSql;
+};
+
+/// Little endian bytes of a number, as BigNumber::AsByteArray() in realmd
+static Bytes ToBytes(BIGNUM const* bn, int minSize = 0)
+{
+    int size = std::max(BN_num_bytes(bn), minSize);
+    Bytes bytes(size, 0);
+    BN_bn2bin(bn, &bytes[size - BN_num_bytes(bn)]);
+    std::reverse(bytes.begin(), bytes.end());
+    return bytes;
+}
+
+static BIGNUM* FromBytes(unsigned char const* data, int size)
+{
+    Bytes bytes(data, data + size);
+    std::reverse(bytes.begin(), bytes.end());
+    return BN_bin2bn(bytes.data(), size, NULL);
+}
+
+static void Append(Bytes& dst, Bytes const& src)
+{
+    dst.insert(dst.end(), src.begin(), src.end());
+}
+
+static Bytes Sha1(Bytes const& data)
+{
+    Bytes digest(SHA_DIGEST_LENGTH);
+    SHA1(data.data(), data.size(), digest.data());
+    return digest;
+}
+
+static std::string ToUpper(std::string str)
+{
+    for (std::string::iterator itr = str.begin(); itr != str.end(); ++itr)
+        *itr = toupper(*itr);
+    return str;
+}
+
+/// sha_pass_hash column of the account table
+static std::string PasswordHash(std::string const& account, std::string const& password)
+{
+    std::string credentials = ToUpper(account) + ":" + ToUpper(password);
+    Bytes digest = Sha1(Bytes(credentials.begin(), credentials.end()));
+
+    std::string hex;
+    char buf[3];
+    for (Bytes::const_iterator itr = digest.begin(); itr != digest.end(); ++itr)
+    {
+        snprintf(buf, sizeof(buf), "%02X", *itr);
+        hex += buf;
+    }
+    return hex;
+}
+
+class AuthClient
+{
+    public:
+        AuthClient() : m_socket(-1) {}
+        ~AuthClient() { Close(); }
+
+        LoginStage Login(Options const& options, std::string const& account);
+
+    private:
+        bool Connect(Options const& options);
+        void Close() { if (m_socket >= 0) close(m_socket); m_socket = -1; }
+        bool Send(Bytes const& data);
+        bool Receive(unsigned char* data, size_t size);
+
+        int m_socket;
+};
+
+bool AuthClient::Connect(Options const& options)
+{
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* address = NULL;
+    if (getaddrinfo(options.host.c_str(), std::to_string(options.port).c_str(), &hints, &address) || !address)
+        return false;
+
+    m_socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    bool connected = m_socket >= 0 && connect(m_socket, address->ai_addr, address->ai_addrlen) == 0;
+    freeaddrinfo(address);
+    if (!connected)
+        return false;
+
+    int noDelay = 1;
+    setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    return true;
+}
+
+bool AuthClient::Send(Bytes const& data)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t n = send(m_socket, data.data() + sent, data.size() - sent, 0);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+bool AuthClient::Receive(unsigned char* data, size_t size)
+{
+    size_t received = 0;
+    while (received < size)
+    {
+        ssize_t n = recv(m_socket, data + received, size - received, 0);
+        if (n <= 0)
+            return false;
+        received += n;
+    }
+    return true;
+}
+
+LoginStage AuthClient::Login(Options const& options, std::string const& account)
+{
+    if (!Connect(options))
+        return STAGE_CONNECT;
+
+    std::string login = ToUpper(account);
+
+    ///- Logon challenge, as sent by a 1.12.1 (5875) enUS windows client
+    Bytes challenge;
+    challenge.push_back(0x00);                              // CMD_AUTH_LOGON_CHALLENGE
+    challenge.push_back(0x03);                              // error
+    uint16_t size = uint16_t(30 + login.size());
+    challenge.push_back(size & 0xFF);
+    challenge.push_back(size >> 8);
+    Append(challenge, Bytes({ 'W', 'o', 'W', 0 }));
+    Append(challenge, Bytes({ 1, 12, 1 }));
+    Append(challenge, Bytes({ 5875 & 0xFF, 5875 >> 8 }));
+    Append(challenge, Bytes({ '6', '8', 'x', 0 }));         // platform and os are reversed
+    Append(challenge, Bytes({ 'n', 'i', 'W', 0 }));
+    Append(challenge, Bytes({ 'S', 'U', 'n', 'e' }));
+    Append(challenge, Bytes({ 0, 0, 0, 0 }));               // timezone bias
+    Append(challenge, Bytes({ 127, 0, 0, 1 }));             // ip
+    challenge.push_back(uint8_t(login.size()));
+    Append(challenge, Bytes(login.begin(), login.end()));
+    if (!Send(challenge))
+        return STAGE_CHALLENGE;
+
+    unsigned char header[3];
+    if (!Receive(header, sizeof(header)) || header[0] != 0x00 || header[2] != 0x00)
+        return STAGE_CHALLENGE;
+
+    // B(32) g_len(1) g(1) N_len(1) N(32) s(32) unk3(16) securityFlags(1)
+    unsigned char body[116];
+    if (!Receive(body, sizeof(body)) || body[32] != 1 || body[34] != 32 || body[115] != 0)
+        return STAGE_CHALLENGE;                             // PIN authentication is not supported
+
+    BN_CTX* ctx = BN_CTX_new();
+    BIGNUM* B = FromBytes(body, 32);
+    BIGNUM* g = FromBytes(body + 33, 1);
+    BIGNUM* N = FromBytes(body + 35, 32);
+    BIGNUM* s = FromBytes(body + 67, 32);
+
+    ///- x = H(s | H(I:P))
+    std::string credentials = login + ":" + ToUpper(options.password);
+    Bytes xData;
+    Append(xData, ToBytes(s));
+    Append(xData, Sha1(Bytes(credentials.begin(), credentials.end())));
+    Bytes xHash = Sha1(xData);
+    BIGNUM* x = FromBytes(xHash.data(), xHash.size());
+
+    ///- A = g^a
+    BIGNUM* a = BN_new();
+    BIGNUM* A = BN_new();
+    BN_rand(a, 19 * 8, -1, 0);
+    BN_mod_exp(A, g, a, N, ctx);
+
+    ///- u = H(A | B)
+    Bytes uData = ToBytes(A);
+    Append(uData, ToBytes(B));
+    Bytes uHash = Sha1(uData);
+    BIGNUM* u = FromBytes(uHash.data(), uHash.size());
+
+    ///- S = (B - 3 * g^x) ^ (a + u * x)
+    BIGNUM* gx = BN_new();
+    BIGNUM* kgx = BN_new();
+    BIGNUM* base = BN_new();
+    BIGNUM* exponent = BN_new();
+    BIGNUM* S = BN_new();
+    BN_mod_exp(gx, g, x, N, ctx);
+    BN_mul_word(gx, 3);
+    BN_mod(kgx, gx, N, ctx);
+    BN_mod_sub(base, B, kgx, N, ctx);
+    BN_mul(exponent, u, x, ctx);
+    BN_add(exponent, exponent, a);
+    BN_mod_exp(S, base, exponent, N, ctx);
+
+    ///- Session key, interleaved hashes of S
+    Bytes t = ToBytes(S, 32);
+    Bytes even, odd;
+    for (int i = 0; i < 16; ++i)
+    {
+        even.push_back(t[i * 2]);
+        odd.push_back(t[i * 2 + 1]);
+    }
+    Bytes evenHash = Sha1(even);
+    Bytes oddHash = Sha1(odd);
+    Bytes vK(40);
+    for (int i = 0; i < 20; ++i)
+    {
+        vK[i * 2] = evenHash[i];
+        vK[i * 2 + 1] = oddHash[i];
+    }
+    BIGNUM* K = FromBytes(vK.data(), vK.size());
+
+    ///- M1 = H(H(N) xor H(g) | H(I) | s | A | B | K)
+    Bytes hash = Sha1(ToBytes(N));
+    Bytes gHash = Sha1(ToBytes(g));
+    for (int i = 0; i < SHA_DIGEST_LENGTH; ++i)
+        hash[i] ^= gHash[i];
+    BIGNUM* t3 = FromBytes(hash.data(), hash.size());
+
+    Bytes mData = ToBytes(t3);
+    Append(mData, Sha1(Bytes(login.begin(), login.end())));
+    Append(mData, ToBytes(s));
+    Append(mData, ToBytes(A));
+    Append(mData, ToBytes(B));
+    Append(mData, ToBytes(K));
+    Bytes M1 = Sha1(mData);
+
+    Bytes proof;
+    proof.push_back(0x01);                                  // CMD_AUTH_LOGON_PROOF
+    Append(proof, ToBytes(A, 32));
+    Append(proof, M1);
+    Append(proof, Bytes(SHA_DIGEST_LENGTH, 0));             // crc_hash
+    proof.push_back(0);                                     // number_of_keys
+    proof.push_back(0);                                     // securityFlags
+
+    Bytes A32 = ToBytes(A);
+    Bytes Kbytes = ToBytes(K);
+
+    BN_free(B); BN_free(g); BN_free(N); BN_free(s); BN_free(x); BN_free(a); BN_free(A); BN_free(u);
+    BN_free(gx); BN_free(kgx); BN_free(base); BN_free(exponent); BN_free(S); BN_free(K); BN_free(t3);
+    BN_CTX_free(ctx);
+
+    if (!Send(proof))
+        return STAGE_PROOF;
+
+    unsigned char proofResult[26];
+    if (!Receive(proofResult, 2) || proofResult[1] != 0x00 || !Receive(proofResult + 2, sizeof(proofResult) - 2))
+        return STAGE_PROOF;
+
+    ///- M2 = H(A | M1 | K), proves the server knows the verifier too
+    Bytes m2Data = A32;
+    Append(m2Data, M1);
+    Append(m2Data, Kbytes);
+    if (memcmp(Sha1(m2Data).data(), proofResult + 2, SHA_DIGEST_LENGTH))
+        return STAGE_PROOF;
+
+    ///- Realm list
+    if (!Send(Bytes({ 0x10, 0, 0, 0, 0 })))
+        return STAGE_REALM_LIST;
+
+    unsigned char listHeader[3];
+    if (!Receive(listHeader, sizeof(listHeader)) || listHeader[0] != 0x10)
+        return STAGE_REALM_LIST;
+
+    Bytes realms(listHeader[1] | (listHeader[2] << 8));
+    if (!realms.empty() && !Receive(realms.data(), realms.size()))
+        return STAGE_REALM_LIST;
+
+    Close();
+    return STAGE_DONE;
+}
+
+static void Usage(char const* program)
+{
+    printf("Usage: %s [options]\n"
+        "    -h <host>        realmd address (default 127.0.0.1)\n"
+        "    -p <port>        realmd port (default 3724)\n"
+        "    -a <account>     account name, or prefix of the account names with -r (default LOADTEST)\n"
+        "    -w <password>    password of the accounts (default LOADTEST)\n"
+        "    -r <count>       use the accounts <account>1 to <account><count>\n"
+        "    -n <logins>      number of logins (default 1000)\n"
+        "    -c <clients>     number of concurrent clients (default 16)\n"
+        "    -s               print the SQL creating the accounts, and exit\n", program);
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "-h" && hasValue)
+            options.host = argv[++i];
+        else if (arg == "-p" && hasValue)
+            options.port = atoi(argv[++i]);
+        else if (arg == "-a" && hasValue)
+            options.account = argv[++i];
+        else if (arg == "-w" && hasValue)
+            options.password = argv[++i];
+        else if (arg == "-r" && hasValue)
+            options.accounts = atoi(argv[++i]);
+        else if (arg == "-n" && hasValue)
+            options.logins = atoi(argv[++i]);
+        else if (arg == "-c" && hasValue)
+            options.clients = atoi(argv[++i]);
+        else if (arg == "-s")
+            options.printSql = true;
+        else
+        {
+            Usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (options.logins <= 0 || options.clients <= 0)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> accounts;
+    if (options.accounts > 0)
+    {
+        for (int i = 1; i <= options.accounts; ++i)
+            accounts.push_back(options.account + std::to_string(i));
+    }
+    else
+        accounts.push_back(options.account);
+
+    if (options.printSql)
+    {
+        for (std::vector<std::string>::const_iterator itr = accounts.begin(); itr != accounts.end(); ++itr)
+            printf("INSERT INTO account (username, sha_pass_hash) VALUES ('%s', '%s');\n",
+                ToUpper(*itr).c_str(), PasswordHash(*itr, options.password).c_str());
+        return 0;
+    }
+
+    std::atomic<int> nextLogin(0);
+    std::atomic<int> failures[STAGE_DONE];
+    for (int i = 0; i < STAGE_DONE; ++i)
+        failures[i] = 0;
+    std::mutex latenciesLock;
+    std::vector<double> latencies;
+    latencies.reserve(options.logins);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> clients;
+    for (int i = 0; i < options.clients; ++i)
+    {
+        clients.push_back(std::thread([&]()
+        {
+            std::vector<double> clientLatencies;
+            for (int login = nextLogin++; login < options.logins; login = nextLogin++)
+            {
+                auto loginStart = std::chrono::steady_clock::now();
+                AuthClient client;
+                LoginStage stage = client.Login(options, accounts[login % accounts.size()]);
+                if (stage != STAGE_DONE)
+                {
+                    ++failures[stage];
+                    continue;
+                }
+                clientLatencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loginStart).count());
+            }
+
+            std::lock_guard<std::mutex> guard(latenciesLock);
+            latencies.insert(latencies.end(), clientLatencies.begin(), clientLatencies.end());
+        }));
+    }
+    for (std::vector<std::thread>::iterator itr = clients.begin(); itr != clients.end(); ++itr)
+        itr->join();
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%d logins, %d clients, %.2f s\n", options.logins, options.clients, elapsed);
+    printf("Succeeded: %u (%.1f logins/s)\n", unsigned(latencies.size()), latencies.size() / elapsed);
+    for (int i = 0; i < STAGE_DONE; ++i)
+        if (failures[i])
+            printf("Failed at %s: %d\n", StageNames[i], int(failures[i]));
+
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        printf("Latency (ms): min %.1f, p50 %.1f, p95 %.1f, p99 %.1f, max %.1f\n", latencies.front(),
+            latencies[latencies.size() / 2], latencies[latencies.size() * 95 / 100],
+            latencies[latencies.size() * 99 / 100], latencies.back());
+    }
+
+    return latencies.size() == size_t(options.logins) ? 0 : 2;
+}
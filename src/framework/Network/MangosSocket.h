@@ -19,9 +19,10 @@
 #endif /* ACE_LACKS_PRAGMA_ONCE */
 
 #include "Common.h"
+#include "WorldPacket.h"
+#include <deque>
 
 class ACE_Message_Block;
-class WorldPacket;
 class WorldSession;
 
 
@@ -73,6 +74,12 @@ typedef ACE_Svc_Handler<ACE_SOCK_STREAM, ACE_NULL_SYNCH> WorldHandler;
  * sending packets from "producer" threads is minimal,
  * and doing a lot of writes with small size is tolerated.
  *
+ * A packet broadcast to many sockets is shared: each socket
+ * only writes its encrypted header in the output buffer, and
+ * keeps a reference on the packet until its content is sent.
+ * The buffer and the shared contents are written together
+ * with one gathered write.
+ *
  * The calls to Update () method are managed by WorldSocketMgr
  * and ReactorRunnable.
  *
@@ -105,7 +112,10 @@ class MangosSocket : protected WorldHandler
         typedef ACE_Guard<LockType> GuardType;
 
         /// Queue for storing packets for which there is no space.
-        typedef ACE_Unbounded_Queue<WorldPacket*> PacketQueueT;
+        typedef std::deque<SharedWorldPacketPtr> PacketQueueT;
+
+        /// Header written before each packet, encrypted.
+        typedef ServerPktHeader OutHeader;
 
         /// Check if socket is closed.
         bool IsClosed() const { return closing_; }
@@ -121,6 +131,10 @@ class MangosSocket : protected WorldHandler
         /// @return -1 of failure
         int SendPacket (const WorldPacket& pct);
 
+        /// Send a packet shared with other sockets, without copying it
+        /// when it is large enough. Reentrant.
+        int SendPacket (const SharedWorldPacketPtr& pct);
+
         /// Add reference to this object.
         long AddReference() { return static_cast<long>(add_reference()); }
 
@@ -172,9 +186,21 @@ class MangosSocket : protected WorldHandler
         int cancel_wakeup_output (GuardType& g);
         int schedule_wakeup_output (GuardType& g);
 
-        /// Try to write WorldPacket to m_OutBuffer ,return -1 if no space
+        /// Try to write a packet to m_OutBuffer ,return -1 if no space.
+        /// With 'shared', a large content is not copied but referenced.
+        /// Need to be called with m_OutBufferLock lock held
+        int iSendPacket (const WorldPacket& pct, const SharedWorldPacketPtr* shared);
+
+        /// Fill the encrypted header of a packet, called in the send order.
+        void BuildHeader (OutHeader& header, uint16 opcode, size_t size);
+
+        /// Write m_OutBuffer and the shared contents with one call.
         /// Need to be called with m_OutBufferLock lock held
-        int iSendPacket (const WorldPacket& pct);
+        ssize_t SendGathered ();
+
+        /// Release the first 'size' bytes written.
+        /// Need to be called with m_OutBufferLock lock held
+        void ConsumeOutput (size_t size);
 
         /// Flush m_PacketQueue if there are packets in it
         /// Need to be called with m_OutBufferLock lock held
@@ -220,6 +246,24 @@ class MangosSocket : protected WorldHandler
         /// Size of the m_OutBuffer.
         size_t m_OutBufferSize;
 
+        /// Content of a shared packet, written after the bytes of
+        /// m_OutBuffer before it.
+        struct SharedContent
+        {
+            SharedWorldPacketPtr packet;
+            uint64 bufferPos;                               // in the bytes ever written to m_OutBuffer
+            size_t sent;
+        };
+
+        /// Shared contents waiting to be sent, in order.
+        std::deque<SharedContent> m_SharedContents;
+
+        /// Bytes of m_SharedContents not sent yet.
+        size_t m_SharedContentsSize;
+
+        /// Bytes ever sent from m_OutBuffer.
+        uint64 m_OutBufferSent;
+
         /// Here are stored packets for which there was no space on m_OutBuffer,
         /// this allows not-to kick player if its buffer is overflowed.
         PacketQueueT m_PacketQueue;
@@ -6,6 +6,8 @@
 #include <ace/os_include/sys/os_types.h>
 #include <ace/os_include/sys/os_socket.h>
 #include <ace/OS_NS_string.h>
+#include <ace/OS_NS_sys_socket.h>
+#include <ace/OS_NS_sys_uio.h>
 #include <ace/Reactor.h>
 #include <ace/Auto_Ptr.h>
 
@@ -23,6 +25,11 @@
 #include "Log.h"
 #include "DBCStores.h"
 
+/// Shared contents smaller than this are copied in the output buffer, cheaper than a gathered write.
+#define SHARED_CONTENT_MIN_SIZE 256
+/// Maximum pieces written by one gathered write (output buffer parts and shared contents).
+#define MAX_GATHERED_WRITE 256
+
 
 template <typename SessionType, typename SocketName, typename Crypt>
 MangosSocket<SessionType, SocketName, Crypt>::MangosSocket() :
@@ -35,6 +42,8 @@ MangosSocket<SessionType, SocketName, Crypt>::MangosSocket() :
     m_Header(sizeof(ClientPktHeader)),
     m_OutBuffer(0),
     m_OutBufferSize(65536),
+    m_SharedContentsSize(0),
+    m_OutBufferSent(0),
     m_OutActive(false),
     m_Seed(static_cast<uint32>(rand32())),
     m_isServerSocket(true)
@@ -53,10 +62,6 @@ MangosSocket<SessionType, SocketName, Crypt>::~MangosSocket(void)
     closing_ = true;
 
     peer().close();
-
-    WorldPacket* pct;
-    while (m_PacketQueue.dequeue_head(pct) == 0)
-        delete pct;
 }
 
 template <typename SessionType, typename SocketName, typename Crypt>
@@ -87,25 +92,30 @@ int MangosSocket<SessionType, SocketName, Crypt>::SendPacket(const WorldPacket&
     if (closing_)
         return -1;
 
-    if (((SocketName*)this)->iSendPacket(pct) == -1)
+    if (iSendPacket(pct, NULL) == -1)
     {
-        WorldPacket* npct;
-
-        ACE_NEW_RETURN(npct, WorldPacket(pct), -1);
-
         // NOTE maybe check of the size of the queue can be good ?
         // to make it bounded instead of unbounded
-        if (m_PacketQueue.enqueue_tail(npct) == -1)
-        {
-            delete npct;
-            sLog.outError("MangosSocket<SessionType, SocketName, Crypt>::SendPacket: m_PacketQueue.enqueue_tail failed");
-            return -1;
-        }
+        m_PacketQueue.push_back(std::make_shared<WorldPacket>(pct));
     }
 
     return 0;
 }
 
+template <typename SessionType, typename SocketName, typename Crypt>
+int MangosSocket<SessionType, SocketName, Crypt>::SendPacket(const SharedWorldPacketPtr& pct)
+{
+    ACE_GUARD_RETURN(LockType, Guard, m_OutBufferLock, -1);
+
+    if (closing_)
+        return -1;
+
+    if (iSendPacket(*pct, &pct) == -1)
+        m_PacketQueue.push_back(pct);
+
+    return 0;
+}
+
 template <typename SessionType, typename SocketName, typename Crypt>
 int MangosSocket<SessionType, SocketName, Crypt>::open(void *a)
 {
@@ -210,16 +220,22 @@ int MangosSocket<SessionType, SocketName, Crypt>::handle_output(ACE_HANDLE)
     if (closing_)
         return -1;
 
-    const size_t send_len = m_OutBuffer->length();
+    const size_t send_len = m_OutBuffer->length() + m_SharedContentsSize;
 
     if (send_len == 0)
         return cancel_wakeup_output(Guard);
 
+    ssize_t n;
+    if (m_SharedContents.empty())
+    {
 #ifdef MSG_NOSIGNAL
-    ssize_t n = peer().send(m_OutBuffer->rd_ptr(), send_len, MSG_NOSIGNAL);
+        n = peer().send(m_OutBuffer->rd_ptr(), send_len, MSG_NOSIGNAL);
 #else
-    ssize_t n = peer().send(m_OutBuffer->rd_ptr(), send_len);
+        n = peer().send(m_OutBuffer->rd_ptr(), send_len);
 #endif // MSG_NOSIGNAL
+    }
+    else
+        n = SendGathered();
 
     if (n == 0)
         return -1;
@@ -232,7 +248,7 @@ int MangosSocket<SessionType, SocketName, Crypt>::handle_output(ACE_HANDLE)
     }
     else if (n < (ssize_t)send_len) //now n > 0
     {
-        m_OutBuffer->rd_ptr(static_cast<size_t>(n));
+        ConsumeOutput(static_cast<size_t>(n));
 
         // move the data to the base of the buffer
         m_OutBuffer->crunch();
@@ -241,6 +257,7 @@ int MangosSocket<SessionType, SocketName, Crypt>::handle_output(ACE_HANDLE)
     }
     else //now n == send_len
     {
+        ConsumeOutput(send_len);
         m_OutBuffer->reset();
 
         if (!iFlushPacketQueue())
@@ -282,7 +299,7 @@ int MangosSocket<SessionType, SocketName, Crypt>::Update(void)
     if (closing_)
         return -1;
 
-    if (m_OutActive || m_OutBuffer->length() == 0)
+    if (m_OutActive || m_OutBuffer->length() + m_SharedContentsSize == 0)
         return 0;
 
     return handle_output(get_handle());
@@ -482,59 +499,154 @@ int MangosSocket<SessionType, SocketName, Crypt>::schedule_wakeup_output(GuardTy
 }
 
 template <typename SessionType, typename SocketName, typename Crypt>
-int MangosSocket<SessionType, SocketName, Crypt>::iSendPacket(const WorldPacket& pct)
+int MangosSocket<SessionType, SocketName, Crypt>::iSendPacket(const WorldPacket& pct, const SharedWorldPacketPtr* shared)
 {
-    if (m_OutBuffer->space() < pct.size() + sizeof(ServerPktHeader))
+    typedef typename SocketName::OutHeader HeaderType;
+
+    const size_t size = pct.size();
+
+    // Large shared contents are written from the packet itself
+    const bool copy = !shared || size < SHARED_CONTENT_MIN_SIZE;
+
+    if (m_OutBuffer->space() < sizeof(HeaderType) + (copy ? size : 0) ||
+        m_OutBuffer->length() + m_SharedContentsSize + sizeof(HeaderType) + size > m_OutBufferSize)
     {
         errno = ENOBUFS;
         return -1;
     }
 
-    ServerPktHeader header;
+    HeaderType header;
+    ((SocketName*)this)->BuildHeader(header, pct.GetOpcode(), size);
+
+    if (m_OutBuffer->copy((char*) & header, sizeof(header)) == -1)
+        ACE_ASSERT(false);
+
+    if (size == 0)
+        return 0;
+
+    if (copy)
+    {
+        if (m_OutBuffer->copy((char*) pct.contents(), size) == -1)
+            ACE_ASSERT(false);
+
+        return 0;
+    }
+
+    SharedContent content;
+    content.packet = *shared;
+    content.bufferPos = m_OutBufferSent + m_OutBuffer->length();
+    content.sent = 0;
+    m_SharedContents.push_back(content);
+    m_SharedContentsSize += size;
 
-    header.cmd = pct.GetOpcode();
+    return 0;
+}
+
+template <typename SessionType, typename SocketName, typename Crypt>
+void MangosSocket<SessionType, SocketName, Crypt>::BuildHeader(OutHeader& header, const uint16 opcode, const size_t size)
+{
+    header.cmd = opcode;
 
-    header.size = (uint16) pct.size() + 2;
+    header.size = (uint16) size + 2;
 
     EndianConvertReverse(header.size);
     EndianConvert(header.cmd);
 
     m_Crypt.EncryptSend((uint8*) & header, sizeof(header));
+}
 
-    if (m_OutBuffer->copy((char*) & header, sizeof(header)) == -1)
-        ACE_ASSERT(false);
+template <typename SessionType, typename SocketName, typename Crypt>
+ssize_t MangosSocket<SessionType, SocketName, Crypt>::SendGathered()
+{
+    iovec iov[MAX_GATHERED_WRITE];
+    int count = 0;
 
-    if (!pct.empty())
-        if (m_OutBuffer->copy((char*) pct.contents(), pct.size()) == -1)
-            ACE_ASSERT(false);
+    char* buffer = m_OutBuffer->rd_ptr();
+    uint64 bufferPos = m_OutBufferSent;
+    size_t bufferLeft = m_OutBuffer->length();
 
-    return 0;
+    typename std::deque<SharedContent>::const_iterator itr = m_SharedContents.begin();
+    for (; itr != m_SharedContents.end() && count + 2 <= MAX_GATHERED_WRITE; ++itr)
+    {
+        // The headers (and small packets) written before this content
+        if (const size_t before = static_cast<size_t>(itr->bufferPos - bufferPos))
+        {
+            iov[count].iov_base = buffer;
+            iov[count].iov_len = before;
+            ++count;
+
+            buffer += before;
+            bufferPos += before;
+            bufferLeft -= before;
+        }
+
+        iov[count].iov_base = (char*) itr->packet->contents() + itr->sent;
+        iov[count].iov_len = itr->packet->size() - itr->sent;
+        ++count;
+    }
+
+    // The rest of the buffer, only when it follows the last content written
+    if (itr == m_SharedContents.end() && bufferLeft > 0)
+    {
+        iov[count].iov_base = buffer;
+        iov[count].iov_len = bufferLeft;
+        ++count;
+    }
+
+#ifdef MSG_NOSIGNAL
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = iov;
+    message.msg_iovlen = count;
+    return ACE_OS::sendmsg(get_handle(), &message, MSG_NOSIGNAL);
+#else
+    return peer().sendv(iov, count);
+#endif // MSG_NOSIGNAL
+}
+
+template <typename SessionType, typename SocketName, typename Crypt>
+void MangosSocket<SessionType, SocketName, Crypt>::ConsumeOutput(size_t size)
+{
+    while (size > 0)
+    {
+        // Bytes of the buffer before the next shared content
+        size_t buffered = m_OutBuffer->length();
+        if (!m_SharedContents.empty())
+            buffered = std::min(buffered, static_cast<size_t>(m_SharedContents.front().bufferPos - m_OutBufferSent));
+
+        const size_t fromBuffer = std::min(size, buffered);
+        m_OutBuffer->rd_ptr(fromBuffer);
+        m_OutBufferSent += fromBuffer;
+        size -= fromBuffer;
+
+        if (size == 0)
+            break;
+
+        MANGOS_ASSERT(!m_SharedContents.empty());
+        SharedContent& content = m_SharedContents.front();
+        const size_t fromContent = std::min(size, content.packet->size() - content.sent);
+        content.sent += fromContent;
+        m_SharedContentsSize -= fromContent;
+        size -= fromContent;
+
+        if (content.sent == content.packet->size())
+            m_SharedContents.pop_front();
+    }
 }
 
 template <typename SessionType, typename SocketName, typename Crypt>
 bool MangosSocket<SessionType, SocketName, Crypt>::iFlushPacketQueue()
 {
-    WorldPacket *pct;
     bool haveone = false;
 
-    while (m_PacketQueue.dequeue_head(pct) == 0)
+    while (!m_PacketQueue.empty())
     {
-        if (((SocketName*)this)->iSendPacket(*pct) == -1)
-        {
-            if (m_PacketQueue.enqueue_head(pct) == -1)
-            {
-                delete pct;
-                sLog.outError("MangosSocket<SessionType, SocketName, Crypt>::iFlushPacketQueue m_PacketQueue->enqueue_head");
-                return false;
-            }
-
+        const SharedWorldPacketPtr& pct = m_PacketQueue.front();
+        if (iSendPacket(*pct, &pct) == -1)
             break;
-        }
-        else
-        {
-            haveone = true;
-            delete pct;
-        }
+
+        haveone = true;
+        m_PacketQueue.pop_front();
     }
 
     return haveone;
@@ -19,15 +19,135 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include "MemoryManagement.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    // Constant initialized: readable by operator new before any constructor ran
+    thread_local std::atomic<uint64>* t_allocations = nullptr;
+
+    struct Registry
+    {
+        Registry() : ended(0) {}
+
+        std::mutex lock;
+        std::vector<std::atomic<uint64>*> threads;
+        uint64 ended;                                       // allocations of the threads ended
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    struct ThreadRegistration
+    {
+        ~ThreadRegistration()
+        {
+            std::atomic<uint64>* allocations = t_allocations;
+            t_allocations = nullptr;
+
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> guard(registry.lock);
+            registry.ended += allocations->load(std::memory_order_relaxed);
+            for (std::vector<std::atomic<uint64>*>::iterator itr = registry.threads.begin(); itr != registry.threads.end(); ++itr)
+            {
+                if (*itr == allocations)
+                {
+                    registry.threads.erase(itr);
+                    break;
+                }
+            }
+            delete allocations;
+        }
+    };
+
+    inline void CountAllocation()
+    {
+        // Only written by its thread
+        if (std::atomic<uint64>* allocations = t_allocations)
+            allocations->store(allocations->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+bool HeapAllocationCounter::IsEnabled()
+{
+    return true;
+}
+
+void HeapAllocationCounter::CountCurrentThread()
+{
+    if (t_allocations)
+        return;
+
+    std::atomic<uint64>* allocations = new std::atomic<uint64>(0);
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+        registry.threads.push_back(allocations);
+    }
+    static thread_local ThreadRegistration registration;
+    t_allocations = allocations;
+}
+
+uint64 HeapAllocationCounter::GetAllocations()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+    uint64 total = registry.ended;
+    for (std::vector<std::atomic<uint64>*>::const_iterator itr = registry.threads.begin(); itr != registry.threads.end(); ++itr)
+        total += (*itr)->load(std::memory_order_relaxed);
+    return total;
+}
+
+#else
+
+inline void CountAllocation() {}
+
+bool HeapAllocationCounter::IsEnabled()
+{
+    return false;
+}
+
+void HeapAllocationCounter::CountCurrentThread()
+{
+}
+
+uint64 HeapAllocationCounter::GetAllocations()
+{
+    return 0;
+}
+
+#endif
+
 //lets use Intel scalable_allocator by default and
 //switch to OS specific allocator only when _STANDARD_MALLOC is defined
-#ifndef USE_STANDARD_MALLOC
+//(the operators are still replaced to count the allocations)
+#if !defined(USE_STANDARD_MALLOC) || defined(COUNT_HEAP_ALLOCATIONS)
 
+#ifndef USE_STANDARD_MALLOC
 #include "tbb/scalable_allocator.h"
+#define MANGOS_MALLOC(sz)   scalable_malloc(sz)
+#define MANGOS_FREE(ptr)    scalable_free(ptr)
+#else
+#define MANGOS_MALLOC(sz)   malloc((sz) ? (sz) : 1)
+#define MANGOS_FREE(ptr)    free(ptr)
+#endif
 
 void* operator new(size_t sz)
 {
-    void *res = scalable_malloc(sz);
+    CountAllocation();
+    void *res = MANGOS_MALLOC(sz);
 
     if (res == NULL)
         throw std::bad_alloc();
@@ -37,7 +157,8 @@ void* operator new(size_t sz)
 
 void* operator new[](size_t sz)
 {
-    void *res = scalable_malloc(sz);
+    CountAllocation();
+    void *res = MANGOS_MALLOC(sz);
 
     if (res == NULL)
         throw std::bad_alloc();
@@ -47,32 +168,34 @@ void* operator new[](size_t sz)
 
 void operator delete(void* ptr) throw()
 {
-    scalable_free(ptr);
+    MANGOS_FREE(ptr);
 }
 
 void operator delete[](void* ptr) throw()
 {
-    scalable_free(ptr);
+    MANGOS_FREE(ptr);
 }
 
 void* operator new(size_t sz, const std::nothrow_t&) throw()
 {
-    return scalable_malloc(sz);
+    CountAllocation();
+    return MANGOS_MALLOC(sz);
 }
 
 void* operator new[](size_t sz, const std::nothrow_t&) throw()
 {
-    return scalable_malloc(sz);
+    CountAllocation();
+    return MANGOS_MALLOC(sz);
 }
 
 void operator delete(void* ptr, const std::nothrow_t&) throw()
 {
-    scalable_free(ptr);
+    MANGOS_FREE(ptr);
 }
 
 void operator delete[](void* ptr, const std::nothrow_t&) throw()
 {
-    scalable_free(ptr);
+    MANGOS_FREE(ptr);
 }
 
 #endif
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_MEMORYMANAGEMENT_H
+#define MANGOS_MEMORYMANAGEMENT_H
+
+#include "Platform/Define.h"
+
+/**
+ * Heap allocations made by the threads registered with CountCurrentThread(). Only counted when the
+ * server is built with COUNT_HEAP_ALLOCATIONS, by the global operator new: each thread increments
+ * its own counter, and the counters are only summed when read. In the other builds, IsEnabled()
+ * is false and the count stays 0.
+ */
+class HeapAllocationCounter
+{
+    public:
+        static bool IsEnabled();
+
+        // Calling thread, once: its allocations are counted until it ends
+        static void CountCurrentThread();
+
+        // All the threads registered, the ended ones included
+        static uint64 GetAllocations();
+};
+
+#endif
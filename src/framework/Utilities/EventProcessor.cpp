@@ -21,6 +21,8 @@
 #include "EventProcessor.h"
 #include "Log.h" // Zerix: For MANGOS_ASSERT. No idea.
 
+#include <algorithm>
+
 void BasicEvent::ScheduleAbort()
 {
     MANGOS_ASSERT(IsRunning()
@@ -46,12 +48,10 @@ void EventProcessor::Update(uint32 p_time)
     m_time += p_time;
 
     // main event loop
-    EventList::iterator i;
-    while (((i = m_events.begin()) != m_events.end()) && i->first <= m_time)
+    while (m_queue && m_queue->m_execTime <= m_time)
     {
         // get and remove event from queue
-        BasicEvent* event = i->second;
-        m_events.erase(i);
+        BasicEvent* event = Pop();
 
         if (event->IsRunning())
         {
@@ -84,33 +84,50 @@ void EventProcessor::Update(uint32 p_time)
 
 void EventProcessor::KillAllEvents(bool force)
 {
-    for (auto itr = m_events.begin(); itr != m_events.end();)
+    // In execution order. The events added by Abort() and planned before the event aborted
+    // are kept, as the non-deletable ones when not forcing.
+    BasicEvent* kept = nullptr;
+    bool killing = false;
+    uint64 lastTime = 0;
+    uint64 lastSequence = 0;
+    while (BasicEvent* event = Pop())
     {
+        if (killing && (event->m_execTime < lastTime || (event->m_execTime == lastTime && event->m_sequence < lastSequence)))
+        {
+            event->m_next = kept;
+            kept = event;
+            continue;
+        }
+        killing = true;
+        lastTime = event->m_execTime;
+        lastSequence = event->m_sequence;
+
         // Abort events which weren't aborted already
-        if (!itr->second->IsAborted())
+        if (!event->IsAborted())
         {
-            itr->second->SetAborted();
-            itr->second->Abort(m_time);
+            event->SetAborted();
+            event->Abort(m_time);
         }
 
         // Skip non-deletable events when we are
         // not forcing the event cancellation.
-        if (!force && !itr->second->IsDeletable())
+        if (!force && !event->IsDeletable())
         {
-            ++itr;
+            event->m_next = kept;
+            kept = event;
             continue;
         }
 
-        delete itr->second;
-
-        if (force)
-            ++itr; // Clear the whole container when forcing
-        else
-            itr = m_events.erase(itr);
+        delete event;
     }
 
-    if (force)
-        m_events.clear();
+    // Same place in the queue as before
+    while (BasicEvent* event = kept)
+    {
+        kept = event->m_next;
+        event->m_next = nullptr;
+        Push(event);
+    }
 }
 
 void EventProcessor::AddEvent(BasicEvent* Event, uint64 e_time, bool set_addtime)
@@ -118,10 +135,102 @@ void EventProcessor::AddEvent(BasicEvent* Event, uint64 e_time, bool set_addtime
     if (set_addtime)
         Event->m_addTime = m_time;
     Event->m_execTime = e_time;
-    m_events.insert(std::pair<uint64, BasicEvent*>(e_time, Event));
+    Event->m_sequence = m_nextSequence++;
+    Push(Event);
 }
 
 uint64 EventProcessor::CalculateTime(uint64 t_offset) const
 {
     return(m_time + t_offset);
-}
\ No newline at end of file
+}
+
+EventProcessor::EventList EventProcessor::GetEvents() const
+{
+    return EventList(m_queue);
+}
+
+BasicEvent* EventProcessor::Meld(BasicEvent* a, BasicEvent* b)
+{
+    if (Before(b, a))
+        std::swap(a, b);
+
+    b->m_prev = a;
+    b->m_next = a->m_child;
+    if (a->m_child)
+        a->m_child->m_prev = b;
+    a->m_child = b;
+    return a;
+}
+
+BasicEvent* EventProcessor::MergePairs(BasicEvent* first)
+{
+    // Melds the children two by two, then the pairs from the last one
+    BasicEvent* pairs = nullptr;
+    while (first)
+    {
+        BasicEvent* heap = first;
+        first = first->m_next;
+        if (first)
+        {
+            BasicEvent* second = first;
+            first = first->m_next;
+            heap = Meld(heap, second);
+        }
+        heap->m_next = pairs;
+        pairs = heap;
+    }
+
+    BasicEvent* root = pairs;
+    if (!root)
+        return nullptr;
+
+    for (BasicEvent* heap = root->m_next; heap;)
+    {
+        BasicEvent* next = heap->m_next;
+        root = Meld(root, heap);
+        heap = next;
+    }
+    root->m_next = nullptr;
+    root->m_prev = nullptr;
+    return root;
+}
+
+void EventProcessor::Push(BasicEvent* event)
+{
+    event->m_child = nullptr;
+    event->m_next = nullptr;
+    event->m_prev = nullptr;
+    m_queue = m_queue ? Meld(m_queue, event) : event;
+}
+
+BasicEvent* EventProcessor::Pop()
+{
+    BasicEvent* event = m_queue;
+    if (!event)
+        return nullptr;
+
+    m_queue = MergePairs(event->m_child);
+    event->m_child = nullptr;
+    return event;
+}
+
+EventProcessor::EventList::const_iterator& EventProcessor::EventList::const_iterator::operator++()
+{
+    // Preorder
+    if (m_event->m_child)
+    {
+        m_event = m_event->m_child;
+        return *this;
+    }
+
+    while (m_event && !m_event->m_next)
+    {
+        // Up to the parent, from the first child
+        while (m_event->m_prev && m_event->m_prev->m_child != m_event)
+            m_event = m_event->m_prev;
+        m_event = m_event->m_prev;
+    }
+    if (m_event)
+        m_event = m_event->m_next;
+    return *this;
+}
@@ -22,7 +22,8 @@
 #define __EVENTPROCESSOR_H
 
 #include "Platform/Define.h"
-#include <map>
+#include <cstddef>
+#include <iterator>
 
 class EventProcessor;
 
@@ -41,7 +42,8 @@ class BasicEvent
 
     public:
         BasicEvent()
-          : m_abortState(AbortState::STATE_RUNNING), m_addTime(0), m_execTime(0) { }
+          : m_abortState(AbortState::STATE_RUNNING), m_addTime(0), m_execTime(0),
+            m_sequence(0), m_child(nullptr), m_next(nullptr), m_prev(nullptr) { }
 
         virtual ~BasicEvent() { }                           // override destructor to perform some actions on event removal
 
@@ -68,14 +70,26 @@ class BasicEvent
         // these can be used for time offset control
         uint64 m_addTime;                                   // time when the event was added to queue, filled by event handler
         uint64 m_execTime;                                  // planned time of next execution, filled by event handler
-};
 
-typedef std::multimap<uint64, BasicEvent*> EventList;
+        // Queue of the event processor
+        uint64 m_sequence;                                  // adding order, for the events planned at the same time
+        BasicEvent* m_child;                                // first event of the subheap
+        BasicEvent* m_next;                                 // next sibling
+        BasicEvent* m_prev;                                 // previous sibling, or parent for the first child
+};
 
+/*
+ * Events are queued in an intrusive pairing heap, ordered by execution time then adding
+ * order: adding an event is O(1) and allocates nothing, and an update without due event only
+ * reads the first one. Each unit has its own processor with a few events, so the processor
+ * is kept small.
+ */
 class EventProcessor
 {
     public:
-        EventProcessor() : m_time(0) { }
+        class EventList;
+
+        EventProcessor() : m_time(0), m_nextSequence(0), m_queue(nullptr) { }
         ~EventProcessor();
 
         void Update(uint32 p_time);
@@ -84,12 +98,59 @@ class EventProcessor
         uint64 CalculateTime(uint64 t_offset) const;
 
         // Zerix: Nostalrius compatibility. Figure a better way to handle this.
-        bool HasScheduledEvent() const { return m_events.empty() ? false : true; }
-        EventList const& GetEvents() const { return m_events; }
+        bool HasScheduledEvent() const { return m_queue != nullptr; }
+        // Queued events, in no particular order. Events added while iterating may be skipped.
+        EventList GetEvents() const;
+
+    private:
+        static bool Before(BasicEvent const* a, BasicEvent const* b)
+        {
+            return a->m_execTime < b->m_execTime || (a->m_execTime == b->m_execTime && a->m_sequence < b->m_sequence);
+        }
+        // Heaps are given by their first event, the other one becomes its child
+        static BasicEvent* Meld(BasicEvent* a, BasicEvent* b);
+        // Children of a removed event, linked by m_next, into one heap
+        static BasicEvent* MergePairs(BasicEvent* first);
+
+        void Push(BasicEvent* event);                       // m_sequence already set
+        BasicEvent* Pop();
 
     protected:
         uint64 m_time;
-        EventList m_events;
+        uint64 m_nextSequence;
+        BasicEvent* m_queue;                                // next event to execute
+};
+
+class EventProcessor::EventList
+{
+    public:
+        class const_iterator
+        {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef BasicEvent* value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef BasicEvent* const* pointer;
+                typedef BasicEvent* reference;
+
+                explicit const_iterator(BasicEvent* event) : m_event(event) { }
+
+                BasicEvent* operator*() const { return m_event; }
+                const_iterator& operator++();
+                bool operator==(const_iterator const& other) const { return m_event == other.m_event; }
+                bool operator!=(const_iterator const& other) const { return m_event != other.m_event; }
+
+            private:
+                BasicEvent* m_event;
+        };
+
+        explicit EventList(BasicEvent* queue) : m_queue(queue) { }
+
+        const_iterator begin() const { return const_iterator(m_queue); }
+        const_iterator end() const { return const_iterator(nullptr); }
+
+    private:
+        BasicEvent* m_queue;
 };
 
-#endif
\ No newline at end of file
+#endif
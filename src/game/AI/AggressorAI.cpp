@@ -66,6 +66,11 @@ AggressorAI::MoveInLineOfSight(Unit *u)
     }
 }
 
+float
+AggressorAI::GetMoveInLineOfSightReach(Unit const* who) const
+{
+    return m_creature->GetAttackDistance(who);
+}
 
 void
 AggressorAI::UpdateAI(const uint32 /*diff*/)
@@ -33,6 +33,7 @@ class MANGOS_DLL_DECL AggressorAI : public CreatureAI
         explicit AggressorAI(Creature *c);
 
         void MoveInLineOfSight(Unit *);
+        float GetMoveInLineOfSightReach(Unit const* who) const;
         void AttackStart(Unit *);
 
         void UpdateAI(const uint32);
@@ -28,6 +28,7 @@
 #include "Dynamic/ObjectRegistry.h"
 #include "Dynamic/FactoryHolder.h"
 #include "ObjectGuid.h"
+#include "AggroScan.h"
 
 #include "Utilities/EventMap.h"
 
@@ -87,6 +88,10 @@ class MANGOS_DLL_SPEC CreatureAI
         // Called if IsVisible(Unit *who) is true at each *who move, reaction at visibility zone enter
         virtual void MoveInLineOfSight(Unit *) {}
 
+        // Farthest distance at which MoveInLineOfSight reacts to who, negative when it can react
+        // anywhere in the relocation notify radius. The creatures farther are not checked.
+        virtual float GetMoveInLineOfSightReach(Unit const* /*who*/) const { return -1.0f; }
+
         // Called for reaction at enter to combat if not in combat yet (enemy can be NULL)
         virtual void EnterCombat(Unit* /*enemy*/) {}
 
@@ -217,6 +222,11 @@ class MANGOS_DLL_SPEC CreatureAI
     protected:
         bool m_bUseAiAtControl;
         uint32 m_uLastAlertTime;
+
+    private:
+        friend class AggroScan;
+
+        AggroPairChecks m_moveLosChecks;
 };
 
 struct SelectableAI : FactoryHolder<CreatureAI>, Permissible<Creature>
@@ -104,6 +104,10 @@ CreatureEventAI::CreatureEventAI(Creature *c) : CreatureAI(c)
         sLog.outError("CreatureEventAI: EventMap for Creature %u is empty but creature is using CreatureEventAI.", m_creature->GetEntry());
 
     m_bEmptyList = m_CreatureEventAIList.empty();
+    m_MaxOOCLosRange = 0.0f;
+    for (CreatureEventAIList::const_iterator i = m_CreatureEventAIList.begin(); i != m_CreatureEventAIList.end(); ++i)
+        if ((*i).Event.event_type == EVENT_T_OOC_LOS)
+            m_MaxOOCLosRange = std::max(m_MaxOOCLosRange, float((*i).Event.ooc_los.maxRange));
     m_Phase = 0;
     m_CombatMovementEnabled = true;
     m_MeleeEnabled = true;
@@ -1070,6 +1074,14 @@ void CreatureEventAI::AttackStart(Unit *who)
     }
 }
 
+float CreatureEventAI::GetMoveInLineOfSightReach(Unit const* who) const
+{
+    if (m_creature->GetCreatureInfo()->flags_extra & CREATURE_FLAG_EXTRA_NO_AGGRO || m_creature->IsNeutralToAll())
+        return m_MaxOOCLosRange;
+
+    return std::max(m_MaxOOCLosRange, m_creature->GetAttackDistance(who));
+}
+
 void CreatureEventAI::MoveInLineOfSight(Unit *who)
 {
     if (!who)
@@ -621,6 +621,7 @@ class MANGOS_DLL_SPEC CreatureEventAI : public CreatureAI
         void JustSummoned(Creature* pUnit) override;
         void AttackStart(Unit *who) override;
         void MoveInLineOfSight(Unit *who) override;
+        float GetMoveInLineOfSightReach(Unit const* who) const override;
         void SpellHit(Unit* pUnit, const SpellEntry* pSpell) override;
         void DamageTaken(Unit* done_by, uint32& damage) override;
         void UpdateAI(const uint32 diff) override;
@@ -660,6 +661,7 @@ class MANGOS_DLL_SPEC CreatureEventAI : public CreatureAI
         float  m_AttackDistance;                            // Distance to attack from
         float  m_AttackAngle;                               // Angle of attack
         uint32 m_InvinceabilityHpLevel;                     // Minimal health level allowed at damage apply
+        float  m_MaxOOCLosRange;                            // Farthest range of the EVENT_T_OOC_LOS events
 };
 
 #endif
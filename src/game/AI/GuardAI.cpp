@@ -55,6 +55,11 @@ void GuardAI::MoveInLineOfSight(Unit *u)
     }
 }
 
+float GuardAI::GetMoveInLineOfSightReach(Unit const* who) const
+{
+    return m_creature->GetAttackDistance(who);
+}
+
 bool GuardAI::IsVisible(Unit *pl) const
 {
     return m_creature->IsWithinDist(pl, sWorld.getConfig(CONFIG_FLOAT_SIGHT_GUARDER))
@@ -33,6 +33,7 @@ class MANGOS_DLL_DECL GuardAI : public CreatureAI
         explicit GuardAI(Creature *c);
 
         void MoveInLineOfSight(Unit *) override;
+        float GetMoveInLineOfSightReach(Unit const* who) const override;
         void AttackStart(Unit *) override;
         void JustDied(Unit *) override;
         bool IsVisible(Unit *) const override;
@@ -36,6 +36,7 @@ class MANGOS_DLL_DECL PetAI : public CreatureAI
         explicit PetAI(Creature *c);
 
         void MoveInLineOfSight(Unit *) {}
+        float GetMoveInLineOfSightReach(Unit const*) const { return 0.0f; }
         void EnterEvadeMode() {}
 
         void KilledUnit(Unit* /*victim*/);
@@ -34,6 +34,7 @@ class MANGOS_DLL_DECL ReactorAI : public CreatureAI
         explicit ReactorAI(Creature *c) : CreatureAI(c) {}
 
         void MoveInLineOfSight(Unit *);
+        float GetMoveInLineOfSightReach(Unit const*) const { return 0.0f; }
         void AttackStart(Unit *);
         void EnterEvadeMode();
 
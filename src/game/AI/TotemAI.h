@@ -41,6 +41,7 @@ class MANGOS_DLL_DECL TotemAI : public CreatureAI
         explicit TotemAI(Creature *c);
 
         void MoveInLineOfSight(Unit *);
+        float GetMoveInLineOfSightReach(Unit const*) const { return 0.0f; }
         void AttackStart(Unit *);
 
         void UpdateAI(const uint32);
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AsyncTaskExecutor.h"
+#include "Database/DatabaseEnv.h"
+#include "Timer.h"
+
+AsyncTaskExecutor::AsyncTaskExecutor() : m_nextSequence(0), m_runningBoundTasks(0), m_windowOpen(false), m_stop(false)
+{
+    for (uint32 type = 0; type < MAX_ASYNC_TASK_TYPES; ++type)
+    {
+        m_stats[type].executed = 0;
+        m_stats[type].runTimeMs = 0;
+        for (uint32 i = 0; i < LATENCY_BUCKETS; ++i)
+            m_stats[type].latency[i] = 0;
+    }
+}
+
+AsyncTaskExecutor::~AsyncTaskExecutor()
+{
+    Stop();
+}
+
+void AsyncTaskExecutor::Start(uint32 threads)
+{
+    m_stop = false;
+    for (uint32 i = 0; i < threads; ++i)
+        m_threads.push_back(std::thread(&AsyncTaskExecutor::Work, this));
+}
+
+void AsyncTaskExecutor::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stop = true;
+        m_taskCond.notify_all();
+    }
+
+    for (std::vector<std::thread>::iterator itr = m_threads.begin(); itr != m_threads.end(); ++itr)
+        itr->join();
+    m_threads.clear();
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    while (!m_boundTasks.empty())
+    {
+        delete m_boundTasks.top();
+        m_boundTasks.pop();
+    }
+    while (!m_freeTasks.empty())
+    {
+        delete m_freeTasks.top();
+        m_freeTasks.pop();
+    }
+}
+
+void AsyncTaskExecutor::Submit(AsyncTask* task)
+{
+    task->m_queuedTime = WorldTimer::getMSTime();
+
+    // No worker: the task is run by the caller
+    if (m_threads.empty())
+    {
+        Execute(task);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    task->m_sequence = m_nextSequence++;
+    if (task->IsMapUpdateBound())
+    {
+        m_boundTasks.push(task);
+        if (!m_windowOpen)
+            return;
+    }
+    else
+        m_freeTasks.push(task);
+    m_taskCond.notify_one();
+}
+
+void AsyncTaskExecutor::BeginMapUpdateWindow()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_windowOpen = true;
+    if (!m_boundTasks.empty())
+        m_taskCond.notify_all();
+}
+
+void AsyncTaskExecutor::EndMapUpdateWindow()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_windowOpen = false;
+    m_windowCond.wait(guard, [this] { return m_runningBoundTasks == 0; });
+}
+
+uint32 AsyncTaskExecutor::GetQueuedCount() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_boundTasks.size() + m_freeTasks.size();
+}
+
+void AsyncTaskExecutor::GetStats(AsyncTaskType type, TypeStats& stats) const
+{
+    stats.executed = m_stats[type].executed;
+    stats.runTimeMs = m_stats[type].runTimeMs;
+    for (uint32 i = 0; i < LATENCY_BUCKETS; ++i)
+        stats.latency[i] = m_stats[type].latency[i];
+}
+
+char const* AsyncTaskExecutor::GetTypeName(AsyncTaskType type)
+{
+    switch (type)
+    {
+        case ASYNC_TASK_AUCTION_SEARCH: return "auction search";
+        case ASYNC_TASK_WHO_LIST:       return "who list";
+        case ASYNC_TASK_PATHFINDING:    return "pathfinding";
+        case ASYNC_TASK_GRID_PRELOAD:   return "grid preload";
+        default:                        return "other";
+    }
+}
+
+void AsyncTaskExecutor::Work()
+{
+    WorldDatabase.ThreadStart();
+
+    std::unique_lock<std::mutex> guard(m_lock);
+    while (!m_stop)
+    {
+        AsyncTask* task = PopRunnableTask();
+        if (!task)
+        {
+            m_taskCond.wait(guard);
+            continue;
+        }
+
+        bool bound = task->IsMapUpdateBound();
+        if (bound)
+            ++m_runningBoundTasks;
+
+        guard.unlock();
+        Execute(task);
+        guard.lock();
+
+        if (bound && --m_runningBoundTasks == 0)
+            m_windowCond.notify_all();
+    }
+    guard.unlock();
+
+    WorldDatabase.ThreadEnd();
+}
+
+AsyncTask* AsyncTaskExecutor::PopRunnableTask()
+{
+    TaskQueue* queue = nullptr;
+    if (m_windowOpen && !m_boundTasks.empty())
+        queue = &m_boundTasks;
+    if (!m_freeTasks.empty() && (!queue || QueuedTaskOrder()(queue->top(), m_freeTasks.top())))
+        queue = &m_freeTasks;
+    if (!queue)
+        return nullptr;
+
+    AsyncTask* task = queue->top();
+    queue->pop();
+    return task;
+}
+
+void AsyncTaskExecutor::Execute(AsyncTask* task)
+{
+    AsyncTaskType type = task->GetType();
+    uint32 queuedTime = task->m_queuedTime;
+    uint32 startTime = WorldTimer::getMSTime();
+
+    task->run();
+    delete task;
+
+    uint32 now = WorldTimer::getMSTime();
+    uint32 latency = WorldTimer::getMSTimeDiff(queuedTime, now);
+    uint32 bucket = 0;
+    while (bucket + 1 < LATENCY_BUCKETS && latency >= GetLatencyBucketLimit(bucket))
+        ++bucket;
+
+    TypeCounters& stats = m_stats[type < MAX_ASYNC_TASK_TYPES ? type : ASYNC_TASK_OTHER];
+    ++stats.executed;
+    stats.runTimeMs += WorldTimer::getMSTimeDiff(startTime, now);
+    ++stats.latency[bucket];
+}
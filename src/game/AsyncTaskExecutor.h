@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_ASYNCTASKEXECUTOR_H
+#define MANGOS_ASYNCTASKEXECUTOR_H
+
+#include "Common.h"
+#include "Platform/Define.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+enum AsyncTaskType
+{
+    ASYNC_TASK_OTHER            = 0,
+    ASYNC_TASK_AUCTION_SEARCH   = 1,
+    ASYNC_TASK_WHO_LIST         = 2,
+    ASYNC_TASK_PATHFINDING      = 3,
+    ASYNC_TASK_GRID_PRELOAD     = 4,
+    MAX_ASYNC_TASK_TYPES
+};
+
+enum AsyncTaskPriority
+{
+    ASYNC_TASK_PRIORITY_LOW     = 0,
+    ASYNC_TASK_PRIORITY_NORMAL  = 1,
+    ASYNC_TASK_PRIORITY_HIGH    = 2,
+};
+
+class AsyncTask
+{
+public:
+    AsyncTask() : m_queuedTime(0), m_sequence(0) {}
+    virtual ~AsyncTask() {}
+    virtual void run() = 0;
+
+    virtual AsyncTaskType GetType() const { return ASYNC_TASK_OTHER; }
+    virtual AsyncTaskPriority GetPriority() const { return ASYNC_TASK_PRIORITY_NORMAL; }
+    // Tasks reading the world state (sessions, players, auctions ...) only run while
+    // maps are updated. Others may run at any time, and complete across world ticks.
+    virtual bool IsMapUpdateBound() const { return true; }
+
+private:
+    friend class AsyncTaskExecutor;
+    uint32 m_queuedTime;
+    uint64 m_sequence;
+};
+
+/**
+ * Long-lived workers executing the tasks queued by the opcode handlers (AH search, /who ...).
+ * The world opens a window while maps are updated: map-update-bound tasks are only started
+ * inside this window, and closing it waits for the running ones only. Queued tasks are
+ * kept, by priority, for the next window.
+ */
+class AsyncTaskExecutor
+{
+public:
+    // Latency histogram buckets: [0, 1ms[, [1, 2ms[, [2, 4ms[ ... [1024ms, +inf[
+    static const uint32 LATENCY_BUCKETS = 12;
+
+    struct TypeStats
+    {
+        uint64 executed;
+        uint64 runTimeMs;
+        uint64 latency[LATENCY_BUCKETS];                    // queued to completed
+    };
+
+    AsyncTaskExecutor();
+    ~AsyncTaskExecutor();
+
+    void Start(uint32 threads);
+    // Queued tasks are discarded
+    void Stop();
+
+    // Thread safe. The executor takes the ownership of the task.
+    void Submit(AsyncTask* task);
+
+    void BeginMapUpdateWindow();
+    // Blocks until the running map-update-bound tasks are done
+    void EndMapUpdateWindow();
+
+    uint32 GetThreadCount() const { return m_threads.size(); }
+    uint32 GetQueuedCount() const;
+    void GetStats(AsyncTaskType type, TypeStats& stats) const;
+
+    static char const* GetTypeName(AsyncTaskType type);
+    // Upper limit of a latency bucket, in ms (0 for the last, unbounded, bucket)
+    static uint32 GetLatencyBucketLimit(uint32 bucket) { return bucket + 1 < LATENCY_BUCKETS ? 1 << bucket : 0; }
+
+private:
+    AsyncTaskExecutor(AsyncTaskExecutor const&);
+    AsyncTaskExecutor& operator=(AsyncTaskExecutor const&);
+
+    struct QueuedTaskOrder
+    {
+        // Highest priority first, then first in first out
+        bool operator()(AsyncTask const* a, AsyncTask const* b) const
+        {
+            if (a->GetPriority() != b->GetPriority())
+                return a->GetPriority() < b->GetPriority();
+            return a->m_sequence > b->m_sequence;
+        }
+    };
+    typedef std::priority_queue<AsyncTask*, std::vector<AsyncTask*>, QueuedTaskOrder> TaskQueue;
+
+    struct TypeCounters
+    {
+        std::atomic<uint64> executed;
+        std::atomic<uint64> runTimeMs;
+        std::atomic<uint64> latency[LATENCY_BUCKETS];
+    };
+
+    void Work();
+    // Must be called with m_lock held
+    AsyncTask* PopRunnableTask();
+    void Execute(AsyncTask* task);
+
+    std::vector<std::thread> m_threads;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_taskCond;
+    std::condition_variable m_windowCond;
+    TaskQueue m_boundTasks;
+    TaskQueue m_freeTasks;
+    uint64 m_nextSequence;
+    uint32 m_runningBoundTasks;
+    bool m_windowOpen;
+    bool m_stop;
+
+    TypeCounters m_stats[MAX_ASYNC_TASK_TYPES];
+};
+
+#endif
@@ -43,12 +43,14 @@ INSTANTIATE_SINGLETON_1(AuctionHouseMgr);
 
 bool AuctionHouseObject::RemoveAuction(uint32 id)
 {
-    if (AuctionsMap.erase(id))
-    {
-        sObjectMgr.FreeAuctionID(id);
-        return true;
-    }
-    return false;
+    AuctionEntryMap::iterator itr = AuctionsMap.find(id);
+    if (itr == AuctionsMap.end())
+        return false;
+
+    m_searchIndex.RemoveAuction(itr->second);
+    AuctionsMap.erase(itr);
+    sObjectMgr.FreeAuctionID(id);
+    return true;
 }
 
 AuctionHouseMgr::AuctionHouseMgr()
@@ -604,8 +606,11 @@ void AuctionHouseObject::Update()
     AuctionEntryMap::iterator next;
     for (AuctionEntryMap::iterator itr = AuctionsMap.begin(); itr != AuctionsMap.end(); itr = next)
     {
-        if (itr->second->depositTime + 5*60 < curTime) // Locked for 5 minutes on IP to prevent AH snipping
+        if (itr->second->depositTime + 5*60 < curTime && !itr->second->lockedIpAddress.empty()) // Locked for 5 minutes on IP to prevent AH snipping
+        {
+            m_searchIndex.ClearIpLock(itr->second);
             itr->second->lockedIpAddress.clear();
+        }
 
         next = itr;
         ++next;
@@ -637,8 +642,9 @@ void AuctionHouseObject::Update()
             ///- In any case clear the auction
             itr->second->DeleteFromDB();
             sAuctionMgr.RemoveAItem(itr->second->itemGuidLow);
-            delete itr->second;
-            RemoveAuction(itr->first);
+            AuctionEntry* auction = itr->second;
+            RemoveAuction(itr->first);                      // the search index still needs the entry
+            delete auction;
         }
     }
 }
@@ -678,96 +684,15 @@ void AuctionHouseObject::BuildListAuctionItems(WorldPacket& data, Player* player
         AuctionHouseClientQuery const& query,
         uint32& count, uint32& totalcount)
 {
-    // Happening often, and easy to deal with
-    if (query.auctionMainCategory == 0xffffffff && query.auctionSubCategory == 0xffffffff && query.auctionSlotID == 0xffffffff &&
-        query.quality == 0xffffffff && query.levelmin == 0x00 && query.levelmax == 0x00 && query.usable == 0x00 && query.wsearchedname.empty())
-    {
-        totalcount = AuctionsMap.size();
-        if (query.listfrom < totalcount)
-        {
-            AuctionEntryMap::iterator itr = AuctionsMap.begin();
-            std::advance(itr, query.listfrom);
-            for (; itr != AuctionsMap.end(); ++itr)
-            {
-                itr->second->BuildAuctionInfo(data);
-                if ((++count) >= 50)
-                    break;
-            }
-        }
-        return;
-    }
-
-    time_t currTime = sWorld.GetGameTime();
+    std::vector<AuctionEntry*> page;
+    page.reserve(50);
     std::string const& clientIp = player->GetSession()->GetRemoteAddress();
     int loc_idx = player->GetSession()->GetSessionDbLocaleIndex();
+    totalcount = m_searchIndex.Search(query, player, clientIp, loc_idx, 50, page);
 
-    for (AuctionEntryMap::const_iterator itr = AuctionsMap.begin(); itr != AuctionsMap.end(); ++itr)
-    {
-        AuctionEntry *Aentry = itr->second;
-        Item *item = sAuctionMgr.GetAItem(Aentry->itemGuidLow);
-        if (!item)
-            continue;
-
-        {
-            ItemPrototype const *proto = item->GetProto();
-
-            if (query.auctionMainCategory != 0xffffffff && proto->Class != query.auctionMainCategory)
-                continue;
-
-            if (query.auctionSubCategory != 0xffffffff && proto->SubClass != query.auctionSubCategory)
-                continue;
-
-            if (query.auctionSlotID != 0xffffffff && proto->InventoryType != query.auctionSlotID)
-                continue;
-
-            if (query.quality != 0xffffffff && proto->Quality < query.quality)
-                continue;
-
-            if (query.levelmin != 0x00 && (proto->RequiredLevel < query.levelmin || (query.levelmax != 0x00 && proto->RequiredLevel > query.levelmax)))
-                continue;
-
-            if (query.usable != 0x00 && player->CanUseItem(item) != EQUIP_ERR_OK)
-                continue;
-
-            if (query.usable != 0x00 && proto->Class == ITEM_CLASS_RECIPE)
-                if (SpellEntry const* spell = sSpellMgr.GetSpellEntry(proto->Spells[0].SpellId))
-                    if (player->HasSpell(spell->EffectTriggerSpell[EFFECT_INDEX_0]))
-                        continue;
-
-            // IP locked auction
-            if (!Aentry->lockedIpAddress.empty() && Aentry->lockedIpAddress != clientIp)
-                continue;
-
-            if (!query.wsearchedname.empty())
-            {
-                std::string name = proto->Name1;
-                if (name.empty())
-                    continue;
-
-                // local name
-                if (loc_idx >= 0)
-                {
-                    ItemLocale const *il = sObjectMgr.GetItemLocale(proto->ItemId);
-                    if (il)
-                    {
-                        if (il->Name.size() > size_t(loc_idx) && !il->Name[loc_idx].empty())
-                            name = il->Name[loc_idx];
-                    }
-                }
-
-                if (!Utf8FitTo(name, query.wsearchedname))
-                    continue;
-            }
-
-            if (count < 50 && totalcount >= query.listfrom)
-            {
-                ++count;
-                Aentry->BuildAuctionInfo(data);
-            }
-        }
-
-        ++totalcount;
-    }
+    for (std::vector<AuctionEntry*>::const_iterator itr = page.begin(); itr != page.end(); ++itr)
+        if ((*itr)->BuildAuctionInfo(data))
+            ++count;
 }
 
 // this function inserts to WorldPacket auction's data
@@ -29,6 +29,7 @@
 #include "Policies/Singleton.h"
 #include "DBCStructure.h"
 #include "Log.h"
+#include "AuctionHouseSearchIndex.h"
 
 class Item;
 class Player;
@@ -97,7 +98,8 @@ struct AuctionHouseClientQuery
 class AuctionHouseObject
 {
     public:
-        AuctionHouseObject() {}
+        // The search index of a synthetic house lists the auctions without item instance
+        explicit AuctionHouseObject(bool checkItems = true) : m_searchIndex(checkItems) {}
         ~AuctionHouseObject()
         {
             for (AuctionEntryMap::const_iterator itr = AuctionsMap.begin(); itr != AuctionsMap.end(); ++itr)
@@ -113,7 +115,11 @@ class AuctionHouseObject
         void AddAuction(AuctionEntry *ah)
         {
             MANGOS_ASSERT( ah );
-            AuctionsMap[ah->Id] = ah;
+            AuctionEntry*& entry = AuctionsMap[ah->Id];
+            if (entry)
+                m_searchIndex.RemoveAuction(entry);
+            entry = ah;
+            m_searchIndex.AddAuction(ah);
         }
 
         AuctionEntry* GetAuction(uint32 id) const
@@ -131,8 +137,10 @@ class AuctionHouseObject
         void BuildListAuctionItems(WorldPacket& data, Player* player,
                 AuctionHouseClientQuery const& query,
             uint32& count, uint32& totalcount);
+        AuctionHouseSearchIndex const& GetSearchIndex() const { return m_searchIndex; }
     private:
         AuctionEntryMap AuctionsMap;
+        AuctionHouseSearchIndex m_searchIndex;
 };
 
 class AuctionHouseMgr
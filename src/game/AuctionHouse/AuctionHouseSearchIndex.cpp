@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AuctionHouseSearchIndex.h"
+#include "AuctionHouseMgr.h"
+#include "Item.h"
+#include "ObjectMgr.h"
+#include "Player.h"
+#include "SpellMgr.h"
+#include "Util.h"
+
+namespace
+{
+    bool AuctionIdLess(AuctionEntry const* auction, uint32 id) { return auction->Id < id; }
+
+    std::wstring NormalizeItemName(std::string const& name)
+    {
+        std::wstring wname;
+        if (!Utf8toWStr(name, wname))
+            return std::wstring();
+        wstrToLower(wname);
+        return wname;
+    }
+}
+
+void AuctionHouseSearchIndex::AddAuction(AuctionEntry* auction)
+{
+    ItemPrototype const* proto = ObjectMgr::GetItemPrototype(auction->itemTemplate);
+    if (!proto)
+        return;
+
+    // Not listed by AuctionEntry::BuildAuctionInfo, so not counted either
+    if (m_checkItems && !sAuctionMgr.GetAItem(auction->itemGuidLow))
+        return;
+
+    TemplateMap::iterator itr = m_templates.find(auction->itemTemplate);
+    if (itr == m_templates.end())
+    {
+        itr = m_templates.insert(TemplateMap::value_type(auction->itemTemplate, TemplateEntry())).first;
+        TemplateEntry& entry = itr->second;
+        entry.proto = proto;
+        entry.names.push_back(NormalizeItemName(proto->Name1));
+        if (ItemLocale const* il = sObjectMgr.GetItemLocale(proto->ItemId))
+            for (std::vector<std::string>::const_iterator name = il->Name.begin(); name != il->Name.end(); ++name)
+                entry.names.push_back(NormalizeItemName(*name));
+        IndexTemplate(itr->first, entry, true);
+    }
+
+    std::vector<AuctionEntry*>& auctions = itr->second.auctions;
+    auctions.insert(std::lower_bound(auctions.begin(), auctions.end(), auction->Id, AuctionIdLess), auction);
+    if (!auction->lockedIpAddress.empty())
+        ++itr->second.ipLockedCount;
+}
+
+bool AuctionHouseSearchIndex::FindAuction(AuctionEntry const* auction, TemplateMap::iterator& itr, std::vector<AuctionEntry*>::iterator& pos)
+{
+    itr = m_templates.find(auction->itemTemplate);
+    if (itr == m_templates.end())
+        return false;
+
+    std::vector<AuctionEntry*>& auctions = itr->second.auctions;
+    pos = std::lower_bound(auctions.begin(), auctions.end(), auction->Id, AuctionIdLess);
+    return pos != auctions.end() && *pos == auction;
+}
+
+void AuctionHouseSearchIndex::RemoveAuction(AuctionEntry* auction)
+{
+    TemplateMap::iterator itr;
+    std::vector<AuctionEntry*>::iterator pos;
+    if (!FindAuction(auction, itr, pos))
+        return;
+
+    std::vector<AuctionEntry*>& auctions = itr->second.auctions;
+    auctions.erase(pos);
+    if (!auction->lockedIpAddress.empty())
+        --itr->second.ipLockedCount;
+
+    if (auctions.empty())
+    {
+        IndexTemplate(itr->first, itr->second, false);
+        m_templates.erase(itr);
+    }
+}
+
+void AuctionHouseSearchIndex::ClearIpLock(AuctionEntry* auction)
+{
+    if (auction->lockedIpAddress.empty())
+        return;
+
+    TemplateMap::iterator itr;
+    std::vector<AuctionEntry*>::iterator pos;
+    if (FindAuction(auction, itr, pos) && itr->second.ipLockedCount)
+        --itr->second.ipLockedCount;
+}
+
+uint64 AuctionHouseSearchIndex::MakeTrigramKey(std::wstring const& str, std::size_t pos)
+{
+    return (uint64(str[pos] & 0x1FFFFF) << 42) | (uint64(str[pos + 1] & 0x1FFFFF) << 21) | uint64(str[pos + 2] & 0x1FFFFF);
+}
+
+void AuctionHouseSearchIndex::UpdateIndex(TemplateIndex& index, uint64 key, uint32 itemId, bool add)
+{
+    if (add)
+    {
+        index[key].insert(itemId);
+        return;
+    }
+
+    TemplateIndex::iterator itr = index.find(key);
+    if (itr == index.end())
+        return;
+    itr->second.erase(itemId);
+    if (itr->second.empty())
+        index.erase(itr);
+}
+
+AuctionHouseSearchIndex::TemplateIdSet const* AuctionHouseSearchIndex::FindIndex(TemplateIndex const& index, uint64 key)
+{
+    TemplateIndex::const_iterator itr = index.find(key);
+    return itr != index.end() ? &itr->second : nullptr;
+}
+
+void AuctionHouseSearchIndex::IndexTemplate(uint32 itemId, TemplateEntry const& entry, bool add)
+{
+    UpdateIndex(m_byClass, entry.proto->Class, itemId, add);
+    UpdateIndex(m_bySubClass, MakeSubClassKey(entry.proto->Class, entry.proto->SubClass), itemId, add);
+    UpdateIndex(m_byInventoryType, entry.proto->InventoryType, itemId, add);
+
+    // Trigrams of every localized name: the search does not know the locale of the template names
+    std::set<uint64> trigrams;
+    for (std::vector<std::wstring>::const_iterator name = entry.names.begin(); name != entry.names.end(); ++name)
+        for (std::size_t pos = 0; pos + 3 <= name->size(); ++pos)
+            trigrams.insert(MakeTrigramKey(*name, pos));
+    for (std::set<uint64>::const_iterator trigram = trigrams.begin(); trigram != trigrams.end(); ++trigram)
+        UpdateIndex(m_byNameTrigram, *trigram, itemId, add);
+}
+
+bool AuctionHouseSearchIndex::IsMatching(TemplateEntry const& entry, AuctionHouseClientQuery const& query, Player* player, int locIdx) const
+{
+    ItemPrototype const* proto = entry.proto;
+
+    if (query.auctionMainCategory != 0xffffffff && proto->Class != query.auctionMainCategory)
+        return false;
+
+    if (query.auctionSubCategory != 0xffffffff && proto->SubClass != query.auctionSubCategory)
+        return false;
+
+    if (query.auctionSlotID != 0xffffffff && proto->InventoryType != query.auctionSlotID)
+        return false;
+
+    if (query.quality != 0xffffffff && proto->Quality < query.quality)
+        return false;
+
+    if (query.levelmin != 0x00 && (proto->RequiredLevel < query.levelmin || (query.levelmax != 0x00 && proto->RequiredLevel > query.levelmax)))
+        return false;
+
+    if (query.usable != 0x00 && player)
+    {
+        // Auctioned items of a template only differ by their enchantments
+        Item* item = sAuctionMgr.GetAItem(entry.auctions.front()->itemGuidLow);
+        if (!item || player->CanUseItem(item) != EQUIP_ERR_OK)
+            return false;
+
+        if (proto->Class == ITEM_CLASS_RECIPE)
+            if (SpellEntry const* spell = sSpellMgr.GetSpellEntry(proto->Spells[0].SpellId))
+                if (player->HasSpell(spell->EffectTriggerSpell[EFFECT_INDEX_0]))
+                    return false;
+    }
+
+    if (!query.wsearchedname.empty())
+    {
+        if (entry.names[0].empty())
+            return false;
+
+        std::wstring const* name = &entry.names[0];
+        if (locIdx >= 0 && std::size_t(locIdx) + 1 < entry.names.size() && !entry.names[locIdx + 1].empty())
+            name = &entry.names[locIdx + 1];
+
+        if (name->find(query.wsearchedname) == std::wstring::npos)
+            return false;
+    }
+
+    return true;
+}
+
+uint32 AuctionHouseSearchIndex::Search(AuctionHouseClientQuery const& query, Player* player, std::string const& clientIp,
+    int locIdx, uint32 pageSize, std::vector<AuctionEntry*>& page) const
+{
+    // Start from the smallest index matching the query
+    std::vector<TemplateIdSet const*> indexes;
+    if (query.auctionMainCategory != 0xffffffff)
+    {
+        if (query.auctionSubCategory != 0xffffffff)
+            indexes.push_back(FindIndex(m_bySubClass, MakeSubClassKey(query.auctionMainCategory, query.auctionSubCategory)));
+        else
+            indexes.push_back(FindIndex(m_byClass, query.auctionMainCategory));
+    }
+    if (query.auctionSlotID != 0xffffffff)
+        indexes.push_back(FindIndex(m_byInventoryType, query.auctionSlotID));
+    for (std::size_t pos = 0; pos + 3 <= query.wsearchedname.size(); ++pos)
+        indexes.push_back(FindIndex(m_byNameTrigram, MakeTrigramKey(query.wsearchedname, pos)));
+
+    TemplateIdSet const* candidates = nullptr;
+    for (std::vector<TemplateIdSet const*>::const_iterator itr = indexes.begin(); itr != indexes.end(); ++itr)
+    {
+        if (!*itr)
+            return 0;                                       // nothing in this category, or no name with this trigram
+        if (!candidates || (*itr)->size() < candidates->size())
+            candidates = *itr;
+    }
+
+    uint32 total = 0;
+    if (candidates)
+    {
+        for (TemplateIdSet::const_iterator itr = candidates->begin(); itr != candidates->end(); ++itr)
+        {
+            TemplateMap::const_iterator entry = m_templates.find(*itr);
+            if (entry != m_templates.end() && IsMatching(entry->second, query, player, locIdx))
+                CollectPage(entry->second, clientIp, query.listfrom, pageSize, total, page);
+        }
+    }
+    else
+    {
+        for (TemplateMap::const_iterator entry = m_templates.begin(); entry != m_templates.end(); ++entry)
+            if (IsMatching(entry->second, query, player, locIdx))
+                CollectPage(entry->second, clientIp, query.listfrom, pageSize, total, page);
+    }
+    return total;
+}
+
+void AuctionHouseSearchIndex::CollectPage(TemplateEntry const& entry, std::string const& clientIp, uint32 listfrom, uint32 pageSize,
+    uint32& total, std::vector<AuctionEntry*>& page)
+{
+    // Usual case, the page is taken without looking at the other auctions
+    if (!entry.ipLockedCount)
+    {
+        uint32 count = entry.auctions.size();
+        if (page.size() < pageSize && total + count > listfrom)
+            for (uint32 i = listfrom > total ? listfrom - total : 0; i < count && page.size() < pageSize; ++i)
+                page.push_back(entry.auctions[i]);
+        total += count;
+        return;
+    }
+
+    // IP locked auctions are only visible from the IP of their owner
+    for (std::vector<AuctionEntry*>::const_iterator itr = entry.auctions.begin(); itr != entry.auctions.end(); ++itr)
+    {
+        if (!(*itr)->lockedIpAddress.empty() && (*itr)->lockedIpAddress != clientIp)
+            continue;
+        if (page.size() < pageSize && total >= listfrom)
+            page.push_back(*itr);
+        ++total;
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _AUCTION_HOUSE_SEARCH_INDEX_H
+#define _AUCTION_HOUSE_SEARCH_INDEX_H
+
+#include "Common.h"
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+struct AuctionEntry;
+struct AuctionHouseClientQuery;
+struct ItemPrototype;
+class Player;
+
+/**
+ * Secondary indexes of an auction house, used by the client searches.
+ * Auctions are grouped by item template: every filter of a search except the IP
+ * lock only depends on the template, so a search checks the candidate templates
+ * (picked from the smallest matching index) instead of every auction, and the
+ * requested page is taken directly in the auctions of the matching templates.
+ *
+ * Updated by the world thread only. Searches are read only and may run concurrently.
+ */
+class AuctionHouseSearchIndex
+{
+    public:
+        // Without the item check, for the synthetic houses of the benchmarks: their auctions have no item instance
+        explicit AuctionHouseSearchIndex(bool checkItems = true) : m_checkItems(checkItems) {}
+
+        // The auction previously added with the same id must be removed first
+        void AddAuction(AuctionEntry* auction);
+        void RemoveAuction(AuctionEntry* auction);
+        // Must be called before the IP lock of an auction is removed
+        void ClearIpLock(AuctionEntry* auction);
+
+        // Returns the number of matching auctions, and fills 'page' with at most
+        // pageSize of them, starting from 'listfrom'. Results are ordered by item
+        // template, then by auction id. Without player, usable filter is ignored.
+        uint32 Search(AuctionHouseClientQuery const& query, Player* player, std::string const& clientIp,
+            int locIdx, uint32 pageSize, std::vector<AuctionEntry*>& page) const;
+
+        uint32 GetTemplatesCount() const { return m_templates.size(); }
+
+    private:
+        struct TemplateEntry
+        {
+            TemplateEntry() : proto(nullptr), ipLockedCount(0) {}
+
+            ItemPrototype const* proto;
+            std::vector<std::wstring> names;                // lower case, [0] default then one per locale (may be empty)
+            std::vector<AuctionEntry*> auctions;            // ordered by id
+            uint32 ipLockedCount;
+        };
+
+        typedef std::map<uint32, TemplateEntry> TemplateMap;
+        typedef std::set<uint32> TemplateIdSet;             // ordered, to get stable pages
+        typedef std::unordered_map<uint64, TemplateIdSet> TemplateIndex;
+
+        static uint64 MakeTrigramKey(std::wstring const& str, std::size_t pos);
+        static uint64 MakeSubClassKey(uint32 itemClass, uint32 itemSubClass) { return (uint64(itemClass) << 32) | itemSubClass; }
+
+        bool FindAuction(AuctionEntry const* auction, TemplateMap::iterator& itr, std::vector<AuctionEntry*>::iterator& pos);
+        void IndexTemplate(uint32 itemId, TemplateEntry const& entry, bool add);
+        static void UpdateIndex(TemplateIndex& index, uint64 key, uint32 itemId, bool add);
+        static TemplateIdSet const* FindIndex(TemplateIndex const& index, uint64 key);
+        static void CollectPage(TemplateEntry const& entry, std::string const& clientIp, uint32 listfrom, uint32 pageSize,
+            uint32& total, std::vector<AuctionEntry*>& page);
+        bool IsMatching(TemplateEntry const& entry, AuctionHouseClientQuery const& query, Player* player, int locIdx) const;
+
+        bool const m_checkItems;
+        TemplateMap m_templates;
+        TemplateIndex m_byClass;
+        TemplateIndex m_bySubClass;
+        TemplateIndex m_byInventoryType;
+        TemplateIndex m_byNameTrigram;
+};
+
+#endif
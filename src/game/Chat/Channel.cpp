@@ -721,11 +721,13 @@ void Channel::SetOwner(ObjectGuid guid, bool exclaim)
 
 void Channel::SendToAll(WorldPacket *data, ObjectGuid p)
 {
+    // Shared by the sockets of all the members
+    SharedWorldPacketPtr packet = std::make_shared<WorldPacket>(*data);
     for (PlayerList::const_iterator i = m_players.begin(); i != m_players.end(); ++i)
     {
         if (PlayerPointer plr = GetPlayer(i->first))
             if (!plr->GetSocial()->HasIgnore(p))
-                plr->GetSession()->SendPacket(data);
+                plr->GetSession()->SendPacket(packet);
     }
 }
 
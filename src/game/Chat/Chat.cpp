@@ -255,6 +255,11 @@ ChatCommand * ChatHandler::getCommandTable()
         { NODE, "movemotion",     SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugMoveCommand,                "", nullptr },
         { NODE, "factionchange_items", SEC_ADMINISTRATOR, true, &ChatHandler::HandleFactionChangeItemsCommand,    "", nullptr },
         { NODE, "loottable",      SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleDebugLootTableCommand,           "", nullptr },
+        { NODE, "mapstats",       SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugMapStatsCommand,            "", nullptr },
+        { NODE, "asynctasks",     SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleDebugAsyncTasksCommand,          "", nullptr },
+        { NODE, "auctionbench",   SEC_ADMINISTRATOR,  true,  &ChatHandler::HandleDebugAuctionSearchBenchCommand,  "", nullptr },
+        { NODE, "aggrobench",     SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugAggroScanBenchCommand,      "", nullptr },
+        { NODE, "threatbench",    SEC_ADMINISTRATOR,  false, &ChatHandler::HandleDebugThreatBenchCommand,         "", nullptr },
         { MSTR, nullptr,       0,                  false, nullptr,                                                "", nullptr }
     };
 
@@ -184,6 +184,11 @@ class MANGOS_DLL_SPEC ChatHandler
         bool HandleDebugExp(char* );
         bool HandleVideoTurn(char* );
         bool HandleDebugLootTableCommand(char*);
+        bool HandleDebugMapStatsCommand(char*);
+        bool HandleDebugAsyncTasksCommand(char*);
+        bool HandleDebugAuctionSearchBenchCommand(char*);
+        bool HandleDebugAggroScanBenchCommand(char*);
+        bool HandleDebugThreatBenchCommand(char*);
         bool HandleServiceDeleteCharacters(char* args);
 
         bool HandleSpamerMute(char* args);
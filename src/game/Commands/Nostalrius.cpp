@@ -44,6 +44,7 @@
 // MMAPS
 #include "MoveMap.h"                                        // for mmap manager
 #include "PathFinder.h"                                     // for mmap commands
+#include "PathRequestQueue.h"                               // for mmap stats
 #include "GridNotifiers.h"
 #include "GridNotifiersImpl.h"
 #include "CellImpl.h"
@@ -2033,6 +2034,27 @@ bool ChatHandler::HandleMmapStatsCommand(char* /*args*/)
     MMAP::MMapManager *manager = MMAP::MMapFactory::createOrGetMMapManager();
     PSendSysMessage(" %u maps loaded with %u tiles overall", manager->getLoadedMapsCount(), manager->getLoadedTilesCount());
 
+    uint32 queriesInUse, queriesPooled;
+    manager->GetNavMeshQueryCounts(queriesInUse, queriesPooled);
+    PSendSysMessage(" %u navmesh queries used by %u threads, %u pooled (%.2f MB)", queriesInUse, MMAP::MMapManager::GetNavMeshQueryThreadsCount(),
+        queriesPooled, float(queriesInUse + queriesPooled) * MMAP::MMapManager::GetNavMeshQuerySize() / 1048576);
+
+    PathRequestQueue::Stats pathStats;
+    m_session->GetPlayer()->GetMap()->GetPathRequestQueue()->GetStats(pathStats);
+    PSendSysMessage(" Async paths on current map: %u queued, %u searching, " UI64FMTD " solved by " UI64FMTD " searches, " UI64FMTD " dropped, " UI64FMTD " overflows",
+        pathStats.queued, pathStats.searching, pathStats.solved, pathStats.searches, pathStats.dropped, pathStats.overflows);
+    PSendSysMessage(" Async paths latency: %.1f ms average, %u ms max", pathStats.solved ? float(pathStats.totalLatencyMs) / pathStats.solved : 0.0f, pathStats.maxLatencyMs);
+
+    if (MMAP::PathCorridorCache* corridorCache = manager->GetPathCorridorCache(m_session->GetPlayer()->GetMapId()))
+    {
+        MMAP::PathCorridorCache::Stats cacheStats;
+        corridorCache->GetStats(cacheStats);
+        uint64 lookups = cacheStats.hits + cacheStats.repairs + cacheStats.misses;
+        PSendSysMessage(" Path corridors cache on current map: %u corridors, %.1f%% hit rate (" UI64FMTD " hits, " UI64FMTD " repaired, " UI64FMTD " misses), " UI64FMTD " invalidated",
+            cacheStats.entries, lookups ? 100.0f * (cacheStats.hits + cacheStats.repairs) / lookups : 0.0f,
+            cacheStats.hits, cacheStats.repairs, cacheStats.misses, cacheStats.invalidated);
+    }
+
     const dtNavMesh* navmesh = manager->GetNavMesh(m_session->GetPlayer()->GetMapId());
     if (Transport* transport = m_session->GetPlayer()->GetTransport())
     {
@@ -32,10 +32,20 @@
 #include "Language.h"
 #include "BattleGroundMgr.h"
 #include <fstream>
+#include <memory>
 #include "ObjectMgr.h"
 #include "ObjectGuid.h"
 #include "SpellMgr.h"
 #include "World.h"
+#include "Map.h"
+#include "GridPreloader.h"
+#include "ScratchArena.h"
+#include "Policies/MemoryManagement.h"
+#include "AggroScan.h"
+#include "CellImpl.h"
+#include "AuctionHouseMgr.h"
+#include "GridNotifiers.h"
+#include "GridNotifiersImpl.h"
 
 bool ChatHandler::HandleDebugSendSpellFailCommand(char* args)
 {
@@ -1131,3 +1141,425 @@ bool ChatHandler::HandleDebugSpellModsCommand(char* args)
 
     return true;
 }
+
+bool ChatHandler::HandleDebugMapStatsCommand(char* /*args*/)
+{
+    Map* map = m_session->GetPlayer()->GetMap();
+    PSendSysMessage("Map %u instance %u: update cost %ums, cells update imbalance %u%%",
+        map->GetId(), map->GetInstanceId(), map->GetUpdateCost(), map->GetCellsUpdateImbalance());
+
+    uint64 built = map->GetUpdateBlocksBuilt();
+    uint64 reused = map->GetUpdateBlocksReused();
+    PSendSysMessage("Values update blocks: " UI64FMTD " built, " UI64FMTD " reused (%.1f%%)",
+        built, reused, built + reused ? reused * 100.0f / (built + reused) : 0.0f);
+
+    CompressionStats const& compression = map->GetCompressionStats();
+    uint64 bytesIn = compression.bytesIn;
+    uint64 bytesOut = compression.bytesOut;
+    PSendSysMessage("Compression: " UI64FMTD " packets, " UI64FMTD " bytes in, " UI64FMTD " bytes out (%.1f%%), " UI64FMTD " ms",
+        uint64(compression.packets), bytesIn, bytesOut, bytesIn ? bytesOut * 100.0f / bytesIn : 0.0f, uint64(compression.timeUs / 1000));
+
+    GridPreloader::Stats preload;
+    map->GetGridPreloader()->GetStats(preload);
+    uint64 notPreloaded = preload.loads - preload.preloadedLoads;
+    PSendSysMessage("Grid preloads: %u pending, %u ready, " UI64FMTD " queued, " UI64FMTD " expired, " UI64FMTD " ms on async workers",
+        preload.pending, preload.ready, preload.queued, preload.expired, preload.preloadTimeMs);
+    PSendSysMessage("Grid loads: " UI64FMTD " preloaded (avg %.1f ms), " UI64FMTD " not preloaded (avg %.1f ms, " UI64FMTD " still preloading), max %u ms",
+        preload.preloadedLoads, preload.preloadedLoads ? float(preload.preloadedLoadTimeMs) / preload.preloadedLoads : 0.0f,
+        notPreloaded, notPreloaded ? float(preload.loadTimeMs) / notPreloaded : 0.0f, preload.lateLoads, preload.maxLoadTimeMs);
+
+    if (HeapAllocationCounter::IsEnabled())
+        PSendSysMessage("Update threads: %u heap allocations last world update", sWorld.GetUpdateHeapAllocationsLastTick());
+    else
+        SendSysMessage("Update threads: heap allocations not counted (build with COUNT_HEAP_ALLOCATIONS)");
+    PSendSysMessage("Scratch arenas: " UI64FMTD " heap allocations, " UI64FMTD " KB reserved",
+        ScratchArena::GetHeapAllocations(), ScratchArena::GetReservedBytes() / 1024);
+
+    AggroScan::Stats aggro;
+    AggroScan::GetStats(aggro);
+    PSendSysMessage("Aggro scan (all maps): " UI64FMTD " pairs, " UI64FMTD " out of reach, " UI64FMTD " rechecks throttled, " UI64FMTD " checked",
+        aggro.pairs, aggro.outOfReach, aggro.throttled, aggro.checked);
+    return true;
+}
+
+bool ChatHandler::HandleDebugAsyncTasksCommand(char* /*args*/)
+{
+    AsyncTaskExecutor const& executor = sWorld.GetAsyncTaskExecutor();
+    PSendSysMessage("Async tasks: %u threads, %u queued", executor.GetThreadCount(), executor.GetQueuedCount());
+
+    for (uint32 type = 0; type < MAX_ASYNC_TASK_TYPES; ++type)
+    {
+        AsyncTaskExecutor::TypeStats stats;
+        executor.GetStats(AsyncTaskType(type), stats);
+        if (!stats.executed)
+            continue;
+
+        // Percentiles are given as the upper limit of their histogram bucket
+        std::ostringstream percentiles;
+        uint32 const percents[] = { 50, 95, 99 };
+        for (uint32 i = 0; i < 3; ++i)
+        {
+            uint64 threshold = (stats.executed * percents[i] + 99) / 100;
+            uint64 count = 0;
+            uint32 bucket = 0;
+            for (; bucket + 1 < AsyncTaskExecutor::LATENCY_BUCKETS; ++bucket)
+            {
+                count += stats.latency[bucket];
+                if (count >= threshold)
+                    break;
+            }
+            percentiles << " p" << percents[i];
+            if (uint32 limit = AsyncTaskExecutor::GetLatencyBucketLimit(bucket))
+                percentiles << " <" << limit << "ms";
+            else
+                percentiles << " >=" << AsyncTaskExecutor::GetLatencyBucketLimit(bucket - 1) << "ms";
+        }
+
+        std::ostringstream histogram;
+        for (uint32 bucket = 0; bucket < AsyncTaskExecutor::LATENCY_BUCKETS; ++bucket)
+        {
+            if (uint32 limit = AsyncTaskExecutor::GetLatencyBucketLimit(bucket))
+                histogram << " <" << limit << ":" << stats.latency[bucket];
+            else
+                histogram << " more:" << stats.latency[bucket];
+        }
+
+        PSendSysMessage("%s: " UI64FMTD " executed, avg run %.2fms, latency%s",
+            AsyncTaskExecutor::GetTypeName(AsyncTaskType(type)), stats.executed, float(stats.runTimeMs) / stats.executed, percentiles.str().c_str());
+        PSendSysMessage("  latency histogram (ms)%s", histogram.str().c_str());
+    }
+    return true;
+}
+
+// Legacy linear search, used as a reference by the auction search benchmark
+static uint32 LinearAuctionSearch(AuctionHouseObject& auctionHouse, AuctionHouseClientQuery const& query)
+{
+    uint32 totalcount = 0;
+    AuctionHouseObject::AuctionEntryMap const& auctions = *auctionHouse.GetAuctions();
+    for (AuctionHouseObject::AuctionEntryMap::const_iterator itr = auctions.begin(); itr != auctions.end(); ++itr)
+    {
+        ItemPrototype const* proto = ObjectMgr::GetItemPrototype(itr->second->itemTemplate);
+        if (query.auctionMainCategory != 0xffffffff && proto->Class != query.auctionMainCategory)
+            continue;
+        if (query.auctionSubCategory != 0xffffffff && proto->SubClass != query.auctionSubCategory)
+            continue;
+        if (query.auctionSlotID != 0xffffffff && proto->InventoryType != query.auctionSlotID)
+            continue;
+        if (query.quality != 0xffffffff && proto->Quality < query.quality)
+            continue;
+        if (query.levelmin != 0x00 && (proto->RequiredLevel < query.levelmin || (query.levelmax != 0x00 && proto->RequiredLevel > query.levelmax)))
+            continue;
+        if (!query.wsearchedname.empty() && (!proto->Name1 || !*proto->Name1 || !Utf8FitTo(proto->Name1, query.wsearchedname)))
+            continue;
+        ++totalcount;
+    }
+    return totalcount;
+}
+
+bool ChatHandler::HandleDebugAuctionSearchBenchCommand(char* args)
+{
+    uint32 auctionsCount;
+    if (!ExtractOptUInt32(&args, auctionsCount, 100000) || !auctionsCount)
+        return false;
+
+    std::vector<uint32> templates;
+    for (uint32 id = 0; id < sItemStorage.GetMaxEntry(); ++id)
+        if (ItemPrototype const* proto = sItemStorage.LookupEntry<ItemPrototype>(id))
+            if (proto->Name1 && *proto->Name1)
+                templates.push_back(id);
+    if (templates.empty())
+        return false;
+
+    // Synthetic house, never saved nor registered in the auction house manager. Its auctions have no item.
+    AuctionHouseObject auctionHouse(false);
+    for (uint32 i = 1; i <= auctionsCount; ++i)
+    {
+        AuctionEntry* auction = new AuctionEntry();
+        auction->Id = i;
+        auction->itemGuidLow = i;
+        auction->itemTemplate = templates[urand(0, templates.size() - 1)];
+        auction->owner = 0;
+        auction->startbid = auction->bid = auction->buyout = auction->deposit = auction->bidder = 0;
+        auction->depositTime = auction->expireTime = 0;
+        auction->auctionHouseEntry = nullptr;
+        auctionHouse.AddAuction(auction);
+    }
+
+    struct BenchQuery
+    {
+        char const* description;
+        uint32 listfrom, itemClass, itemSubClass, quality;
+        uint8 levelmin, levelmax;
+        wchar_t const* name;
+    };
+    BenchQuery const queries[] =
+    {
+        { "all, first page",        0,                  0xffffffff, 0xffffffff, 0xffffffff, 0,  0,  L"" },
+        { "all, middle page",       auctionsCount / 2,  0xffffffff, 0xffffffff, 0xffffffff, 0,  0,  L"" },
+        { "weapons",                0,                  ITEM_CLASS_WEAPON, 0xffffffff, 0xffffffff, 0, 0, L"" },
+        { "rare, level 40-60",      0,                  0xffffffff, 0xffffffff, ITEM_QUALITY_RARE, 40, 60, L"" },
+        { "name 'of the'",          0,                  0xffffffff, 0xffffffff, 0xffffffff, 0,  0,  L"of the" },
+        { "name 'li'",              0,                  0xffffffff, 0xffffffff, 0xffffffff, 0,  0,  L"li" },
+    };
+
+    uint32 const iterations = 20;
+    PSendSysMessage("Auction search benchmark: %u auctions, %u templates, %u iterations",
+        auctionsCount, auctionHouse.GetSearchIndex().GetTemplatesCount(), iterations);
+    for (uint32 i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i)
+    {
+        AuctionHouseClientQuery query;
+        query.accountId = 0;
+        query.wsearchedname = queries[i].name;
+        query.levelmin = queries[i].levelmin;
+        query.levelmax = queries[i].levelmax;
+        query.usable = 0;
+        query.listfrom = queries[i].listfrom;
+        query.auctionSlotID = 0xffffffff;
+        query.auctionMainCategory = queries[i].itemClass;
+        query.auctionSubCategory = queries[i].itemSubClass;
+        query.quality = queries[i].quality;
+
+        uint32 indexedTotal = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32 j = 0; j < iterations; ++j)
+        {
+            std::vector<AuctionEntry*> page;
+            indexedTotal = auctionHouse.GetSearchIndex().Search(query, nullptr, "", -1, 50, page);
+        }
+        std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+        uint32 linearTotal = 0;
+        for (uint32 j = 0; j < iterations; ++j)
+            linearTotal = LinearAuctionSearch(auctionHouse, query);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        uint64 indexedUs = std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count() / iterations;
+        uint64 linearUs = std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count() / iterations;
+        PSendSysMessage("%s: %u results, indexed " UI64FMTD " us, linear " UI64FMTD " us%s",
+            queries[i].description, indexedTotal, indexedUs, linearUs, indexedTotal == linearTotal ? "" : " [RESULTS MISMATCH]");
+    }
+    return true;
+}
+
+// Relocation notify of a player, without the AI reactions: the pairs reaching the visibility check
+struct AggroScanBenchNotifier
+{
+    Player& i_player;
+    bool i_scan;
+    AggroScan::Stats i_stats;
+    uint32 i_visible;
+
+    AggroScanBenchNotifier(Player& player, bool scan) : i_player(player), i_scan(scan), i_visible(0) {}
+
+    template<class T> void Visit(GridRefManager<T>&) {}
+    void Visit(CreatureMapType& m)
+    {
+        for (CreatureMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
+        {
+            Creature* c = iter->getSource();
+            if (!c->isAlive() || c->hasUnitState(UNIT_STAT_LOST_CONTROL | UNIT_STAT_IGNORE_MOVE_LOS) || c->IsInEvadeMode() || !c->AI())
+                continue;
+
+            // Every spot stands for another player: no recheck delay
+            if (i_scan)
+            {
+                if (!AggroScan::ShouldCheck(c, &i_player, 0, i_stats))
+                    continue;
+            }
+            else
+            {
+                ++i_stats.pairs;
+                ++i_stats.checked;
+            }
+
+            if (i_player.isVisibleForOrDetect(c, c, true, false))
+                ++i_visible;
+        }
+    }
+};
+
+bool ChatHandler::HandleDebugAggroScanBenchCommand(char* args)
+{
+    uint32 playersCount;
+    if (!ExtractOptUInt32(&args, playersCount, 300) || !playersCount)
+        return false;
+
+    float spread;
+    if (!ExtractOptFloat(&args, spread, 60.0f) || spread <= 0.0f)
+        return false;
+
+    // The command player stands in turn at each spot, for example spread in Ironforge
+    Player* player = m_session->GetPlayer();
+    float const notifyRadius = sWorld.getConfig(CONFIG_FLOAT_MAX_CREATURE_ATTACK_RADIUS) * sWorld.getConfig(CONFIG_FLOAT_RATE_CREATURE_AGGRO);
+    std::vector<Position> spots(playersCount);
+    for (uint32 i = 0; i < playersCount; ++i)
+    {
+        float angle = rand_norm_f() * 2 * M_PI_F;
+        float distance = spread * sqrt(rand_norm_f());
+        spots[i].x = player->GetPositionX() + distance * cos(angle);
+        spots[i].y = player->GetPositionY() + distance * sin(angle);
+        spots[i].z = player->GetPositionZ();
+        spots[i].o = player->GetOrientation();
+    }
+
+    Position home;
+    home.x = player->GetPositionX();
+    home.y = player->GetPositionY();
+    home.z = player->GetPositionZ();
+    home.o = player->GetOrientation();
+    MovementInfo const homeMovementInfo = player->m_movementInfo;
+
+    uint32 const rounds = 5;
+    PSendSysMessage("Aggro scan benchmark: %u players within %.0f yards, notify radius %.0f yards, %u rounds",
+        playersCount, spread, notifyRadius, rounds);
+    char const* const modes[] = { "fan-out", "aggro scan" };
+    for (uint32 mode = 0; mode < 2; ++mode)
+    {
+        AggroScan::Stats stats;
+        uint32 visible = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32 round = 0; round < rounds; ++round)
+        {
+            for (uint32 i = 0; i < playersCount; ++i)
+            {
+                player->Relocate(spots[i].x, spots[i].y, spots[i].z, spots[i].o);
+                AggroScanBenchNotifier notify(*player, mode == 1);
+                Cell::VisitAllObjects(player, notify, notifyRadius);
+                stats.pairs += notify.i_stats.pairs;
+                stats.outOfReach += notify.i_stats.outOfReach;
+                stats.checked += notify.i_stats.checked;
+                visible += notify.i_visible;
+            }
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+        uint64 relocations = uint64(rounds) * playersCount;
+        uint64 totalUs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        PSendSysMessage("%s: " UI64FMTD " pairs, " UI64FMTD " out of reach, " UI64FMTD " checked (" UI64FMTD " visible), %.2f us per relocation",
+            modes[mode], stats.pairs / rounds, stats.outOfReach / rounds, stats.checked / rounds, uint64(visible) / rounds, float(totalUs) / relocations);
+    }
+
+    player->Relocate(home.x, home.y, home.z, home.o);
+    player->m_movementInfo = homeMovementInfo;
+    return true;
+}
+
+// A damage on one of the creatures, or a heal on all of them
+struct ThreatBenchEvent
+{
+    uint32 creature;                                        // creatures count for a heal
+    uint32 victim;
+    float threat;
+};
+
+bool ChatHandler::HandleDebugThreatBenchCommand(char* args)
+{
+    uint32 creaturesCount;
+    if (!ExtractOptUInt32(&args, creaturesCount, 10) || !creaturesCount)
+        return false;
+
+    uint32 eventsCount;
+    if (!ExtractOptUInt32(&args, eventsCount, 200))
+        return false;
+
+    uint32 ticks;
+    if (!ExtractOptUInt32(&args, ticks, 1000) || !ticks)
+        return false;
+
+    // The selected creature stands for every creature of the fight, in threat managers apart
+    // from its own one. The units around it are the raid.
+    Creature* attacker = getSelectedCreature();
+    if (!attacker)
+    {
+        SendSysMessage(LANG_SELECT_CREATURE);
+        SetSentErrorMessage(true);
+        return false;
+    }
+
+    std::vector<Unit*> victims;
+    MaNGOS::AnyUnitInObjectRangeCheck check(attacker, 40.0f);
+    MaNGOS::UnitListSearcher<MaNGOS::AnyUnitInObjectRangeCheck, std::vector<Unit*> > searcher(victims, check);
+    Cell::VisitAllObjects(attacker, searcher, 40.0f);
+    victims.erase(std::remove(victims.begin(), victims.end(), attacker), victims.end());
+    if (victims.empty())
+    {
+        SendSysMessage("No unit around the creature.");
+        SetSentErrorMessage(true);
+        return false;
+    }
+
+    // Both runs replay the same events
+    std::vector<ThreatBenchEvent> events(eventsCount * ticks);
+    for (std::vector<ThreatBenchEvent>::iterator itr = events.begin(); itr != events.end(); ++itr)
+    {
+        itr->creature = urand(0, 3) ? urand(0, creaturesCount - 1) : creaturesCount;
+        itr->victim = urand(0, uint32(victims.size()) - 1);
+        itr->threat = float(urand(100, 2000));
+    }
+
+    std::vector<std::unique_ptr<ThreatManager> > managers;
+    for (uint32 i = 0; i < creaturesCount; ++i)
+        managers.emplace_back(new ThreatManager(attacker));
+
+    PSendSysMessage("Threat benchmark: %u creatures, %u units, %u threat events per tick, %u ticks",
+        creaturesCount, uint32(victims.size()), eventsCount, ticks);
+
+    // The indexed heap, as updated by the creatures
+    uint32 victimChanges = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32 tick = 0; tick < ticks; ++tick)
+    {
+        for (uint32 i = tick * eventsCount; i < (tick + 1) * eventsCount; ++i)
+        {
+            if (events[i].creature < creaturesCount)
+                managers[events[i].creature]->addThreatDirectly(victims[events[i].victim], events[i].threat);
+            else
+                for (uint32 j = 0; j < creaturesCount; ++j)
+                    managers[j]->addThreatDirectly(victims[events[i].victim], events[i].threat * 0.5f);
+        }
+        for (uint32 j = 0; j < creaturesCount; ++j)
+        {
+            HostileReference* previous = managers[j]->getCurrentVictim();
+            managers[j]->getHostileTarget();
+            if (managers[j]->getCurrentVictim() != previous)
+                ++victimChanges;
+        }
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+    uint64 updates = uint64(ticks) * creaturesCount;
+    uint64 heapUs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    PSendSysMessage("indexed heap: %.2f us per creature update, threat events and victim selection, %u victim changes",
+        float(heapUs) / updates, victimChanges);
+
+    // The former container also sorted a list of its references at each update after a change
+    std::vector<ThreatList> lists(creaturesCount);
+    for (uint32 j = 0; j < creaturesCount; ++j)
+        managers[j]->clearReferences();
+    std::chrono::steady_clock::duration sortTime(0);
+    for (uint32 tick = 0; tick < ticks; ++tick)
+    {
+        for (uint32 i = tick * eventsCount; i < (tick + 1) * eventsCount; ++i)
+        {
+            if (events[i].creature < creaturesCount)
+                managers[events[i].creature]->addThreatDirectly(victims[events[i].victim], events[i].threat);
+            else
+                for (uint32 j = 0; j < creaturesCount; ++j)
+                    managers[j]->addThreatDirectly(victims[events[i].victim], events[i].threat * 0.5f);
+        }
+        for (uint32 j = 0; j < creaturesCount; ++j)
+        {
+            // New references are added at the end of the list, as the former container did
+            ThreatList const& references = managers[j]->getThreatList();
+            if (lists[j].size() != references.size())
+                lists[j] = references;
+
+            std::chrono::steady_clock::time_point sortStart = std::chrono::steady_clock::now();
+            lists[j].sort(ThreatContainer::isMoreHated);
+            sortTime += std::chrono::steady_clock::now() - sortStart;
+        }
+    }
+
+    uint64 sortUs = std::chrono::duration_cast<std::chrono::microseconds>(sortTime).count();
+    PSendSysMessage("former list sort: %.2f us more per creature update", float(sortUs) / updates);
+    return true;
+}
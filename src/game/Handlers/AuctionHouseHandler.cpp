@@ -369,9 +369,10 @@ void WorldSession::HandleAuctionSellItem(WorldPacket & recv_data)
 
     DETAIL_LOG("selling %s to auctioneer %s with initial bid %u with buyout %u and with time %u (in sec) in auctionhouse %u",
                itemGuid.GetString().c_str(), auctioneerGuid.GetString().c_str(), bid, buyout, auction_time, AH->GetHouseId());
+    // The item is needed to list the auction
+    sAuctionMgr.AddAItem(it);
     auctionHouse->AddAuction(AH);
 
-    sAuctionMgr.AddAItem(it);
     pl->MoveItemFromInventory(it->GetBagSlot(), it->GetSlot(), true);
 
     CharacterDatabase.BeginTransaction();
@@ -700,6 +701,7 @@ void WorldSession::HandleAuctionListOwnerItems(WorldPacket & recv_data)
 class AuctionHouseClientQueryTask: public AsyncTask, public AuctionHouseClientQuery
 {
 public:
+    AsyncTaskType GetType() const override { return ASYNC_TASK_AUCTION_SEARCH; }
     void run()
     {
         if (WorldSession* sess = sWorld.FindSession(accountId))
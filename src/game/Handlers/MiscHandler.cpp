@@ -89,6 +89,9 @@ public:
     uint32 zoneids[10];                                     // 10 is client limit
     std::wstring str[4];                                    // 4 is client limit
     std::wstring wplayer_name, wguild_name;
+    AsyncTaskType GetType() const override { return ASYNC_TASK_WHO_LIST; }
+    // Iterates over all the players, the client can wait a bit more
+    AsyncTaskPriority GetPriority() const override { return ASYNC_TASK_PRIORITY_LOW; }
     void run()
     {
         WorldSession* sess = sWorld.FindSession(accountId);
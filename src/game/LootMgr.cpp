@@ -25,6 +25,7 @@
 #include "ProgressBar.h"
 #include "World.h"
 #include "Util.h"
+#include "Database/SQLStorageSnapshot.h"
 
 static eConfigFloatValues const qualityToRate[MAX_ITEM_QUALITY] =
 {
@@ -98,8 +99,10 @@ void LootStore::LoadLootTable()
 
     sLog.outString("%s :", GetName());
 
-    //                                                 0      1     2                    3        4              5         6
-    QueryResult* result = WorldDatabase.PQuery("SELECT entry, item, ChanceOrQuestChance, groupid, mincountOrRef, maxcount, condition_id FROM %s", GetName());
+    //                          0      1     2                    3        4              5         6
+    std::string query = "SELECT entry, item, ChanceOrQuestChance, groupid, mincountOrRef, maxcount, condition_id FROM ";
+    query += GetName();
+    QueryResult* result = SQLStorageSnapshot::Query(GetName(), GetName(), query.c_str());
 
     if (result)
     {
@@ -64,32 +64,15 @@ int MapSocket::ProcessIncoming(WorldPacket* new_pct)
     return 0;
 }
 
-int MapSocket::iSendPacket(const WorldPacket& pct)
+void MapSocket::BuildHeader(OutHeader& header, uint16 opcode, size_t size)
 {
-    if (m_OutBuffer->space() < pct.size() + sizeof(ClientPktHeader))
-    {
-        errno = ENOBUFS;
-        return -1;
-    }
-
-    ClientPktHeader header;
-
-    header.cmd = pct.GetOpcode();
-    header.size = pct.size() + 4;
+    header.cmd = opcode;
+    header.size = size + 4;
 
     EndianConvertReverse(header.size);
     EndianConvert(header.cmd);
 
     m_Crypt.EncryptSend((uint8*) & header, sizeof(header));
-
-    if (m_OutBuffer->copy((char*) & header, sizeof(header)) == -1)
-        ACE_ASSERT(false);
-
-    if (!pct.empty())
-        if (m_OutBuffer->copy((char*) pct.contents(), pct.size()) == -1)
-            ACE_ASSERT(false);
-
-    return 0;
 }
 
 int MapSocket::OnSocketOpen()
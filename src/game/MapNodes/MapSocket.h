@@ -20,7 +20,9 @@ class MapSocket: public MangosSocket<NodeSession, MapSocket, NoCrypt>
     protected:
         int OnSocketOpen();
         int ProcessIncoming (WorldPacket* new_pct);
-        int iSendPacket (const WorldPacket& pct);
+        /// Node packets are sent with the client header
+        typedef ClientPktHeader OutHeader;
+        void BuildHeader (OutHeader& header, uint16 opcode, size_t size);
 };
 
 #endif // MAPSOCKET_H
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "AggroScan.h"
+#include "Creature.h"
+#include "CreatureAI.h"
+#include "Timer.h"
+#include <atomic>
+
+// Stealthed players within it alert the hostile creatures (see Unit::canDetectStealthOf)
+#define AGGRO_SCAN_MAX_ALERT_DISTANCE   15.0f
+
+namespace
+{
+    std::atomic<uint64> s_pairs(0);
+    std::atomic<uint64> s_outOfReach(0);
+    std::atomic<uint64> s_throttled(0);
+    std::atomic<uint64> s_checked(0);
+}
+
+bool AggroScan::ShouldCheck(Creature* c, Unit* moving, uint32 recheckDelay, Stats& stats)
+{
+    ++stats.pairs;
+
+    CreatureAI* ai = c->AI();
+    float reach = ai->GetMoveInLineOfSightReach(moving);
+    if (reach >= 0.0f)
+    {
+        if (moving->GetTypeId() == TYPEID_PLAYER && moving->HasStealthAura())
+            reach = std::max(reach, AGGRO_SCAN_MAX_ALERT_DISTANCE);
+
+        if (!c->IsWithinDistInMap(moving, reach))
+        {
+            ++stats.outOfReach;
+            return false;
+        }
+    }
+
+    if (recheckDelay && !ai->m_moveLosChecks.Check(moving->GetObjectGuid(), WorldTimer::getMSTime(), recheckDelay))
+    {
+        ++stats.throttled;
+        return false;
+    }
+
+    ++stats.checked;
+    return true;
+}
+
+void AggroScan::AddStats(Stats const& stats)
+{
+    if (!stats.pairs)
+        return;
+
+    s_pairs += stats.pairs;
+    s_outOfReach += stats.outOfReach;
+    s_throttled += stats.throttled;
+    s_checked += stats.checked;
+}
+
+void AggroScan::GetStats(Stats& stats)
+{
+    stats.pairs = s_pairs;
+    stats.outOfReach = s_outOfReach;
+    stats.throttled = s_throttled;
+    stats.checked = s_checked;
+}
+
+bool AggroPairChecks::Check(ObjectGuid const& moving, uint32 now, uint32 delay)
+{
+    // Units gone away are forgotten once in a while
+    if (WorldTimer::getMSTimeDiff(m_lastPruneTime, now) > 10 * delay)
+    {
+        for (CheckTimes::iterator itr = m_checkTimes.begin(); itr != m_checkTimes.end();)
+        {
+            if (WorldTimer::getMSTimeDiff(itr->second, now) >= delay)
+                itr = m_checkTimes.erase(itr);
+            else
+                ++itr;
+        }
+        m_lastPruneTime = now;
+    }
+
+    std::pair<CheckTimes::iterator, bool> result = m_checkTimes.insert(CheckTimes::value_type(moving, now));
+    if (result.second)
+        return true;
+
+    if (WorldTimer::getMSTimeDiff(result.first->second, now) < delay)
+        return false;
+
+    result.first->second = now;
+    return true;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_AGGROSCAN_H
+#define MANGOS_AGGROSCAN_H
+
+#include "Common.h"
+#include "ObjectGuid.h"
+
+class Creature;
+class Unit;
+
+/**
+ * Selects the creatures that react to a unit moving around them (CreatureAI::MoveInLineOfSight),
+ * for the relocation notifiers. The cells visited around the unit moving already bucket the
+ * creatures by position. Among them, a creature is only checked when the unit is within the
+ * reach of its AI (CreatureAI::GetMoveInLineOfSightReach), and when the same pair was not
+ * checked during the last Visibility.AIPairRecheckDelay ms: both units moving, or a player
+ * and a creature moving around each other, used to check the pair at each of their moves.
+ */
+class AggroScan
+{
+    public:
+        struct Stats
+        {
+            Stats() : pairs(0), outOfReach(0), throttled(0), checked(0) {}
+
+            uint64 pairs;                                   // creatures found around a unit moving
+            uint64 outOfReach;
+            uint64 throttled;
+            uint64 checked;                                 // given to the visibility check, then to the AI
+        };
+
+        // Whether c has to check moving. recheckDelay 0 checks the pair again whenever asked.
+        static bool ShouldCheck(Creature* c, Unit* moving, uint32 recheckDelay, Stats& stats);
+
+        // Totals of all maps
+        static void AddStats(Stats const& stats);
+        static void GetStats(Stats& stats);
+};
+
+// Last checks of a creature, by unit moving around it
+class AggroPairChecks
+{
+    public:
+        AggroPairChecks() : m_lastPruneTime(0) {}
+
+        // Records the check at now, false when the pair was checked less than delay ms before
+        bool Check(ObjectGuid const& moving, uint32 now, uint32 delay);
+
+    private:
+        typedef UNORDERED_MAP<ObjectGuid, uint32> CheckTimes;
+
+        CheckTimes m_checkTimes;
+        uint32 m_lastPruneTime;
+};
+
+#endif
@@ -31,6 +31,11 @@
 #include "Util.h"
 #include "SQLStorages.h"
 
+#include <ace/OS_NS_fcntl.h>
+#include <ace/OS_NS_sys_mman.h>
+#include <ace/OS_NS_sys_stat.h>
+#include <ace/OS_NS_unistd.h>
+
 char const* MAP_MAGIC         = "MAPS";
 char const* MAP_VERSION_MAGIC = "z1.3";
 char const* MAP_AREA_MAGIC    = "AREA";
@@ -41,6 +46,10 @@ GridMap::GridMap()
 {
     m_flags = 0;
 
+    m_mappedData = NULL;
+    m_mappedSize = 0;
+    m_fileData = NULL;
+
     // Area data
     m_gridArea = 0;
     m_area_map = NULL;
@@ -69,62 +78,116 @@ GridMap::~GridMap()
     unloadData();
 }
 
-bool GridMap::loadData(char* filename)
+bool GridMap::loadData(char* filename, bool memoryMapped)
 {
     // Unload old data if exist
     unloadData();
 
-    GridMapFileHeader header;
+    if (memoryMapped)
+    {
+        // The mapping stays valid once the file is closed. On failure, the file is read.
+        ACE_HANDLE handle = ACE_OS::open(filename, O_RDONLY);
+        if (handle != ACE_INVALID_HANDLE)
+        {
+            ACE_OFF_T size = ACE_OS::filesize(handle);
+            if (size > 0)
+            {
+                void* data = ACE_OS::mmap(0, size_t(size), PROT_READ, ACE_MAP_PRIVATE, handle);
+                if (data != MAP_FAILED)
+                {
+                    m_mappedData = static_cast<uint8*>(data);
+                    m_mappedSize = size_t(size);
+                }
+            }
+            ACE_OS::close(handle);
+        }
+
+        if (m_mappedData)
+            return loadFileData(m_mappedData, uint32(m_mappedSize), filename);
+    }
+
     // Not return error if file not found
     FILE* in = fopen(filename, "rb");
     if (!in)
         return true;
 
-    fread(&header, sizeof(header), 1, in);
-    if (header.mapMagic     == *((uint32 const*)(MAP_MAGIC)) &&
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+
+    m_fileData = new uint8[size > 0 ? size : 1];
+    bool read = size >= 0 && fread(m_fileData, 1, size, in) == size_t(size);
+    fclose(in);
+
+    if (!read)
+    {
+        sLog.outError("Error reading map file '%s'", filename);
+        return false;
+    }
+
+    return loadFileData(m_fileData, uint32(size), filename);
+}
+
+bool GridMap::loadFileData(uint8 const* data, uint32 dataSize, char const* filename)
+{
+    GridMapFileHeader header;
+    uint32 offset = 0;
+    if (readFileStruct(data, dataSize, offset, header) &&
+            header.mapMagic     == *((uint32 const*)(MAP_MAGIC)) &&
             header.versionMagic == *((uint32 const*)(MAP_VERSION_MAGIC)))
     {
         // loadup area data
-        if (header.areaMapOffset && !loadAreaData(in, header.areaMapOffset, header.areaMapSize))
+        if (header.areaMapOffset && !loadAreaData(data, dataSize, header.areaMapOffset))
         {
             sLog.outError("Error loading map area data\n");
-            fclose(in);
             return false;
         }
 
         // loadup height data
-        if (header.heightMapOffset && !loadHeightData(in, header.heightMapOffset, header.heightMapSize))
+        if (header.heightMapOffset && !loadHeightData(data, dataSize, header.heightMapOffset))
         {
             sLog.outError("Error loading map height data\n");
-            fclose(in);
             return false;
         }
 
         // loadup liquid data
-        if (header.liquidMapOffset && !loadGridMapLiquidData(in, header.liquidMapOffset, header.liquidMapSize))
+        if (header.liquidMapOffset && !loadGridMapLiquidData(data, dataSize, header.liquidMapOffset))
         {
             sLog.outError("Error loading map liquids data\n");
-            fclose(in);
             return false;
         }
 
-        fclose(in);
         return true;
     }
 
     sLog.outError("Map file '%s' is non-compatible version (outdated?). Please, create new using ad.exe program.", filename);
-    fclose(in);
     return false;
 }
 
+void GridMap::prefetchData() const
+{
+    if (!m_mappedData)
+        return;
+
+    // One read per page
+    uint32 sum = 0;
+    for (size_t offset = 0; offset < m_mappedSize; offset += 4096)
+        sum += *static_cast<uint8 volatile const*>(m_mappedData + offset);
+    (void)sum;
+}
+
 void GridMap::unloadData()
 {
-    delete[] m_area_map;
-    delete[] m_V9;
-    delete[] m_V8;
-    delete[] m_liquidEntry;
-    delete[] m_liquidFlags;
-    delete[] m_liquid_map;
+    if (m_mappedData)
+        ACE_OS::munmap(m_mappedData, m_mappedSize);
+    delete[] m_fileData;
+    for (std::vector<uint8*>::const_iterator itr = m_alignedCopies.begin(); itr != m_alignedCopies.end(); ++itr)
+        delete[] *itr;
+
+    m_mappedData = NULL;
+    m_mappedSize = 0;
+    m_fileData = NULL;
+    m_alignedCopies.clear();
 
     m_area_map = NULL;
     m_V9 = NULL;
@@ -135,30 +198,55 @@ void GridMap::unloadData()
     m_gridGetHeight = &GridMap::getHeightFromFlat;
 }
 
-bool GridMap::loadAreaData(FILE* in, uint32 offset, uint32 /*size*/)
+template<typename T>
+bool GridMap::readFileStruct(uint8 const* data, uint32 dataSize, uint32& offset, T& value)
+{
+    if (offset > dataSize || dataSize - offset < sizeof(T))
+        return false;
+
+    memcpy(&value, data + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+template<typename T>
+bool GridMap::getFileArray(uint8 const* data, uint32 dataSize, uint32& offset, uint32 count, T const*& array)
+{
+    if (offset > dataSize || (dataSize - offset) / sizeof(T) < count)
+        return false;
+
+    uint8 const* fileArray = data + offset;
+    if (reinterpret_cast<uintptr_t>(fileArray) % alignof(T))
+    {
+        // follows an array of bytes in the file
+        uint8* copy = new uint8[count * sizeof(T)];
+        memcpy(copy, fileArray, count * sizeof(T));
+        m_alignedCopies.push_back(copy);
+        fileArray = copy;
+    }
+
+    array = reinterpret_cast<T const*>(fileArray);
+    offset += count * sizeof(T);
+    return true;
+}
+
+bool GridMap::loadAreaData(uint8 const* data, uint32 dataSize, uint32 offset)
 {
     GridMapAreaHeader header;
-    fseek(in, offset, SEEK_SET);
-    fread(&header, sizeof(header), 1, in);
-    if (header.fourcc != *((uint32 const*)(MAP_AREA_MAGIC)))
+    if (!readFileStruct(data, dataSize, offset, header) || header.fourcc != *((uint32 const*)(MAP_AREA_MAGIC)))
         return false;
 
     m_gridArea = header.gridArea;
     if (!(header.flags & MAP_AREA_NO_AREA))
-    {
-        m_area_map = new uint16 [16 * 16];
-        fread(m_area_map, sizeof(uint16), 16 * 16, in);
-    }
+        return getFileArray(data, dataSize, offset, 16 * 16, m_area_map);
 
     return true;
 }
 
-bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadHeightData(uint8 const* data, uint32 dataSize, uint32 offset)
 {
     GridMapHeightHeader header;
-    fseek(in, offset, SEEK_SET);
-    fread(&header, sizeof(header), 1, in);
-    if (header.fourcc != *((uint32 const*)(MAP_HEIGHT_MAGIC)))
+    if (!readFileStruct(data, dataSize, offset, header) || header.fourcc != *((uint32 const*)(MAP_HEIGHT_MAGIC)))
         return false;
 
     m_gridHeight = header.gridHeight;
@@ -166,28 +254,25 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
     {
         if ((header.flags & MAP_HEIGHT_AS_INT16))
         {
-            m_uint16_V9 = new uint16 [129 * 129];
-            m_uint16_V8 = new uint16 [128 * 128];
-            fread(m_uint16_V9, sizeof(uint16), 129 * 129, in);
-            fread(m_uint16_V8, sizeof(uint16), 128 * 128, in);
+            if (!getFileArray(data, dataSize, offset, 129 * 129, m_uint16_V9) ||
+                    !getFileArray(data, dataSize, offset, 128 * 128, m_uint16_V8))
+                return false;
             m_gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 65535;
             m_gridGetHeight = &GridMap::getHeightFromUint16;
         }
         else if ((header.flags & MAP_HEIGHT_AS_INT8))
         {
-            m_uint8_V9 = new uint8 [129 * 129];
-            m_uint8_V8 = new uint8 [128 * 128];
-            fread(m_uint8_V9, sizeof(uint8), 129 * 129, in);
-            fread(m_uint8_V8, sizeof(uint8), 128 * 128, in);
+            if (!getFileArray(data, dataSize, offset, 129 * 129, m_uint8_V9) ||
+                    !getFileArray(data, dataSize, offset, 128 * 128, m_uint8_V8))
+                return false;
             m_gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 255;
             m_gridGetHeight = &GridMap::getHeightFromUint8;
         }
         else
         {
-            m_V9 = new float [129 * 129];
-            m_V8 = new float [128 * 128];
-            fread(m_V9, sizeof(float), 129 * 129, in);
-            fread(m_V8, sizeof(float), 128 * 128, in);
+            if (!getFileArray(data, dataSize, offset, 129 * 129, m_V9) ||
+                    !getFileArray(data, dataSize, offset, 128 * 128, m_V8))
+                return false;
             m_gridGetHeight = &GridMap::getHeightFromFloat;
         }
     }
@@ -197,12 +282,10 @@ bool GridMap::loadHeightData(FILE* in, uint32 offset, uint32 /*size*/)
     return true;
 }
 
-bool GridMap::loadGridMapLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadGridMapLiquidData(uint8 const* data, uint32 dataSize, uint32 offset)
 {
     GridMapLiquidHeader header;
-    fseek(in, offset, SEEK_SET);
-    fread(&header, sizeof(header), 1, in);
-    if (header.fourcc != *((uint32 const*)(MAP_LIQUID_MAGIC)))
+    if (!readFileStruct(data, dataSize, offset, header) || header.fourcc != *((uint32 const*)(MAP_LIQUID_MAGIC)))
         return false;
 
     m_liquidType    = header.liquidType;
@@ -214,18 +297,13 @@ bool GridMap::loadGridMapLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
 
     if (!(header.flags & MAP_LIQUID_NO_TYPE))
     {
-        m_liquidEntry = new uint16[16 * 16];
-        fread(m_liquidEntry, sizeof(uint16), 16 * 16, in);
-
-        m_liquidFlags = new uint8[16 * 16];
-        fread(m_liquidFlags, sizeof(uint8), 16 * 16, in);
+        if (!getFileArray(data, dataSize, offset, 16 * 16, m_liquidEntry) ||
+                !getFileArray(data, dataSize, offset, 16 * 16, m_liquidFlags))
+            return false;
     }
 
     if (!(header.flags & MAP_LIQUID_NO_HEIGHT))
-    {
-        m_liquid_map = new float [m_liquid_width * m_liquid_height];
-        fread(m_liquid_map, sizeof(float), m_liquid_width * m_liquid_height, in);
-    }
+        return getFileArray(data, dataSize, offset, m_liquid_width * m_liquid_height, m_liquid_map);
 
     return true;
 }
@@ -345,7 +423,7 @@ float GridMap::getHeightFromUint8(float x, float y) const
     y_int &= (MAP_RESOLUTION - 1);
 
     int32 a, b, c;
-    uint8* V9_h1_ptr = &m_uint8_V9[x_int * 128 + x_int + y_int];
+    uint8 const* V9_h1_ptr = &m_uint8_V9[x_int * 128 + x_int + y_int];
     if (x + y < 1)
     {
         if (x > y)
@@ -413,7 +491,7 @@ float GridMap::getHeightFromUint16(float x, float y) const
     y_int &= (MAP_RESOLUTION - 1);
 
     int32 a, b, c;
-    uint16* V9_h1_ptr = &m_uint16_V9[x_int * 128 + x_int + y_int];
+    uint16 const* V9_h1_ptr = &m_uint16_V9[x_int * 128 + x_int + y_int];
     if (x + y < 1)
     {
         if (x > y)
@@ -661,6 +739,7 @@ TerrainInfo::TerrainInfo(uint32 mapid) : m_mapId(mapid)
         for (int i = 0; i < MAX_NUMBER_OF_GRIDS; ++i)
         {
             m_GridMaps[i][k] = NULL;
+            m_PreloadedGridMaps[i][k] = NULL;
             m_GridRef[i][k] = 0;
         }
     }
@@ -685,7 +764,10 @@ TerrainInfo::~TerrainInfo()
 {
     for (int k = 0; k < MAX_NUMBER_OF_GRIDS; ++k)
         for (int i = 0; i < MAX_NUMBER_OF_GRIDS; ++i)
+        {
             delete m_GridMaps[i][k];
+            delete m_PreloadedGridMaps[i][k];
+        }
 
     VMAP::VMapFactory::createOrGetVMapManager()->unloadMap(m_mapId);
     MMAP::MMapFactory::createOrGetMMapManager()->unloadMap(m_mapId);
@@ -1121,45 +1203,96 @@ GridMap* TerrainInfo::LoadMapAndVMap(const uint32 x, const uint32 y)
 
         if (!m_GridMaps[x][y])
         {
-            GridMap* map = new GridMap();
-
-            // map file name
-            int len = sWorld.GetDataPath().length() + strlen("maps/%03u%02u%02u.map") + 1;
-            char* tmp = new char[len];
-            snprintf(tmp, len, (char*)(sWorld.GetDataPath() + "maps/%03u%02u%02u.map").c_str(), m_mapId, x, y);
-
-            if (!map->loadData(tmp))
+            // A preloaded map comes with its vmap and mmap tiles
+            GridMap* map = m_PreloadedGridMaps[x][y];
+            if (map)
+                m_PreloadedGridMaps[x][y] = NULL;
+            else
             {
-                sLog.outError("Error load map file: \n %s\n", tmp);
-                // ASSERT(false);
+                map = LoadMapFile(x, y);
+                LoadVMapAndMMap(x, y);
             }
 
-            delete[] tmp;
             m_GridMaps[x][y] = map;
+        }
+    }
 
-            // load VMAPs for current map/grid...
-            const MapEntry* i_mapEntry = sMapStorage.LookupEntry<MapEntry>(m_mapId);
-            const char* mapName = i_mapEntry ? i_mapEntry->name : "UNNAMEDMAP\x0";
+    return  m_GridMaps[x][y];
+}
 
-            int vmapLoadResult = VMAP::VMapFactory::createOrGetVMapManager()->loadMap((sWorld.GetDataPath() + "vmaps").c_str(),  m_mapId, x, y);
-            switch (vmapLoadResult)
-            {
-                case VMAP::VMAP_LOAD_RESULT_OK:
-                    break;
-                case VMAP::VMAP_LOAD_RESULT_ERROR:
-                    DEBUG_LOG("Could not load VMAP name:%s, id:%d, x:%d, y:%d (vmap rep.: x:%d, y:%d)", mapName, m_mapId, x, y, x, y);
-                    break;
-                case VMAP::VMAP_LOAD_RESULT_IGNORED:
-                    DEBUG_LOG("Ignored VMAP name:%s, id:%d, x:%d, y:%d (vmap rep.: x:%d, y:%d)", mapName, m_mapId, x, y, x, y);
-                    break;
-            }
+void TerrainInfo::LoadVMapAndMMap(const uint32 x, const uint32 y) const
+{
+    // load VMAPs for current map/grid...
+    const MapEntry* i_mapEntry = sMapStorage.LookupEntry<MapEntry>(m_mapId);
+    const char* mapName = i_mapEntry ? i_mapEntry->name : "UNNAMEDMAP\x0";
 
-            // load navmesh
-            MMAP::MMapFactory::createOrGetMMapManager()->loadMap(m_mapId, x, y);
-        }
+    int vmapLoadResult = VMAP::VMapFactory::createOrGetVMapManager()->loadMap((sWorld.GetDataPath() + "vmaps").c_str(),  m_mapId, x, y);
+    switch (vmapLoadResult)
+    {
+        case VMAP::VMAP_LOAD_RESULT_OK:
+            break;
+        case VMAP::VMAP_LOAD_RESULT_ERROR:
+            DEBUG_LOG("Could not load VMAP name:%s, id:%d, x:%d, y:%d (vmap rep.: x:%d, y:%d)", mapName, m_mapId, x, y, x, y);
+            break;
+        case VMAP::VMAP_LOAD_RESULT_IGNORED:
+            DEBUG_LOG("Ignored VMAP name:%s, id:%d, x:%d, y:%d (vmap rep.: x:%d, y:%d)", mapName, m_mapId, x, y, x, y);
+            break;
     }
 
-    return  m_GridMaps[x][y];
+    // load navmesh, the tile is added under the navmesh write lock
+    MMAP::MMapFactory::createOrGetMMapManager()->loadMap(m_mapId, x, y);
+}
+
+GridMap* TerrainInfo::LoadMapFile(const uint32 x, const uint32 y) const
+{
+    GridMap* map = new GridMap();
+
+    // map file name
+    int len = sWorld.GetDataPath().length() + strlen("maps/%03u%02u%02u.map") + 1;
+    char* tmp = new char[len];
+    snprintf(tmp, len, (char*)(sWorld.GetDataPath() + "maps/%03u%02u%02u.map").c_str(), m_mapId, x, y);
+
+    if (!map->loadData(tmp, sWorld.getConfig(CONFIG_BOOL_TERRAIN_MEMORY_MAPPED)))
+    {
+        sLog.outError("Error load map file: \n %s\n", tmp);
+        // ASSERT(false);
+    }
+
+    delete[] tmp;
+    return map;
+}
+
+void TerrainInfo::PreloadMap(const uint32 x, const uint32 y)
+{
+    if (m_GridMaps[x][y])
+        return;
+
+    GridMap* map = LoadMapFile(x, y);
+    map->prefetchData();
+
+    // The tiles are loaded under the lock, so that the thread loading the grid meanwhile waits for
+    // them instead of loading them a second time
+    LOCK_GUARD lock(m_mutex);
+    if (m_GridMaps[x][y] || m_PreloadedGridMaps[x][y])
+        delete map;
+    else
+    {
+        LoadVMapAndMMap(x, y);
+        m_PreloadedGridMaps[x][y] = map;
+    }
+}
+
+void TerrainInfo::DropPreloadedMap(const uint32 x, const uint32 y)
+{
+    LOCK_GUARD lock(m_mutex);
+    if (!m_PreloadedGridMaps[x][y])
+        return;
+
+    delete m_PreloadedGridMaps[x][y];
+    m_PreloadedGridMaps[x][y] = NULL;
+
+    VMAP::VMapFactory::createOrGetVMapManager()->unloadMap(m_mapId, x, y);
+    MMAP::MMapFactory::createOrGetMMapManager()->unloadMap(m_mapId, x, y);
 }
 
 float TerrainInfo::GetWaterLevel(float x, float y, float z, float* pGround /*= NULL*/) const
@@ -28,6 +28,7 @@
 
 #include <bitset>
 #include <list>
+#include <vector>
 
 class Creature;
 class Unit;
@@ -122,24 +123,30 @@ class GridMap
 
         uint32 m_flags;
 
+        // Whole .map file: the data arrays below point into it
+        uint8* m_mappedData;                                // memory mapped mode
+        size_t m_mappedSize;
+        uint8* m_fileData;                                  // read mode
+        std::vector<uint8*> m_alignedCopies;                // arrays not aligned in the file
+
         // Area data
         uint16 m_gridArea;
-        uint16* m_area_map;
+        uint16 const* m_area_map;
 
         // Height level data
         float m_gridHeight;
         float m_gridIntHeightMultiplier;
         union
         {
-            float* m_V9;
-            uint16* m_uint16_V9;
-            uint8* m_uint8_V9;
+            float const* m_V9;
+            uint16 const* m_uint16_V9;
+            uint8 const* m_uint8_V9;
         };
         union
         {
-            float* m_V8;
-            uint16* m_uint16_V8;
-            uint8* m_uint8_V8;
+            float const* m_V8;
+            uint16 const* m_uint16_V8;
+            uint8 const* m_uint8_V8;
         };
 
         // Liquid data
@@ -149,13 +156,21 @@ class GridMap
         uint8 m_liquid_width;
         uint8 m_liquid_height;
         float m_liquidLevel;
-        uint16* m_liquidEntry;
-        uint8* m_liquidFlags;
-        float* m_liquid_map;
-
-        bool loadAreaData(FILE* in, uint32 offset, uint32 size);
-        bool loadHeightData(FILE* in, uint32 offset, uint32 size);
-        bool loadGridMapLiquidData(FILE* in, uint32 offset, uint32 size);
+        uint16 const* m_liquidEntry;
+        uint8 const* m_liquidFlags;
+        float const* m_liquid_map;
+
+        bool loadAreaData(uint8 const* data, uint32 dataSize, uint32 offset);
+        bool loadHeightData(uint8 const* data, uint32 dataSize, uint32 offset);
+        bool loadGridMapLiquidData(uint8 const* data, uint32 dataSize, uint32 offset);
+
+        bool loadFileData(uint8 const* data, uint32 dataSize, char const* filename);
+        // Copies the structure of the file at 'offset', if it fits in the file
+        template<typename T>
+        static bool readFileStruct(uint8 const* data, uint32 dataSize, uint32& offset, T& value);
+        // Points 'array' to 'count' elements of the file at 'offset', if they fit in the file
+        template<typename T>
+        bool getFileArray(uint8 const* data, uint32 dataSize, uint32& offset, uint32 count, T const*& array);
 
         // Get height functions and pointers
         typedef float(GridMap::*pGetHeightPtr)(float x, float y) const;
@@ -170,8 +185,11 @@ class GridMap
         GridMap();
         ~GridMap();
 
-        bool loadData(char* filaname);
+        // With 'memoryMapped', the file is mapped read only instead of being read
+        bool loadData(char* filaname, bool memoryMapped);
         void unloadData();
+        // Reads the mapped file once, so that its pages are in memory before the first query
+        void prefetchData() const;
 
         static bool ExistMap(uint32 mapid, int gx, int gy);
         static bool ExistVMap(uint32 mapid, int gx, int gy);
@@ -252,12 +270,23 @@ class MANGOS_DLL_SPEC TerrainInfo : public Referencable<AtomicLong>
         GridMap* Load(const uint32 x, const uint32 y);
         void Unload(const uint32 x, const uint32 y);
 
+        // .map files read ahead of the grid loads, on any thread
+        friend class GridPreload;
+
     private:
         TerrainInfo(const TerrainInfo&);
         TerrainInfo& operator=(const TerrainInfo&);
 
         GridMap* GetGrid(const float x, const float y);
         GridMap* LoadMapAndVMap(const uint32 x, const uint32 y);
+        GridMap* LoadMapFile(const uint32 x, const uint32 y) const;
+        void LoadVMapAndMMap(const uint32 x, const uint32 y) const;
+
+        // Any thread. Reads the .map file of a grid ahead of its load, and loads its vmap and mmap
+        // tiles. The file is only published by LoadMapAndVMap on the thread loading the grid.
+        void PreloadMap(const uint32 x, const uint32 y);
+        // The preloaded file not used by a grid load is freed, and its tiles unloaded
+        void DropPreloadedMap(const uint32 x, const uint32 y);
 
         int RefGrid(const uint32& x, const uint32& y);
         int UnrefGrid(const uint32& x, const uint32& y);
@@ -265,6 +294,7 @@ class MANGOS_DLL_SPEC TerrainInfo : public Referencable<AtomicLong>
         const uint32 m_mapId;
 
         GridMap* m_GridMaps[MAX_NUMBER_OF_GRIDS][MAX_NUMBER_OF_GRIDS];
+        GridMap* m_PreloadedGridMaps[MAX_NUMBER_OF_GRIDS][MAX_NUMBER_OF_GRIDS];   // guarded by m_mutex
         int16 m_GridRef[MAX_NUMBER_OF_GRIDS][MAX_NUMBER_OF_GRIDS];
 
         // global garbage collection timer
@@ -24,6 +24,8 @@
 
 #include "ObjectGridLoader.h"
 #include "UpdateData.h"
+#include "ScratchArena.h"
+#include "AggroScan.h"
 #include <iostream>
 
 #include "Corpse.h"
@@ -130,7 +132,9 @@ namespace MaNGOS
     struct MANGOS_DLL_DECL PlayerRelocationNotifier
     {
         Player &i_player;
+        AggroScan::Stats i_stats;
         PlayerRelocationNotifier(Player &pl) : i_player(pl) {}
+        ~PlayerRelocationNotifier() { AggroScan::AddStats(i_stats); }
         template<class T> void Visit(GridRefManager<T> &) {}
         void Visit(CreatureMapType &);
     };
@@ -138,7 +142,9 @@ namespace MaNGOS
     struct MANGOS_DLL_DECL CreatureRelocationNotifier
     {
         Creature &i_creature;
+        AggroScan::Stats i_stats;
         CreatureRelocationNotifier(Creature &c) : i_creature(c) {}
+        ~CreatureRelocationNotifier() { AggroScan::AddStats(i_stats); }
         template<class T> void Visit(GridRefManager<T> &) {}
         #ifdef WIN32
         template<> void Visit(PlayerMapType &);
@@ -348,14 +354,14 @@ namespace MaNGOS
         template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
     };
 
-    // All accepted by Check units if any
-    template<class Check>
+    // All accepted by Check units if any. Container can also be a ScratchList or ScratchVector.
+    template<class Check, class Container = std::list<Unit*> >
         struct MANGOS_DLL_DECL UnitListSearcher
     {
-        std::list<Unit*> &i_objects;
+        Container &i_objects;
         Check& i_check;
 
-        UnitListSearcher(std::list<Unit*> &objects, Check & check) : i_objects(objects),i_check(check) {}
+        UnitListSearcher(Container &objects, Check & check) : i_objects(objects),i_check(check) {}
 
         void Visit(PlayerMapType &m);
         void Visit(CreatureMapType &m);
@@ -392,13 +398,13 @@ namespace MaNGOS
         template<class NOT_INTERESTED> void Visit(GridRefManager<NOT_INTERESTED> &) {}
     };
 
-    template<class Check>
+    template<class Check, class Container = std::list<Creature*> >
         struct MANGOS_DLL_DECL CreatureListSearcher
     {
-        std::list<Creature*> &i_objects;
+        Container &i_objects;
         Check& i_check;
 
-        CreatureListSearcher(std::list<Creature*> &objects, Check & check) : i_objects(objects),i_check(check) {}
+        CreatureListSearcher(Container &objects, Check & check) : i_objects(objects),i_check(check) {}
 
         void Visit(CreatureMapType &m);
 
@@ -32,6 +32,7 @@
 #include "DBCStores.h"
 #include "DBCEnums.h"
 #include "SpellMgr.h"
+#include "World.h"
 
 template<class T>
 inline void MaNGOS::VisibleNotifier::Visit(GridRefManager<T> &m)
@@ -45,21 +46,27 @@ inline void MaNGOS::VisibleNotifier::Visit(GridRefManager<T> &m)
 
 inline void MaNGOS::ObjectUpdater::Visit(CreatureMapType &m)
 {
-    std::vector<Creature*> creaturesToUpdate;
+    // Creatures can leave the cell while updated: copied on the scratch arena of the thread
+    ScratchArena::Scope scope;
+    ScratchVector<Creature*> creaturesToUpdate;
+    creaturesToUpdate.reserve(m.getSize());
     for (CreatureMapType::iterator iter = m.begin(); iter != m.end(); ++iter)
         creaturesToUpdate.push_back(iter->getSource());
-    for (std::vector<Creature*>::iterator it = creaturesToUpdate.begin(); it != creaturesToUpdate.end(); ++it)
+    for (ScratchVector<Creature*>::iterator it = creaturesToUpdate.begin(); it != creaturesToUpdate.end(); ++it)
     {
         WorldObject::UpdateHelper helper(*it);
         helper.UpdateRealTime(i_now, i_timeDiff);
     }
 }
 
-inline void CallAIMoveLOS(Creature* c, Unit* moving)
+inline void CallAIMoveLOS(Creature* c, Unit* moving, AggroScan::Stats& stats)
 {
     // Creature AI reaction
     if (!c->hasUnitState(UNIT_STAT_LOST_CONTROL | UNIT_STAT_IGNORE_MOVE_LOS) && !c->IsInEvadeMode() && c->AI())
     {
+        if (!AggroScan::ShouldCheck(c, moving, World::GetRelocationAIPairRecheckDelay(), stats))
+            return;
+
         bool alert = false;
         if (moving->isVisibleForOrDetect(c, c, true, false, &alert))
               c->AI()->MoveInLineOfSight(moving);
@@ -69,15 +76,15 @@ inline void CallAIMoveLOS(Creature* c, Unit* moving)
     }
 }
 
-inline void PlayerCreatureRelocationWorker(Player* pl, Creature* c)
+inline void PlayerCreatureRelocationWorker(Player* pl, Creature* c, AggroScan::Stats& stats)
 {
-    CallAIMoveLOS(c, pl);
+    CallAIMoveLOS(c, pl, stats);
 }
 
-inline void CreatureCreatureRelocationWorker(Creature* c1, Creature* c2)
+inline void CreatureCreatureRelocationWorker(Creature* c1, Creature* c2, AggroScan::Stats& stats)
 {
-    CallAIMoveLOS(c1, c2);
-    CallAIMoveLOS(c2, c1);
+    CallAIMoveLOS(c1, c2, stats);
+    CallAIMoveLOS(c2, c1, stats);
 }
 
 inline void MaNGOS::PlayerRelocationNotifier::Visit(CreatureMapType &m)
@@ -89,7 +96,7 @@ inline void MaNGOS::PlayerRelocationNotifier::Visit(CreatureMapType &m)
     {
         Creature* c = iter->getSource();
         if (c->isAlive())
-            PlayerCreatureRelocationWorker(&i_player, c);
+            PlayerCreatureRelocationWorker(&i_player, c, i_stats);
     }
 }
 
@@ -103,7 +110,7 @@ inline void MaNGOS::CreatureRelocationNotifier::Visit(PlayerMapType &m)
     {
         Player* player = iter->getSource();
         if (player->isAlive() && !player->IsTaxiFlying())
-            PlayerCreatureRelocationWorker(player, &i_creature);
+            PlayerCreatureRelocationWorker(player, &i_creature, i_stats);
     }
 }
 
@@ -117,7 +124,7 @@ inline void MaNGOS::CreatureRelocationNotifier::Visit(CreatureMapType &m)
     {
         Creature* c = iter->getSource();
         if (c != &i_creature && c->isAlive())
-            CreatureCreatureRelocationWorker(c, &i_creature);
+            CreatureCreatureRelocationWorker(c, &i_creature, i_stats);
     }
 }
 
@@ -441,16 +448,16 @@ void MaNGOS::UnitLastSearcher<Check>::Visit(PlayerMapType &m)
     }
 }
 
-template<class Check>
-void MaNGOS::UnitListSearcher<Check>::Visit(PlayerMapType &m)
+template<class Check, class Container>
+void MaNGOS::UnitListSearcher<Check, Container>::Visit(PlayerMapType &m)
 {
     for(PlayerMapType::iterator itr = m.begin(); itr != m.end(); ++itr)
         if (i_check(itr->getSource()))
             i_objects.push_back(itr->getSource());
 }
 
-template<class Check>
-void MaNGOS::UnitListSearcher<Check>::Visit(CreatureMapType &m)
+template<class Check, class Container>
+void MaNGOS::UnitListSearcher<Check, Container>::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator itr = m.begin(); itr != m.end(); ++itr)
         if (i_check(itr->getSource()))
@@ -486,8 +493,8 @@ void MaNGOS::CreatureLastSearcher<Check>::Visit(CreatureMapType &m)
     }
 }
 
-template<class Check>
-void MaNGOS::CreatureListSearcher<Check>::Visit(CreatureMapType &m)
+template<class Check, class Container>
+void MaNGOS::CreatureListSearcher<Check, Container>::Visit(CreatureMapType &m)
 {
     for(CreatureMapType::iterator itr = m.begin(); itr != m.end(); ++itr)
         if (i_check(itr->getSource()))
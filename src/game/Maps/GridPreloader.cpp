@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "GridPreloader.h"
+#include "AsyncTaskExecutor.h"
+#include "CellImpl.h"
+#include "GridMap.h"
+#include "Map.h"
+#include "MoveSpline.h"
+#include "Player.h"
+#include "World.h"
+
+#define GRID_PRELOAD_INTERVAL       1000                    // ms between two predictions
+#define GRID_PRELOAD_MAX_PENDING    8                       // grids preloaded at once by a map
+
+class GridPreloadTask : public AsyncTask
+{
+    public:
+        GridPreloadTask(GridPreloadPtr const& preload, std::shared_ptr<GridPreloader::Counters> const& counters) :
+            m_preload(preload), m_counters(counters) {}
+
+        void run() override;
+        AsyncTaskType GetType() const override { return ASYNC_TASK_GRID_PRELOAD; }
+        // The grid is needed seconds later
+        AsyncTaskPriority GetPriority() const override { return ASYNC_TASK_PRIORITY_LOW; }
+        // Only reads the terrain files of the grid and the static spawns. The tiles are added under
+        // the locks of the vmap and mmap managers.
+        bool IsMapUpdateBound() const override { return false; }
+
+    private:
+        GridPreloadPtr m_preload;
+        std::shared_ptr<GridPreloader::Counters> m_counters;
+};
+
+void GridPreloadTask::run()
+{
+    // Dropped by the preloader: the grid is loaded already, or no player is heading to it anymore
+    if (m_preload.use_count() == 1)
+        return;
+
+    uint32 startTime = WorldTimer::getMSTime();
+    m_preload->Load();
+    m_counters->preloadTimeMs += WorldTimer::getMSTimeDiffToNow(startTime);
+}
+
+GridPreload::GridPreload(TerrainInfo* terrain, uint32 gridX, uint32 gridY, bool loadTerrain) :
+    m_terrain(terrain), m_gridX(gridX), m_gridY(gridY), m_loadTerrain(loadTerrain),
+    m_wantedTime(0), m_spawnsGeneration(0), m_ready(false)
+{
+    m_terrain->AddRef();
+}
+
+GridPreload::~GridPreload()
+{
+    // Expired, or the grid loaded before the preload was done
+    if (m_loadTerrain)
+        m_terrain->DropPreloadedMap((MAX_NUMBER_OF_GRIDS - 1) - m_gridX, (MAX_NUMBER_OF_GRIDS - 1) - m_gridY);
+
+    if (m_terrain->Release())
+        sTerrainMgr.UnloadTerrain(m_terrain->GetMapId());
+}
+
+void GridPreload::Load()
+{
+    // The vmap and mmap tiles are loaded with the .map file, before the grid is published
+    if (m_loadTerrain)
+        m_terrain->PreloadMap((MAX_NUMBER_OF_GRIDS - 1) - m_gridX, (MAX_NUMBER_OF_GRIDS - 1) - m_gridY);
+
+    m_spawnsGeneration = sObjectMgr.CopyGridObjectGuids(m_terrain->GetMapId(), m_gridX, m_gridY, m_cells);
+    m_ready.store(true, std::memory_order_release);
+}
+
+bool GridPreload::HasCurrentSpawns() const
+{
+    return m_spawnsGeneration == sObjectMgr.GetCellObjectGuidsGeneration();
+}
+
+GridPreloader::GridPreloader(Map& map, TerrainInfo* terrain) :
+    m_map(map), m_terrain(terrain), m_pending(0), m_queued(0), m_expired(0), m_loads(0), m_preloadedLoads(0),
+    m_lateLoads(0), m_loadTimeMs(0), m_preloadedLoadTimeMs(0), m_maxLoadTimeMs(0), m_counters(new Counters())
+{
+    m_timer.SetInterval(GRID_PRELOAD_INTERVAL);
+}
+
+bool GridPreloader::IsEnabled() const
+{
+    return sWorld.getConfig(CONFIG_UINT32_GRID_PRELOAD_LOOKAHEAD) != 0 && m_map.IsContinent();
+}
+
+void GridPreloader::Update(uint32 diff)
+{
+    m_timer.Update(diff);
+    if (!m_timer.Passed())
+        return;
+    m_timer.Reset();
+
+    uint32 now = WorldTimer::getMSTime();
+    uint32 lookAhead = sWorld.getConfig(CONFIG_UINT32_GRID_PRELOAD_LOOKAHEAD);
+
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    m_pending = 0;
+    for (PreloadMap::const_iterator itr = m_preloads.begin(); itr != m_preloads.end(); ++itr)
+        if (!itr->second->IsReady())
+            ++m_pending;
+
+    if (IsEnabled())
+    {
+        for (Map::PlayerList::const_iterator itr = m_map.GetPlayers().begin(); itr != m_map.GetPlayers().end(); ++itr)
+        {
+            Player const* player = itr->getSource();
+            if (player && player->IsInWorld())
+                PreloadAhead(player, lookAhead, now);
+        }
+    }
+
+    // Grids no player is heading to anymore
+    for (PreloadMap::iterator itr = m_preloads.begin(); itr != m_preloads.end();)
+    {
+        if (WorldTimer::getMSTimeDiff(itr->second->m_wantedTime, now) > lookAhead)
+        {
+            if (itr->second->IsReady())
+                ++m_expired;
+            itr = m_preloads.erase(itr);
+        }
+        else
+            ++itr;
+    }
+}
+
+void GridPreloader::PreloadAhead(Player const* player, uint32 lookAhead, uint32 now)
+{
+    // Taxi flights and other splines: the points of the path reached during the look ahead
+    Movement::MoveSpline const* spline = player->movespline;
+    if (spline->Initialized() && !spline->Finalized() && !spline->GetTransportGuid())
+    {
+        int32 lookAheadEnd = spline->timePassed() + int32(lookAhead);
+        float lastX = player->GetPositionX();
+        float lastY = player->GetPositionY();
+        for (int32 i = spline->_currentSplineIdx() + 1; i <= spline->_Spline().last(); ++i)
+        {
+            if (spline->_Spline().length(i) > lookAheadEnd)
+                break;
+
+            // Taxi nodes are close to each other, sampling about twice per grid is enough
+            Movement::Vector3 const point = spline->GetPoint(i);
+            if (fabs(point.x - lastX) < SIZE_OF_GRIDS / 2 && fabs(point.y - lastY) < SIZE_OF_GRIDS / 2)
+                continue;
+
+            PreloadAround(point.x, point.y, now);
+            lastX = point.x;
+            lastY = point.y;
+        }
+        return;
+    }
+
+    if (!player->IsMoving())
+        return;
+
+    // Straight ahead, at the current speed
+    MovementInfo const& movementInfo = player->m_movementInfo;
+    float angle = player->GetOrientation();
+    UnitMoveType moveType = player->IsWalking() ? MOVE_WALK : MOVE_RUN;
+    if (movementInfo.HasMovementFlag(MOVEFLAG_BACKWARD))
+    {
+        angle += M_PI_F;
+        moveType = MOVE_RUN_BACK;
+    }
+    else if (!movementInfo.HasMovementFlag(MOVEFLAG_FORWARD))
+    {
+        if (movementInfo.HasMovementFlag(MOVEFLAG_STRAFE_LEFT))
+            angle += M_PI_F / 2;
+        else if (movementInfo.HasMovementFlag(MOVEFLAG_STRAFE_RIGHT))
+            angle -= M_PI_F / 2;
+    }
+    if (player->IsSwimming())
+        moveType = MOVE_SWIM;
+
+    float distance = player->GetSpeed(moveType) * lookAhead / IN_MILLISECONDS;
+    float const step = SIZE_OF_GRIDS / 2;
+    for (float traveled = std::min(step, distance);; traveled = std::min(traveled + step, distance))
+    {
+        PreloadAround(player->GetPositionX() + traveled * cos(angle), player->GetPositionY() + traveled * sin(angle), now);
+        if (traveled >= distance)
+            break;
+    }
+}
+
+void GridPreloader::PreloadAround(float x, float y, uint32 now)
+{
+    if (!MaNGOS::IsValidMapCoord(x, y))
+        return;
+
+    // The grids a player loads around him when he gets there
+    CellArea area = Cell::CalculateCellArea(x, y, m_map.GetGridActivationDistance());
+    for (uint32 gridX = area.low_bound.x_coord / MAX_NUMBER_OF_CELLS; gridX <= area.high_bound.x_coord / MAX_NUMBER_OF_CELLS; ++gridX)
+    {
+        for (uint32 gridY = area.low_bound.y_coord / MAX_NUMBER_OF_CELLS; gridY <= area.high_bound.y_coord / MAX_NUMBER_OF_CELLS; ++gridY)
+        {
+            uint32 gridId = gridX * MAX_NUMBER_OF_GRIDS + gridY;
+            PreloadMap::const_iterator itr = m_preloads.find(gridId);
+            if (itr != m_preloads.end())
+            {
+                itr->second->m_wantedTime = now;
+                continue;
+            }
+
+            NGridType* grid = m_map.getNGrid(gridX, gridY);
+            if ((grid && grid->isGridObjectDataLoaded()) || m_pending >= GRID_PRELOAD_MAX_PENDING)
+                continue;
+
+            // The terrain of a grid already created is loaded by the map
+            GridPreloadPtr preload(new GridPreload(m_terrain, gridX, gridY, grid == NULL));
+            preload->m_wantedTime = now;
+            m_preloads[gridId] = preload;
+            ++m_pending;
+            ++m_queued;
+            sWorld.AddAsyncTask(new GridPreloadTask(preload, m_counters));
+        }
+    }
+}
+
+GridPreloadPtr GridPreloader::Take(uint32 gridX, uint32 gridY)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    PreloadMap::iterator itr = m_preloads.find(gridX * MAX_NUMBER_OF_GRIDS + gridY);
+    if (itr == m_preloads.end())
+        return GridPreloadPtr();
+
+    GridPreloadPtr preload;
+    preload.swap(itr->second);
+    m_preloads.erase(itr);
+
+    // Still preloading: the map thread loads the grid, after the terrain load in progress
+    if (!preload->IsReady())
+    {
+        ++m_lateLoads;
+        return GridPreloadPtr();
+    }
+
+    return preload;
+}
+
+void GridPreloader::AddLoad(uint32 timeMs, bool preloaded)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    ++m_loads;
+    if (preloaded)
+    {
+        ++m_preloadedLoads;
+        m_preloadedLoadTimeMs += timeMs;
+    }
+    else
+        m_loadTimeMs += timeMs;
+    m_maxLoadTimeMs = std::max(m_maxLoadTimeMs, timeMs);
+}
+
+void GridPreloader::GetStats(Stats& stats) const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    stats.pending = 0;
+    stats.ready = 0;
+    for (PreloadMap::const_iterator itr = m_preloads.begin(); itr != m_preloads.end(); ++itr)
+    {
+        if (itr->second->IsReady())
+            ++stats.ready;
+        else
+            ++stats.pending;
+    }
+
+    stats.queued = m_queued;
+    stats.expired = m_expired;
+    stats.loads = m_loads;
+    stats.preloadedLoads = m_preloadedLoads;
+    stats.lateLoads = m_lateLoads;
+    stats.loadTimeMs = m_loadTimeMs;
+    stats.preloadedLoadTimeMs = m_preloadedLoadTimeMs;
+    stats.maxLoadTimeMs = m_maxLoadTimeMs;
+    stats.preloadTimeMs = m_counters->preloadTimeMs;
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_GRID_PRELOADER_H
+#define MANGOS_GRID_PRELOADER_H
+
+#include "Common.h"
+#include "GridDefines.h"
+#include "ObjectMgr.h"
+#include "Timer.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+class Map;
+class Player;
+class TerrainInfo;
+
+/**
+ * A grid read ahead of its load: its .map file, its vmap and mmap tiles and a copy of the static
+ * spawns of its cells. Shared by the preloader of the map and the task loading it. The terrain
+ * keeps the .map file aside, and only publishes it when the map thread loads the grid. The file
+ * and the tiles are freed with the preload when no grid load used them.
+ */
+class GridPreload
+{
+    public:
+        // Map thread. gridX and gridY are the coordinates of the NGrid.
+        GridPreload(TerrainInfo* terrain, uint32 gridX, uint32 gridY, bool loadTerrain);
+        ~GridPreload();
+
+        bool IsReady() const { return m_ready.load(std::memory_order_acquire); }
+
+        // Once ready. Spawns of a cell of the grid, as they were when the grid was preloaded.
+        CellObjectGuids const& GetCellObjectGuids(uint32 cellX, uint32 cellY) const { return m_cells[cellX][cellY]; }
+        // Once ready. The spawns are stale when a spawn was added to or removed from any cell since.
+        bool HasCurrentSpawns() const;
+
+    private:
+        friend class GridPreloadTask;
+        friend class GridPreloader;
+
+        GridPreload(GridPreload const&);
+        GridPreload& operator=(GridPreload const&);
+
+        // Any thread
+        void Load();
+
+        TerrainInfo* m_terrain;
+        uint32 m_gridX;
+        uint32 m_gridY;
+        bool m_loadTerrain;
+        uint32 m_wantedTime;                                // last time a player was heading to the grid
+        uint32 m_spawnsGeneration;
+        CellObjectGuids m_cells[MAX_NUMBER_OF_CELLS][MAX_NUMBER_OF_CELLS];
+        std::atomic<bool> m_ready;
+};
+
+typedef std::shared_ptr<GridPreload> GridPreloadPtr;
+
+/**
+ * Predicts the grids the players of a map are about to enter, from their taxi path or from
+ * their current movement, and preloads them on the async task workers. When the grid is
+ * entered, the map thread only has the objects to create.
+ */
+class GridPreloader
+{
+    public:
+        struct Stats
+        {
+            uint32 pending;                                 // preloads not ready yet
+            uint32 ready;                                   // ready, waiting for their grid to load
+            uint64 queued;
+            uint64 expired;                                 // ready, but no player went there
+            uint64 loads;                                   // grids loaded on the map thread
+            uint64 preloadedLoads;                          // ... of which were ready
+            uint64 lateLoads;                               // ... of which were still preloading
+            uint64 loadTimeMs;                              // map thread time of the grids not preloaded
+            uint64 preloadedLoadTimeMs;                     // map thread time of the preloaded grids
+            uint32 maxLoadTimeMs;
+            uint64 preloadTimeMs;                           // async workers time
+        };
+
+        GridPreloader(Map& map, TerrainInfo* terrain);
+
+        bool IsEnabled() const;
+
+        // Map thread, once per map update: queues the preloads of the grids ahead of the players
+        void Update(uint32 diff);
+
+        // Map thread, when the objects of the grid are loaded. Returns its preload when it is ready
+        // with up to date spawns. The preload is dropped in any case.
+        GridPreloadPtr Take(uint32 gridX, uint32 gridY);
+        // Map thread, after the grid is loaded. preloaded when the objects were loaded from the preload.
+        void AddLoad(uint32 timeMs, bool preloaded);
+
+        void GetStats(Stats& stats) const;
+
+    private:
+        struct Counters
+        {
+            Counters() : preloadTimeMs(0) {}
+
+            std::atomic<uint64> preloadTimeMs;
+        };
+        friend class GridPreloadTask;
+
+        typedef UNORDERED_MAP<uint32 /*grid id*/, GridPreloadPtr> PreloadMap;
+
+        void PreloadAround(float x, float y, uint32 now);
+        void PreloadAhead(Player const* player, uint32 lookAhead, uint32 now);
+
+        Map& m_map;
+        TerrainInfo* m_terrain;
+        ShortIntervalTimer m_timer;
+
+        // Grids are also loaded by the relocations of the motion update threads
+        mutable std::mutex m_lock;
+        PreloadMap m_preloads;
+        uint32 m_pending;
+
+        uint64 m_queued;
+        uint64 m_expired;
+        uint64 m_loads;
+        uint64 m_preloadedLoads;
+        uint64 m_lateLoads;
+        uint64 m_loadTimeMs;
+        uint64 m_preloadedLoadTimeMs;
+        uint32 m_maxLoadTimeMs;
+        // Shared with the tasks, which may outlive the map
+        std::shared_ptr<Counters> m_counters;
+};
+
+#endif
@@ -41,9 +41,12 @@
 #include "DynamicTree.h"
 #include "RegularGrid.h"
 #include "PathFinder.h"
+#include "PathRequestQueue.h"
+#include "GridPreloader.h"
 #include "Detour/Include/DetourNavMesh.h"
 #include "Detour/Include/DetourNavMeshQuery.h"
 #include "MoveMap.h"
+#include "Policies/MemoryManagement.h"
 #include "SocialMgr.h"
 #include "Chat.h"
 #include "MovementBroadcaster.h"
@@ -68,6 +71,11 @@ Map::~Map()
         i_data = NULL;
     }
 
+    // Searching requests are kept alive by their tasks
+    delete m_pathRequests;
+    // Preloads still running keep their own references on the terrain
+    delete m_gridPreloader;
+
     //release reference count
     if (m_TerrainData->Release())
         sTerrainMgr.UnloadTerrain(m_TerrainData->GetMapId());
@@ -94,7 +102,10 @@ Map::Map(uint32 id, time_t expiry, uint32 InstanceId)
       m_updateFinished(false), m_updateDiffMod(0), m_GridActivationDistance(DEFAULT_VISIBILITY_DISTANCE),
       _lastPlayersUpdate(WorldTimer::getMSTime()), _lastMapUpdate(WorldTimer::getMSTime()),
       _lastCellsUpdate(WorldTimer::getMSTime()), _inactivePlayersSkippedUpdates(0),
-      _objUpdatesThreads(0), _unitRelocationThreads(0), _lastPlayerLeftTime(0)
+      _objUpdatesThreads(0), _unitRelocationThreads(0), _lastPlayerLeftTime(0),
+      _updateCost(0), _updateIdx(-1), m_cellBlockSize(1), m_cellsUpdateImbalance(100),
+      m_updateBlocksBuilt(0), m_updateBlocksReused(0), m_pathRequests(new PathRequestQueue(id)),
+      m_gridPreloader(new GridPreloader(*this, m_TerrainData))
 {
     m_CreatureGuids.Set(sObjectMgr.GetFirstTemporaryCreatureLowGuid());
     m_GameObjectGuids.Set(sObjectMgr.GetFirstTemporaryGameObjectLowGuid());
@@ -296,6 +307,7 @@ Map::EnsureGridLoadedAtEnter(const Cell &cell, Player *player)
 
 bool Map::EnsureGridLoaded(const Cell &cell)
 {
+    uint32 loadStartTime = WorldTimer::getMSTime();
     EnsureGridCreated(GridPair(cell.GridX(), cell.GridY()));
     NGridType *grid = getNGrid(cell.GridX(), cell.GridY());
 
@@ -315,11 +327,15 @@ bool Map::EnsureGridLoaded(const Cell &cell)
         //summons some active object B, while B added to map grid loading called again and so on..
         ASSERT(!m_unloading && "Trying to load grid while unloading the whole map !");
         setGridObjectDataLoaded(true, cell.GridX(), cell.GridY());
-        ObjectGridLoader loader(*grid, this, cell);
+        // When preloaded, the .map file was already read and the static spawns are read from their copy
+        GridPreloadPtr preload = m_gridPreloader->Take(cell.GridX(), cell.GridY());
+        bool const preloaded = preload && preload->HasCurrentSpawns();
+        ObjectGridLoader loader(*grid, this, cell, preloaded ? preload.get() : nullptr);
         loader.LoadN();
 
         // Add resurrectable corpses to world object list in grid
         sObjectAccessor.AddCorpsesToGrid(GridPair(cell.GridX(), cell.GridY()), (*grid)(cell.CellX(), cell.CellY()), this);
+        m_gridPreloader->AddLoad(WorldTimer::getMSTimeDiffToNow(loadStartTime), preloaded);
         //Balance();
         return true;
     }
@@ -362,6 +378,7 @@ bool Map::Add(Player *player)
 
     player->GetSession()->ClearIncomingPacketsByType(PACKET_PROCESS_MOVEMENT);
     player->m_broadcaster->SetInstanceId(GetInstanceId());
+    player->m_broadcaster->SetPosition(player->GetPositionX(), player->GetPositionY());
     return true;
 }
 
@@ -622,21 +639,20 @@ inline void Map::MarkCellsAroundObject(WorldObject const* object)
 }
 
 
-inline void Map::UpdateActiveCellsCallback(uint32 diff, uint32 now, uint32 threadId, uint32 totalThreads, uint32 step)
+inline void Map::UpdateCellBlock(uint32 blockId, uint32 diff, uint32 now)
 {
     MaNGOS::ObjectUpdater updater(diff, now);
     TypeContainerVisitor<MaNGOS::ObjectUpdater, GridTypeMapContainer  > grid_object_update(updater);
     TypeContainerVisitor<MaNGOS::ObjectUpdater, WorldTypeMapContainer > world_object_update(updater);
 
-    int safeDistCells = sWorld.getConfig(CONFIG_UINT32_MTCELLS_SAFEDISTANCE) / SIZE_OF_GRID_CELL + 1;
-    totalThreads *= 2;
-    threadId = 2 * threadId + step;
-    for (int y = 0; y < TOTAL_NUMBER_OF_CELLS_PER_MAP; ++y)
+    uint32 const blocksPerSide = (TOTAL_NUMBER_OF_CELLS_PER_MAP + m_cellBlockSize - 1) / m_cellBlockSize;
+    uint32 const beginX = (blockId % blocksPerSide) * m_cellBlockSize;
+    uint32 const beginY = (blockId / blocksPerSide) * m_cellBlockSize;
+    uint32 const endX = std::min<uint32>(beginX + m_cellBlockSize, TOTAL_NUMBER_OF_CELLS_PER_MAP);
+    uint32 const endY = std::min<uint32>(beginY + m_cellBlockSize, TOTAL_NUMBER_OF_CELLS_PER_MAP);
+    for (uint32 y = beginY; y < endY; ++y)
     {
-        // Skip grids not for this thread
-        if ((y / safeDistCells) % totalThreads != threadId)
-            continue;
-        for (int x = 0; x < TOTAL_NUMBER_OF_CELLS_PER_MAP; ++x)
+        for (uint32 x = beginX; x < endX; ++x)
         {
             uint32 cellId = (y * TOTAL_NUMBER_OF_CELLS_PER_MAP) + x;
             if (!isCellMarked(cellId))
@@ -650,56 +666,91 @@ inline void Map::UpdateActiveCellsCallback(uint32 diff, uint32 now, uint32 threa
     }
 }
 
-class MapAsynchCellsWorker : public ACE_Based::Runnable
+void Map::UpdateCellBlocks(std::vector<uint32> const& blocks, std::atomic<std::size_t>& next, uint32 diff, uint32 now, uint32& workTime)
 {
-public:
-    MapAsynchCellsWorker(int i, int nthreads, uint32 _diff, uint32 _now, uint32 _step, Map* m) : threadIdx(i), nThreads(nthreads), now(_now), diff(_diff), map(m), step(_step)
-    {
-    }
-
-    virtual void run()
-    {
-        map->UpdateActiveCellsCallback(diff, now, threadIdx, nThreads, step);
-    }
-    int threadIdx;
-    int nThreads;
-    uint32 diff, now, step;
-    Map* map;
-};
-
+    PacketCompressorScope compressionScope(&m_compressionStats, now, sWorld.getConfig(CONFIG_UINT32_INTERVAL_MAPUPDATE));
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    // Blocks are taken one at a time, so a crowded block does not hold back the others
+    for (std::size_t i = next++; i < blocks.size(); i = next++)
+        UpdateCellBlock(blocks[i], diff, now);
+    workTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+}
 
 inline void Map::UpdateActiveCellsAsynch(uint32 now, uint32 diff)
 {
     resetMarkedCells();
 
-    // Mark all cells that need update
+    // Two cells closer than SafeDistance must never be updated at the same time (thread race issues).
+    // Cells are grouped in blocks of that size, colored as a checkerboard: blocks of the same color
+    // are always separated by a whole block, so they can be updated in parallel.
+    m_cellBlockSize = sWorld.getConfig(CONFIG_UINT32_MTCELLS_SAFEDISTANCE) / SIZE_OF_GRID_CELL + 1;
+    uint32 const blocksPerSide = (TOTAL_NUMBER_OF_CELLS_PER_MAP + m_cellBlockSize - 1) / m_cellBlockSize;
+    m_markedCellBlocks.assign(blocksPerSide * blocksPerSide, false);
+    for (int color = 0; color < 4; ++color)
+        m_cellBlocksByColor[color].clear();
+
+    // Mark all cells that need update, and the blocks they belong to
+    auto markAroundObject = [this, blocksPerSide](WorldObject const* object)
+    {
+        if (!object || !object->IsInWorld() || !object->IsPositionValid())
+            return;
+        MarkCellsAroundObject(object);
+
+        CellArea area = Cell::CalculateCellArea(object->GetPositionX(), object->GetPositionY(), GetGridActivationDistance());
+        for (uint32 by = area.low_bound.y_coord / m_cellBlockSize; by <= area.high_bound.y_coord / m_cellBlockSize; ++by)
+        {
+            for (uint32 bx = area.low_bound.x_coord / m_cellBlockSize; bx <= area.high_bound.x_coord / m_cellBlockSize; ++bx)
+            {
+                uint32 blockId = by * blocksPerSide + bx;
+                if (m_markedCellBlocks[blockId])
+                    continue;
+                m_markedCellBlocks[blockId] = true;
+                m_cellBlocksByColor[(by % 2) * 2 + (bx % 2)].push_back(blockId);
+            }
+        }
+    };
+
     for (m_mapRefIter = m_mapRefManager.begin(); m_mapRefIter != m_mapRefManager.end(); ++m_mapRefIter)
-        MarkCellsAroundObject(m_mapRefIter->getSource());
+        markAroundObject(m_mapRefIter->getSource());
 
     for (m_activeNonPlayersIter = m_activeNonPlayers.begin(); m_activeNonPlayersIter != m_activeNonPlayers.end(); ++m_activeNonPlayersIter)
-        MarkCellsAroundObject(*m_activeNonPlayersIter);
-
-    const int nthreads = sWorld.getConfig(CONFIG_UINT32_MTCELLS_THREADS);
-    // Step 1
-    std::vector<ACE_Based::Thread*> threads;
-    for (int i = 0; i < (nthreads - 1); ++i)
-        threads.push_back(new ACE_Based::Thread(new MapAsynchCellsWorker(i, nthreads, diff, now, 0, this)));
-    UpdateActiveCellsCallback(diff, now, nthreads-1, nthreads, 0);
-    for (int i = 0; i < threads.size(); ++i)
+        markAroundObject(*m_activeNonPlayersIter);
+
+    uint32 const nthreads = sWorld.getConfig(CONFIG_UINT32_MTCELLS_THREADS);
+    m_cellWorkersTime.assign(nthreads, 0);
+    ThreadPool* pool = sMapMgr.GetCellUpdatePool();
+    std::size_t usedWorkers = 1;                            // slots of m_cellWorkersTime that ran
+
+    for (int color = 0; color < 4; ++color)
     {
-        threads[i]->wait();
-        delete threads[i];
+        std::vector<uint32> const& blocks = m_cellBlocksByColor[color];
+        if (blocks.empty())
+            continue;
+
+        std::atomic<std::size_t> next(0);
+        ThreadPool::TaskGroup blocksUpdate;
+        std::size_t const helpers = pool ? std::min<std::size_t>(nthreads - 1, blocks.size() - 1) : 0;
+        usedWorkers = std::max(usedWorkers, helpers + 1);
+        for (std::size_t i = 1; i <= helpers; ++i)
+        {
+            uint32* workTime = &m_cellWorkersTime[i];
+            pool->Submit([this, &blocks, &next, diff, now, workTime]() { UpdateCellBlocks(blocks, next, diff, now, *workTime); }, &blocksUpdate);
+        }
+        // This thread is a worker too. The pool is shared by the continents: only the blocks of
+        // this map are run while waiting, not the blocks of another map.
+        UpdateCellBlocks(blocks, next, diff, now, m_cellWorkersTime[0]);
+        if (pool)
+            pool->WaitGroupTasks(blocksUpdate);
     }
-    // Step 2
-    threads.clear();
-    for (int i = 0; i < (nthreads - 1); ++i)
-        threads.push_back(new ACE_Based::Thread(new MapAsynchCellsWorker(i, nthreads, diff, now, 1, this)));
-    UpdateActiveCellsCallback(diff, now, nthreads-1, nthreads, 1);
-    for (int i = 0; i < threads.size(); ++i)
+
+    uint32 maxTime = 0;
+    uint64 totalTime = 0;
+    for (std::size_t i = 0; i < usedWorkers; ++i)
     {
-        threads[i]->wait();
-        delete threads[i];
+        maxTime = std::max(maxTime, m_cellWorkersTime[i]);
+        totalTime += m_cellWorkersTime[i];
     }
+    m_cellsUpdateImbalance = totalTime ? uint32(uint64(maxTime) * 100 * usedWorkers / totalTime) : 100;
 }
 
 inline void Map::UpdateActiveCellsSynch(uint32 now, uint32 diff)
@@ -729,21 +780,25 @@ inline void Map::UpdateActiveCellsSynch(uint32 now, uint32 diff)
 class UnitsMovementUpdater : public ACE_Based::Runnable
 {
 public:
-    UnitsMovementUpdater(int i, int nthreads, std::set<Unit*>& _updates, uint32 _diff) : threadIdx(i), nThreads(nthreads), updates(_updates), diff(_diff)
+    UnitsMovementUpdater(int i, int nthreads, MapUpdateQueue<Unit>::EntryList& _updates, uint32 _diff) : threadIdx(i), nThreads(nthreads), updates(_updates), diff(_diff)
     {
     }
 
     virtual void run()
     {
-        int i = 0;
-        for (std::set<Unit*>::iterator iter = updates.begin(); iter != updates.end(); ++iter)
-            if (((++i) % nThreads) == threadIdx)
-                if ((*iter)->IsInWorld())
-                    (*iter)->GetMotionMaster()->UpdateMotionAsync(diff);
+        HeapAllocationCounter::CountCurrentThread();
+
+        // Contiguous and even share of the units
+        std::size_t begin = updates.size() * threadIdx / nThreads;
+        std::size_t end = updates.size() * (threadIdx + 1) / nThreads;
+        for (std::size_t i = begin; i < end; ++i)
+            if (Unit* unit = updates[i].object)
+                if (unit->IsInWorld())
+                    unit->GetMotionMaster()->UpdateMotionAsync(diff);
     }
     int threadIdx;
     int nThreads;
-    std::set<Unit*>& updates;
+    MapUpdateQueue<Unit>::EntryList& updates;
     uint32 diff;
 };
 
@@ -764,16 +819,18 @@ inline void Map::UpdateCells(uint32 map_diff)
     int nthreads = sWorld.getConfig(CONFIG_UINT32_CONTINENTS_MOTIONUPDATE_THREADS);
     if (IsContinent() && nthreads)
     {
+        MapUpdateQueue<Unit>::EntryList& units = unitsMvtUpdate.Collect();
         std::vector<ACE_Based::Thread*> threads;
         for (int i = 0; i < nthreads; ++i)
-            threads.push_back(new ACE_Based::Thread(new UnitsMovementUpdater(i, nthreads, unitsMvtUpdate, diff)));
+            threads.push_back(new ACE_Based::Thread(new UnitsMovementUpdater(i, nthreads, units, diff)));
         for (int i = 0; i < threads.size(); ++i)
         {
             threads[i]->wait();
             delete threads[i];
         }
     }
-    unitsMvtUpdate.clear();
+    unitsMvtUpdate.Collect();
+    unitsMvtUpdate.Clear();
 }
 
 
@@ -856,6 +913,7 @@ void Map::DoUpdate(uint32 maxDiff)
 void Map::Update(uint32 t_diff)
 {
     uint32 updateMapTime = WorldTimer::getMSTime();
+    PacketCompressorScope compressionScope(&m_compressionStats, updateMapTime, sWorld.getConfig(CONFIG_UINT32_INTERVAL_MAPUPDATE));
     uint32 timeDiff = 0;
     _dynamicTree.update(t_diff);
 
@@ -881,6 +939,10 @@ void Map::Update(uint32 t_diff)
     uint32 playersUpdateTime = WorldTimer::getMSTimeDiffToNow(updateMapTime) - sessionsUpdateTime;
 
     UpdateCells(t_diff);
+    // Paths requested by the units, delivered at their next update
+    m_pathRequests->Dispatch();
+    // Grids ahead of the moving players
+    m_gridPreloader->Update(t_diff);
     uint32 activeCellsUpdateTime = WorldTimer::getMSTimeDiffToNow(updateMapTime) - playersUpdateTime - sessionsUpdateTime;
 
     // Send world objects and item update field changes
@@ -895,6 +957,7 @@ void Map::Update(uint32 t_diff)
     uint32 playersUpdateTime2 = WorldTimer::getMSTimeDiffToNow(updateMapTime) - objectsUpdateTime - activeCellsUpdateTime - playersUpdateTime - sessionsUpdateTime - visibilityUpdateTime;
 
     updateMapTime = WorldTimer::getMSTimeDiffToNow(updateMapTime);
+    _updateCost = (_updateCost * 3 + updateMapTime) / 4;
 
     uint32 additionnalWaitTime = 0;
     uint32 additionnalUpdateCounts = 0;
@@ -902,12 +965,8 @@ void Map::Update(uint32 t_diff)
     {
         additionnalWaitTime = WorldTimer::getMSTime();
         sMapMgr.MarkContinentUpdateFinished(_updateIdx);
-        while (!sMapMgr.IsContinentUpdateFinished())
+        while (!sMapMgr.WaitContinentUpdateFinished(10))
         {
-            ACE_Based::Thread::Sleep(10);
-            if (sMapMgr.IsContinentUpdateFinished())
-                break;
-
             UpdateSessionsMovementAndSpellsIfNeeded();
             UpdatePlayers();
             ++additionnalUpdateCounts;
@@ -938,10 +997,10 @@ void Map::Update(uint32 t_diff)
     if (sWorld.getConfig(CONFIG_UINT32_PERFLOG_SLOW_MAP_UPDATE) && updateMapTime > sWorld.getConfig(CONFIG_UINT32_PERFLOG_SLOW_MAP_UPDATE))
         sLog.out(LOG_PERFORMANCE, "Update single map %3u inst %2u: %3ums "
             "[sess %3ums|players %3ums|cells %3ums|sendObjUpdates %3ums"
-            "|relocations %3ums|players2 %3ums|wait%2u %3ums] %s",
+            "|relocations %3ums|players2 %3ums|wait%2u %3ums|cellsImbalance %3u%%] %s",
             GetId(), GetInstanceId(), updateMapTime,
                  sessionsUpdateTime, playersUpdateTime, activeCellsUpdateTime, objectsUpdateTime,
-                 visibilityUpdateTime, playersUpdateTime2, additionnalUpdateCounts, additionnalWaitTime,
+                 visibilityUpdateTime, playersUpdateTime2, additionnalUpdateCounts, additionnalWaitTime, m_cellsUpdateImbalance,
                 packetBroadcastSlow ? "SLOWBCAST" : "");
     // Continent only
     if (IsContinent())
@@ -1138,6 +1197,7 @@ Map::PlayerRelocation(Player *player, float x, float y, float z, float orientati
     bool same_cell = (new_cell == old_cell);
 
     player->Relocate(x, y, z, orientation);
+    player->m_broadcaster->SetPosition(x, y);
 
     if (old_cell.DiffGrid(new_cell) || old_cell.DiffCell(new_cell))
     {
@@ -1168,6 +1228,7 @@ Map::PlayerRelocation(Player *player, float x, float y, float z, float orientati
 void Map::DoPlayerGridRelocation(Player *player, float x, float y, float z, float orientation)
 {
     MANGOS_ASSERT(player);
+    player->m_broadcaster->SetPosition(x, y);
 
     CellPair old_val = MaNGOS::ComputeCellPair(player->GetPositionX(), player->GetPositionY());
     CellPair new_val = MaNGOS::ComputeCellPair(x, y);
@@ -3594,16 +3655,40 @@ WorldObject* Map::GetWorldObject(ObjectGuid guid)
     return NULL;
 }
 
+void Map::AddRelocatedUnit(Unit* obj)
+{
+    if (_processingUnitsRelocation)
+        return;
+    i_unitsRelocated.Add(obj, obj->m_relocationQueueNode);
+}
+
+void Map::RemoveRelocatedUnit(Unit* obj)
+{
+    ASSERT(!_processingUnitsRelocation);
+    i_unitsRelocated.Remove(obj->m_relocationQueueNode);
+}
+
+void Map::AddUnitToMovementUpdate(Unit* unit)
+{
+    unitsMvtUpdate.Add(unit, unit->m_movementUpdateQueueNode);
+}
+
+void Map::RemoveUnitFromMovementUpdate(Unit* unit)
+{
+    unitsMvtUpdate.Remove(unit->m_movementUpdateQueueNode);
+}
+
 class ObjectUpdatePacketBuilder : public ACE_Based::Runnable
 {
 public:
-    ObjectUpdatePacketBuilder(std::set<Object*>::iterator& a, std::set<Object*>::iterator& b, uint32 now) : begin(a), end(b), beginTime(now), current(a)
+    ObjectUpdatePacketBuilder(MapUpdateQueue<Object>::EntryList& l, std::size_t a, std::size_t b, uint32 now, Map* m) : objects(l), current(a), end(b), beginTime(now), map(m)
     {
     }
 
     virtual void run()
     {
         WorldDatabase.ThreadStart(); // Not needed if we don't do SQL queries from this thread ...
+        PacketCompressorScope compressionScope(&map->GetCompressionStats(), beginTime, sWorld.getConfig(CONFIG_UINT32_INTERVAL_MAPUPDATE));
         DoUpdateObjects();
         WorldDatabase.ThreadEnd();
     }
@@ -3616,16 +3701,21 @@ public:
         {
             if (WorldTimer::getMSTimeDiffToNow(beginTime) > timeout)
                 break;
-            (*current)->BuildUpdateData(update_players);
+            MapUpdateQueue<Object>::Entry& entry = objects[current];
+            if (!entry.object)
+                continue;
+            entry.object->BuildUpdateData(update_players);
+            MapUpdateQueue<Object>::Release(entry);
         }
 
         for (UpdateDataMapType::iterator iter = update_players.begin(); iter != update_players.end(); ++iter)
             iter->second.Send(iter->first->GetSession());
     }
-    std::set<Object*>::iterator begin;
-    std::set<Object*>::iterator current;
-    std::set<Object*>::iterator end;
+    MapUpdateQueue<Object>::EntryList& objects;
+    std::size_t current;
+    std::size_t end;
     uint32 beginTime;
+    Map* map;
 };
 
 //#define MAP_SENDOBJECTUPDATES_PROFILE
@@ -3635,7 +3725,8 @@ void Map::SendObjectUpdates()
     // VERY HEAVY LOAD in case of a lot of players at the same place
     // ~2ms / object if 500 players in the visible area around
     uint32 now = WorldTimer::getMSTime();
-    uint32 objectsCount = i_objectsToClientUpdate.size();
+    MapUpdateQueue<Object>::EntryList& objects = i_objectsToClientUpdate.Collect();
+    uint32 objectsCount = objects.size();
     if (!objectsCount)
         return;
     _processingSendObjUpdates = true;
@@ -3655,25 +3746,15 @@ void Map::SendObjectUpdates()
     if (threads > objectsCount)
         threads = objectsCount;
 
-    uint32 step = objectsCount / threads;
-    uint32 i = 0;
     ACE_Based::Thread** updaters = threads > 1 ? new ACE_Based::Thread*[threads - 1] : NULL;
     ObjectUpdatePacketBuilder** objUpdaters = new ObjectUpdatePacketBuilder*[threads];
-    std::set<Object*>::iterator itBegin = i_objectsToClientUpdate.begin();
-    std::set<Object*>::iterator itEnd = i_objectsToClientUpdate.begin();
-    ASSERT(step > 0);
     ASSERT(threads >= 1);
     for (uint32 i = 0; i < threads; ++i)
     {
-        itBegin = itEnd;
-        if (i == (threads - 1))
-            itEnd = i_objectsToClientUpdate.end();
-        else
-        {
-            for (uint32 j = 0; j < step; ++j)
-                ++itEnd;
-        }
-        objUpdaters[i] = new ObjectUpdatePacketBuilder(itBegin, itEnd, now);
+        // Contiguous ranges, sizes differ by at most one object
+        std::size_t itBegin = std::size_t(objectsCount) * i / threads;
+        std::size_t itEnd = std::size_t(objectsCount) * (i + 1) / threads;
+        objUpdaters[i] = new ObjectUpdatePacketBuilder(objects, itBegin, itEnd, now, this);
         objUpdaters[i]->incReference();
 
         if (i == (threads - 1)) // Do not create a useless supplementary thread
@@ -3685,18 +3766,15 @@ void Map::SendObjectUpdates()
         updaters[i]->wait();
     for (uint32 i = 0; i < threads; ++i)
     {
-        /* std::set::erase
-         * Iterators, pointers and references referring to elements removed by the function are invalidated.
-         * All other iterators, pointers and references keep their validity.
-         */
-        i_objectsToClientUpdate.erase(objUpdaters[i]->begin, objUpdaters[i]->current);
         objUpdaters[i]->decReference();
         if (i != (threads - 1))
             delete updaters[i];
     }
+    // Objects not processed before the timeout stay queued, in front of the next ones
+    i_objectsToClientUpdate.Compact();
 
     // If we timeout, use more threads !
-    if (i_objectsToClientUpdate.size())
+    if (!objects.empty())
         ++_objUpdatesThreads;
     else
         --_objUpdatesThreads;
@@ -3707,14 +3785,14 @@ void Map::SendObjectUpdates()
 #ifdef MAP_SENDOBJECTUPDATES_PROFILE
     uint32 diff = WorldTimer::getMSTimeDiffToNow(now);
     if (diff > 50)
-        sLog.outString("SendObjectUpdates in %04u ms [%u threads. %3u/%3u]", diff, threads, objectsCount - i_objectsToClientUpdate.size(), objectsCount);
+        sLog.outString("SendObjectUpdates in %04u ms [%u threads. %3u/%3u]", diff, threads, objectsCount - objects.size(), objectsCount);
 #endif
 }
 
 class VisibilityUpdater : public ACE_Based::Runnable
 {
 public:
-    VisibilityUpdater(std::set<Unit*>::iterator& a, std::set<Unit*>::iterator& b, uint32 now) : begin(a), end(b), beginTime(now), current(a)
+    VisibilityUpdater(MapUpdateQueue<Unit>::EntryList& l, std::size_t a, std::size_t b, uint32 now) : units(l), current(a), end(b), beginTime(now)
     {
     }
 
@@ -3731,12 +3809,16 @@ public:
         {
             if (WorldTimer::getMSTimeDiffToNow(beginTime) > timeout)
                 break;
-            (*current)->ProcessRelocationVisibilityUpdates();
+            MapUpdateQueue<Unit>::Entry& entry = units[current];
+            if (!entry.object)
+                continue;
+            entry.object->ProcessRelocationVisibilityUpdates();
+            MapUpdateQueue<Unit>::Release(entry);
         }
     }
-    std::set<Unit*>::iterator begin;
-    std::set<Unit*>::iterator current;
-    std::set<Unit*>::iterator end;
+    MapUpdateQueue<Unit>::EntryList& units;
+    std::size_t current;
+    std::size_t end;
     uint32 beginTime;
 };
 
@@ -3746,7 +3828,8 @@ void Map::UpdateVisibilityForRelocations()
 {
     // VERY HEAVY LOAD in case of a lot of players at the same place
     uint32 now = WorldTimer::getMSTime();
-    uint32 objectsCount = i_unitsRelocated.size();
+    MapUpdateQueue<Unit>::EntryList& units = i_unitsRelocated.Collect();
+    uint32 objectsCount = units.size();
     if (!objectsCount)
         return;
     _processingUnitsRelocation = true;
@@ -3766,24 +3849,13 @@ void Map::UpdateVisibilityForRelocations()
     if (threads > objectsCount)
         threads = objectsCount;
 
-    uint32 step = objectsCount / threads;
-    uint32 i = 0;
     ACE_Based::Thread** updaters = threads > 1 ? new ACE_Based::Thread*[threads - 1] : NULL;
     VisibilityUpdater** visUpdaters = new VisibilityUpdater*[threads];
-    std::set<Unit*>::iterator itBegin = i_unitsRelocated.begin();
-    std::set<Unit*>::iterator itEnd = i_unitsRelocated.begin();
-    ASSERT(step > 0);
     for (uint32 i = 0; i < threads; ++i)
     {
-        itBegin = itEnd;
-        if (i == (threads - 1))
-            itEnd = i_unitsRelocated.end();
-        else
-        {
-            for (uint32 j = 0; j < step; ++j)
-                ++itEnd;
-        }
-        visUpdaters[i] = new VisibilityUpdater(itBegin, itEnd, now);
+        std::size_t itBegin = std::size_t(objectsCount) * i / threads;
+        std::size_t itEnd = std::size_t(objectsCount) * (i + 1) / threads;
+        visUpdaters[i] = new VisibilityUpdater(units, itBegin, itEnd, now);
         visUpdaters[i]->incReference();
         if (i == (threads - 1))
             visUpdaters[i]->DoUpdateVisibility();
@@ -3794,13 +3866,13 @@ void Map::UpdateVisibilityForRelocations()
         updaters[i]->wait();
     for (uint32 i = 0; i < threads; ++i)
     {
-        i_unitsRelocated.erase(visUpdaters[i]->begin, visUpdaters[i]->current);
         visUpdaters[i]->decReference();
         if (i != (threads - 1))
             delete updaters[i];
     }
+    i_unitsRelocated.Compact();
 
-    if (i_unitsRelocated.size())
+    if (!units.empty())
         ++_unitRelocationThreads;
     else
         --_unitRelocationThreads;
@@ -3812,7 +3884,7 @@ void Map::UpdateVisibilityForRelocations()
 #ifdef MAP_UPDATEVISIBILITY_PROFILE
     uint32 diff = WorldTimer::getMSTimeDiffToNow(now);
     if (diff > 50)
-        sLog.outString("VisibilityUpdate in %04u ms [%u threads/done %u/%u]", diff, threads, objectsCount - i_unitsRelocated.size(), objectsCount);
+        sLog.outString("VisibilityUpdate in %04u ms [%u threads/done %u/%u]", diff, threads, objectsCount - units.size(), objectsCount);
 #endif
 }
 
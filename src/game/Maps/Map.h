@@ -37,6 +37,7 @@
 #include "GridMap.h"
 #include "GameSystem/GridRefManager.h"
 #include "MapRefManager.h"
+#include "MapUpdateQueue.h"
 #include "Utilities/TypeList.h"
 #include "ScriptMgr.h"
 #include "vmap/DynamicTree.h"
@@ -44,6 +45,7 @@
 #include "WorldSession.h"
 #include "SQLStorages.h"
 
+#include <atomic>
 #include <bitset>
 #include <list>
 #include <set>
@@ -64,6 +66,8 @@ class WorldPersistentState;
 class DungeonPersistentState;
 class BattleGroundPersistentState;
 class ChatHandler;
+class PathRequestQueue;
+class GridPreloader;
 
 struct ScriptInfo;
 class BattleGround;
@@ -195,6 +199,7 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
     friend class MapReference;
     friend class ObjectGridLoader;
     friend class ObjectWorldLoader;
+    friend class GridPreloader;
 
     protected:
         Map(uint32 id, time_t, uint32 InstanceId);
@@ -224,7 +229,8 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
         inline void UpdateActiveCellsSynch(uint32 now, uint32 diff);
         inline void MarkCellsAroundObject(WorldObject const* object);
         inline void UpdateActiveCellsAsynch(uint32 now, uint32 diff);
-        inline void UpdateActiveCellsCallback(uint32 diff, uint32 now, uint32 threadId, uint32 totalThreads, uint32 step);
+        inline void UpdateCellBlock(uint32 blockId, uint32 diff, uint32 now);
+        void UpdateCellBlocks(std::vector<uint32> const& blocks, std::atomic<std::size_t>& next, uint32 diff, uint32 now, uint32& workTime);
         inline void UpdateCells(uint32 diff);
         void UpdateSync(const uint32);
         void UpdatePlayers();
@@ -363,47 +369,20 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
         {
             if (_processingSendObjUpdates)
                 return;
-            i_objectsToClientUpdate_lock.acquire();
-            i_objectsToClientUpdate.insert(obj);
-            i_objectsToClientUpdate_lock.release();
+            i_objectsToClientUpdate.Add(obj, obj->GetClientUpdateQueueNode());
         }
 
         void RemoveUpdateObject(Object *obj)
         {
             ASSERT(!_processingSendObjUpdates);
-            i_objectsToClientUpdate_lock.acquire();
-            i_objectsToClientUpdate.erase( obj );
-            i_objectsToClientUpdate_lock.release();
+            i_objectsToClientUpdate.Remove(obj->GetClientUpdateQueueNode());
         }
         // May be called from a different map ...
-        void AddRelocatedUnit(Unit* obj)
-        {
-            if (_processingUnitsRelocation)
-                return;
-            i_unitsRelocated_lock.acquire();
-            i_unitsRelocated.insert(obj);
-            i_unitsRelocated_lock.release();
-        }
-        void RemoveRelocatedUnit(Unit* obj)
-        {
-            ASSERT(!_processingUnitsRelocation);
-            i_unitsRelocated_lock.acquire();
-            i_unitsRelocated.erase(obj);
-            i_unitsRelocated_lock.release();
-        }
+        void AddRelocatedUnit(Unit* obj);
+        void RemoveRelocatedUnit(Unit* obj);
 
-        void AddUnitToMovementUpdate(Unit* unit)
-        {
-            unitsMvtUpdate_lock.acquire();
-            unitsMvtUpdate.insert(unit);
-            unitsMvtUpdate_lock.release();
-        }
-        void RemoveUnitFromMovementUpdate(Unit* unit)
-        {
-            unitsMvtUpdate_lock.acquire();
-            unitsMvtUpdate.erase(unit);
-            unitsMvtUpdate_lock.release();
-        }
+        void AddUnitToMovementUpdate(Unit* unit);
+        void RemoveUnitFromMovementUpdate(Unit* unit);
         // DynObjects currently
         uint32 GenerateLocalLowGuid(HighGuid guidhigh);
 
@@ -485,6 +464,19 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
         void TeleportAllPlayersToHomeBind();
 
         void SetMapUpdateIndex(int idx) { _updateIdx = idx; }
+        // Smoothed duration of the last updates (ms), used to schedule expensive maps first
+        uint32 GetUpdateCost() const { return _updateCost; }
+        // Slowest cell worker time in percent of the average one, 100 when perfectly balanced
+        uint32 GetCellsUpdateImbalance() const { return m_cellsUpdateImbalance; }
+        // Values update blocks sent to observers: built for them, or shared with another observer
+        void AddUpdateBlocksStats(uint32 built, uint32 reused) { m_updateBlocksBuilt += built; m_updateBlocksReused += reused; }
+        uint64 GetUpdateBlocksBuilt() const { return m_updateBlocksBuilt; }
+        uint64 GetUpdateBlocksReused() const { return m_updateBlocksReused; }
+        CompressionStats& GetCompressionStats() { return m_compressionStats; }
+        // Asynchronous pathfinding of the movement generators
+        PathRequestQueue* GetPathRequestQueue() const { return m_pathRequests; }
+        // Grids read ahead of the players
+        GridPreloader* GetGridPreloader() const { return m_gridPreloader; }
 
     private:
         void LoadMapAndVMap(int gx, int gy);
@@ -526,16 +518,13 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
 
         bool                    _processingSendObjUpdates;
         uint32                  _objUpdatesThreads;
-        mutable MapMutexType    i_objectsToClientUpdate_lock;
-        std::set<Object *>      i_objectsToClientUpdate;
+        MapUpdateQueue<Object>  i_objectsToClientUpdate;
 
         bool                    _processingUnitsRelocation;
         uint32                  _unitRelocationThreads;
-        mutable MapMutexType    i_unitsRelocated_lock;
-        std::set<Unit* >        i_unitsRelocated;
+        MapUpdateQueue<Unit>    i_unitsRelocated;
 
-        mutable MapMutexType    unitsMvtUpdate_lock;
-        std::set<Unit*>         unitsMvtUpdate;
+        MapUpdateQueue<Unit>    unitsMvtUpdate;
 
     protected:
         MapEntry const* i_mapEntry;
@@ -581,6 +570,20 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
 
         std::bitset<TOTAL_NUMBER_OF_CELLS_PER_MAP*TOTAL_NUMBER_OF_CELLS_PER_MAP> marked_cells;
 
+        // Multithreaded cells update: marked cells grouped by blocks of MTCells.SafeDistance,
+        // split in the 4 colors of a checkerboard
+        uint32 m_cellBlockSize;
+        std::vector<bool> m_markedCellBlocks;
+        std::vector<uint32> m_cellBlocksByColor[4];
+        std::vector<uint32> m_cellWorkersTime;
+        uint32 m_cellsUpdateImbalance;
+
+        std::atomic<uint64> m_updateBlocksBuilt;
+        std::atomic<uint64> m_updateBlocksReused;
+        CompressionStats m_compressionStats;
+        PathRequestQueue* m_pathRequests;
+        GridPreloader* m_gridPreloader;
+
         mutable MapMutexType    i_objectsToRemove_lock;
         std::set<WorldObject *> i_objectsToRemove;
 
@@ -610,6 +613,7 @@ class MANGOS_DLL_SPEC Map : public GridRefManager<NGridType>, public MaNGOS::Obj
         uint32 _lastPlayersUpdate;
         uint32 _inactivePlayersSkippedUpdates;
         uint32 _lastCellsUpdate;
+        uint32 _updateCost;
 
         int8 _updateIdx;
     public:
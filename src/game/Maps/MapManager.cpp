@@ -22,6 +22,7 @@
 #include "MapManager.h"
 #include "MapPersistentStateMgr.h"
 #include "Policies/SingletonImp.h"
+#include "Policies/MemoryManagement.h"
 #include "Database/DatabaseEnv.h"
 #include "Log.h"
 #include "GridDefines.h"
@@ -40,8 +41,8 @@ MapManager::MapManager()
     : i_gridCleanUpDelay(sWorld.getConfig(CONFIG_UINT32_INTERVAL_GRIDCLEAN)),
     i_MaxInstanceId(RESERVED_INSTANCES_LAST),
     i_GridStateErrorCount(0),
-    i_continentUpdateFinished(NULL),
-    i_maxContinentThread(0)
+    i_maxContinentThread(0),
+    i_continentUpdatesExpected(0)
 {
     i_timer.SetInterval(sWorld.getConfig(CONFIG_UINT32_INTERVAL_MAPUPDATE));
 }
@@ -59,6 +60,22 @@ MapManager::Initialize()
 {
     InitStateMachine();
     InitMaxInstanceId();
+
+    uint32 threads = sWorld.getConfig(CONFIG_UINT32_MAPUPDATE_THREADS);
+    if (!threads)
+        threads = ThreadPool::GetDefaultThreadCount();
+    m_updatePool.reset(new ThreadPool(threads,
+                                      []() { WorldDatabase.ThreadStart(); HeapAllocationCounter::CountCurrentThread(); },
+                                      []() { WorldDatabase.ThreadEnd(); }));
+    sLog.outString("Map update pool started with %u workers", threads);
+
+    // The thread updating the map takes part in its cells update
+    uint32 cellThreads = sWorld.getConfig(CONFIG_UINT32_MTCELLS_THREADS);
+    if (cellThreads > 1)
+        m_cellUpdatePool.reset(new ThreadPool(cellThreads - 1,
+                                              []() { WorldDatabase.ThreadStart(); HeapAllocationCounter::CountCurrentThread(); },
+                                              []() { WorldDatabase.ThreadEnd(); }));
+
     for (auto itr = sMapStorage.begin<MapEntry>(); itr < sMapStorage.end<MapEntry>(); ++itr)
     {
         bool load = false;
@@ -238,54 +255,10 @@ void MapManager::DeleteInstance(uint32 mapid, uint32 instanceId)
     }
 }
 
-class MapAsyncUpdater : public ACE_Based::Runnable
-{
-public:
-    MapAsyncUpdater(bool* updFinished, uint32 updateDiff) :
-        updateFinished(updFinished), diff(updateDiff), loops(0)
-    {
-    }
-
-    virtual void run()
-    {
-        WorldDatabase.ThreadStart();
-        do
-        {
-            for (std::vector<Map*>::iterator it = maps.begin(); it != maps.end(); ++it)
-            {
-                if (loops && *updateFinished)
-                    break;
-                (*it)->DoUpdate(diff);
-            }
-            if (!(*updateFinished))
-                ACE_Based::Thread::Sleep(5);
-            ++loops;
-        }
-        while (!(*updateFinished));
-        WorldDatabase.ThreadEnd();
-    }
-    std::vector<Map*> maps;
-    volatile bool* updateFinished;
-    uint32 diff;
-    uint32 loops;
-};
-
-class ContinentAsyncUpdater : public ACE_Based::Runnable
+static bool MapUpdateCostCompare(Map const* a, Map const* b)
 {
-public:
-    ContinentAsyncUpdater(uint32 updateDiff, Map* m) : diff(updateDiff), map(m)
-    {
-    }
-
-    virtual void run()
-    {
-        WorldDatabase.ThreadStart();
-        map->DoUpdate(diff);
-        WorldDatabase.ThreadEnd();
-    }
-    Map* map;
-    uint32 diff;
-};
+    return a->GetUpdateCost() > b->GetUpdateCost();
+}
 
 void MapManager::Update(uint32 diff)
 {
@@ -294,14 +267,9 @@ void MapManager::Update(uint32 diff)
         return;
 
     uint32 mapsDiff = (uint32)i_timer.GetCurrent();
-    bool updateFinished = false;
-    std::vector<MapAsyncUpdater*> instanceUpdaters(sWorld.getConfig(CONFIG_UINT32_MAPUPDATE_INSTANCED_UPDATE_THREADS));
-    std::vector<ContinentAsyncUpdater*> continentsUpdaters;
-    for (int i = 0; i < instanceUpdaters.size(); ++i)
-        instanceUpdaters[i] = new MapAsyncUpdater(&updateFinished, mapsDiff); // Will be deleted at thread end
-
-    int mapIdx = 0;
-    int continentsIdx = 0;
+    std::vector<Map*> continents;
+    std::vector<Map*> instances;
+
     uint32 now = WorldTimer::getMSTime();
     for (MapMapType::iterator iter = i_maps.begin(); iter != i_maps.end(); ++iter)
     {
@@ -315,51 +283,58 @@ void MapManager::Update(uint32 diff)
         iter->second->MarkNotUpdated();
         iter->second->SetMapUpdateIndex(-1);
         if (iter->second->Instanceable())
-        {
-            if (instanceUpdaters.size())
-            {
-                instanceUpdaters[mapIdx % instanceUpdaters.size()]->maps.push_back(iter->second);
-                ++mapIdx;
-            }
-            else
-                iter->second->Update(mapsDiff);
-        }
-        else // One threat per continent part
-        {
-            iter->second->SetMapUpdateIndex(continentsIdx++);
-            ContinentAsyncUpdater* task = new ContinentAsyncUpdater(mapsDiff, iter->second);
-            continentsUpdaters.push_back(task);
-        }
+            instances.push_back(iter->second);
+        else // One task per continent part
+            continents.push_back(iter->second);
     }
-    i_maxContinentThread = continentsIdx;
-    i_continentUpdateFinished = new volatile bool[i_maxContinentThread];
+
+    // Start the most expensive maps first, so they don't end up last on a busy worker
+    std::sort(continents.begin(), continents.end(), MapUpdateCostCompare);
+    std::sort(instances.begin(), instances.end(), MapUpdateCostCompare);
+
+    i_maxContinentThread = continents.size();
+    i_continentUpdateFinished.reset(new std::atomic<bool>[i_maxContinentThread]);
+    i_continentUpdatesExpected = std::min<int>(i_maxContinentThread, m_updatePool->GetThreadCount());
     for (int i = 0; i < i_maxContinentThread; ++i)
+    {
         i_continentUpdateFinished[i] = false;
+        continents[i]->SetMapUpdateIndex(i);
+    }
 
-    std::vector<ACE_Based::Thread*> asyncUpdateThreads(instanceUpdaters.size() + continentsUpdaters.size());
+    ThreadPool::TaskGroup continentsUpdate;
+    ThreadPool::TaskGroup instancesUpdate;
+    for (std::vector<Map*>::const_iterator it = continents.begin(); it != continents.end(); ++it)
+    {
+        Map* map = *it;
+        m_updatePool->Submit([map, mapsDiff]() { map->DoUpdate(mapsDiff); }, &continentsUpdate);
+    }
 
-    for (int tid = 0; tid < instanceUpdaters.size(); ++tid)
-        asyncUpdateThreads[tid]                             = new ACE_Based::Thread(instanceUpdaters[tid]);
-    for (int tid = 0; tid < continentsUpdaters.size(); ++tid)
-        asyncUpdateThreads[tid + instanceUpdaters.size()]   = new ACE_Based::Thread(continentsUpdaters[tid]);
+    // Instances keep being updated while continents are not finished. An instance
+    // is only queued again once its previous update is done.
+    std::unique_ptr<std::atomic_bool[]> instanceUpdating(new std::atomic_bool[instances.size()]);
+    for (std::size_t i = 0; i < instances.size(); ++i)
+        instanceUpdating[i] = false;
 
-    // Finish continents updating
-    for (int tid = instanceUpdaters.size(); tid < asyncUpdateThreads.size(); ++tid)
+    do
     {
-        asyncUpdateThreads[tid]->wait();
-        delete asyncUpdateThreads[tid];
+        for (std::size_t i = 0; i < instances.size(); ++i)
+        {
+            if (instanceUpdating[i])
+                continue;
+            instanceUpdating[i] = true;
+            Map* map = instances[i];
+            std::atomic_bool* updating = &instanceUpdating[i];
+            m_updatePool->Submit([map, mapsDiff, updating]() { map->DoUpdate(mapsDiff); *updating = false; }, &instancesUpdate);
+        }
     }
+    while (!continentsUpdate.WaitFor(std::chrono::milliseconds(5)));
 
-    updateFinished = true;
     SwitchPlayersInstances();
 
     // And then instances updating
-    for (int tid = 0; tid < instanceUpdaters.size(); ++tid)
-    {
-        asyncUpdateThreads[tid]->wait();
-        delete asyncUpdateThreads[tid];
-    }
-    delete[] i_continentUpdateFinished;
+    m_updatePool->Wait(instancesUpdate);
+    i_continentUpdateFinished.reset();
+    i_maxContinentThread = 0;
 
     MapMapType::iterator crashedMapsIter = i_maps.begin();
     while (crashedMapsIter != i_maps.end())
@@ -418,6 +393,12 @@ bool MapManager::IsValidMAP(uint32 mapid)
 
 void MapManager::UnloadAll()
 {
+    // Workers use the world database, stop them while it is still alive
+    if (m_updatePool)
+        m_updatePool->Stop();
+    if (m_cellUpdatePool)
+        m_cellUpdatePool->Stop();
+
     for (MapMapType::iterator iter = i_maps.begin(); iter != i_maps.end(); ++iter)
         iter->second->UnloadAll(true);
 
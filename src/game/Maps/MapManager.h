@@ -29,6 +29,11 @@
 #include "ace/Thread_Mutex.h"
 #include "Map.h"
 #include "GridStates.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 
 class BattleGround;
 
@@ -181,15 +186,28 @@ class MANGOS_DLL_DECL MapManager : public MaNGOS::Singleton<MapManager, MaNGOS::
         void MarkContinentUpdateFinished(int idx)
         {
             ASSERT(idx < i_maxContinentThread);
+            std::lock_guard<std::mutex> guard(i_continentUpdateLock);
             i_continentUpdateFinished[idx] = true;
+            i_continentUpdateCond.notify_all();
         }
+        // Waits for as many continents as the update workers can run at once, whatever their start
+        // order: with fewer workers than continents, the others only start once a worker is free.
         bool IsContinentUpdateFinished()
         {
+            int finished = 0;
             for (int i = 0; i < i_maxContinentThread; ++i)
-                if (!i_continentUpdateFinished[i])
-                    return false;
-            return true;
+                if (i_continentUpdateFinished[i])
+                    ++finished;
+            return finished >= i_continentUpdatesExpected;
         }
+        // Returns false if the other continents are still updated after timeoutMs
+        bool WaitContinentUpdateFinished(uint32 timeoutMs)
+        {
+            std::unique_lock<std::mutex> guard(i_continentUpdateLock);
+            return i_continentUpdateCond.wait_for(guard, std::chrono::milliseconds(timeoutMs), [this]() { return IsContinentUpdateFinished(); });
+        }
+        // Helpers for continents cells update (MTCells), NULL if disabled
+        ThreadPool* GetCellUpdatePool() { return m_cellUpdatePool.get(); }
     private:
 
         // debugging code, should be deleted some day
@@ -217,7 +235,14 @@ class MANGOS_DLL_DECL MapManager : public MaNGOS::Singleton<MapManager, MaNGOS::
 
         uint32 i_MaxInstanceId;
         int             i_maxContinentThread;
-        volatile bool*  i_continentUpdateFinished;
+        std::unique_ptr<std::atomic<bool>[]> i_continentUpdateFinished;
+        int             i_continentUpdatesExpected;      // set before the continent updates are submitted
+        std::mutex i_continentUpdateLock;
+        std::condition_variable i_continentUpdateCond;
+
+        // Long-lived workers shared by continents and instances
+        std::unique_ptr<ThreadPool> m_updatePool;
+        std::unique_ptr<ThreadPool> m_cellUpdatePool;
 
         // Instanced continent zones
         const static int LAST_CONTINENT_ID = 2;
@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_MAPUPDATEQUEUE_H
+#define MANGOS_MAPUPDATEQUEUE_H
+
+#include "Platform/Define.h"
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Intrusive part of a MapUpdateQueue entry, embedded in the queued objects.
+ * It replaces the lookup of the old std::set: an object knows whether it is
+ * already queued (deduplication) and where (constant time removal).
+ */
+struct MapUpdateQueueNode
+{
+    MapUpdateQueueNode() : queue(nullptr), location(0) {}
+
+    std::atomic<void const*> queue;                         // owning queue, NULL when not queued
+    std::atomic<uint64> location;                           // shard << 32 | index in that shard
+};
+
+namespace MaNGOS
+{
+    // Small per-thread index, used to give each producer thread its own buffer
+    inline uint32 GetMapUpdateQueueThreadSlot()
+    {
+        static std::atomic<uint32> nextSlot(0);
+        thread_local uint32 slot = nextSlot++;
+        return slot;
+    }
+}
+
+/**
+ * Multi producer / single consumer queue of objects to process once per map tick.
+ * Producers (cells update workers, other maps) append to a buffer picked by their
+ * thread, so they never contend with each other. Once per tick the consumer
+ * merges all buffers into a contiguous list, which can be split evenly between
+ * update threads. Entries left unprocessed (timeout) stay queued for the next tick.
+ */
+template<class T>
+class MapUpdateQueue
+{
+    public:
+        struct Entry
+        {
+            T* object;
+            MapUpdateQueueNode* node;
+        };
+        typedef std::vector<Entry> EntryList;
+
+        MapUpdateQueue() : m_pending(0) {}
+
+        // Thread safe. Returns false if the object is already queued.
+        bool Add(T* object, MapUpdateQueueNode& node)
+        {
+            // Claims the node, the queue is only published once the entry and its location are stored
+            void const* expected = nullptr;
+            if (!node.queue.compare_exchange_strong(expected, Adding()))
+                return false;
+
+            uint32 shardId = MaNGOS::GetMapUpdateQueueThreadSlot() % SHARD_COUNT;
+            Shard& shard = m_shards[shardId];
+            shard.Lock();
+            node.location.store((uint64(shardId) << 32) | shard.entries.size());
+            Entry entry = { object, &node };
+            shard.entries.push_back(entry);
+            shard.Unlock();
+            ++m_pending;
+            node.queue.store(this);
+            return true;
+        }
+
+        // Must not be called while the collected list is processed
+        void Remove(MapUpdateQueueNode& node)
+        {
+            void const* queue = node.queue.load();
+            while (queue == Adding())
+            {
+                std::this_thread::yield();
+                queue = node.queue.load();
+            }
+            if (queue != this)
+                return;
+
+            uint64 location = node.location.load();
+            uint32 shardId = uint32(location >> 32);
+            std::size_t index = std::size_t(location & 0xFFFFFFFF);
+            if (shardId == COLLECTED)
+            {
+                if (index < m_collected.size() && m_collected[index].node == &node)
+                    m_collected[index].object = nullptr;
+            }
+            else if (shardId < SHARD_COUNT)
+            {
+                Shard& shard = m_shards[shardId];
+                shard.Lock();
+                if (index < shard.entries.size() && shard.entries[index].node == &node)
+                    shard.entries[index].object = nullptr;
+                shard.Unlock();
+            }
+            node.queue.store(nullptr);
+        }
+
+        // Consumer only. Appends the entries queued since the last call after
+        // the ones left from the previous ticks, and returns the whole list.
+        EntryList& Collect()
+        {
+            if (!m_pending.load())
+                return m_collected;
+
+            for (uint32 shardId = 0; shardId < SHARD_COUNT; ++shardId)
+            {
+                Shard& shard = m_shards[shardId];
+                shard.Lock();
+                for (typename EntryList::const_iterator itr = shard.entries.begin(); itr != shard.entries.end(); ++itr)
+                {
+                    if (!itr->object)
+                        continue;
+                    itr->node->location.store((uint64(COLLECTED) << 32) | m_collected.size());
+                    m_collected.push_back(*itr);
+                }
+                m_pending -= shard.entries.size();
+                shard.entries.clear();                      // keeps capacity for the next ticks
+                shard.Unlock();
+            }
+            return m_collected;
+        }
+
+        // Marks a collected entry as processed. Entries are owned by a single
+        // update thread, so this can be called concurrently on different entries.
+        static void Release(Entry& entry)
+        {
+            entry.object = nullptr;
+            entry.node->queue.store(nullptr);
+        }
+
+        // Consumer only. Drops processed entries, keeping the order of the others.
+        void Compact()
+        {
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < m_collected.size(); ++i)
+            {
+                if (!m_collected[i].object)
+                    continue;
+                m_collected[i].node->location.store((uint64(COLLECTED) << 32) | kept);
+                m_collected[kept++] = m_collected[i];
+            }
+            m_collected.resize(kept);
+        }
+
+        // Consumer only. Dequeues every collected entry.
+        void Clear()
+        {
+            for (typename EntryList::iterator itr = m_collected.begin(); itr != m_collected.end(); ++itr)
+                if (itr->object)
+                    Release(*itr);
+            m_collected.clear();
+        }
+
+        // Approximate if producers are running
+        std::size_t size() const { return m_collected.size() + m_pending.load(); }
+
+    private:
+        MapUpdateQueue(MapUpdateQueue const&);
+        MapUpdateQueue& operator=(MapUpdateQueue const&);
+
+        // Owner of the nodes being added to any queue
+        static void const* Adding()
+        {
+            static char const marker = 0;
+            return &marker;
+        }
+
+        static const uint32 SHARD_COUNT = 16;
+        static const uint32 COLLECTED   = SHARD_COUNT;
+
+        struct Shard
+        {
+            Shard() { flag.clear(); }
+
+            // Only contended when an entry is removed while its producer appends
+            void Lock() { while (flag.test_and_set(std::memory_order_acquire)) std::this_thread::yield(); }
+            void Unlock() { flag.clear(std::memory_order_release); }
+
+            std::atomic_flag flag;
+            EntryList entries;
+            char padding[64];                               // keep producers on separate cache lines
+        };
+
+        Shard m_shards[SHARD_COUNT];
+        EntryList m_collected;
+        std::atomic<std::size_t> m_pending;
+};
+
+#endif
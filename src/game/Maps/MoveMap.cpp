@@ -23,6 +23,13 @@
 #include "MoveMap.h"
 #include "MoveMapSharedDefines.h"
 
+#include "Detour/Include/DetourCommon.h"
+#include "Detour/Include/DetourNode.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
 namespace MMAP
 {
 // ######################## MMapFactory ########################
@@ -46,6 +53,312 @@ void MMapFactory::clear()
     }
 }
 
+// ######################## NavMeshQueryPool ########################
+namespace
+{
+    // nodes of the dtNavMeshQuery A* searches
+    const int NAVMESH_QUERY_MAX_NODES = 2048;
+    // queries kept by a pool for the next threads, the others are freed
+    const uint32 NAVMESH_QUERY_MAX_POOLED = 8;
+
+    // pools alive, by id
+    typedef UNORDERED_MAP<uint32, NavMeshQueryPool*> NavMeshQueryPoolSet;
+    NavMeshQueryPoolSet g_queryPools;
+    ACE_Thread_Mutex g_queryPoolsLock;
+    uint32 g_nextQueryPoolId = 0;
+
+    std::atomic<uint32> g_queryThreadsCount(0);
+
+    // queries owned by the current thread, by pool id
+    struct ThreadNavMeshQueries
+    {
+        typedef std::vector<std::pair<uint32, dtNavMeshQuery*> > QueryList;
+
+        ~ThreadNavMeshQueries()
+        {
+            if (queries.empty())
+                return;
+
+            // queries of the unloaded maps are already freed
+            ACE_Guard<ACE_Thread_Mutex> guard(g_queryPoolsLock);
+            for (QueryList::const_iterator itr = queries.begin(); itr != queries.end(); ++itr)
+            {
+                NavMeshQueryPoolSet::const_iterator pool = g_queryPools.find(itr->first);
+                if (pool != g_queryPools.end())
+                    pool->second->Release(itr->second);
+            }
+            --g_queryThreadsCount;
+        }
+
+        void Add(uint32 poolId, dtNavMeshQuery* query)
+        {
+            if (queries.empty())
+                ++g_queryThreadsCount;
+            else
+            {
+                // forget the queries of the unloaded maps
+                ACE_Guard<ACE_Thread_Mutex> guard(g_queryPoolsLock);
+                for (QueryList::iterator itr = queries.begin(); itr != queries.end();)
+                {
+                    if (g_queryPools.find(itr->first) == g_queryPools.end())
+                        itr = queries.erase(itr);
+                    else
+                        ++itr;
+                }
+            }
+            queries.push_back(std::make_pair(poolId, query));
+        }
+
+        QueryList queries;
+    };
+
+    thread_local ThreadNavMeshQueries t_navMeshQueries;
+}
+
+NavMeshQueryPool::NavMeshQueryPool(dtNavMesh const* navMesh) : m_navMesh(navMesh)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(g_queryPoolsLock);
+    m_id = ++g_nextQueryPoolId;
+    g_queryPools[m_id] = this;
+}
+
+NavMeshQueryPool::~NavMeshQueryPool()
+{
+    {
+        ACE_Guard<ACE_Thread_Mutex> guard(g_queryPoolsLock);
+        g_queryPools.erase(m_id);
+    }
+
+    for (std::vector<dtNavMeshQuery*>::const_iterator itr = m_inUse.begin(); itr != m_inUse.end(); ++itr)
+        dtFreeNavMeshQuery(*itr);
+    for (std::vector<dtNavMeshQuery*>::const_iterator itr = m_pooled.begin(); itr != m_pooled.end(); ++itr)
+        dtFreeNavMeshQuery(*itr);
+}
+
+dtNavMeshQuery* NavMeshQueryPool::GetThreadQuery()
+{
+    ThreadNavMeshQueries& threadQueries = t_navMeshQueries;
+    for (ThreadNavMeshQueries::QueryList::const_iterator itr = threadQueries.queries.begin(); itr != threadQueries.queries.end(); ++itr)
+        if (itr->first == m_id)
+            return itr->second;
+
+    dtNavMeshQuery* query = Acquire();
+    if (query)
+        threadQueries.Add(m_id, query);
+    return query;
+}
+
+dtNavMeshQuery* NavMeshQueryPool::Acquire()
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(m_lock);
+
+    dtNavMeshQuery* query;
+    if (!m_pooled.empty())
+    {
+        query = m_pooled.back();
+        m_pooled.pop_back();
+    }
+    else
+    {
+        query = dtAllocNavMeshQuery();
+        MANGOS_ASSERT(query);
+    }
+
+    // the node pool of a reused query is kept
+    uint32 tid = ACE_Based::Thread::currentId();
+    if (dtStatusFailed(query->init(m_navMesh, NAVMESH_QUERY_MAX_NODES, tid)))
+    {
+        dtFreeNavMeshQuery(query);
+        sLog.outError("MMAP:NavMeshQueryPool: Failed to initialize dtNavMeshQuery for thread %u", tid);
+        return NULL;
+    }
+
+    m_inUse.push_back(query);
+    return query;
+}
+
+void NavMeshQueryPool::Release(dtNavMeshQuery* query)
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(m_lock);
+
+    std::vector<dtNavMeshQuery*>::iterator itr = std::find(m_inUse.begin(), m_inUse.end(), query);
+    if (itr == m_inUse.end())
+        return;
+    m_inUse.erase(itr);
+
+    if (m_pooled.size() < NAVMESH_QUERY_MAX_POOLED)
+        m_pooled.push_back(query);
+    else
+        dtFreeNavMeshQuery(query);
+}
+
+void NavMeshQueryPool::GetCounts(uint32& inUse, uint32& pooled) const
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(m_lock);
+    inUse = m_inUse.size();
+    pooled = m_pooled.size();
+}
+
+// ######################## PathCorridorCache ########################
+PathCorridorCache::PathCorridorCache(dtNavMesh const* navMesh, uint32 maxEntries) :
+    m_navMesh(navMesh), m_maxEntries(maxEntries), m_hits(0), m_repairs(0), m_misses(0), m_invalidated(0)
+{
+}
+
+uint32 PathCorridorCache::Find(dtPolyRef startRef, dtPolyRef endRef, dtQueryFilter const& filter, dtPolyRef* path, uint32 maxPath)
+{
+    if (!m_maxEntries)
+        return 0;
+
+    Key key(startRef, endRef, filter);
+    ACE_Guard<ACE_Thread_Mutex> guard(m_lock);
+
+    EntryMap::const_iterator itr = m_index.find(key);
+    if (itr != m_index.end() && itr->second->path.size() <= maxPath)
+    {
+        m_entries.splice(m_entries.begin(), m_entries, itr->second);
+        std::vector<dtPolyRef> const& cached = itr->second->path;
+        std::copy(cached.begin(), cached.end(), path);
+        ++m_hits;
+        return cached.size();
+    }
+
+    std::vector<dtPolyRef> repaired;
+    if ((Repair(startRef, endRef, filter, true, repaired) || Repair(startRef, endRef, filter, false, repaired)) && repaired.size() <= maxPath)
+    {
+        std::copy(repaired.begin(), repaired.end(), path);
+        uint32 length = repaired.size();
+        Store(key, repaired);
+        ++m_repairs;
+        return length;
+    }
+
+    ++m_misses;
+    return 0;
+}
+
+void PathCorridorCache::Add(dtPolyRef startRef, dtPolyRef endRef, dtQueryFilter const& filter, dtPolyRef const* path, uint32 pathLength)
+{
+    if (!m_maxEntries || !pathLength)
+        return;
+
+    std::vector<dtPolyRef> corridor(path, path + pathLength);
+    ACE_Guard<ACE_Thread_Mutex> guard(m_lock);
+    Store(Key(startRef, endRef, filter), corridor);
+}
+
+void PathCorridorCache::InvalidateTile(int32 tileX, int32 tileY)
+{
+    if (!m_maxEntries)
+        return;
+
+    ACE_Guard<ACE_Thread_Mutex> guard(m_lock);
+    for (EntryList::iterator itr = m_entries.begin(); itr != m_entries.end();)
+    {
+        // The polygons on the borders of the neighbour tiles are linked to the tile
+        if (tileX >= itr->minTileX - 1 && tileX <= itr->maxTileX + 1 && tileY >= itr->minTileY - 1 && tileY <= itr->maxTileY + 1)
+        {
+            m_index.erase(itr->key);
+            itr = m_entries.erase(itr);
+            ++m_invalidated;
+        }
+        else
+            ++itr;
+    }
+}
+
+void PathCorridorCache::GetStats(Stats& stats) const
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(m_lock);
+    stats.entries = m_entries.size();
+    stats.hits = m_hits;
+    stats.repairs = m_repairs;
+    stats.misses = m_misses;
+    stats.invalidated = m_invalidated;
+}
+
+bool PathCorridorCache::GetPolyTile(dtPolyRef ref, dtMeshTile const*& tile, dtPoly const*& poly) const
+{
+    return dtStatusSucceed(m_navMesh->getTileAndPolyByRef(ref, &tile, &poly));
+}
+
+bool PathCorridorCache::Repair(dtPolyRef startRef, dtPolyRef endRef, dtQueryFilter const& filter, bool atEnd, std::vector<dtPolyRef>& path)
+{
+    // Looks for the corridor of a neighbour of the moved polygon, then walks the link between them
+    dtPolyRef const movedRef = atEnd ? endRef : startRef;
+    dtMeshTile const* tile;
+    dtPoly const* poly;
+    if (!GetPolyTile(movedRef, tile, poly) || !filter.passFilter(movedRef, tile, poly))
+        return false;
+
+    for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+    {
+        dtPolyRef const neighbourRef = tile->links[i].ref;
+        EntryMap::const_iterator itr = m_index.find(atEnd ? Key(startRef, neighbourRef, filter) : Key(neighbourRef, endRef, filter));
+        if (itr == m_index.end())
+            continue;
+
+        // An incomplete corridor does not reach the neighbour
+        std::vector<dtPolyRef> const& cached = itr->second->path;
+        if ((atEnd ? cached.back() : cached.front()) != neighbourRef)
+            continue;
+
+        path = cached;
+        if (atEnd)
+        {
+            // The corridor may already go through the new end polygon
+            std::vector<dtPolyRef>::iterator pos = std::find(path.begin(), path.end(), endRef);
+            if (pos != path.end())
+                path.erase(pos + 1, path.end());
+            else
+                path.push_back(endRef);
+        }
+        else
+        {
+            std::vector<dtPolyRef>::iterator pos = std::find(path.begin(), path.end(), startRef);
+            if (pos != path.end())
+                path.erase(path.begin(), pos);
+            else
+                path.insert(path.begin(), startRef);
+        }
+        return true;
+    }
+    return false;
+}
+
+void PathCorridorCache::Store(Key const& key, std::vector<dtPolyRef>& path)
+{
+    EntryMap::iterator itr = m_index.find(key);
+    if (itr != m_index.end())
+        m_entries.splice(m_entries.begin(), m_entries, itr->second);
+    else
+    {
+        m_entries.push_front(Entry(key));
+        m_index.insert(EntryMap::value_type(key, m_entries.begin()));
+        if (m_entries.size() > m_maxEntries)
+        {
+            m_index.erase(m_entries.back().key);
+            m_entries.pop_back();
+        }
+    }
+
+    Entry& entry = m_entries.front();
+    entry.path.swap(path);
+    entry.minTileX = entry.minTileY = std::numeric_limits<int32>::max();
+    entry.maxTileX = entry.maxTileY = std::numeric_limits<int32>::min();
+    for (std::vector<dtPolyRef>::const_iterator ref = entry.path.begin(); ref != entry.path.end(); ++ref)
+    {
+        dtMeshTile const* tile;
+        dtPoly const* poly;
+        if (!GetPolyTile(*ref, tile, poly))
+            continue;
+        entry.minTileX = std::min(entry.minTileX, tile->header->x);
+        entry.minTileY = std::min(entry.minTileY, tile->header->y);
+        entry.maxTileX = std::max(entry.maxTileX, tile->header->x);
+        entry.maxTileY = std::max(entry.maxTileY, tile->header->y);
+    }
+}
+
 // ######################## MMapManager ########################
 MMapManager::~MMapManager()
 {
@@ -100,7 +413,7 @@ bool MMapManager::loadMapData(uint32 mapId)
     DETAIL_LOG("MMAP:loadMapData: Loaded %03i.mmap", mapId);
 
     // store inside our map list
-    MMapData* mmap_data = new MMapData(mesh);
+    MMapData* mmap_data = new MMapData(mesh, sWorld.getConfig(CONFIG_UINT32_MMAP_PATH_CACHE_SIZE));
     mmap_data->mmapLoadedTiles.clear();
 
     loadedMMaps_lock.acquire_write();
@@ -186,11 +499,14 @@ bool MMapManager::loadMap(uint32 mapId, int32 x, int32 y)
     dtTileRef tileRef = 0;
 
     // memory allocated for data is now managed by detour, and will be deallocated when the tile is removed
+    ACE_Write_Guard<ACE_RW_Mutex> navMeshGuard(mmap->navMesh_lock);
     dtStatus dResult = mmap->navMesh->addTile(data, fileHeader.size, DT_TILE_FREE_DATA, 0, &tileRef);
     if (dtStatusSucceed(dResult))
     {
         mmap->mmapLoadedTiles.insert(std::pair<uint32, dtTileRef>(packedGridPos, tileRef));
         ++loadedTiles;
+        // the known corridors around the tile may not be the shortest anymore
+        mmap->corridorCache.InvalidateTile(header->x, header->y);
         return true;
     }
     else
@@ -225,6 +541,12 @@ bool MMapManager::unloadMap(uint32 mapId, int32 x, int32 y)
     }
 
     dtTileRef tileRef = mmap->mmapLoadedTiles[packedGridPos];
+    dtMeshHeader const* header = mmap->navMesh->getTileByRef(tileRef)->header;
+    int32 const tileX = header->x;
+    int32 const tileY = header->y;
+
+    ACE_Write_Guard<ACE_RW_Mutex> navMeshGuard(mmap->navMesh_lock);
+    mmap->corridorCache.InvalidateTile(tileX, tileY);
 
     // unload, and mark as non loaded
     if (DT_SUCCESS != mmap->navMesh->removeTile(tileRef, NULL, NULL))
@@ -256,6 +578,7 @@ bool MMapManager::unloadMap(uint32 mapId)
 
     // unload all tiles from given map
     MMapData* mmap = loadedMMaps[mapId];
+    mmap->navMesh_lock.acquire_write();
     for (MMapTileSet::iterator i = mmap->mmapLoadedTiles.begin(); i != mmap->mmapLoadedTiles.end(); ++i)
     {
         uint32 x = (i->first >> 16);
@@ -265,6 +588,7 @@ bool MMapManager::unloadMap(uint32 mapId)
         else
             --loadedTiles;
     }
+    mmap->navMesh_lock.release();
 
     delete mmap;
     loadedMMaps.erase(mapId);
@@ -273,75 +597,78 @@ bool MMapManager::unloadMap(uint32 mapId)
     return true;
 }
 
-bool MMapManager::unloadMapInstance(uint32 mapId, uint32 instanceId)
+dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
 {
-    // check if we have this map loaded
     if (loadedMMaps.find(mapId) == loadedMMaps.end())
-    {
-        // file may not exist, therefore not loaded
-        DEBUG_LOG("MMAP:unloadMapInstance: Asked to unload not loaded navmesh map %03u", mapId);
-        return false;
-    }
-
-    MMapData* mmap = loadedMMaps[mapId];
-    if (mmap->navMeshQueries.find(instanceId) == mmap->navMeshQueries.end())
-    {
-        DEBUG_LOG("MMAP:unloadMapInstance: Asked to unload not loaded dtNavMeshQuery mapId %03u instanceId %u", mapId, instanceId);
-        return false;
-    }
+        return NULL;
 
-    dtNavMeshQuery* query = mmap->navMeshQueries[instanceId];
+    return loadedMMaps[mapId]->navMesh;
+}
 
-    dtFreeNavMeshQuery(query);
-    mmap->navMeshQueries.erase(instanceId);
-    DETAIL_LOG("MMAP:unloadMapInstance: Unloaded mapId %03u instanceId %u", mapId, instanceId);
+PathCorridorCache* MMapManager::GetPathCorridorCache(uint32 mapId)
+{
+    MMapDataSet::const_iterator itr = loadedMMaps.find(mapId);
+    if (itr == loadedMMaps.end())
+        return NULL;
 
-    return true;
+    return &itr->second->corridorCache;
 }
 
-dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
+ACE_RW_Mutex* MMapManager::GetNavMeshLock(uint32 mapId)
 {
-    if (loadedMMaps.find(mapId) == loadedMMaps.end())
+    MMapDataSet::const_iterator itr = loadedMMaps.find(mapId);
+    if (itr == loadedMMaps.end())
         return NULL;
 
-    return loadedMMaps[mapId]->navMesh;
+    return &itr->second->navMesh_lock;
 }
 
 dtNavMeshQuery const* MMapManager::GetNavMeshQuery(uint32 mapId)
 {
-    if (loadedMMaps.find(mapId) == loadedMMaps.end())
+    MMapDataSet::const_iterator itr = loadedMMaps.find(mapId);
+    if (itr == loadedMMaps.end())
         return NULL;
 
-    uint32 tid = ACE_Based::Thread::currentId();
-    MMapData* mmap = loadedMMaps[mapId];
-    mmap->navMeshQueries_lock.acquire_read();
+    return itr->second->navMeshQueries.GetThreadQuery();
+}
 
-    NavMeshQuerySet::iterator it = mmap->navMeshQueries.find(tid);
-    dtNavMeshQuery* navMeshQuery = NULL;
-    if (it == mmap->navMeshQueries.end())
-    {
-        mmap->navMeshQueries_lock.release();
-        mmap->navMeshQueries_lock.acquire_write();
+void MMapManager::GetNavMeshQueryCounts(uint32& inUse, uint32& pooled)
+{
+    inUse = 0;
+    pooled = 0;
 
-        // allocate mesh query
-        navMeshQuery = dtAllocNavMeshQuery();
-        MANGOS_ASSERT(navMeshQuery);
-        if (DT_SUCCESS != navMeshQuery->init(mmap->navMesh, 2048, tid))
-        {
-            mmap->navMeshQueries_lock.release();
-            dtFreeNavMeshQuery(navMeshQuery);
-            sLog.outError("MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId %03u thread %u", mapId, tid);
-            return NULL;
-        }
+    uint32 mapInUse, mapPooled;
+    loadedMMaps_lock.acquire_read();
+    for (MMapDataSet::const_iterator itr = loadedMMaps.begin(); itr != loadedMMaps.end(); ++itr)
+    {
+        itr->second->navMeshQueries.GetCounts(mapInUse, mapPooled);
+        inUse += mapInUse;
+        pooled += mapPooled;
+    }
+    loadedMMaps_lock.release();
 
-        DETAIL_LOG("MMAP:GetNavMeshQuery: created dtNavMeshQuery for mapId %03u thread %u", mapId, tid);
-        mmap->navMeshQueries.insert(std::pair<uint32, dtNavMeshQuery*>(tid, navMeshQuery));
+    ACE_Guard<ACE_Thread_Mutex> guard(lockForModels);
+    for (MMapDataSet::const_iterator itr = loadedModels.begin(); itr != loadedModels.end(); ++itr)
+    {
+        itr->second->navMeshQueries.GetCounts(mapInUse, mapPooled);
+        inUse += mapInUse;
+        pooled += mapPooled;
     }
-    else
-        navMeshQuery = it->second;
-    mmap->navMeshQueries_lock.release();
+}
+
+uint32 MMapManager::GetNavMeshQueryThreadsCount()
+{
+    return g_queryThreadsCount;
+}
 
-    return navMeshQuery;
+uint32 MMapManager::GetNavMeshQuerySize()
+{
+    // dtNavMeshQuery::init: node pool, tiny node pool (64 nodes) and open list
+    uint32 const hashSize = dtNextPow2(NAVMESH_QUERY_MAX_NODES / 4);
+    return sizeof(dtNavMeshQuery) + 2 * sizeof(dtNodePool) + sizeof(dtNodeQueue) +
+           NAVMESH_QUERY_MAX_NODES * (sizeof(dtNode) + sizeof(dtNodeIndex)) + hashSize * sizeof(dtNodeIndex) +
+           64 * (sizeof(dtNode) + sizeof(dtNodeIndex)) + 32 * sizeof(dtNodeIndex) +
+           (NAVMESH_QUERY_MAX_NODES + 1) * sizeof(dtNode*);
 }
 
 bool MMapManager::loadGameObject(uint32 displayId)
@@ -413,31 +740,10 @@ bool MMapManager::loadGameObject(uint32 displayId)
 
 dtNavMeshQuery const* MMapManager::GetModelNavMeshQuery(uint32 displayId)
 {
-    if (loadedModels.find(displayId) == loadedModels.end())
+    MMapDataSet::const_iterator itr = loadedModels.find(displayId);
+    if (itr == loadedModels.end())
         return NULL;
 
-    uint32 tid = ACE_Based::Thread::currentId();
-    MMapData* mmap = loadedModels[displayId];
-    if (mmap->navMeshQueries.find(tid) == mmap->navMeshQueries.end())
-    {
-        ACE_Guard<ACE_Thread_Mutex> g(lockForModels);
-        if (mmap->navMeshQueries.find(tid) == mmap->navMeshQueries.end())
-        {
-            // allocate mesh query
-            dtNavMeshQuery* query = dtAllocNavMeshQuery();
-            MANGOS_ASSERT(query);
-            if (dtStatusFailed(query->init(mmap->navMesh, 2048, tid)))
-            {
-                dtFreeNavMeshQuery(query);
-                sLog.outError("MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for displayid %03u tid %u", displayId, tid);
-                return NULL;
-            }
-
-            DETAIL_LOG("MMAP:GetNavMeshQuery: created dtNavMeshQuery for displayid %03u tid %u", displayId, tid);
-            mmap->navMeshQueries.insert(std::pair<uint32, dtNavMeshQuery*>(tid, query));
-        }
-    }
-
-    return mmap->navMeshQueries[tid];
+    return itr->second->navMeshQueries.GetThreadQuery();
 }
 }
@@ -25,6 +25,9 @@
 
 #include "Utilities/UnorderedMapSet.h"
 
+#include <list>
+#include <vector>
+
 #include "Detour/Include/DetourAlloc.h"
 #include "Detour/Include/DetourNavMesh.h"
 #include "Detour/Include/DetourNavMeshQuery.h"
@@ -44,28 +47,135 @@ inline void dtCustomFree(void* ptr)
 namespace MMAP
 {
     typedef UNORDERED_MAP<uint32, dtTileRef> MMapTileSet;
-    typedef UNORDERED_MAP<uint32, dtNavMeshQuery*> NavMeshQuerySet;
+
+    // Pool of the dtNavMeshQuery objects of a navmesh. dtNavMeshQuery is not thread safe, so each
+    // thread gets its own: it is kept in a thread local cache, looked up without any lock, until the
+    // thread exits. It then goes back to the pool, to be reused by the next thread.
+    class NavMeshQueryPool
+    {
+        public:
+            explicit NavMeshQueryPool(dtNavMesh const* navMesh);
+            // The queries still used by threads are freed too
+            ~NavMeshQueryPool();
+
+            // Query of the current thread, allocated or taken from the pool on first use
+            dtNavMeshQuery* GetThreadQuery();
+
+            void GetCounts(uint32& inUse, uint32& pooled) const;
+
+            // Called at thread exit
+            void Release(dtNavMeshQuery* query);
+
+        private:
+            NavMeshQueryPool(NavMeshQueryPool const&);
+            NavMeshQueryPool& operator=(NavMeshQueryPool const&);
+
+            dtNavMeshQuery* Acquire();
+
+            dtNavMesh const* m_navMesh;
+            uint32 m_id;                                    // identifies the pool in the thread caches, never reused
+            std::vector<dtNavMeshQuery*> m_inUse;
+            std::vector<dtNavMeshQuery*> m_pooled;
+            mutable ACE_Thread_Mutex m_lock;
+    };
+
+    // Most recently used polygon corridors of a navmesh, by start and end polygons and filter.
+    // A corridor is also repaired for a start or end polygon next to the cached one, as the
+    // targets of the chasing creatures usually move to a neighbour polygon between two searches.
+    // The corridors crossing or touching a tile are dropped when the tile is loaded or unloaded.
+    // Outside of the map thread, Find must be called with the navmesh lock held for reading, as
+    // the repairs read the tiles of the navmesh (MMapData::navMesh_lock).
+    class PathCorridorCache
+    {
+        public:
+            struct Stats
+            {
+                uint32 entries;
+                uint64 hits;
+                uint64 repairs;                             // reused with a neighbour start or end polygon
+                uint64 misses;
+                uint64 invalidated;
+            };
+
+            PathCorridorCache(dtNavMesh const* navMesh, uint32 maxEntries);
+
+            // Copies the corridor from startRef to endRef in 'path', returns its length (0 if not cached)
+            uint32 Find(dtPolyRef startRef, dtPolyRef endRef, dtQueryFilter const& filter, dtPolyRef* path, uint32 maxPath);
+            // Corridor found by dtNavMeshQuery::findPath
+            void Add(dtPolyRef startRef, dtPolyRef endRef, dtQueryFilter const& filter, dtPolyRef const* path, uint32 pathLength);
+            // Before a tile is removed from the navmesh, or after it is added, with the navmesh lock held for writing
+            void InvalidateTile(int32 tileX, int32 tileY);
+
+            void GetStats(Stats& stats) const;
+
+        private:
+            PathCorridorCache(PathCorridorCache const&);
+            PathCorridorCache& operator=(PathCorridorCache const&);
+
+            struct Key
+            {
+                Key(dtPolyRef start, dtPolyRef end, dtQueryFilter const& filter) :
+                    startRef(start), endRef(end), flags(uint32(filter.getIncludeFlags()) << 16 | filter.getExcludeFlags()) {}
+                bool operator==(Key const& other) const { return startRef == other.startRef && endRef == other.endRef && flags == other.flags; }
+
+                dtPolyRef startRef;
+                dtPolyRef endRef;
+                uint32 flags;
+            };
+
+            struct KeyHash
+            {
+                std::size_t operator()(Key const& key) const
+                {
+                    return std::size_t(uint64(key.startRef) * 0x9E3779B97F4A7C15ULL ^ uint64(key.endRef) * 0xC2B2AE3D27D4EB4FULL ^ key.flags);
+                }
+            };
+
+            struct Entry
+            {
+                explicit Entry(Key const& k) : key(k), minTileX(0), minTileY(0), maxTileX(0), maxTileY(0) {}
+
+                Key key;
+                std::vector<dtPolyRef> path;
+                int32 minTileX, minTileY, maxTileX, maxTileY;   // tiles crossed by the corridor
+            };
+
+            typedef std::list<Entry> EntryList;             // most recently used first
+            typedef UNORDERED_MAP<Key, EntryList::iterator, KeyHash> EntryMap;
+
+            // Returns false if a polygon is not in the navmesh
+            bool GetPolyTile(dtPolyRef ref, dtMeshTile const*& tile, dtPoly const*& poly) const;
+            bool Repair(dtPolyRef startRef, dtPolyRef endRef, dtQueryFilter const& filter, bool atEnd, std::vector<dtPolyRef>& path);
+            void Store(Key const& key, std::vector<dtPolyRef>& path);
+
+            dtNavMesh const* m_navMesh;
+            uint32 const m_maxEntries;
+            EntryList m_entries;
+            EntryMap m_index;
+            uint64 m_hits;
+            uint64 m_repairs;
+            uint64 m_misses;
+            uint64 m_invalidated;
+            mutable ACE_Thread_Mutex m_lock;
+    };
 
     // dummy struct to hold map's mmap data
     struct MMapData
     {
-        MMapData(dtNavMesh* mesh) : navMesh(mesh) {}
+        MMapData(dtNavMesh* mesh, uint32 corridorCacheSize = 0) : navMesh(mesh), navMeshQueries(mesh), corridorCache(mesh, corridorCacheSize) {}
         ~MMapData()
         {
-            for (NavMeshQuerySet::iterator i = navMeshQueries.begin(); i != navMeshQueries.end(); ++i)
-                dtFreeNavMeshQuery(i->second);
-
             if (navMesh)
                 dtFreeNavMesh(navMesh);
         }
 
         dtNavMesh* navMesh;
 
-        // we have to use single dtNavMeshQuery for every instance, since those are not thread safe
-        NavMeshQuerySet navMeshQueries;     // threadId to query
-        ACE_RW_Mutex navMeshQueries_lock;
+        NavMeshQueryPool navMeshQueries;
+        PathCorridorCache corridorCache;
         MMapTileSet mmapLoadedTiles;        // maps [map grid coords] to [dtTile]
         ACE_Thread_Mutex tilesLoading_lock;
+        ACE_RW_Mutex navMesh_lock;          // read by the async searches, written when a tile is added or removed
     };
 
     typedef UNORDERED_MAP<uint32, MMapData*> MMapDataSet;
@@ -82,16 +192,26 @@ namespace MMAP
             bool loadGameObject(uint32 displayId);
             bool unloadMap(uint32 mapId, int32 x, int32 y);
             bool unloadMap(uint32 mapId);
-            bool unloadMapInstance(uint32 mapId, uint32 instanceId);
 
             // The returned [dtNavMeshQuery const*] is NOT threadsafe
             // Returns a NavMeshQuery valid for current thread only.
             dtNavMeshQuery const* GetNavMeshQuery(uint32 mapId);
             dtNavMeshQuery const* GetModelNavMeshQuery(uint32 displayId);
             dtNavMesh const* GetNavMesh(uint32 mapId);
+            // Corridors of the map searches, NULL if the map navmesh is not loaded
+            PathCorridorCache* GetPathCorridorCache(uint32 mapId);
+            // Held for reading by the searches running outside of the map thread, NULL if the map navmesh is not loaded
+            ACE_RW_Mutex* GetNavMeshLock(uint32 mapId);
 
             uint32 getLoadedTilesCount() const { return loadedTiles; }
             uint32 getLoadedMapsCount() const { return loadedMMaps.size(); }
+
+            // dtNavMeshQuery of all the maps and models, used by a thread or kept for the next ones
+            void GetNavMeshQueryCounts(uint32& inUse, uint32& pooled);
+            // Threads owning dtNavMeshQuery objects
+            static uint32 GetNavMeshQueryThreadsCount();
+            // Approximate memory used by a dtNavMeshQuery, in bytes
+            static uint32 GetNavMeshQuerySize();
         private:
             bool loadMapData(uint32 mapId);
             uint32 packTileID(int32 x, int32 y);
@@ -35,7 +35,9 @@
 PathInfo::PathInfo(const Unit* owner) :
     m_polyLength(0), m_type(PATHFIND_BLANK),
     m_useStraightPath(false), m_forceDestination(false), m_pointPathLimit(MAX_POINT_PATH_LENGTH),
-    m_sourceUnit(owner), m_navMesh(NULL), m_navMeshQuery(NULL), m_transport(NULL), m_targetAllowedFlags(0)
+    m_sourceUnit(owner), m_navMesh(NULL), m_navMeshQuery(NULL), m_corridorCache(NULL), m_transport(NULL), m_targetAllowedFlags(0),
+    m_sourceGuidLow(owner->GetGUIDLow()), m_sourceCanFly(false), m_deferSearch(false), m_searchPending(false),
+    m_startPoly(INVALID_POLYREF), m_endPoly(INVALID_POLYREF), m_distToStartPoly(0.0f), m_distToEndPoly(0.0f)
 {
     //DEBUG_FILTER_LOG(LOG_FILTER_PATHFINDING, "++ PathFinder::PathInfo for %u \n", m_sourceUnit->GetGUIDLow());
     createFilter();
@@ -62,9 +64,13 @@ bool PathInfo::calculate(float destX, float destY, float destZ, bool forceDest,
         if (!offsets)
             m_transport->CalculatePassengerOffset(destX, destY, destZ);
         m_navMeshQuery = mmap->GetModelNavMeshQuery(m_transport->GetDisplayId());
+        m_corridorCache = NULL;
     }
     else
+    {
         m_navMeshQuery = mmap->GetNavMeshQuery(m_sourceUnit->GetMapId());
+        m_corridorCache = mmap->GetPathCorridorCache(m_sourceUnit->GetMapId());
+    }
 
     if (m_navMeshQuery)
         m_navMesh = m_navMeshQuery->getAttachedNavMesh();
@@ -81,6 +87,8 @@ bool PathInfo::calculate(float destX, float destY, float destZ, bool forceDest,
     setStartPosition(start);
 
     m_forceDestination = forceDest;
+    m_sourceCanFly = m_sourceUnit->CanFly();
+    m_searchPending = false;
     m_type = PATHFIND_BLANK;
 
     //DEBUG_FILTER_LOG(LOG_FILTER_PATHFINDING, "++ PathFinder::calculate() for %u \n", m_sourceUnit->GetGUIDLow());
@@ -116,6 +124,68 @@ bool PathInfo::calculate(float destX, float destY, float destZ, bool forceDest,
     }
 }
 
+bool PathInfo::calculateAsync(float destX, float destY, float destZ, bool forceDest)
+{
+    // No previous poly path to reuse: the searches do not depend on the previous calculations
+    clear();
+    m_deferSearch = true;
+    calculate(destX, destY, destZ, forceDest);
+    m_deferSearch = false;
+    return m_searchPending;
+}
+
+void PathInfo::searchAsync(dtNavMeshQuery const* query, MMAP::PathCorridorCache* corridorCache, std::vector<PathInfo*> const& sameSearches)
+{
+    MANGOS_ASSERT(m_searchPending);
+
+    m_searchPending = false;
+    m_navMeshQuery = query;
+    m_navMesh = query ? query->getAttachedNavMesh() : NULL;
+    m_corridorCache = corridorCache;
+
+    // The navmesh may have been unloaded since the path was prepared
+    bool found = false;
+    if (m_navMeshQuery)
+        found = FindPolyPath();
+    else
+    {
+        BuildShortcut();
+        m_type = PATHFIND_NOPATH;
+    }
+
+    for (std::vector<PathInfo*>::const_iterator itr = sameSearches.begin(); itr != sameSearches.end(); ++itr)
+    {
+        PathInfo* path = *itr;
+        MANGOS_ASSERT(path->m_searchPending);
+        path->m_searchPending = false;
+        path->m_navMeshQuery = m_navMeshQuery;
+        path->m_navMesh = m_navMesh;
+        path->m_corridorCache = m_corridorCache;
+        if (!found)
+        {
+            path->BuildShortcut();
+            path->m_type = PATHFIND_NOPATH;
+            continue;
+        }
+
+        memcpy(path->m_pathPolyRefs, m_pathPolyRefs, m_polyLength * sizeof(dtPolyRef));
+        path->m_polyLength = m_polyLength;
+        path->FinishPolyPath();
+    }
+
+    if (found)
+        FinishPolyPath();
+}
+
+void PathInfo::cancelAsync()
+{
+    MANGOS_ASSERT(m_searchPending);
+
+    m_searchPending = false;
+    BuildShortcut();
+    m_type = PathType(PATHFIND_NORMAL | PATHFIND_NOT_USING_PATH);
+}
+
 dtPolyRef PathInfo::FindWalkPoly(dtNavMeshQuery const* query, float const* pointYZX, dtQueryFilter const& filter, float* closestPointYZX, float zSearchDist)
 {
     ASSERT(query);
@@ -152,9 +222,12 @@ void PathInfo::BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos)
 {
     // *** getting start/end poly logic ***
 
-    float distToStartPoly, distToEndPoly;
-    float startPoint[VERTEX_SIZE] = {startPos.y, startPos.z, startPos.x};
-    float endPoint[VERTEX_SIZE] = {endPos.y, endPos.z, endPos.x};
+    float& distToStartPoly = m_distToStartPoly;
+    float& distToEndPoly = m_distToEndPoly;
+    float* startPoint = m_startPoint;
+    float* endPoint = m_endPoint;
+    dtVset(startPoint, startPos.y, startPos.z, startPos.x);
+    dtVset(endPoint, endPos.y, endPos.z, endPos.x);
 
     // First case : easy flying / swimming
     if ((m_sourceUnit->CanSwim() && m_sourceUnit->GetTerrain()->IsInWater(endPos.x, endPos.y, endPos.z)) ||
@@ -176,13 +249,13 @@ void PathInfo::BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos)
         else if (m_sourceUnit->CanFly())
             m_forceDestination = true;
     }
-    dtPolyRef startPoly = getPolyByLocation(startPoint, &distToStartPoly);
-    dtPolyRef endPoly = getPolyByLocation(endPoint, &distToEndPoly, m_targetAllowedFlags);
+    m_startPoly = getPolyByLocation(startPoint, &distToStartPoly);
+    m_endPoly = getPolyByLocation(endPoint, &distToEndPoly, m_targetAllowedFlags);
 
     // we have a hole in our mesh
     // make shortcut path and mark it as NOPATH ( with flying exception )
     // its up to caller how he will use this info
-    if (startPoly == INVALID_POLYREF || endPoly == INVALID_POLYREF)
+    if (m_startPoly == INVALID_POLYREF || m_endPoly == INVALID_POLYREF)
     {
         //DEBUG_FILTER_LOG(LOG_FILTER_PATHFINDING, "++ BuildPolyPath :: (startPoly == 0 || endPoly == 0)\n");
         BuildShortcut();
@@ -219,7 +292,7 @@ void PathInfo::BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos)
         else
         {
             float closestPoint[VERTEX_SIZE];
-            if (dtStatusSucceed(m_navMeshQuery->closestPointOnPolyBoundary(endPoly, endPoint, closestPoint)))
+            if (dtStatusSucceed(m_navMeshQuery->closestPointOnPolyBoundary(m_endPoly, endPoint, closestPoint)))
             {
                 dtVcopy(endPoint, closestPoint);
                 setActualEndPosition(Vector3(endPoint[2], endPoint[0], endPoint[1]));
@@ -229,6 +302,24 @@ void PathInfo::BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos)
         }
     }
 
+    // The searches only use the navmesh: the async ones are run later, on another thread
+    if (m_deferSearch)
+    {
+        m_searchPending = true;
+        return;
+    }
+
+    if (FindPolyPath())
+        FinishPolyPath();
+}
+
+bool PathInfo::FindPolyPath()
+{
+    dtPolyRef const startPoly = m_startPoly;
+    dtPolyRef const endPoly = m_endPoly;
+    float const* startPoint = m_startPoint;
+    float const* endPoint = m_endPoint;
+
     // *** poly path generating logic ***
 
     // look for startPoly/endPoly in current path
@@ -304,7 +395,7 @@ void PathInfo::BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos)
                 // suffixStartPoly is still invalid, error state
                 BuildShortcut();
                 m_type = PATHFIND_NOPATH;
-                return;
+                return false;
             }
         }
 
@@ -325,7 +416,7 @@ void PathInfo::BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos)
             // this is probably an error state, but we'll leave it
             // and hopefully recover on the next Update
             // we still need to copy our preffix
-            sLog.outError("%u's Path Build failed: 0 length path r=0x%x", m_sourceUnit->GetGUIDLow(), dtResult);
+            sLog.outError("%u's Path Build failed: 0 length path r=0x%x", m_sourceGuidLow, dtResult);
         }
 
         //DEBUG_FILTER_LOG(LOG_FILTER_PATHFINDING, "++  m_polyLength=%u prefixPolyLength=%u suffixPolyLength=%u \n",m_polyLength, prefixPolyLength, suffixPolyLength);
@@ -349,6 +440,12 @@ void PathInfo::BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos)
         if (threadId != m_navMeshQuery->m_owningThread)
             sLog.outError("CRASH: We are using a dtNavMeshQuery from thread %u which belongs to thread %u!", threadId, m_navMeshQuery->m_owningThread);
 
+        // corridor of a previous search between the same polygons, or their neighbours
+        if (m_corridorCache)
+            m_polyLength = m_corridorCache->Find(startPoly, endPoly, m_filter, m_pathPolyRefs, MAX_PATH_LENGTH);
+        if (m_polyLength)
+            return true;
+
         dtStatus dtResult = m_navMeshQuery->findPath(
                                 startPoly,          // start polygon
                                 endPoly,            // end polygon
@@ -362,20 +459,27 @@ void PathInfo::BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos)
         if (!m_polyLength || dtStatusFailed(dtResult))
         {
             // only happens if we passed bad data to findPath(), or navmesh is messed up
-            sLog.outError("%u's Path Build failed: 0 length path. Result=0x%x", m_sourceUnit->GetGUIDLow(), dtResult);
+            sLog.outError("%u's Path Build failed: 0 length path. Result=0x%x", m_sourceGuidLow, dtResult);
             BuildShortcut();
             m_type = PATHFIND_NOPATH;
-            return;
+            return false;
         }
+
+        if (m_corridorCache)
+            m_corridorCache->Add(startPoly, endPoly, m_filter, m_pathPolyRefs, m_polyLength);
     }
+    return true;
+}
 
+void PathInfo::FinishPolyPath()
+{
     // by now we know what type of path we can get
-    if (m_pathPolyRefs[m_polyLength - 1] == endPoly && !(m_type & (PATHFIND_INCOMPLETE | PATHFIND_NOPATH)))
+    if (m_pathPolyRefs[m_polyLength - 1] == m_endPoly && !(m_type & (PATHFIND_INCOMPLETE | PATHFIND_NOPATH)))
         m_type = PATHFIND_NORMAL;
     else
         m_type = PATHFIND_INCOMPLETE;
 
-    BuildPointPath(startPoint, endPoint, distToStartPoly, distToEndPoly);
+    BuildPointPath(m_startPoint, m_endPoint, m_distToStartPoly, m_distToEndPoly);
 }
 
 void PathInfo::BuildPointPath(const float *startPoint, const float *endPoint, float distToStartPoly, float distToEndPoly)
@@ -445,7 +549,7 @@ void PathInfo::BuildPointPath(const float *startPoint, const float *endPoint, fl
         }
 
         m_type = PathType(PATHFIND_NORMAL | PATHFIND_NOT_USING_PATH | PATHFIND_DEST_FORCED);
-        if (m_sourceUnit->CanFly())
+        if (m_sourceCanFly)
             m_type |= PATHFIND_FLYPATH;
     }
 
@@ -464,7 +568,7 @@ void PathInfo::BuildShortcut()
     m_pathPoints[1] = getActualEndPosition();
 
     m_type = PATHFIND_SHORTCUT;
-    if (m_sourceUnit->CanFly())
+    if (m_sourceCanFly)
         m_type |= PATHFIND_FLYPATH | PATHFIND_NORMAL;
 }
 
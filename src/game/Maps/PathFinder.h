@@ -42,6 +42,11 @@ struct GridMapLiquidData;
 #define VERTEX_SIZE       3
 #define INVALID_POLYREF   0
 
+namespace MMAP
+{
+    class PathCorridorCache;
+}
+
 enum PathType
 {
     PATHFIND_BLANK          = 0x0000,   // path not built yet
@@ -65,6 +70,19 @@ class PathInfo
         // return value : true if new path was calculated
         bool calculate(float destX, float destY, float destZ, bool forceDest = false, bool offsets = false);
 
+        // Asynchronous calculation (see PathRequestQueue). Everything depending on the unit is done here:
+        // returns false if the path is already built, else the Detour searches are left to searchAsync.
+        bool calculateAsync(float destX, float destY, float destZ, bool forceDest = false);
+        // Runs the Detour searches of a path prepared by calculateAsync, without accessing the unit.
+        // 'sameSearches' have the same start and end polygons and filter: they reuse our poly path.
+        void searchAsync(dtNavMeshQuery const* query, MMAP::PathCorridorCache* corridorCache, std::vector<PathInfo*> const& sameSearches);
+        // Straight line to the destination instead of the searches of a path prepared by calculateAsync
+        void cancelAsync();
+        bool isSearchPending() const { return m_searchPending; }
+        dtPolyRef getStartPoly() const { return m_startPoly; }
+        dtPolyRef getEndPoly() const { return m_endPoly; }
+        dtQueryFilter const& getFilter() const { return m_filter; }
+
         void setUseStrightPath(bool useStraightPath) { m_useStraightPath = useStraightPath; };
         void setPathLengthLimit(float distance);
 
@@ -108,10 +126,23 @@ class PathInfo
         const Unit* const       m_sourceUnit;       // the unit that is moving
         const dtNavMesh*        m_navMesh;          // the nav mesh
         const dtNavMeshQuery*   m_navMeshQuery;     // the nav mesh query used to find the path
+        MMAP::PathCorridorCache* m_corridorCache;   // corridors of the previous searches on the map nav mesh
         uint32          m_targetAllowedFlags;
+        uint32          m_sourceGuidLow;
+        bool            m_sourceCanFly;
 
         dtQueryFilter m_filter;                     // use single filter for all movements, update it when needed
 
+        // poly path search inputs, kept between calculateAsync and searchAsync
+        bool            m_deferSearch;
+        bool            m_searchPending;
+        dtPolyRef       m_startPoly;
+        dtPolyRef       m_endPoly;
+        float           m_startPoint[VERTEX_SIZE];
+        float           m_endPoint[VERTEX_SIZE];
+        float           m_distToStartPoly;
+        float           m_distToEndPoly;
+
         inline void setStartPosition(Vector3 point) { m_startPosition = point; }
         inline void setEndPosition(Vector3 point) { m_actualEndPosition = point; m_endPosition = point; }
         inline void setActualEndPosition(Vector3 point) { m_actualEndPosition = point; }
@@ -129,6 +160,8 @@ class PathInfo
         bool HaveTiles(const Vector3& p) const;
 
         void BuildPolyPath(const Vector3 &startPos, const Vector3 &endPos);
+        bool FindPolyPath();
+        void FinishPolyPath();
         void BuildPointPath(const float *startPoint, const float *endPoint, float distToStartPoly, float distToEndPoly);
         void BuildShortcut();
         void BuildUnderwaterPath();
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "PathRequestQueue.h"
+#include "AsyncTaskExecutor.h"
+#include "MoveMap.h"
+#include "Timer.h"
+#include "World.h"
+
+#include <algorithm>
+#include <iterator>
+
+class PathSearchTask : public AsyncTask
+{
+    public:
+        PathSearchTask(uint32 mapId, std::shared_ptr<PathRequestQueue::Counters> const& counters, std::vector<PathRequestPtr>& requests) :
+            m_mapId(mapId), m_counters(counters)
+        {
+            m_requests.swap(requests);
+        }
+
+        void run() override;
+        AsyncTaskType GetType() const override { return ASYNC_TASK_PATHFINDING; }
+        // Units are standing still until they get their path
+        AsyncTaskPriority GetPriority() const override { return ASYNC_TASK_PRIORITY_HIGH; }
+
+    private:
+        uint32 m_mapId;
+        std::shared_ptr<PathRequestQueue::Counters> m_counters;
+        std::vector<PathRequestPtr> m_requests;             // ordered by search
+};
+
+void PathSearchTask::run()
+{
+    // Queries are per thread, and the navmesh may have been unloaded since the requests were queued
+    MMAP::MMapManager* mmap = MMAP::MMapFactory::createOrGetMMapManager();
+    dtNavMeshQuery const* query = mmap->GetNavMeshQuery(m_mapId);
+    MMAP::PathCorridorCache* corridorCache = mmap->GetPathCorridorCache(m_mapId);
+    // The map thread adds and removes the tiles of the grids it loads and unloads meanwhile
+    ACE_RW_Mutex* navMeshLock = mmap->GetNavMeshLock(m_mapId);
+    if (navMeshLock)
+        navMeshLock->acquire_read();
+
+    uint64 searches = 0;
+    std::vector<PathInfo*> sameSearches;
+    for (std::size_t begin = 0, end = 0; begin < m_requests.size(); begin = end)
+    {
+        PathInfo* search = NULL;
+        sameSearches.clear();
+        for (end = begin; end < m_requests.size() && PathRequestQueue::IsSameSearch(m_requests[begin]->m_path, m_requests[end]->m_path); ++end)
+        {
+            // Released by its movement generator, nobody will read the result
+            if (m_requests[end].use_count() == 1)
+                continue;
+
+            if (!search)
+                search = &m_requests[end]->m_path;
+            else
+                sameSearches.push_back(&m_requests[end]->m_path);
+        }
+
+        if (search)
+        {
+            search->searchAsync(query, corridorCache, sameSearches);
+            ++searches;
+        }
+    }
+
+    if (navMeshLock)
+        navMeshLock->release();
+
+    uint32 now = WorldTimer::getMSTime();
+    uint64 solved = 0;
+    uint64 totalLatency = 0;
+    uint32 maxLatency = 0;
+    for (std::vector<PathRequestPtr>::const_iterator itr = m_requests.begin(); itr != m_requests.end(); ++itr)
+    {
+        PathRequest& request = **itr;
+        if (request.m_path.isSearchPending())
+            continue;
+
+        uint32 latency = WorldTimer::getMSTimeDiff(request.m_queuedTime, now);
+        totalLatency += latency;
+        maxLatency = std::max(maxLatency, latency);
+        ++solved;
+        request.m_solved.store(true, std::memory_order_release);
+    }
+
+    PathRequestQueue::Counters& counters = *m_counters;
+    counters.searching -= m_requests.size();
+    counters.solved += solved;
+    counters.searches += searches;
+    counters.dropped += m_requests.size() - solved;
+    counters.totalLatencyMs += totalLatency;
+    uint32 previousMax = counters.maxLatencyMs;
+    while (previousMax < maxLatency && !counters.maxLatencyMs.compare_exchange_weak(previousMax, maxLatency)) {}
+}
+
+PathRequestQueue::PathRequestQueue(uint32 mapId) : m_mapId(mapId), m_counters(new Counters())
+{
+}
+
+bool PathRequestQueue::IsEnabled() const
+{
+    return sWorld.getConfig(CONFIG_UINT32_MMAP_ASYNC_QUEUE_SIZE) != 0;
+}
+
+bool PathRequestQueue::Add(PathRequestPtr const& request, float destX, float destY, float destZ, bool forceDest)
+{
+    PathInfo& path = request->m_path;
+    if (!path.calculateAsync(destX, destY, destZ, forceDest))
+        return false;
+
+    ++m_counters->requested;
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_queued.size() >= sWorld.getConfig(CONFIG_UINT32_MMAP_ASYNC_QUEUE_SIZE))
+    {
+        ++m_counters->overflows;
+        path.cancelAsync();
+        return false;
+    }
+
+    request->m_queuedTime = WorldTimer::getMSTime();
+    m_queued.push_back(request);
+    return true;
+}
+
+void PathRequestQueue::Dispatch()
+{
+    std::vector<PathRequestPtr> requests;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_queued.empty())
+            return;
+        requests.swap(m_queued);
+    }
+
+    std::sort(requests.begin(), requests.end(), SearchOrder);
+    m_counters->searching += requests.size();
+
+    // About one task per worker. The requests of a same search are not split between tasks.
+    std::size_t tasksCount = std::max<uint32>(1, sWorld.GetAsyncTaskExecutor().GetThreadCount());
+    std::size_t taskSize = (requests.size() + tasksCount - 1) / tasksCount;
+    for (std::size_t begin = 0, end = 0; begin < requests.size(); begin = end)
+    {
+        end = std::min(begin + taskSize, requests.size());
+        while (end < requests.size() && IsSameSearch(requests[end - 1]->m_path, requests[end]->m_path))
+            ++end;
+        // The task must hold the only references, with the movement generators
+        std::vector<PathRequestPtr> taskRequests(std::make_move_iterator(requests.begin() + begin), std::make_move_iterator(requests.begin() + end));
+        sWorld.AddAsyncTask(new PathSearchTask(m_mapId, m_counters, taskRequests));
+    }
+}
+
+void PathRequestQueue::GetStats(Stats& stats) const
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        stats.queued = m_queued.size();
+    }
+
+    Counters const& counters = *m_counters;
+    stats.searching = counters.searching;
+    stats.requested = counters.requested;
+    stats.solved = counters.solved;
+    stats.searches = counters.searches;
+    stats.dropped = counters.dropped;
+    stats.overflows = counters.overflows;
+    stats.totalLatencyMs = counters.totalLatencyMs;
+    stats.maxLatencyMs = counters.maxLatencyMs;
+}
+
+bool PathRequestQueue::IsSameSearch(PathInfo const& a, PathInfo const& b)
+{
+    return a.getStartPoly() == b.getStartPoly() && a.getEndPoly() == b.getEndPoly() &&
+        a.getFilter().getIncludeFlags() == b.getFilter().getIncludeFlags() &&
+        a.getFilter().getExcludeFlags() == b.getFilter().getExcludeFlags();
+}
+
+bool PathRequestQueue::SearchOrder(PathRequestPtr const& a, PathRequestPtr const& b)
+{
+    PathInfo const& pathA = a->m_path;
+    PathInfo const& pathB = b->m_path;
+    if (pathA.getStartPoly() != pathB.getStartPoly())
+        return pathA.getStartPoly() < pathB.getStartPoly();
+    if (pathA.getEndPoly() != pathB.getEndPoly())
+        return pathA.getEndPoly() < pathB.getEndPoly();
+    if (pathA.getFilter().getIncludeFlags() != pathB.getFilter().getIncludeFlags())
+        return pathA.getFilter().getIncludeFlags() < pathB.getFilter().getIncludeFlags();
+    return pathA.getFilter().getExcludeFlags() < pathB.getFilter().getExcludeFlags();
+}
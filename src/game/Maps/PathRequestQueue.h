@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_PATH_REQUEST_QUEUE_H
+#define MANGOS_PATH_REQUEST_QUEUE_H
+
+#include "Common.h"
+#include "PathFinder.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class PathRequest
+{
+    public:
+        explicit PathRequest(Unit const* owner) : m_path(owner), m_queuedTime(0), m_solved(false) {}
+
+        // Must not be accessed while the request is queued (not solved yet)
+        PathFinder& GetPath() { return m_path; }
+        bool IsSolved() const { return m_solved.load(std::memory_order_acquire); }
+
+    private:
+        friend class PathRequestQueue;
+        friend class PathSearchTask;
+
+        PathFinder m_path;
+        uint32 m_queuedTime;
+        std::atomic<bool> m_solved;
+};
+
+typedef std::shared_ptr<PathRequest> PathRequestPtr;
+
+/**
+ * Paths requested by the movement generators of a map during an update. At the end of
+ * the units update, the requests are grouped by start and end polygons and filter: each
+ * group is searched once, on the async task workers. The generators pick up their path
+ * at their next update.
+ * A request is dropped (not searched) when its generator has released it.
+ */
+class PathRequestQueue
+{
+    public:
+        struct Stats
+        {
+            uint32 queued;                                  // waiting for the next dispatch
+            uint32 searching;                               // dispatched, not solved yet
+            uint64 requested;
+            uint64 solved;
+            uint64 searches;                                // Detour searches run for the solved requests
+            uint64 dropped;
+            uint64 overflows;                               // straight line, too many requests queued
+            uint64 totalLatencyMs;                          // queued to solved
+            uint32 maxLatencyMs;
+        };
+
+        explicit PathRequestQueue(uint32 mapId);
+
+        bool IsEnabled() const;
+
+        // Map thread, or motion update threads. Calculates the path of the request with calculateAsync.
+        // Returns false when the path is already built: no search needed, or too many queued requests.
+        bool Add(PathRequestPtr const& request, float destX, float destY, float destZ, bool forceDest);
+        // Map thread, after the units update
+        void Dispatch();
+
+        void GetStats(Stats& stats) const;
+
+    private:
+        struct Counters
+        {
+            Counters() : searching(0), requested(0), solved(0), searches(0), dropped(0), overflows(0), totalLatencyMs(0), maxLatencyMs(0) {}
+
+            std::atomic<uint32> searching;
+            std::atomic<uint64> requested;
+            std::atomic<uint64> solved;
+            std::atomic<uint64> searches;
+            std::atomic<uint64> dropped;
+            std::atomic<uint64> overflows;
+            std::atomic<uint64> totalLatencyMs;
+            std::atomic<uint32> maxLatencyMs;
+        };
+        friend class PathSearchTask;
+
+        static bool IsSameSearch(PathInfo const& a, PathInfo const& b);
+        static bool SearchOrder(PathRequestPtr const& a, PathRequestPtr const& b);
+
+        uint32 const m_mapId;
+        mutable std::mutex m_lock;
+        std::vector<PathRequestPtr> m_queued;
+        // Shared with the dispatched tasks, which may outlive the map
+        std::shared_ptr<Counters> m_counters;
+};
+
+#endif
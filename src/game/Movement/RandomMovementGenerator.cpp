@@ -24,6 +24,20 @@
 #include "MoveSplineInit.h"
 #include "MoveSpline.h"
 
+template<>
+void RandomMovementGenerator<Creature>::_moveOnPath(Creature &creature, PathFinder& path)
+{
+    Movement::MoveSplineInit init(creature, "RandomMovementGenerator");
+    init.Move(&path);
+    init.SetWalk(true);
+    init.Launch();
+
+    if (roll_chance_i(40))
+        i_nextMoveTime.Reset(50);
+    else
+        i_nextMoveTime.Reset(urand(3000, 10000));
+}
+
 template<>
 void RandomMovementGenerator<Creature>::_setRandomLocation(Creature &creature)
 {
@@ -53,15 +67,25 @@ void RandomMovementGenerator<Creature>::_setRandomLocation(Creature &creature)
 
     creature.addUnitState(UNIT_STAT_ROAMING_MOVE);
 
-    Movement::MoveSplineInit init(creature, "RandomMovementGenerator");
-    init.MoveTo(destX, destY, destZ, MOVE_PATHFINDING | MOVE_EXCLUDE_STEEP_SLOPES);
-    init.SetWalk(true);
-    init.Launch();
+    PathRequestQueue* pathRequests = creature.GetMap()->GetPathRequestQueue();
+    if (pathRequests->IsEnabled())
+    {
+        PathRequestPtr request(new PathRequest(&creature));
+        request->GetPath().ExcludeSteepSlopes();
+        if (pathRequests->Add(request, destX, destY, destZ, false))
+        {
+            // Moving at the next update
+            i_pathRequest = request;
+            return;
+        }
+        _moveOnPath(creature, request->GetPath());
+        return;
+    }
 
-    if (roll_chance_i(40))
-        i_nextMoveTime.Reset(50);
-    else
-        i_nextMoveTime.Reset(urand(3000, 10000));
+    PathFinder path(&creature);
+    path.ExcludeSteepSlopes();
+    path.calculate(destX, destY, destZ);
+    _moveOnPath(creature, path);
 }
 
 template<>
@@ -83,6 +107,7 @@ void RandomMovementGenerator<Creature>::Reset(Creature &creature)
 template<>
 void RandomMovementGenerator<Creature>::Interrupt(Creature &creature)
 {
+    i_pathRequest.reset();
     creature.clearUnitState(UNIT_STAT_ROAMING | UNIT_STAT_ROAMING_MOVE);
     creature.SetWalk(!creature.hasUnitState(UNIT_STAT_RUNNING), false);
 }
@@ -107,13 +132,24 @@ void RandomMovementGenerator<Creature>::UpdateAsync(Creature &creature, uint32 d
     if (creature.hasUnitState(UNIT_STAT_CAN_NOT_MOVE | UNIT_STAT_DISTRACTED))
     {
         i_nextMoveTime.Reset(0);  // Expire the timer
+        i_pathRequest.reset();
         creature.clearUnitState(UNIT_STAT_ROAMING_MOVE);
     }
     else if (creature.IsNoMovementSpellCasted())
     {
+        i_pathRequest.reset();
         if (!creature.IsStopped())
             creature.StopMoving();
     }
+    else if (i_pathRequest)
+    {
+        if (i_pathRequest->IsSolved())
+        {
+            PathRequestPtr request;
+            request.swap(i_pathRequest);
+            _moveOnPath(creature, request->GetPath());
+        }
+    }
     else if (creature.movespline->Finalized())
     {
         i_nextMoveTime.Update(diff);
@@ -20,6 +20,7 @@
 #define MANGOS_RANDOMMOTIONGENERATOR_H
 
 #include "MovementGenerator.h"
+#include "PathRequestQueue.h"
 
 template<class T>
 class MANGOS_DLL_SPEC RandomMovementGenerator
@@ -39,8 +40,11 @@ class MANGOS_DLL_SPEC RandomMovementGenerator
 
         bool GetResetPosition(T&, float& x, float& y, float& z);
     private:
+        void _moveOnPath(T &, PathFinder& path);
+
         ShortTimeTracker i_nextMoveTime;
         uint32 i_nextMove;
+        PathRequestPtr i_pathRequest;                       // path searched asynchronously
 };
 
 #endif
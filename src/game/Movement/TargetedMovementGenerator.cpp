@@ -34,6 +34,8 @@
 template<class T, typename D>
 void TargetedMovementGeneratorMedium<T, D>::_setTargetLocation(T &owner)
 {
+    i_pathRequest.reset();
+
     if (!i_target.isValid() || !i_target->IsInWorld())
         return;
 
@@ -95,13 +97,37 @@ void TargetedMovementGeneratorMedium<T, D>::_setTargetLocation(T &owner)
     _targetOnTransport = transport;
     i_target->GetPosition(_targetLastX, _targetLastY, _targetLastZ, transport);
 
-    PathFinder path(&owner);
-
     // allow pets following their master to cheat while generating paths
     bool petFollowing = (isPet && owner.hasUnitState(UNIT_STAT_FOLLOW));
-    Movement::MoveSplineInit init(owner, "TargetedMovementGenerator");
+
+    PathRequestQueue* pathRequests = owner.GetMap()->GetPathRequestQueue();
+    if (!transport && owner.GetTypeId() == TYPEID_UNIT && pathRequests->IsEnabled())
+    {
+        PathRequestPtr request(new PathRequest(&owner));
+        if (pathRequests->Add(request, x, y, z, petFollowing))
+        {
+            // Moving at the next update
+            i_pathRequest = request;
+            i_recalculateTravel = true;
+            return;
+        }
+        _moveOnPath(owner, request->GetPath(), losChecked, losResult);
+        return;
+    }
+
+    PathFinder path(&owner);
     path.SetTransport(transport);
     path.calculate(x, y, z, petFollowing);
+    _moveOnPath(owner, path, losChecked, losResult);
+}
+
+template<class T, typename D>
+void TargetedMovementGeneratorMedium<T, D>::_moveOnPath(T &owner, PathFinder& path, bool losChecked, bool losResult)
+{
+    Transport* transport = path.GetTransport();
+    bool petFollowing = (owner.GetTypeId() == TYPEID_UNIT && ((Creature*)&owner)->IsPet() && owner.hasUnitState(UNIT_STAT_FOLLOW));
+
+    Movement::MoveSplineInit init(owner, "TargetedMovementGenerator");
     i_reachable = path.getPathType() & PATHFIND_NORMAL;
     i_recalculateTravel = false;
     if (this->GetMovementGeneratorType() == CHASE_MOTION_TYPE && !transport && owner.HasDistanceCasterMovement())
@@ -302,6 +328,9 @@ bool TargetedMovementGeneratorMedium<T, D>::Update(T &owner, const uint32 & time
     }
     else if (i_recalculateTravel)
         owner.GetMotionMaster()->SetNeedAsyncUpdate();
+
+    if (i_pathRequest)
+        owner.GetMotionMaster()->SetNeedAsyncUpdate();
     return true;
 }
 
@@ -315,7 +344,22 @@ void TargetedMovementGeneratorMedium<T, D>::UpdateAsync(T &owner, uint32 /*diff*
             || (this->GetMovementGeneratorType() == CHASE_MOTION_TYPE && owner.hasUnitState(UNIT_STAT_NO_COMBAT_MOVEMENT))
             || static_cast<D*>(this)->_lostTarget(owner)
             || owner.IsNoMovementSpellCasted())
+    {
+        i_pathRequest.reset();
         return;
+    }
+
+    if (i_pathRequest)
+    {
+        if (!i_pathRequest->IsSolved())
+            return;
+
+        PathRequestPtr request;
+        request.swap(i_pathRequest);
+        i_recalculateTravel = false;
+        _moveOnPath(owner, request->GetPath(), false, false);
+        return;
+    }
 
     _setTargetLocation(owner);
 }
@@ -356,6 +400,7 @@ template<class T>
 void ChaseMovementGenerator<T>::Interrupt(T &owner)
 {
     owner.clearUnitState(UNIT_STAT_CHASE | UNIT_STAT_CHASE_MOVE);
+    this->i_pathRequest.reset();
 }
 
 template<class T>
@@ -456,6 +501,7 @@ void FollowMovementGenerator<T>::Interrupt(T &owner)
 {
     owner.clearUnitState(UNIT_STAT_FOLLOW | UNIT_STAT_FOLLOW_MOVE);
     _updateSpeed(owner);
+    this->i_pathRequest.reset();
 }
 
 template<class T>
@@ -22,6 +22,7 @@
 #include "MovementGenerator.h"
 #include "FollowerReference.h"
 #include "PathFinder.h"
+#include "PathRequestQueue.h"
 #include "Unit.h"
 
 class MANGOS_DLL_SPEC TargetedMovementGeneratorBase
@@ -62,6 +63,7 @@ class MANGOS_DLL_SPEC TargetedMovementGeneratorMedium
 
     protected:
         void _setTargetLocation(T &);
+        void _moveOnPath(T &, PathFinder& path, bool losChecked, bool losResult);
 
         ShortTimeTracker i_recheckDistance;
         float i_offset;
@@ -73,6 +75,7 @@ class MANGOS_DLL_SPEC TargetedMovementGeneratorMedium
         float _targetLastY;
         float _targetLastZ;
         bool  _targetOnTransport;
+        PathRequestPtr i_pathRequest;                       // path searched asynchronously
 };
 
 template<class T>
@@ -30,6 +30,7 @@
 #include "World.h"
 #include "CellImpl.h"
 #include "BattleGround.h"
+#include "GridPreloader.h"
 
 class MANGOS_DLL_DECL ObjectGridRespawnMover
 {
@@ -209,7 +210,7 @@ ObjectGridLoader::Visit(GameObjectMapType &m)
     CellPair cell_pair(x, y);
     uint32 cell_id = (cell_pair.y_coord * TOTAL_NUMBER_OF_CELLS_PER_MAP) + cell_pair.x_coord;
 
-    CellObjectGuids const& cell_guids = sObjectMgr.GetCellObjectGuids(i_map->GetId(), cell_id);
+    CellObjectGuids const& cell_guids = i_preload ? i_preload->GetCellObjectGuids(i_cell.CellX(), i_cell.CellY()) : sObjectMgr.GetCellObjectGuids(i_map->GetId(), cell_id);
 
     GridType& grid = (*i_map->getNGrid(i_cell.GridX(), i_cell.GridY()))(i_cell.CellX(), i_cell.CellY());
     LoadHelper(cell_guids.gameobjects, cell_pair, m, i_gameObjects, i_map, grid);
@@ -224,7 +225,7 @@ ObjectGridLoader::Visit(CreatureMapType &m)
     CellPair cell_pair(x, y);
     uint32 cell_id = (cell_pair.y_coord * TOTAL_NUMBER_OF_CELLS_PER_MAP) + cell_pair.x_coord;
 
-    CellObjectGuids const& cell_guids = sObjectMgr.GetCellObjectGuids(i_map->GetId(), cell_id);
+    CellObjectGuids const& cell_guids = i_preload ? i_preload->GetCellObjectGuids(i_cell.CellX(), i_cell.CellY()) : sObjectMgr.GetCellObjectGuids(i_map->GetId(), cell_id);
 
     GridType& grid = (*i_map->getNGrid(i_cell.GridX(), i_cell.GridY()))(i_cell.CellX(), i_cell.CellY());
     LoadHelper(cell_guids.creatures, cell_pair, m, i_creatures, i_map, grid);
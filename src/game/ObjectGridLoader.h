@@ -30,14 +30,16 @@
 #include "Cell.h"
 
 class ObjectWorldLoader;
+class GridPreload;
 
 class MANGOS_DLL_DECL ObjectGridLoader
 {
     friend class ObjectWorldLoader;
 
     public:
-        ObjectGridLoader(NGridType &grid, Map* map, const Cell &cell)
-            : i_cell(cell), i_grid(grid), i_map(map), i_gameObjects(0), i_creatures(0), i_corpses (0)
+        // With 'preload', the static spawns are read from the copy made by the grid preloader
+        ObjectGridLoader(NGridType &grid, Map* map, const Cell &cell, GridPreload const* preload = nullptr)
+            : i_cell(cell), i_grid(grid), i_map(map), i_preload(preload), i_gameObjects(0), i_creatures(0), i_corpses (0)
             {}
 
         void Load(GridType &grid);
@@ -53,6 +55,7 @@ class MANGOS_DLL_DECL ObjectGridLoader
         Cell i_cell;
         NGridType &i_grid;
         Map* i_map;
+        GridPreload const* i_preload;
         uint32 i_gameObjects;
         uint32 i_creatures;
         uint32 i_corpses;
@@ -23,6 +23,7 @@
 #include "Database/DatabaseEnv.h"
 #include "Database/DatabaseImpl.h"
 #include "Database/SQLStorageImpl.h"
+#include "Database/SQLStorageSnapshot.h"
 #include "Policies/SingletonImp.h"
 
 #include "SQLStorages.h"
@@ -129,7 +130,8 @@ ObjectMgr::ObjectMgr() :
     m_MailIds("Mail ids"),
     m_GroupIds("Group ids"),
     // Nostalrius
-    DBCLocaleIndex(0)
+    DBCLocaleIndex(0),
+    mMapObjectGuidsGeneration(0)
 {
     // Only zero condition left, others will be added while loading DB tables
     mConditions.resize(1);
@@ -890,6 +892,8 @@ struct SQLCreatureLoader : public SQLStorageLoaderBase<SQLCreatureLoader, SQLSto
     {
         dst = D(sScriptMgr.GetScriptId(src));
     }
+
+    uint32 snapshot_salt() { return sScriptMgr.GetScriptNamesHash(); }
 };
 
 void ObjectMgr::LoadCreatureTemplates()
@@ -1388,8 +1392,9 @@ void ObjectMgr::LoadCreatureModelInfo()
 void ObjectMgr::LoadCreatures(bool reload)
 {
     uint32 count = 0;
-    //                                                0                       1   2    3
-    QueryResult *result = WorldDatabase.Query("SELECT creature.guid, creature.id, map, modelid,"
+    QueryResult *result = SQLStorageSnapshot::Query("creature", "creature, game_event_creature, pool_creature, pool_creature_template",
+                          //      0              1            2    3
+                          "SELECT creature.guid, creature.id, map, modelid,"
                           //   4             5           6           7           8            9              10         11
                           "equipment_id, position_x, position_y, position_z, orientation, spawntimesecs, spawndist, currentwaypoint,"
                           //   12         13       14          15            16
@@ -1554,6 +1559,7 @@ void ObjectMgr::AddCreatureToGrid(uint32 guid, CreatureData const* data)
     mMapObjectGuids_lock.acquire();
     CellObjectGuids& cell_guids = mMapObjectGuids[data->mapid][cell_id];
     cell_guids.creatures.insert(guid);
+    ++mMapObjectGuidsGeneration;
     mMapObjectGuids_lock.release();
 }
 
@@ -1565,6 +1571,7 @@ void ObjectMgr::RemoveCreatureFromGrid(uint32 guid, CreatureData const* data)
     mMapObjectGuids_lock.acquire();
     CellObjectGuids& cell_guids = mMapObjectGuids[data->mapid][cell_id];
     cell_guids.creatures.erase(guid);
+    ++mMapObjectGuidsGeneration;
     mMapObjectGuids_lock.release();
 }
 
@@ -1572,8 +1579,9 @@ void ObjectMgr::LoadGameobjects(bool reload)
 {
     uint32 count = 0;
 
-    //                                                0                           1   2    3           4           5           6
-    QueryResult *result = WorldDatabase.Query("SELECT gameobject.guid, gameobject.id, map, position_x, position_y, position_z, orientation,"
+    QueryResult *result = SQLStorageSnapshot::Query("gameobject", "gameobject, game_event_gameobject, pool_gameobject, pool_gameobject_template",
+                          //      0                1              2    3           4           5           6
+                          "SELECT gameobject.guid, gameobject.id, map, position_x, position_y, position_z, orientation,"
                           //   7          8          9          10         11             12            13     14
                           "rotation0, rotation1, rotation2, rotation3, spawntimesecs, animprogress, state, event, "
                           //   15                          16                                   17
@@ -1711,6 +1719,7 @@ void ObjectMgr::AddGameobjectToGrid(uint32 guid, GameObjectData const* data)
     mMapObjectGuids_lock.acquire();
     CellObjectGuids& cell_guids = mMapObjectGuids[data->mapid][cell_id];
     cell_guids.gameobjects.insert(guid);
+    ++mMapObjectGuidsGeneration;
     mMapObjectGuids_lock.release();
 }
 
@@ -1722,6 +1731,7 @@ void ObjectMgr::RemoveGameobjectFromGrid(uint32 guid, GameObjectData const* data
     mMapObjectGuids_lock.acquire();
     CellObjectGuids& cell_guids = mMapObjectGuids[data->mapid][cell_id];
     cell_guids.gameobjects.erase(guid);
+    ++mMapObjectGuidsGeneration;
     mMapObjectGuids_lock.release();
 }
 
@@ -1898,6 +1908,8 @@ struct SQLItemLoader : public SQLStorageLoaderBase<SQLItemLoader, SQLStorage>
     {
         dst = D(sScriptMgr.GetScriptId(src));
     }
+
+    uint32 snapshot_salt() { return sScriptMgr.GetScriptNamesHash(); }
 };
 
 void ObjectMgr::LoadItemPrototypes()
@@ -3247,8 +3259,9 @@ void ObjectMgr::LoadQuests()
 
     m_ExclusiveQuestGroups.clear();
 
-    //                                                0      1       2           3         4           5     6                7              8              9
-    QueryResult *result = WorldDatabase.Query("SELECT entry, Method, ZoneOrSort, MinLevel, QuestLevel, Type, RequiredClasses, RequiredRaces, RequiredSkill, RequiredSkillValue,"
+    QueryResult *result = SQLStorageSnapshot::Query("quest_template", "quest_template",
+                          //      0      1       2           3         4           5     6                7              8              9
+                          "SELECT entry, Method, ZoneOrSort, MinLevel, QuestLevel, Type, RequiredClasses, RequiredRaces, RequiredSkill, RequiredSkillValue,"
                           //   10                   11                 12                     13                   14                     15                   16                17
                           "RepObjectiveFaction, RepObjectiveValue, RequiredMinRepFaction, RequiredMinRepValue, RequiredMaxRepFaction, RequiredMaxRepValue, SuggestedPlayers, LimitTime,"
                           //   18          19            20           21           22              23                24         25            26
@@ -4304,6 +4317,8 @@ struct SQLMapLoader : public SQLStorageLoaderBase<SQLMapLoader, SQLStorage>
     {
         dst = D(sScriptMgr.GetScriptId(src));
     }
+
+    uint32 snapshot_salt() { return sScriptMgr.GetScriptNamesHash(); }
 };
 
 void ObjectMgr::LoadMapTemplate()
@@ -4376,6 +4391,8 @@ struct SQLWorldLoader : public SQLStorageLoaderBase<SQLWorldLoader, SQLStorage>
     {
         dst = D(sScriptMgr.GetScriptId(src));
     }
+
+    uint32 snapshot_salt() { return sScriptMgr.GetScriptNamesHash(); }
 };
 
 GossipText const *ObjectMgr::GetGossipText(uint32 Text_ID) const
@@ -5568,6 +5585,8 @@ struct SQLGameObjectLoader : public SQLStorageLoaderBase<SQLGameObjectLoader, SQ
     {
         dst = D(sScriptMgr.GetScriptId(src));
     }
+
+    uint32 snapshot_salt() { return sScriptMgr.GetScriptNamesHash(); }
 };
 
 inline void CheckGOLockId(GameObjectInfo const* goInfo, uint32 dataN, uint32 N)
@@ -6453,6 +6472,31 @@ void ObjectMgr::DeleteGOData(uint32 guid)
     mGameObjectDataMap.erase(guid);
 }
 
+uint32 ObjectMgr::CopyGridObjectGuids(uint16 mapid, uint32 gridX, uint32 gridY, CellObjectGuids (&cells)[MAX_NUMBER_OF_CELLS][MAX_NUMBER_OF_CELLS])
+{
+    ACE_Guard<ACE_Thread_Mutex> guard(mMapObjectGuids_lock);
+
+    MapObjectGuids::const_iterator mapItr = mMapObjectGuids.find(mapid);
+    if (mapItr == mMapObjectGuids.end())
+        return mMapObjectGuidsGeneration;
+
+    for (uint32 x = 0; x < MAX_NUMBER_OF_CELLS; ++x)
+    {
+        for (uint32 y = 0; y < MAX_NUMBER_OF_CELLS; ++y)
+        {
+            uint32 cell_id = (gridY * MAX_NUMBER_OF_CELLS + y) * TOTAL_NUMBER_OF_CELLS_PER_MAP + gridX * MAX_NUMBER_OF_CELLS + x;
+            CellObjectGuidsMap::const_iterator cellItr = mapItr->second.find(cell_id);
+            if (cellItr == mapItr->second.end())
+                continue;
+
+            cells[x][y].creatures = cellItr->second.creatures;
+            cells[x][y].gameobjects = cellItr->second.gameobjects;
+        }
+    }
+
+    return mMapObjectGuidsGeneration;
+}
+
 void ObjectMgr::AddCorpseCellData(uint32 mapid, uint32 cellid, uint32 player_guid, uint32 instance)
 {
     // corpses are always added to spawn mode 0 and they are spawned by their instance id
@@ -1006,6 +1006,14 @@ class ObjectMgr
         {
             return mMapObjectGuids_lock;
         }
+        // Copy of the static spawns of the cells of a grid, for any thread. Returns the spawns generation of the copy.
+        uint32 CopyGridObjectGuids(uint16 mapid, uint32 gridX, uint32 gridY, CellObjectGuids (&cells)[MAX_NUMBER_OF_CELLS][MAX_NUMBER_OF_CELLS]);
+        // Changes each time a static spawn is added to or removed from any cell
+        uint32 GetCellObjectGuidsGeneration()
+        {
+            ACE_Guard<ACE_Thread_Mutex> guard(mMapObjectGuids_lock);
+            return mMapObjectGuidsGeneration;
+        }
 
         // modifiers for global grid objects state (static DB spawns, global spawn mods from gameevent system)
         // Don't must be used for modify instance specific spawn state modifications
@@ -1309,6 +1317,7 @@ class ObjectMgr
 
         MapObjectGuids mMapObjectGuids;
         ACE_Thread_Mutex mMapObjectGuids_lock;
+        uint32 mMapObjectGuidsGeneration;
 
         CreatureDataMap mCreatureDataMap;
         CreatureLocaleMap mCreatureLocaleMap;
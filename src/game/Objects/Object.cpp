@@ -363,17 +363,65 @@ void WorldObject::DirectSendPublicValueUpdate(uint32 index)
 void Object::BuildValuesUpdateBlockForPlayer(UpdateData *data, Player *target) const
 {
     ByteBuffer buf(500);
+    BuildValuesUpdateBlockForPlayer(buf, target);
+    data->AddUpdateBlock(buf);
+}
 
-    buf << uint8(UPDATETYPE_VALUES);
-    buf << GetPackGUID();
+void Object::BuildValuesUpdateBlockForPlayer(ByteBuffer& block, Player *target) const
+{
+    block << uint8(UPDATETYPE_VALUES);
+    block << GetPackGUID();
 
     UpdateMask updateMask;
     updateMask.SetCount(m_valuesCount);
 
     _SetUpdateBits(&updateMask, target);
-    BuildValuesUpdate(UPDATETYPE_VALUES, &buf, &updateMask, target);
+    BuildValuesUpdate(UPDATETYPE_VALUES, &block, &updateMask, target);
+}
 
-    data->AddUpdateBlock(buf);
+bool Object::HasObserverDependentValuesChanges() const
+{
+    // Quest activation is computed (and stored) for every observer
+    if (isType(TYPEMASK_GAMEOBJECT))
+        return true;
+
+    if (isType(TYPEMASK_UNIT))
+    {
+        // See BuildValuesUpdate. Health only depends on the visibility class.
+        static uint16 const observerDependentFields[] = { UNIT_NPC_FLAGS, UNIT_DYNAMIC_FLAGS, UNIT_FIELD_FACTIONTEMPLATE };
+        for (uint16 index : observerDependentFields)
+            if (m_uint32Values_mirror[index] != m_uint32Values[index])
+                return true;
+
+        if (isType(TYPEMASK_PLAYER) && m_uint32Values_mirror[PLAYER_FLAGS] != m_uint32Values[PLAYER_FLAGS] &&
+            (m_uint32Values[PLAYER_FLAGS] & PLAYER_FLAGS_FFA_PVP))
+            return true;
+        return false;
+    }
+
+    if (GetTypeId() == TYPEID_CORPSE)
+        return m_uint32Values_mirror[CORPSE_FIELD_DYNAMIC_FLAGS] != m_uint32Values[CORPSE_FIELD_DYNAMIC_FLAGS];
+
+    return false;
+}
+
+UpdateVisibilityClass Object::GetUpdateVisibilityClass(Player const* target) const
+{
+    if (target == this)
+        return UPDATE_VISIBILITY_SELF;
+
+    if (isType(TYPEMASK_UNIT))
+    {
+        // UNIT_FIELD_FLAGS are altered for them
+        if (target->isGameMaster() || target->HasOption(PLAYER_VIDEO_MODE))
+            return UPDATE_VISIBILITY_UNIQUE;
+
+        Player* owner = ((Unit*)this)->GetCharmerOrOwnerPlayerOrPlayerItself();
+        if (owner && owner->IsInSameRaidWith(target))
+            return UPDATE_VISIBILITY_GROUP;
+    }
+
+    return UPDATE_VISIBILITY_OTHER;
 }
 
 void Object::BuildOutOfRangeUpdateBlock(UpdateData * data) const
@@ -2349,12 +2397,20 @@ struct WorldObjectChangeAccumulator
 {
     UpdateDataMapType &i_updateDatas;
     WorldObject &i_object;
-    WorldObjectChangeAccumulator(WorldObject &obj, UpdateDataMapType &d) : i_updateDatas(d), i_object(obj)
+    // Values update blocks, built once per visibility class and shared by its observers
+    bool i_shareBlocks;
+    ByteBuffer i_blocks[MAX_UPDATE_VISIBILITY_CLASS];
+    uint32 i_blocksBuilt;
+    uint32 i_blocksReused;
+
+    WorldObjectChangeAccumulator(WorldObject &obj, UpdateDataMapType &d) : i_updateDatas(d), i_object(obj),
+        i_shareBlocks(!obj.HasObserverDependentValuesChanges()), i_blocks{ ByteBuffer(0), ByteBuffer(0), ByteBuffer(0) },
+        i_blocksBuilt(0), i_blocksReused(0)
     {
         // send self fields changes in another way, otherwise
         // with new camera system when player's camera too far from player, camera wouldn't receive packets and changes from player
         if (i_object.isType(TYPEMASK_PLAYER))
-            i_object.BuildUpdateDataForPlayer((Player*)&i_object, i_updateDatas);
+            BuildUpdateDataForPlayer((Player*)&i_object);
     }
 
     void Visit(CameraMapType &m)
@@ -2363,17 +2419,40 @@ struct WorldObjectChangeAccumulator
         {
             Player* owner = iter->getSource()->GetOwner();
             if (owner != &i_object && owner->IsInVisibleList_Unsafe(&i_object))
-                i_object.BuildUpdateDataForPlayer(owner, i_updateDatas);
+                BuildUpdateDataForPlayer(owner);
         }
     }
 
     template<class SKIP> void Visit(GridRefManager<SKIP> &) {}
+
+    void BuildUpdateDataForPlayer(Player* target)
+    {
+        UpdateData& data = i_updateDatas[target];
+        UpdateVisibilityClass visibility = i_shareBlocks ? i_object.GetUpdateVisibilityClass(target) : UPDATE_VISIBILITY_UNIQUE;
+        if (visibility == UPDATE_VISIBILITY_UNIQUE)
+        {
+            ++i_blocksBuilt;
+            i_object.BuildValuesUpdateBlockForPlayer(&data, target);
+            return;
+        }
+
+        ByteBuffer& block = i_blocks[visibility];
+        if (block.empty())
+        {
+            ++i_blocksBuilt;
+            i_object.BuildValuesUpdateBlockForPlayer(block, target);
+        }
+        else
+            ++i_blocksReused;
+        data.AddUpdateBlock(block);
+    }
 };
 
 void WorldObject::BuildUpdateData(UpdateDataMapType & update_players)
 {
     WorldObjectChangeAccumulator notifier(*this, update_players);
     Cell::VisitWorldObjects(this, notifier, GetMap()->GetVisibilityDistance());
+    GetMap()->AddUpdateBlocksStats(notifier.i_blocksBuilt, notifier.i_blocksReused);
 
     ClearUpdateMask(false);
 }
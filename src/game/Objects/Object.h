@@ -29,6 +29,7 @@
 #include "ObjectGuid.h"
 #include "Camera.h"
 #include "SpellEntry.h"
+#include "MapUpdateQueue.h"
 
 #include <set>
 #include <string>
@@ -84,6 +85,16 @@ class Transport;
 
 typedef UNORDERED_MAP<Player*, UpdateData> UpdateDataMapType;
 
+// Observers of an object which receive the same values update block
+enum UpdateVisibilityClass
+{
+    UPDATE_VISIBILITY_SELF          = 0,
+    UPDATE_VISIBILITY_GROUP         = 1,                    // in the same raid as the object's owner
+    UPDATE_VISIBILITY_OTHER         = 2,
+    MAX_UPDATE_VISIBILITY_CLASS     = 3,
+    UPDATE_VISIBILITY_UNIQUE        = MAX_UPDATE_VISIBILITY_CLASS // block must be built for this observer only
+};
+
 struct Position
 {
     Position() : x(0.0f), y(0.0f), z(0.0f), o(0.0f) {}
@@ -350,12 +361,18 @@ class MANGOS_DLL_SPEC Object
         virtual void AddToClientUpdateList();
         virtual void RemoveFromClientUpdateList();
         virtual void BuildUpdateData(UpdateDataMapType& update_players);
+        MapUpdateQueueNode& GetClientUpdateQueueNode() { return m_clientUpdateQueueNode; }
         void MarkForClientUpdate();
         void SendForcedObjectUpdate();
         void AddDelayedAction(ObjectDelayedAction e) { _delayedActions |= e; }
         void ExecuteDelayedActions();
 
         void BuildValuesUpdateBlockForPlayer( UpdateData *data, Player *target ) const;
+        void BuildValuesUpdateBlockForPlayer( ByteBuffer& block, Player *target ) const;
+        // True if a changed field is sent with observer specific content, so the values update
+        // block can't be shared between observers of the same visibility class
+        bool HasObserverDependentValuesChanges() const;
+        UpdateVisibilityClass GetUpdateVisibilityClass(Player const* target) const;
         void BuildOutOfRangeUpdateBlock( UpdateData *data ) const;
         void BuildMovementUpdateBlock( UpdateData * data, uint8 flags = 0 ) const;
 
@@ -625,6 +642,8 @@ class MANGOS_DLL_SPEC Object
     private:
         bool m_inWorld;
 
+        MapUpdateQueueNode m_clientUpdateQueueNode;
+
         PackedGuid m_PackGUID;
 
         // for output helpfull error messages from ASSERTs
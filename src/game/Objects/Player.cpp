@@ -19761,9 +19761,8 @@ void Player::InterruptSpellsWithCastItem(Item* item)
             }
 
     // Interrupt eventually delayed spells
-    auto i_Events = m_Events.GetEvents().begin();
-    for (; i_Events != m_Events.GetEvents().end(); ++i_Events)
-        if (SpellEvent* event = dynamic_cast<SpellEvent*>(i_Events->second))
+    for (BasicEvent* i_Event : m_Events.GetEvents())
+        if (SpellEvent* event = dynamic_cast<SpellEvent*>(i_Event))
             if (event && event->GetSpell()->m_CastItem == item)
             {
                 event->GetSpell()->ClearCastItem();
@@ -19976,14 +19975,15 @@ void Player::HandleStealthedUnitsDetection()
     if (!FindMap())
         return;
 
-    std::list<Unit*> stealthedUnits;
+    ScratchArena::Scope scope;
+    ScratchVector<Unit*> stealthedUnits;
 
     MaNGOS::AnyStealthedCheck u_check(this);
-    MaNGOS::UnitListSearcher<MaNGOS::AnyStealthedCheck > searcher(stealthedUnits, u_check);
+    MaNGOS::UnitListSearcher<MaNGOS::AnyStealthedCheck, ScratchVector<Unit*> > searcher(stealthedUnits, u_check);
     Cell::VisitAllObjects(this, searcher, sWorld.getConfig(CONFIG_FLOAT_MAX_PLAYERS_STEALTH_DETECT_RANGE));
 
     WorldObject const* viewPoint = GetCamera().GetBody();
-    for (std::list<Unit*>::const_iterator i = stealthedUnits.begin(); i != stealthedUnits.end(); ++i)
+    for (ScratchVector<Unit*>::const_iterator i = stealthedUnits.begin(); i != stealthedUnits.end(); ++i)
     {
         if ((*i) == this)
             continue;
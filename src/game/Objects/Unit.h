@@ -1856,6 +1856,8 @@ class MANGOS_DLL_SPEC Unit : public WorldObject
         void OnRelocated();
         void ProcessRelocationVisibilityUpdates();
         bool m_needUpdateVisibility;
+        MapUpdateQueueNode m_relocationQueueNode;           // Map::AddRelocatedUnit
+        MapUpdateQueueNode m_movementUpdateQueueNode;       // Map::AddUnitToMovementUpdate
 
         uint32 m_lastCastedSpellID;
         virtual void SetLastCastedSpell(uint32 spell_id, bool byclient);
@@ -27,7 +27,9 @@
 #include "Opcodes.h"
 #include "World.h"
 #include "ObjectGuid.h"
+#include "Timer.h"
 #include <zlib/zlib.h>
+#include <chrono>
 
 #define MAX_UNCOMPRESSED_PACKET_SIZE 0x8000 // 32ko
 
@@ -66,29 +68,140 @@ void UpdateData::AddUpdateBlock(const ByteBuffer &block)
     ++it->blockCount;
 }
 
+namespace
+{
+    // Map the calling thread is updating
+    thread_local CompressionStats* t_compressionStats = NULL;
+    thread_local uint32 t_tickStart = 0;
+    thread_local uint32 t_tickBudget = 0;
+
+    // deflateInit allocates ~256KB, so every thread keeps its stream and resets it between packets
+    class DeflateContext
+    {
+        public:
+            DeflateContext() : m_initialized(false), m_level(0)
+            {
+                m_stream.zalloc = (alloc_func)0;
+                m_stream.zfree = (free_func)0;
+                m_stream.opaque = (voidpf)0;
+            }
+
+            ~DeflateContext()
+            {
+                if (m_initialized)
+                    deflateEnd(&m_stream);
+            }
+
+            // The buffers are set before the level is changed: deflateParams may already compress
+            z_stream* Acquire(int level, void* dst, uint32 dst_size, void* src, int src_size)
+            {
+                int z_res;
+                if (!m_initialized)
+                {
+                    z_res = deflateInit(&m_stream, level);
+                    if (z_res != Z_OK)
+                    {
+                        sLog.outError("Can't compress update packet (zlib: deflateInit) Error code: %i (%s)", z_res, zError(z_res));
+                        return NULL;
+                    }
+                    m_initialized = true;
+                    m_level = level;
+                    SetBuffers(dst, dst_size, src, src_size);
+                    return &m_stream;
+                }
+
+                z_res = deflateReset(&m_stream);
+                SetBuffers(dst, dst_size, src, src_size);
+                if (z_res == Z_OK && level != m_level)
+                    z_res = deflateParams(&m_stream, level, Z_DEFAULT_STRATEGY);
+                if (z_res != Z_OK)
+                {
+                    sLog.outError("Can't compress update packet (zlib: deflateReset) Error code: %i (%s)", z_res, zError(z_res));
+                    deflateEnd(&m_stream);
+                    m_initialized = false;
+                    return NULL;
+                }
+                m_level = level;
+                return &m_stream;
+            }
+
+        private:
+            void SetBuffers(void* dst, uint32 dst_size, void* src, int src_size)
+            {
+                m_stream.next_out = (Bytef*)dst;
+                m_stream.avail_out = dst_size;
+                m_stream.next_in = (Bytef*)src;
+                m_stream.avail_in = (uInt)src_size;
+            }
+
+            z_stream m_stream;
+            bool m_initialized;
+            int m_level;
+    };
+
+    thread_local DeflateContext t_deflateContext;
+
+    FixedCompressionLevelPolicy s_fixedPolicy;
+}
+
+std::atomic<CompressionLevelPolicy const*> PacketCompressor::m_policy(&s_fixedPolicy);
+CompressionStats PacketCompressor::m_globalStats;
+
+int FixedCompressionLevelPolicy::SelectLevel(uint32 /*size*/, uint32 /*tickElapsed*/, uint32 /*tickBudget*/) const
+{
+    return sWorld.getConfig(CONFIG_UINT32_COMPRESSION);
+}
+
+int AdaptiveCompressionLevelPolicy::SelectLevel(uint32 size, uint32 tickElapsed, uint32 tickBudget) const
+{
+    int maxLevel = sWorld.getConfig(CONFIG_UINT32_COMPRESSION);
+
+    // Higher levels gain almost nothing on small packets
+    if (size < sWorld.getConfig(CONFIG_UINT32_COMPRESSION_ADAPTIVE_MIN_SIZE))
+        return Z_BEST_SPEED;
+
+    if (!tickBudget || tickElapsed < tickBudget / 4)
+        return maxLevel;
+    if (tickElapsed < tickBudget / 2)
+        return (Z_BEST_SPEED + maxLevel) / 2;
+    return Z_BEST_SPEED;
+}
+
+void PacketCompressor::SetLevelPolicy(CompressionLevelPolicy const* policy)
+{
+    m_policy = policy ? policy : &s_fixedPolicy;
+}
+
+PacketCompressorScope::PacketCompressorScope(CompressionStats* stats, uint32 tickStart, uint32 tickBudget)
+    : m_prevStats(t_compressionStats), m_prevTickStart(t_tickStart), m_prevTickBudget(t_tickBudget)
+{
+    t_compressionStats = stats;
+    t_tickStart = tickStart;
+    t_tickBudget = tickBudget;
+}
+
+PacketCompressorScope::~PacketCompressorScope()
+{
+    t_compressionStats = m_prevStats;
+    t_tickStart = m_prevTickStart;
+    t_tickBudget = m_prevTickBudget;
+}
+
 void PacketCompressor::Compress(void* dst, uint32 *dst_size, void* src, int src_size)
 {
-    z_stream c_stream;
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
-    c_stream.zalloc = (alloc_func)0;
-    c_stream.zfree = (free_func)0;
-    c_stream.opaque = (voidpf)0;
+    uint32 tickElapsed = t_tickBudget ? WorldTimer::getMSTimeDiffToNow(t_tickStart) : 0;
+    int level = m_policy.load()->SelectLevel(src_size, tickElapsed, t_tickBudget);
 
-    // default Z_BEST_SPEED (1)
-    int z_res = deflateInit(&c_stream, sWorld.getConfig(CONFIG_UINT32_COMPRESSION));
-    if (z_res != Z_OK)
+    z_stream* c_stream = t_deflateContext.Acquire(level, dst, *dst_size, src, src_size);
+    if (!c_stream)
     {
-        sLog.outError("Can't compress update packet (zlib: deflateInit) Error code: %i (%s)", z_res, zError(z_res));
         *dst_size = 0;
         return;
     }
 
-    c_stream.next_out = (Bytef*)dst;
-    c_stream.avail_out = *dst_size;
-    c_stream.next_in = (Bytef*)src;
-    c_stream.avail_in = (uInt)src_size;
-
-    z_res = deflate(&c_stream, Z_NO_FLUSH);
+    int z_res = deflate(c_stream, Z_NO_FLUSH);
     if (z_res != Z_OK)
     {
         sLog.outError("Can't compress update packet (zlib: deflate) Error code: %i (%s)", z_res, zError(z_res));
@@ -96,14 +209,14 @@ void PacketCompressor::Compress(void* dst, uint32 *dst_size, void* src, int src_
         return;
     }
 
-    if (c_stream.avail_in != 0)
+    if (c_stream->avail_in != 0)
     {
         sLog.outError("Can't compress update packet (zlib: deflate not greedy)");
         *dst_size = 0;
         return;
     }
 
-    z_res = deflate(&c_stream, Z_FINISH);
+    z_res = deflate(c_stream, Z_FINISH);
     if (z_res != Z_STREAM_END)
     {
         sLog.outError("Can't compress update packet (zlib: deflate should report Z_STREAM_END instead %i (%s)", z_res, zError(z_res));
@@ -111,15 +224,19 @@ void PacketCompressor::Compress(void* dst, uint32 *dst_size, void* src, int src_
         return;
     }
 
-    z_res = deflateEnd(&c_stream);
-    if (z_res != Z_OK)
+    *dst_size = c_stream->total_out;
+
+    uint64 timeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+    CompressionStats* statsList[] = { &m_globalStats, t_compressionStats };
+    for (CompressionStats* stats : statsList)
     {
-        sLog.outError("Can't compress update packet (zlib: deflateEnd) Error code: %i (%s)", z_res, zError(z_res));
-        *dst_size = 0;
-        return;
+        if (!stats)
+            continue;
+        ++stats->packets;
+        stats->bytesIn += src_size;
+        stats->bytesOut += *dst_size;
+        stats->timeUs += timeUs;
     }
-
-    *dst_size = c_stream.total_out;
 }
 
 bool UpdateData::BuildPacket(WorldPacket *packet, bool hasTransport)
@@ -24,6 +24,7 @@
 
 #include "ByteBuffer.h"
 #include "ObjectGuid.h"
+#include <atomic>
 
 class WorldPacket;
 class WorldSession;
@@ -60,10 +61,66 @@ class UpdatePacket
         uint32 blockCount;
 };
 
+struct CompressionStats
+{
+    CompressionStats() : packets(0), bytesIn(0), bytesOut(0), timeUs(0) {}
+
+    std::atomic<uint64> packets;
+    std::atomic<uint64> bytesIn;
+    std::atomic<uint64> bytesOut;
+    std::atomic<uint64> timeUs;
+};
+
+// Chooses the zlib level of each compressed packet
+class CompressionLevelPolicy
+{
+    public:
+        virtual ~CompressionLevelPolicy() {}
+        // tickElapsed / tickBudget: time spent in the current map update, and its expected length (0 if unknown)
+        virtual int SelectLevel(uint32 size, uint32 tickElapsed, uint32 tickBudget) const = 0;
+};
+
+// Always the configured level
+class FixedCompressionLevelPolicy : public CompressionLevelPolicy
+{
+    public:
+        int SelectLevel(uint32 size, uint32 tickElapsed, uint32 tickBudget) const override;
+};
+
+// Configured level for large packets while the map has time left, fastest level otherwise
+class AdaptiveCompressionLevelPolicy : public CompressionLevelPolicy
+{
+    public:
+        int SelectLevel(uint32 size, uint32 tickElapsed, uint32 tickBudget) const override;
+};
+
 class PacketCompressor
 {
     public:
         static void Compress(void* dst, uint32 *dst_size, void* src, int src_size);
+
+        // NULL restores the fixed level policy
+        static void SetLevelPolicy(CompressionLevelPolicy const* policy);
+        static CompressionStats const& GetGlobalStats() { return m_globalStats; }
+
+    private:
+        friend class PacketCompressorScope;
+
+        static std::atomic<CompressionLevelPolicy const*> m_policy;
+        static CompressionStats m_globalStats;
+};
+
+// Accounts the packets compressed by the calling thread to a map, until destroyed
+class PacketCompressorScope
+{
+    public:
+        PacketCompressorScope(CompressionStats* stats, uint32 tickStart, uint32 tickBudget);
+        ~PacketCompressorScope();
+
+    private:
+        CompressionStats* m_prevStats;
+        uint32 m_prevTickStart;
+        uint32 m_prevTickBudget;
 };
 
 class UpdateData
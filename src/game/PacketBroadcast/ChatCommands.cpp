@@ -9,8 +9,9 @@ bool ChatHandler::HandlePBCastStatsCommand(char*)
     auto const& stats = bcaster->GetStats();
     PSendSysMessage("PacketBroadcast: %u threads.", stats.size());
     for (int i = 0; i < stats.size(); ++i)
-        PSendSysMessage("Thread #%02u: Update %03ums | %u packets",
-            i, stats[i].update_time, stats[i].num_packets);
+        PSendSysMessage("Thread #%02u: Update %03ums | %u packets | saved %u coalesced, %u far (total %llu, %llu)",
+            i, stats[i].update_time, stats[i].num_packets, stats[i].num_coalesced, stats[i].num_far_skipped,
+            (unsigned long long)stats[i].total_coalesced, (unsigned long long)stats[i].total_far_skipped);
     PSendSysMessage("Created %u broadcasters | Deleted %u",
         PlayerBroadcaster::num_bcaster_created, PlayerBroadcaster::num_bcaster_deleted);
     return true;
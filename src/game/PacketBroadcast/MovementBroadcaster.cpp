@@ -61,13 +61,21 @@ void MovementBroadcaster::RemovePlayer(const std::shared_ptr<PlayerBroadcaster>&
 
 void MovementBroadcaster::Work(std::size_t thread_id)
 {
+    uint32 tick = 0;
     while (!m_stop)
     {
         ThreadUpdateStats& stats = m_thread_update_stats[thread_id];
         uint32 num_packets = 0;
+        uint32 num_coalesced = 0;
+        uint32 num_far_skipped = 0;
+        uint32 far_interval = std::max<uint32>(sWorld.getConfig(CONFIG_UINT32_PBCAST_FAR_INTERVAL), 1);
         uint32 begin_time = WorldTimer::getMSTime();
-        BroadcastPackets(thread_id, num_packets);
+        BroadcastPackets(thread_id, num_packets, num_coalesced, num_far_skipped, ++tick % far_interval == 0);
         stats.num_packets = num_packets;
+        stats.num_coalesced = num_coalesced;
+        stats.num_far_skipped = num_far_skipped;
+        stats.total_coalesced += num_coalesced;
+        stats.total_far_skipped += num_far_skipped;
         stats.update_time = WorldTimer::getMSTimeDiffToNow(begin_time);
 
         if (sWorld.getConfig(CONFIG_UINT32_PERFLOG_SLOW_PACKET_BCAST) &&
@@ -105,7 +113,7 @@ uint32 MovementBroadcaster::IdentifySlowMap(std::size_t thread_id)
     return max_instance_id;
 }
 
-void MovementBroadcaster::BroadcastPackets(std::size_t index, uint32& num_packets)
+void MovementBroadcaster::BroadcastPackets(std::size_t index, uint32& num_packets, uint32& num_coalesced, uint32& num_far_skipped, bool far_tick)
 {
     PlayersBCastSet my_players;
     {
@@ -113,8 +121,9 @@ void MovementBroadcaster::BroadcastPackets(std::size_t index, uint32& num_packet
         my_players = m_thread_players[index];
     }
 
+    float far_distance = sWorld.getConfig(CONFIG_FLOAT_PBCAST_FAR_DISTANCE);
     for (auto& player : my_players)
-        player->ProcessQueue(num_packets);
+        player->ProcessQueue(num_packets, num_coalesced, num_far_skipped, far_distance, far_tick);
 }
 
 void MovementBroadcaster::Stop()
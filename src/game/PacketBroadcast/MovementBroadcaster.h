@@ -30,7 +30,7 @@ class MovementBroadcaster final
     std::vector<std::mutex> m_thread_locks;
 
     void Work(std::size_t thread_id);
-    void BroadcastPackets(std::size_t index, uint32& num_packets);
+    void BroadcastPackets(std::size_t index, uint32& num_packets, uint32& num_coalesced, uint32& num_far_skipped, bool far_tick);
     uint32 IdentifySlowMap(std::size_t thread_id);
 
 public:
@@ -44,11 +44,16 @@ public:
     void UpdateConfiguration(std::size_t new_threads_count, std::chrono::milliseconds new_frequency);
     void Stop();
 
+    // Packets are counted per listener
     struct ThreadUpdateStats
     {
         uint32 update_time;
         uint32 num_packets;
         int32 slow_instance;
+        uint32 num_coalesced;                               // position updates replaced by a newer one before the update
+        uint32 num_far_skipped;                             // position updates not sent to far listeners
+        uint64 total_coalesced;
+        uint64 total_far_skipped;
     };
     std::vector<ThreadUpdateStats> const& GetStats() const { return m_thread_update_stats; }
     std::chrono::milliseconds GetSleepTimer() const { return m_sleep_timer; }
@@ -7,7 +7,8 @@ uint32 PlayerBroadcaster::num_bcaster_created = 0;
 uint32 PlayerBroadcaster::num_bcaster_deleted = 0;
 
 PlayerBroadcaster::PlayerBroadcaster(WorldSocket* w_socket, const ObjectGuid& self, std::size_t max_queue)
-    : m_socket(w_socket), m_self(self), MAX_QUEUE_SIZE(max_queue), instanceId(0), lastUpdatePackets(0)
+    : m_socket(w_socket), m_self(self), MAX_QUEUE_SIZE(max_queue), m_position_x(0.0f), m_position_y(0.0f),
+      m_coalesced(0), m_has_far_pending(false), instanceId(0), lastUpdatePackets(0)
 {
     if (m_socket)
         m_socket->AddReference();
@@ -48,38 +49,126 @@ void PlayerBroadcaster::ClearListeners()
     m_listeners.clear();
 }
 
-void PlayerBroadcaster::SendPacket(const WorldPacket& packet)
+void PlayerBroadcaster::SendPacket(const SharedWorldPacketPtr& packet)
 {
     if (m_socket)
         m_socket->SendPacket(packet);
 }
 
-void PlayerBroadcaster::ProcessQueue(uint32& num_packets)
+bool PlayerBroadcaster::IsFarListener(PlayerBroadcaster const& listener, float far_distance) const
 {
-    if (m_queue.empty())
+    float dx = listener.m_position_x - m_position_x;
+    float dy = listener.m_position_y - m_position_y;
+    return dx * dx + dy * dy > far_distance * far_distance;
+}
+
+uint32 PlayerBroadcaster::SendToFarListeners(const SharedWorldPacketPtr& packet, ObjectGuid except, float far_distance)
+{
+    uint32 sent = 0;
+    for (auto it = m_listeners.begin(); it != m_listeners.end(); ++it)
+    {
+        if (it->first == except || !IsFarListener(*it->second, far_distance))
+            continue;
+
+        it->second->SendPacket(packet);
+        ++sent;
+    }
+    return sent;
+}
+
+void PlayerBroadcaster::ProcessQueue(uint32& num_packets, uint32& num_coalesced, uint32& num_far_skipped, float far_distance, bool far_tick)
+{
+    if (m_queue.empty() && !(far_tick && m_has_far_pending))
         return;
 
     std::unique_lock<std::mutex> q_g(m_queue_lock), v_g(m_listeners_lock);
     auto queue = std::move(m_queue);
+    m_queue.clear();
     q_g.unlock();
 
-    lastUpdatePackets = queue.size() * m_listeners.size();
-    num_packets += lastUpdatePackets;
+    num_coalesced += m_coalesced.exchange(0) * m_listeners.size();
 
+    // The listeners far from the player only get its position updates on far ticks. The latest
+    // one withheld from them is sent before the next other packet, or at the next far tick.
+    bool limit_far = far_distance > 0.0f && !m_listeners.empty();
+    uint32 sent = 0;
+    uint32 far_skipped = 0;
     for (auto& data : queue)
     {
+        // Serialized once, shared by the sockets of the listeners
+        SharedWorldPacketPtr packet = std::make_shared<WorldPacket>(std::move(data.packet));
+        bool position_update = IsPositionUpdate(packet->GetOpcode());
+
+        if (m_has_far_pending)
+        {
+            if (position_update)
+                far_skipped += m_far_pending.withheld;
+            else
+                sent += SendToFarListeners(m_far_pending.packet, m_far_pending.except, far_distance);
+
+            m_far_pending.packet.reset();
+            m_has_far_pending = false;
+        }
+
         // Send to self?
         if (data.sendToSelf && data.except != GetGUID())
-            SendPacket(data.packet);
+            SendPacket(packet);
 
+        bool skip_far = limit_far && position_update && !far_tick;
+        uint32 withheld = 0;
         for (auto it = m_listeners.begin(); it != m_listeners.end(); ++it)
         {
             if (it->first == data.except)
                 continue;
 
-            it->second->SendPacket(data.packet);
+            if (skip_far && IsFarListener(*it->second, far_distance))
+            {
+                ++withheld;
+                continue;
+            }
+
+            it->second->SendPacket(packet);
+            ++sent;
+        }
+
+        if (withheld)
+        {
+            m_far_pending.packet = packet;
+            m_far_pending.except = data.except;
+            m_far_pending.withheld = withheld;
+            m_has_far_pending = true;
         }
     }
+
+    if (m_has_far_pending && far_tick)
+    {
+        sent += SendToFarListeners(m_far_pending.packet, m_far_pending.except, far_distance);
+        m_far_pending.packet.reset();
+        m_has_far_pending = false;
+    }
+
+    lastUpdatePackets = sent;
+    num_packets += sent;
+    num_far_skipped += far_skipped;
+}
+
+bool PlayerBroadcaster::CanCoalesce(BroadcastData const& queued, BroadcastData const& data)
+{
+    if (!IsPositionUpdate(queued.packet.GetOpcode()) || !IsPositionUpdate(data.packet.GetOpcode()) ||
+        queued.sendToSelf != data.sendToSelf || queued.except != data.except)
+        return false;
+
+    // Same mover: both start with its packed guid
+    if (queued.packet.empty() || data.packet.empty())
+        return false;
+
+    uint8 mask = queued.packet.contents()[0];
+    std::size_t guid_size = 1;
+    for (; mask; mask &= mask - 1)
+        ++guid_size;
+
+    return queued.packet.size() >= guid_size && data.packet.size() >= guid_size &&
+        memcmp(queued.packet.contents(), data.packet.contents(), guid_size) == 0;
 }
 
 void PlayerBroadcaster::QueuePacket(WorldPacket packet, bool self, ObjectGuid except)
@@ -93,11 +182,21 @@ void PlayerBroadcaster::QueuePacket(WorldPacket packet, bool self, ObjectGuid ex
 
     guard.lock();
 
+    // Only the latest position of the player is sent in a broadcaster update, the
+    // other movements are kept in order
+    if (!m_queue.empty() && CanCoalesce(m_queue.back(), data))
+    {
+        m_queue.back() = std::move(data);
+        ++m_coalesced;
+        guard.unlock();
+        return;
+    }
+
     // We need to drop a packet here - if possible
     if (m_queue.size() >= MAX_QUEUE_SIZE)
     {
         BroadcastData& last_in_queue = m_queue[m_queue.size() - 1];
-        if (CanSkipPacket(last_in_queue.packet.GetOpcode()) && CanSkipPacket(packet.GetOpcode()))
+        if (CanSkipPacket(last_in_queue.packet.GetOpcode()) && CanSkipPacket(data.packet.GetOpcode()))
         {
             m_queue[m_queue.size() - 1] = std::move(data);
             guard.unlock();
@@ -124,6 +223,8 @@ void PlayerBroadcaster::FreeAtLogout()
     std::unique_lock<std::mutex> q_g(m_queue_lock), v_g(m_listeners_lock);
     m_queue.clear();
     m_listeners.clear();
+    m_far_pending.packet.reset();
+    m_has_far_pending = false;
 }
 
 PlayerBroadcaster::~PlayerBroadcaster()
@@ -6,6 +6,7 @@
 #include "WorldSocket.h"
 #include "WorldPacket.h"
 #include "Opcodes.h"
+#include <atomic>
 #include <mutex>
 #include <list>
 #include <vector>
@@ -28,19 +29,44 @@ class PlayerBroadcaster final
     WorldSocket* m_socket;
     ObjectGuid m_self;
 
+    // Latest position update withheld from the far listeners, sent at the next far tick
+    struct FarPendingData
+    {
+        SharedWorldPacketPtr packet;
+        ObjectGuid except;
+        uint32 withheld;                                    // far listeners it was not sent to
+    };
+
     std::map<ObjectGuid, std::shared_ptr<PlayerBroadcaster> > m_listeners;
     std::vector<BroadcastData> m_queue;
     std::mutex m_listeners_lock;
     std::mutex m_queue_lock;
 
-    void ProcessQueue(uint32& num_packets);
-    void SendPacket(const WorldPacket& packet);
+    // Position of the player, for the distance to the movers it listens to
+    std::atomic<float> m_position_x;
+    std::atomic<float> m_position_y;
+
+    std::atomic<uint32> m_coalesced;                        // since the last ProcessQueue
+    FarPendingData m_far_pending;                           // with m_listeners_lock
+    std::atomic<bool> m_has_far_pending;
+
+    void ProcessQueue(uint32& num_packets, uint32& num_coalesced, uint32& num_far_skipped, float far_distance, bool far_tick);
+    void SendPacket(const SharedWorldPacketPtr& packet);
+    uint32 SendToFarListeners(const SharedWorldPacketPtr& packet, ObjectGuid except, float far_distance);
+    bool IsFarListener(PlayerBroadcaster const& listener, float far_distance) const;
 
     static inline bool CanSkipPacket(uint32 opcode)
     {
         return opcode < MSG_MOVE_SET_RUN_SPEED_CHEAT || opcode > MSG_MOVE_SET_TURN_RATE;
     }
 
+    // Only moves the player: a newer one replaces it
+    static inline bool IsPositionUpdate(uint32 opcode)
+    {
+        return opcode == MSG_MOVE_HEARTBEAT || opcode == MSG_MOVE_SET_FACING || opcode == MSG_MOVE_SET_PITCH;
+    }
+    static bool CanCoalesce(BroadcastData const& queued, BroadcastData const& data);
+
     uint32 instanceId;
     uint32 lastUpdatePackets;
 
@@ -63,6 +89,8 @@ public:
 
     void ClearListeners();
     void SetInstanceId(uint32 id) { instanceId = id; }
+    // Map thread, when the player is relocated
+    void SetPosition(float x, float y) { m_position_x = x; m_position_y = y; }
 
     friend class MovementBroadcaster;
 };
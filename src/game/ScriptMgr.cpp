@@ -44,7 +44,7 @@ ScriptMapMap sCreatureMovementScripts;
 
 INSTANTIATE_SINGLETON_1(ScriptMgr);
 
-ScriptMgr::ScriptMgr() : m_scheduledScripts(0), m_spellSummary(nullptr)
+ScriptMgr::ScriptMgr() : m_scriptNamesHash(0), m_spellSummary(nullptr), m_scheduledScripts(0)
 {
 }
 
@@ -856,6 +856,16 @@ void ScriptMgr::LoadScriptNames()
     delete result;
 
     std::sort(m_scriptNames.begin(), m_scriptNames.end());
+
+    // FNV-1a of the sorted names, with their ending '\0'
+    m_scriptNamesHash = 2166136261u;
+    for (ScriptNameMap::const_iterator itr = m_scriptNames.begin(); itr != m_scriptNames.end(); ++itr)
+    {
+        for (std::string::const_iterator c = itr->begin(); c != itr->end(); ++c)
+            m_scriptNamesHash = (m_scriptNamesHash ^ uint8(*c)) * 16777619u;
+        m_scriptNamesHash *= 16777619u;
+    }
+
     sLog.outString();
     sLog.outString(">> Loaded %d Script Names", count);
 }
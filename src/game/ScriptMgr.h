@@ -537,6 +537,8 @@ class ScriptMgr
         const char* GetScriptName(uint32 id) const { return id < m_scriptNames.size() ? m_scriptNames[id].c_str() : ""; }
         uint32 GetScriptId(const char *name) const;
         uint32 GetScriptIdsCount() const { return m_scriptNames.size(); }
+        // Changes with the script names, and so with the script ids
+        uint32 GetScriptNamesHash() const { return m_scriptNamesHash; }
         
         void Initialize();
         void LoadDatabase();
@@ -627,6 +629,7 @@ class ScriptMgr
         EventIdScriptMap        m_EventIdScripts;
 
         ScriptNameMap           m_scriptNames;
+        uint32                  m_scriptNamesHash;
 
         TSpellSummary* m_spellSummary;
         
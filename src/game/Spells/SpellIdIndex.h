@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef _SPELL_ID_INDEX_H
+#define _SPELL_ID_INDEX_H
+
+#include "Platform/Define.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Table keyed by spell id, compiled from its map once loaded: the value of a spell is found at
+// the position the spell id indexes, with neither search nor hashing, and the values are
+// contiguous. Built again when the table is reloaded.
+template <class T>
+class SpellIdIndex
+{
+    public:
+        template <class Map>
+        void Build(Map const& map)
+        {
+            uint32 size = 0;
+            for (typename Map::const_iterator itr = map.begin(); itr != map.end(); ++itr)
+                size = std::max<uint32>(size, itr->first + 1);
+
+            m_positions.assign(size, 0);
+            m_values.clear();
+            m_values.reserve(map.size());
+            for (typename Map::const_iterator itr = map.begin(); itr != map.end(); ++itr)
+            {
+                m_values.push_back(itr->second);
+                m_positions[itr->first] = m_values.size();
+            }
+        }
+
+        T const* Find(uint32 spellId) const
+        {
+            if (spellId >= m_positions.size() || !m_positions[spellId])
+                return NULL;
+            return &m_values[m_positions[spellId] - 1];
+        }
+
+    private:
+        std::vector<uint32> m_positions;                    // of the value + 1, 0 for none
+        std::vector<T> m_values;
+};
+
+// Same for a multimap: the values of a spell are contiguous, in the order of the multimap
+template <class T>
+class SpellIdRangeIndex
+{
+    public:
+        typedef std::pair<T const*, T const*> Bounds;
+
+        template <class MultiMap>
+        void Build(MultiMap const& map)
+        {
+            uint32 size = map.empty() ? 0 : uint32(map.rbegin()->first) + 1;
+            m_begins.assign(size + 1, 0);
+            m_values.clear();
+            m_values.reserve(map.size());
+            for (typename MultiMap::const_iterator itr = map.begin(); itr != map.end(); ++itr)
+            {
+                m_values.push_back(itr->second);
+                m_begins[itr->first + 1] = m_values.size();
+            }
+            // Spells without values begin where the previous ones end
+            for (uint32 i = 1; i <= size; ++i)
+                m_begins[i] = std::max(m_begins[i], m_begins[i - 1]);
+        }
+
+        Bounds Find(uint32 spellId) const
+        {
+            if (spellId + 1 >= m_begins.size())
+                return Bounds(NULL, NULL);
+            T const* values = m_values.empty() ? NULL : &m_values[0];
+            return Bounds(values + m_begins[spellId], values + m_begins[spellId + 1]);
+        }
+
+    private:
+        std::vector<uint32> m_begins;                       // of the values of each spell, then the end
+        std::vector<T> m_values;
+};
+
+#endif
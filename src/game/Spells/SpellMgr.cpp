@@ -30,6 +30,7 @@
 #include "BattleGroundMgr.h"
 #include "MapManager.h"
 #include "Unit.h"
+#include "Database/SQLStorageSnapshot.h"
 
 SpellMgr::SpellMgr()
 {
@@ -1074,7 +1075,7 @@ void SpellMgr::LoadSpellTargetPositions()
     uint32 count = 0;
 
     //                                                0   1           2                  3                  4                  5
-    QueryResult *result = WorldDatabase.Query("SELECT id, target_map, target_position_x, target_position_y, target_position_z, target_orientation FROM spell_target_position");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_target_position", "spell_target_position", "SELECT id, target_map, target_position_x, target_position_y, target_position_z, target_orientation FROM spell_target_position");
     if (!result)
     {
         BarGoLink bar(1);
@@ -1345,13 +1346,14 @@ void SpellMgr::LoadSpellProcEvents()
     mSpellProcEventMap.clear();                             // need for reload case
 
     //                                                0      1           2                3                 4                 5                 6          7       8        9             10
-    QueryResult *result = WorldDatabase.Query("SELECT entry, SchoolMask, SpellFamilyName, SpellFamilyMask0, SpellFamilyMask1, SpellFamilyMask2, procFlags, procEx, ppmRate, CustomChance, Cooldown FROM spell_proc_event");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_proc_event", "spell_proc_event", "SELECT entry, SchoolMask, SpellFamilyName, SpellFamilyMask0, SpellFamilyMask1, SpellFamilyMask2, procFlags, procEx, ppmRate, CustomChance, Cooldown FROM spell_proc_event");
     if (!result)
     {
         BarGoLink bar(1);
         bar.step();
         sLog.outString();
         sLog.outString(">> No spell proc event conditions loaded");
+        mSpellProcEventIndex.Build(mSpellProcEventMap);
         return;
     }
 
@@ -1389,6 +1391,8 @@ void SpellMgr::LoadSpellProcEvents()
 
     delete result;
 
+    mSpellProcEventIndex.Build(mSpellProcEventMap);
+
     sLog.outString();
     sLog.outString(">> Loaded %u extra spell proc event conditions +%u custom proc (inc. +%u custom ranks)",  rankHelper.worker.count, rankHelper.worker.customProc, rankHelper.customRank);
 }
@@ -1412,7 +1416,7 @@ void SpellMgr::LoadSpellProcItemEnchant()
     uint32 count = 0;
 
     //                                                0      1
-    QueryResult *result = WorldDatabase.Query("SELECT entry, ppmRate FROM spell_proc_item_enchant");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_proc_item_enchant", "spell_proc_item_enchant", "SELECT entry, ppmRate FROM spell_proc_item_enchant");
     if (!result)
     {
 
@@ -1422,6 +1426,7 @@ void SpellMgr::LoadSpellProcItemEnchant()
 
         sLog.outString();
         sLog.outString(">> Loaded %u proc item enchant definitions", count);
+        mSpellProcItemEnchantIndex.Build(mSpellProcItemEnchantMap);
         return;
     }
 
@@ -1465,6 +1470,8 @@ void SpellMgr::LoadSpellProcItemEnchant()
 
     delete result;
 
+    mSpellProcItemEnchantIndex.Build(mSpellProcItemEnchantMap);
+
     sLog.outString();
     sLog.outString(">> Loaded %u proc item enchant definitions", count);
 }
@@ -1486,13 +1493,14 @@ void SpellMgr::LoadSpellBonuses()
     mSpellBonusMap.clear();                             // need for reload case
     uint32 count = 0;
     //                                                0      1             2          3
-    QueryResult *result = WorldDatabase.Query("SELECT entry, direct_bonus, dot_bonus, ap_bonus, ap_dot_bonus FROM spell_bonus_data");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_bonus_data", "spell_bonus_data", "SELECT entry, direct_bonus, dot_bonus, ap_bonus, ap_dot_bonus FROM spell_bonus_data");
     if (!result)
     {
         BarGoLink bar(1);
         bar.step();
         sLog.outString();
         sLog.outString(">> Loaded %u spell bonus data", count);
+        mSpellBonusIndex.Build(mSpellBonusMap);
         return;
     }
 
@@ -1614,6 +1622,8 @@ void SpellMgr::LoadSpellBonuses()
 
     delete result;
 
+    mSpellBonusIndex.Build(mSpellBonusMap);
+
     sLog.outString();
     sLog.outString(">> Loaded %u extra spell bonus data",  count);
 }
@@ -1689,11 +1699,12 @@ void SpellMgr::LoadSpellGroups()
     uint32 count = 0;
 
     //                                                0         1
-    QueryResult* result = WorldDatabase.Query("SELECT group_id, spell_id FROM spell_group ORDER BY group_id, group_spell_id, spell_id");
+    QueryResult* result = SQLStorageSnapshot::Query("spell_group", "spell_group", "SELECT group_id, spell_id FROM spell_group ORDER BY group_id, group_spell_id, spell_id");
     if (!result)
     {
         sLog.outString();
         sLog.outString(">> Loaded %u spell group definitions", count);
+        mSpellSpellGroupIndex.Build(mSpellSpellGroup);
         return;
     }
 
@@ -1755,6 +1766,8 @@ void SpellMgr::LoadSpellGroups()
         }
     }
     delete result;
+    mSpellSpellGroupIndex.Build(mSpellSpellGroup);
+
     sLog.outString();
     sLog.outString(">> Loaded %u spell group definitions", count);
 }
@@ -1766,7 +1779,7 @@ void SpellMgr::LoadSpellGroupStackRules()
     uint32 count = 0;
 
     //                                                       0         1
-    QueryResult* result = WorldDatabase.Query("SELECT group_id, stack_rule FROM spell_group_stack_rules");
+    QueryResult* result = SQLStorageSnapshot::Query("spell_group_stack_rules", "spell_group_stack_rules", "SELECT group_id, stack_rule FROM spell_group_stack_rules");
     if (!result)
     {
         sLog.outString();
@@ -1889,7 +1902,7 @@ void SpellMgr::LoadSpellElixirs()
     uint32 count = 0;
 
     //                                                0      1
-    QueryResult *result = WorldDatabase.Query("SELECT entry, mask FROM spell_elixir");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_elixir", "spell_elixir", "SELECT entry, mask FROM spell_elixir");
     if (!result)
     {
 
@@ -1899,6 +1912,7 @@ void SpellMgr::LoadSpellElixirs()
 
         sLog.outString();
         sLog.outString(">> Loaded %u spell elixir definitions", count);
+        mSpellElixirIndex.Build(mSpellElixirs);
         return;
     }
 
@@ -1929,6 +1943,8 @@ void SpellMgr::LoadSpellElixirs()
 
     delete result;
 
+    mSpellElixirIndex.Build(mSpellElixirs);
+
     sLog.outString();
     sLog.outString(">> Loaded %u spell elixir definitions", count);
 }
@@ -2000,13 +2016,14 @@ void SpellMgr::LoadSpellThreats()
     mSpellThreatMap.clear();                                // need for reload case
 
     //                                                0      1       2           3
-    QueryResult *result = WorldDatabase.Query("SELECT entry, Threat, multiplier, ap_bonus FROM spell_threat");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_threat", "spell_threat", "SELECT entry, Threat, multiplier, ap_bonus FROM spell_threat");
     if (!result)
     {
         BarGoLink bar(1);
         bar.step();
         sLog.outString();
         sLog.outString(">> No spell threat entries loaded.");
+        mSpellThreatIndex.Build(mSpellThreatMap);
         return;
     }
 
@@ -2036,6 +2053,8 @@ void SpellMgr::LoadSpellThreats()
 
     delete result;
 
+    mSpellThreatIndex.Build(mSpellThreatMap);
+
     sLog.outString();
     sLog.outString(">> Loaded %u spell threat entries", rankHelper.worker.count);
 }
@@ -2772,7 +2791,7 @@ void SpellMgr::LoadSpellChains()
     }
 
     // load custom case
-    QueryResult *result = WorldDatabase.Query("SELECT spell_id, prev_spell, first_spell, rank, req_spell FROM spell_chain");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_chain", "spell_chain", "SELECT spell_id, prev_spell, first_spell, rank, req_spell FROM spell_chain");
     if (!result)
     {
         BarGoLink bar(1);
@@ -2781,6 +2800,7 @@ void SpellMgr::LoadSpellChains()
         sLog.outString();
         sLog.outString(">> Loaded 0 spell chain records");
         sLog.outErrorDb("`spell_chains` table is empty!");
+        mSpellChainIndex.Build(mSpellChains);
         return;
     }
 
@@ -2995,6 +3015,8 @@ void SpellMgr::LoadSpellChains()
         }
     }
 
+    mSpellChainIndex.Build(mSpellChains);
+
     sLog.outString();
     sLog.outString(">> Loaded %u spell chain records (%u from DBC data with %u req field updates, and %u loaded from table)", dbc_count + new_count, dbc_count, req_count, new_count);
 }
@@ -3043,7 +3065,7 @@ void SpellMgr::LoadSpellLearnSpells()
     mSpellLearnSpells.clear();                              // need for reload case
 
     //                                                0      1        2
-    QueryResult *result = WorldDatabase.Query("SELECT entry, SpellID, Active FROM spell_learn_spell");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_learn_spell", "spell_learn_spell", "SELECT entry, SpellID, Active FROM spell_learn_spell");
     if (!result)
     {
         BarGoLink bar(1);
@@ -3155,7 +3177,7 @@ void SpellMgr::LoadSpellScriptTarget()
 
     uint32 count = 0;
 
-    QueryResult *result = WorldDatabase.Query("SELECT entry,type,targetEntry FROM spell_script_target");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_script_target", "spell_script_target", "SELECT entry,type,targetEntry FROM spell_script_target");
 
     if (!result)
     {
@@ -3300,7 +3322,7 @@ void SpellMgr::LoadSpellPetAuras()
     uint32 count = 0;
 
     //                                                0      1    2
-    QueryResult *result = WorldDatabase.Query("SELECT spell, pet, aura FROM spell_pet_auras");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_pet_auras", "spell_pet_auras", "SELECT spell, pet, aura FROM spell_pet_auras");
     if (!result)
     {
 
@@ -3456,7 +3478,7 @@ void SpellMgr::LoadSpellAreas()
     uint32 count = 0;
 
     //                                                0      1     2            3                   4          5           6         7       8
-    QueryResult *result = WorldDatabase.Query("SELECT spell, area, quest_start, quest_start_active, quest_end, aura_spell, racemask, gender, autocast FROM spell_area");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_area", "spell_area", "SELECT spell, area, quest_start, quest_start_active, quest_end, aura_spell, racemask, gender, autocast FROM spell_area");
 
     if (!result)
     {
@@ -4108,7 +4130,7 @@ void SpellMgr::LoadSpellAffects()
     uint32 count = 0;
 
     //                                                0      1         2
-    QueryResult *result = WorldDatabase.Query("SELECT entry, effectId, SpellFamilyMask FROM spell_affect");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_affect", "spell_affect", "SELECT entry, effectId, SpellFamilyMask FROM spell_affect");
     if (!result)
     {
 
@@ -4210,7 +4232,7 @@ void SpellMgr::LoadFacingCasterFlags()
     uint32 count = 0;
 
     //                                                0              1
-    QueryResult *result = WorldDatabase.Query("SELECT entry, facingcasterflag FROM spell_facing");
+    QueryResult *result = SQLStorageSnapshot::Query("spell_facing", "spell_facing", "SELECT entry, facingcasterflag FROM spell_facing");
     if (!result)
     {
         BarGoLink bar(1);
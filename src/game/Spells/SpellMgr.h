@@ -32,10 +32,13 @@
 #include "DBCStores.h"
 #include "SQLStorages.h"
 #include "SpellEntry.h"
+#include "SpellIdIndex.h"
 
 #include "Utilities/UnorderedMapSet.h"
 
 #include <map>
+#include <utility>
+#include <vector>
 
 class Player;
 class Spell;
@@ -832,17 +835,17 @@ class SpellMgr
     // Accessors (const or static functions)
     public:
         // Spell Groups - TrinityCore
-        SpellSpellGroupMapBounds GetSpellSpellGroupMapBounds(uint32 spell_id) const
+        SpellIdRangeIndex<SpellGroup>::Bounds GetSpellSpellGroupMapBounds(uint32 spell_id) const
         {
             spell_id = GetFirstSpellInChain(spell_id);
-            return SpellSpellGroupMapBounds(mSpellSpellGroup.lower_bound(spell_id),mSpellSpellGroup.upper_bound(spell_id));
+            return mSpellSpellGroupIndex.Find(spell_id);
         }
         uint32 IsSpellMemberOfSpellGroup(uint32 spellid, SpellGroup groupid) const
         {
-            SpellSpellGroupMapBounds spellGroup = GetSpellSpellGroupMapBounds(spellid);
-            for (SpellSpellGroupMap::const_iterator itr = spellGroup.first; itr != spellGroup.second ; ++itr)
+            SpellIdRangeIndex<SpellGroup>::Bounds spellGroup = GetSpellSpellGroupMapBounds(spellid);
+            for (SpellGroup const* itr = spellGroup.first; itr != spellGroup.second ; ++itr)
             {
-                if (itr->second == groupid)
+                if (*itr == groupid)
                     return true;
             }
             return false;
@@ -885,11 +888,11 @@ class SpellMgr
             if (spellid_1 == spellid_2)
                 return SPELL_GROUP_STACK_RULE_DEFAULT;
             // find SpellGroups which are common for both spells
-            SpellSpellGroupMapBounds spellGroup1 = GetSpellSpellGroupMapBounds(spellid_1);
+            SpellIdRangeIndex<SpellGroup>::Bounds spellGroup1 = GetSpellSpellGroupMapBounds(spellid_1);
             std::set<SpellGroup> groups;
-            for (SpellSpellGroupMap::const_iterator itr = spellGroup1.first; itr != spellGroup1.second ; ++itr)
-                if (IsSpellMemberOfSpellGroup(spellid_2, itr->second))
-                    groups.insert(itr->second);
+            for (SpellGroup const* itr = spellGroup1.first; itr != spellGroup1.second ; ++itr)
+                if (IsSpellMemberOfSpellGroup(spellid_2, *itr))
+                    groups.insert(*itr);
 
             SpellGroupStackRule rule = SPELL_GROUP_STACK_RULE_DEFAULT;
 
@@ -918,11 +921,9 @@ class SpellMgr
         bool IsMorePowerfullSpell(uint32 powerfullSpell, uint32 otherSpell, SpellGroup group) const
         {
             // The most powerfull spell appears after less powerfull spells in the list.
-            bool spellPassed = false;
-            for (SpellGroupSpellMap::const_iterator itr = mSpellGroupSpell.begin(); itr != mSpellGroupSpell.end(); ++itr)
+            SpellGroupSpellMapBounds groupSpell = GetSpellGroupSpellMapBounds(group);
+            for (SpellGroupSpellMap::const_iterator itr = groupSpell.first; itr != groupSpell.second; ++itr)
             {
-                if (itr->first != group)
-                    continue;
                 if (itr->second == powerfullSpell)
                     return false;
                 if (itr->second == otherSpell)
@@ -947,11 +948,8 @@ class SpellMgr
 
         uint32 GetSpellElixirMask(uint32 spellid) const
         {
-            SpellElixirMap::const_iterator itr = mSpellElixirs.find(spellid);
-            if(itr==mSpellElixirs.end())
-                return 0x0;
-
-            return itr->second;
+            uint8 const* mask = mSpellElixirIndex.Find(spellid);
+            return mask ? *mask : 0x0;
         }
 
         SpellSpecific GetSpellElixirSpecific(uint32 spellid) const
@@ -969,11 +967,7 @@ class SpellMgr
 
         SpellThreatEntry const* GetSpellThreatEntry(uint32 spellid) const
         {
-            SpellThreatMap::const_iterator itr = mSpellThreatMap.find(spellid);
-            if (itr != mSpellThreatMap.end())
-                return &itr->second;
-
-            return NULL;
+            return mSpellThreatIndex.Find(spellid);
         }
 
         float GetSpellThreatMultiplier(SpellEntry const *spellInfo) const
@@ -990,20 +984,14 @@ class SpellMgr
         // Spell proc events
         SpellProcEventEntry const* GetSpellProcEvent(uint32 spellId) const
         {
-            SpellProcEventMap::const_iterator itr = mSpellProcEventMap.find(spellId);
-            if( itr != mSpellProcEventMap.end( ) )
-                return &itr->second;
-            return NULL;
+            return mSpellProcEventIndex.Find(spellId);
         }
 
         // Spell procs from item enchants
         float GetItemEnchantProcChance(uint32 spellid) const
         {
-            SpellProcItemEnchantMap::const_iterator itr = mSpellProcItemEnchantMap.find(spellid);
-            if(itr==mSpellProcItemEnchantMap.end())
-                return 0.0f;
-
-            return itr->second;
+            float const* ppm = mSpellProcItemEnchantIndex.Find(spellid);
+            return ppm ? *ppm : 0.0f;
         }
 
         static bool IsSpellProcEventCanTriggeredBy( SpellProcEventEntry const * spellProcEvent, uint32 EventProcFlag, SpellEntry const * procSpell, uint32 procFlags, uint32 procExtra);
@@ -1011,12 +999,7 @@ class SpellMgr
         // Spell bonus data
         SpellBonusEntry const* GetSpellBonusData(uint32 spellId) const
         {
-            // Lookup data
-            SpellBonusMap::const_iterator itr = mSpellBonusMap.find(spellId);
-            if( itr != mSpellBonusMap.end( ) )
-                return &itr->second;
-
-            return NULL;
+            return mSpellBonusIndex.Find(spellId);
         }
 
         uint32 GetSpellFacingFlag(uint32 spellId) const
@@ -1039,11 +1022,7 @@ class SpellMgr
         // Spell ranks chains
         SpellChainNode const* GetSpellChainNode(uint32 spell_id) const
         {
-            SpellChainMap::const_iterator itr = mSpellChains.find(spell_id);
-            if(itr == mSpellChains.end())
-                return NULL;
-
-            return &itr->second;
+            return mSpellChainIndex.Find(spell_id);
         }
 
         uint32 GetFirstSpellInChain(uint32 spell_id) const
@@ -1087,17 +1066,17 @@ class SpellMgr
 
         uint8 IsHighRankOfSpell(uint32 spell1,uint32 spell2) const
         {
-            SpellChainMap::const_iterator itr = mSpellChains.find(spell1);
+            SpellChainNode const* node = GetSpellChainNode(spell1);
 
             uint32 rank2 = GetSpellRank(spell2);
 
             // not ordered correctly by rank value
-            if(itr == mSpellChains.end() || !rank2 || itr->second.rank <= rank2)
+            if(!node || !rank2 || node->rank <= rank2)
                 return false;
 
             // check present in same rank chain
-            for(; itr != mSpellChains.end(); itr = mSpellChains.find(itr->second.prev))
-                if(itr->second.prev==spell2)
+            for(; node; node = GetSpellChainNode(node->prev))
+                if(node->prev==spell2)
                     return true;
 
             return false;
@@ -1282,6 +1261,15 @@ class SpellMgr
         SpellGroupStackMap   mSpellGroupStack;
         // SpellEntry
         SpellEntryMap      mSpellEntryMap;
+
+        // Compiled from the maps above, for the lookups during the fights
+        SpellIdIndex<SpellChainNode> mSpellChainIndex;
+        SpellIdIndex<uint8> mSpellElixirIndex;
+        SpellIdIndex<SpellThreatEntry> mSpellThreatIndex;
+        SpellIdIndex<SpellProcEventEntry> mSpellProcEventIndex;
+        SpellIdIndex<float> mSpellProcItemEnchantIndex;
+        SpellIdIndex<SpellBonusEntry> mSpellBonusIndex;
+        SpellIdRangeIndex<SpellGroup> mSpellSpellGroupIndex;
 };
 
 #define sSpellMgr SpellMgr::Instance()
@@ -29,6 +29,8 @@
 #include "UnitEvents.h"
 #include "TargetedMovementGenerator.h"
 
+#include <algorithm>
+
 //==============================================================
 //================= ThreatCalcHelper ===========================
 //==============================================================
@@ -68,6 +70,8 @@ HostileReference::HostileReference(Unit* pUnit, ThreatManager *pThreatManager, f
     iUnitGuid = pUnit->GetObjectGuid();
     iOnline = true;
     iAccessible = true;
+    iHeapIndex = 0;
+    iSequence = 0;
 }
 
 //============================================================
@@ -204,12 +208,105 @@ Unit* HostileReference::getSourceUnit()
 
 void ThreatContainer::clearReferences()
 {
-    for (ThreatList::const_iterator i = iThreatList.begin(); i != iThreatList.end(); ++i)
+    for (std::vector<HostileReference*>::const_iterator i = iHeap.begin(); i != iHeap.end(); ++i)
     {
         (*i)->unlink();
         delete(*i);
     }
+    iHeap.clear();
     iThreatList.clear();
+    iDirty = false;
+}
+
+//============================================================
+
+void ThreatContainer::addReference(HostileReference* pHostileReference)
+{
+    pHostileReference->iSequence = iNextSequence++;
+    iHeap.push_back(pHostileReference);
+    pHostileReference->iHeapIndex = iHeap.size() - 1;
+    siftUp(pHostileReference->iHeapIndex);
+
+    iThreatList.push_back(pHostileReference);
+    iDirty = true;
+}
+
+//============================================================
+
+void ThreatContainer::remove(HostileReference* pRef)
+{
+    if (!contains(pRef))
+        return;
+
+    uint32 index = pRef->iHeapIndex;
+    HostileReference* last = iHeap.back();
+    iHeap.pop_back();
+    if (last != pRef)
+    {
+        setHeapPosition(last, index);
+        siftUp(index);
+        siftDown(last->iHeapIndex);
+    }
+
+    iThreatList.remove(pRef);
+}
+
+//============================================================
+
+void ThreatContainer::threatChanged(HostileReference* pRef)
+{
+    if (!contains(pRef))
+        return;
+
+    siftUp(pRef->iHeapIndex);
+    siftDown(pRef->iHeapIndex);
+    iDirty = true;
+}
+
+//============================================================
+
+void ThreatContainer::siftUp(uint32 pIndex)
+{
+    HostileReference* ref = iHeap[pIndex];
+    while (pIndex > 0)
+    {
+        uint32 parent = (pIndex - 1) / 2;
+        if (!isMoreHated(ref, iHeap[parent]))
+            break;
+        setHeapPosition(iHeap[parent], pIndex);
+        pIndex = parent;
+    }
+    setHeapPosition(ref, pIndex);
+}
+
+//============================================================
+
+void ThreatContainer::siftDown(uint32 pIndex)
+{
+    HostileReference* ref = iHeap[pIndex];
+    uint32 size = iHeap.size();
+    while (true)
+    {
+        uint32 child = 2 * pIndex + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && isMoreHated(iHeap[child + 1], iHeap[child]))
+            ++child;
+        if (!isMoreHated(iHeap[child], ref))
+            break;
+        setHeapPosition(iHeap[child], pIndex);
+        pIndex = child;
+    }
+    setHeapPosition(ref, pIndex);
+}
+
+//============================================================
+
+void ThreatContainer::update()
+{
+    if (iDirty && iThreatList.size() > 1)
+        iThreatList.sort(isMoreHated);
+    iDirty = false;
 }
 
 //============================================================
@@ -221,7 +318,7 @@ HostileReference* ThreatContainer::getReferenceByTarget(Unit* pVictim)
 
     HostileReference* result = nullptr;
     ObjectGuid guid = pVictim->GetObjectGuid();
-    for (ThreatList::const_iterator i = iThreatList.begin(); i != iThreatList.end(); ++i)
+    for (std::vector<HostileReference*>::const_iterator i = iHeap.begin(); i != iHeap.end(); ++i)
     {
         if ((*i)->getUnitGuid() == guid)
         {
@@ -265,22 +362,6 @@ void ThreatContainer::modifyThreatPercent(Unit *pVictim, int32 pPercent)
 
 //============================================================
 
-bool HostileReferenceSortPredicate(const HostileReference* lhs, const HostileReference* rhs)
-{
-    // std::list::sort ordering predicate must be: (Pred(x,y)&&Pred(y,x))==false
-    return lhs->getThreat() > rhs->getThreat();             // reverse sorting
-}
-
-//============================================================
-// Check if the list is dirty and sort if necessary
-
-void ThreatContainer::update()
-{
-    if (iDirty && iThreatList.size() > 1)
-        iThreatList.sort(HostileReferenceSortPredicate);
-    iDirty = false;
-}
-
 //============================================================
 // return the next best victim
 // could be the current victim
@@ -294,15 +375,29 @@ HostileReference* ThreatContainer::selectNextVictim(Creature* pAttacker, Hostile
     bool found = false;
     bool allowLowPriorityTargets = false;
     bool attackerImmobilized = pAttacker->hasUnitState(UNIT_STAT_CAN_NOT_MOVE);
+    auto walkOrder = [this](uint32 left, uint32 right) { return isMoreHated(iHeap[right], iHeap[left]); };
 
     for (int attempt = 0; attempt < 2 && !found; ++attempt)
     {
         if (attempt) // Second attempt
             allowLowPriorityTargets = true;
 
-        for (ThreatList::const_iterator iter = iThreatList.begin(); iter != iThreatList.end() && !found;)
+        // The references by threat: the most hated of the positions left, whose children
+        // are walked after it
+        iWalk.clear();
+        if (!iHeap.empty())
+            iWalk.push_back(0);
+        while (!iWalk.empty() && !found)
         {
-            currentRef = (*iter);
+            std::pop_heap(iWalk.begin(), iWalk.end(), walkOrder);
+            uint32 index = iWalk.back();
+            iWalk.pop_back();
+            for (uint32 child = 2 * index + 1; child <= 2 * index + 2 && child < iHeap.size(); ++child)
+            {
+                iWalk.push_back(child);
+                std::push_heap(iWalk.begin(), iWalk.end(), walkOrder);
+            }
+            currentRef = iHeap[index];
 
             Unit* target = currentRef->getTarget();
             MANGOS_ASSERT(target);                              // if the ref has status online the target must be there !
@@ -318,7 +413,6 @@ HostileReference* ThreatContainer::selectNextVictim(Creature* pAttacker, Hostile
             {
                 if (currentRef == pCurrentVictim)
                     pCurrentVictim = nullptr;
-                ++iter;
                 continue;
             }
 
@@ -331,7 +425,6 @@ HostileReference* ThreatContainer::selectNextVictim(Creature* pAttacker, Hostile
                 // current victim is a second choice target, so don't compare threat with it below
                 if (currentRef == pCurrentVictim)
                     pCurrentVictim = nullptr;
-                ++iter;
                 continue;
             }
 
@@ -358,7 +451,6 @@ HostileReference* ThreatContainer::selectNextVictim(Creature* pAttacker, Hostile
                 found = true;
                 break;
             }
-            ++iter;
         }
     }
     if (!found)
@@ -513,35 +605,29 @@ void ThreatManager::processThreatEvent(ThreatRefStatusChangeEvent* threatRefStat
     switch (threatRefStatusChangeEvent->getType())
     {
         case UEV_THREAT_REF_THREAT_CHANGE:
-            if ((getCurrentVictim() == hostileReference && threatRefStatusChangeEvent->getFValue() < 0.0f) ||
-                    (getCurrentVictim() != hostileReference && threatRefStatusChangeEvent->getFValue() > 0.0f))
-                setDirty(true);                             // the order in the threat list might have changed
+            if (hostileReference->isOnline())
+                iThreatContainer.threatChanged(hostileReference);
+            else
+                iThreatOfflineContainer.threatChanged(hostileReference);
             break;
         case UEV_THREAT_REF_ONLINE_STATUS:
+            // Removed first, the position in the heap is the one of its container
             if (!hostileReference->isOnline())
             {
                 if (hostileReference == getCurrentVictim())
-                {
                     setCurrentVictim(nullptr);
-                    setDirty(true);
-                }
                 iThreatContainer.remove(hostileReference);
                 iThreatOfflineContainer.addReference(hostileReference);
             }
             else
             {
-                if (getCurrentVictim() && hostileReference->getThreat() > (1.1f * getCurrentVictim()->getThreat()))
-                    setDirty(true);
-                iThreatContainer.addReference(hostileReference);
                 iThreatOfflineContainer.remove(hostileReference);
+                iThreatContainer.addReference(hostileReference);
             }
             break;
         case UEV_THREAT_REF_REMOVE_FROM_LIST:
             if (hostileReference == getCurrentVictim())
-            {
                 setCurrentVictim(nullptr);
-                setDirty(true);
-            }
             if (hostileReference->isOnline())
                 iThreatContainer.remove(hostileReference);
             else
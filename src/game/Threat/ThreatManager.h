@@ -28,6 +28,7 @@
 #include "UnitEvents.h"
 #include "ObjectGuid.h"
 #include <list>
+#include <vector>
 
 //==============================================================
 
@@ -120,6 +121,8 @@ class MANGOS_DLL_SPEC HostileReference : public Reference<Unit, ThreatManager>
         // Tell our refFrom (source) object, that the link is cut (Target destroyed)
         void sourceObjectDestroyLink() override;
     private:
+        friend class ThreatContainer;
+
         // Inform the source, that the status of that reference was changed
         void fireStatusChanged(ThreatRefStatusChangeEvent& pThreatRefStatusChangeEvent);
 
@@ -129,6 +132,8 @@ class MANGOS_DLL_SPEC HostileReference : public Reference<Unit, ThreatManager>
         ObjectGuid iUnitGuid;
         bool iOnline;
         bool iAccessible;
+        uint32 iHeapIndex;                                  // position in the heap of its container
+        uint64 iSequence;                                   // order of addition to its container, for equal threats
 };
 
 //==============================================================
@@ -136,20 +141,27 @@ class ThreatManager;
 
 typedef std::list<HostileReference*> ThreatList;
 
+// The references are kept in an indexed binary heap, most hated first, each one knowing its
+// position: a change of threat moves a single reference in O(log n), and the next victim is
+// searched walking the references by threat, without sorting them all. The list given to the
+// scripts is sorted by update(), when the victim is selected.
 class MANGOS_DLL_SPEC ThreatContainer
 {
-    ThreatList iThreatList;
-    bool iDirty;
+    std::vector<HostileReference*> iHeap;
+    ThreatList iThreatList;                                 // same references
+    bool iDirty;                                            // iThreatList is to sort
+    std::vector<uint32> iWalk;                              // heap positions left to walk, selectNextVictim
+    uint64 iNextSequence;
 protected:
     friend class ThreatManager;
 
-    void remove(HostileReference* pRef) { iThreatList.remove(pRef); }
-    void addReference(HostileReference* pHostileReference) { iThreatList.push_back(pHostileReference); }
+    void remove(HostileReference* pRef);
+    void addReference(HostileReference* pHostileReference);
     void clearReferences();
-    // Sort the list if necessary
-    void update();
+    // The threat of the reference changed, move it in the heap
+    void threatChanged(HostileReference* pRef);
 public:
-    ThreatContainer() { iDirty = false; }
+    ThreatContainer() : iDirty(false), iNextSequence(0) {}
     ~ThreatContainer() { clearReferences(); }
 
     HostileReference* addThreat(Unit* pVictim, float pThreat);
@@ -158,17 +170,29 @@ public:
 
     HostileReference* selectNextVictim(Creature* pAttacker, HostileReference* pCurrentVictim);
 
-    void setDirty(bool pDirty) { iDirty = pDirty; }
-
-    bool isDirty() const { return iDirty; }
+    // Sort the threat list after a change
+    void update();
 
-    bool empty() const { return(iThreatList.empty()); }
+    bool empty() const { return(iHeap.empty()); }
 
-    HostileReference* getMostHated() { return iThreatList.empty() ? NULL : iThreatList.front(); }
+    HostileReference* getMostHated() { return iHeap.empty() ? NULL : iHeap.front(); }
 
     HostileReference* getReferenceByTarget(Unit* pVictim);
 
+    // Sorted by threat at the last update()
     ThreatList const& getThreatList() const { return iThreatList; }
+
+    // Higher threat, or same threat and added before
+    static bool isMoreHated(HostileReference const* pLeft, HostileReference const* pRight)
+    {
+        return pLeft->getThreat() > pRight->getThreat() ||
+            (pLeft->getThreat() == pRight->getThreat() && pLeft->iSequence < pRight->iSequence);
+    }
+private:
+    void setHeapPosition(HostileReference* pRef, uint32 pIndex) { iHeap[pIndex] = pRef; pRef->iHeapIndex = pIndex; }
+    void siftUp(uint32 pIndex);
+    void siftDown(uint32 pIndex);
+    bool contains(HostileReference const* pRef) const { return pRef->iHeapIndex < iHeap.size() && iHeap[pRef->iHeapIndex] == pRef; }
 };
 
 //=================================================
@@ -209,8 +233,6 @@ public:
 
     void setCurrentVictim(HostileReference* pHostileReference);
 
-    void setDirty(bool pDirty) { iThreatContainer.setDirty(pDirty); }
-
     // Don't must be used for explicit modify threat values in iterator return pointers
     ThreatList const& getThreatList() const { return iThreatContainer.getThreatList(); }
 private:
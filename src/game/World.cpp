@@ -32,6 +32,7 @@
 #include "Opcodes.h"
 #include "WorldSession.h"
 #include "WorldPacket.h"
+#include "UpdateData.h"
 #include "Weather.h"
 #include "Player.h"
 #include "SkillExtraItems.h"
@@ -57,6 +58,7 @@
 #include "GameEventMgr.h"
 #include "PoolManager.h"
 #include "Database/DatabaseImpl.h"
+#include "Database/SQLStorageSnapshot.h"
 #include "GridNotifiersImpl.h"
 #include "CellImpl.h"
 #include "MapPersistentStateMgr.h"
@@ -71,6 +73,8 @@
 #include "Transports/TransportMgr.h"
 #include "PlayerBotMgr.h"
 #include "ProgressBar.h"
+#include "Policies/MemoryManagement.h"
+#include "TaskGraph.h"
 #include "ZoneScriptMgr.h"
 #include "CharacterDatabaseCache.h"
 #include "CreatureGroups.h"
@@ -100,6 +104,7 @@ float World::m_VisibleObjectGreyDistance      = 0;
 
 float  World::m_relocation_lower_limit_sq     = 10.f * 10.f;
 uint32 World::m_relocation_ai_notify_delay    = 1000u;
+uint32 World::m_relocation_ai_pair_recheck_delay = 500u;
 
 void LoadGameObjectModelList();
 
@@ -123,6 +128,8 @@ World::World()
     m_maxQueuedSessionCount = 0;
 	m_MaintenanceTimeChecker = 0;
 	m_anticrashRearmTimer = 0;
+    m_updateHeapAllocations = 0;
+    m_updateHeapAllocationsLastTick = 0;
     m_wowPatch = WOW_PATCH_102;
 
     m_defaultDbcLocale = LOCALE_enUS;
@@ -180,6 +187,7 @@ World::~World()
 
 void World::Shutdown()
 {
+    m_asyncTaskExecutor.Stop();                             // queued tasks would reply to kicked sessions
     sWorld.KickAll();                                       // save and kick all players
     sWorld.UpdateSessions( 1 );                             // real players unload required UpdateSessions call
     if (m_charDbWorkerThread)
@@ -564,6 +572,10 @@ void World::LoadConfigSettings(bool reload)
 
     ///- Read other configuration items from the config file
     setConfigMinMax(CONFIG_UINT32_COMPRESSION, "Compression", 1, 1, 9);
+    setConfigMinMax(CONFIG_UINT32_COMPRESSION_POLICY, "Compression.Policy", 0, 0, 1);
+    setConfig(CONFIG_UINT32_COMPRESSION_ADAPTIVE_MIN_SIZE, "Compression.Adaptive.MinSize", 1024);
+    static AdaptiveCompressionLevelPolicy adaptiveCompressionPolicy;
+    PacketCompressor::SetLevelPolicy(getConfig(CONFIG_UINT32_COMPRESSION_POLICY) ? &adaptiveCompressionPolicy : NULL);
     setConfig(CONFIG_BOOL_ADDON_CHANNEL, "AddonChannel", true);
     setConfig(CONFIG_BOOL_CLEAN_CHARACTER_DB, "CleanCharacterDB", true);
     setConfig(CONFIG_BOOL_GRID_UNLOAD, "GridUnload", true);
@@ -575,6 +587,7 @@ void World::LoadConfigSettings(bool reload)
     setConfigMin(CONFIG_UINT32_INTERVAL_GRIDCLEAN, "GridCleanUpDelay", 5 * MINUTE * IN_MILLISECONDS, MIN_GRID_DELAY);
     if (reload)
         sMapMgr.SetGridCleanUpDelay(getConfig(CONFIG_UINT32_INTERVAL_GRIDCLEAN));
+    setConfig(CONFIG_UINT32_GRID_PRELOAD_LOOKAHEAD, "GridPreload.LookAhead", 10 * IN_MILLISECONDS);
 
     setConfigMin(CONFIG_UINT32_INTERVAL_MAPUPDATE, "MapUpdateInterval", 100, MIN_MAP_UPDATE_DELAY);
     if (reload)
@@ -781,6 +794,7 @@ void World::LoadConfigSettings(bool reload)
     setConfig(CONFIG_UINT32_ANTIFLOOD_SANCTION,       "Antiflood.Sanction", CHEAT_ACTION_KICK);
 
     m_relocation_ai_notify_delay = sConfig.GetIntDefault("Visibility.AIRelocationNotifyDelay", 1000u);
+    m_relocation_ai_pair_recheck_delay = sConfig.GetIntDefault("Visibility.AIPairRecheckDelay", 500u);
     m_relocation_lower_limit_sq  = pow(sConfig.GetFloatDefault("Visibility.RelocationLowerLimit", 10), 2);
 
     m_VisibleUnitGreyDistance = sConfig.GetFloatDefault("Visibility.Distance.Grey.Unit", 1);
@@ -927,13 +941,15 @@ void World::LoadNostalriusConfig(bool reload)
 
     setConfig(CONFIG_BOOL_MMAP_ENABLED, "mmap.enabled", true);
     sLog.outString("WORLD: mmap pathfinding %sabled", getConfig(CONFIG_BOOL_MMAP_ENABLED) ? "en" : "dis");
+    setConfig(CONFIG_UINT32_MMAP_ASYNC_QUEUE_SIZE, "mmap.async.QueueSize", 1000);
+    setConfig(CONFIG_UINT32_MMAP_PATH_CACHE_SIZE, "mmap.PathCache.Size", 1024);
 
     setConfigMinMax(CONFIG_UINT32_PET_DEFAULT_LOYALTY, "Pet.DefaultLoyalty", 1, 1, 6);
     setConfigMinMax(CONFIG_UINT32_MAP_OBJECTSUPDATE_THREADS,            "MapUpdate.ObjectsUpdate.MaxThreads", 4, 1, 20);
     setConfigMinMax(CONFIG_UINT32_MAP_OBJECTSUPDATE_TIMEOUT,            "MapUpdate.ObjectsUpdate.Timeout", 100, 10, 2000);
     setConfigMinMax(CONFIG_UINT32_MAP_VISIBILITYUPDATE_THREADS,         "MapUpdate.VisibilityUpdate.MaxThreads", 4, 1, 20);
     setConfigMinMax(CONFIG_UINT32_MAP_VISIBILITYUPDATE_TIMEOUT,         "MapUpdate.VisibilityUpdate.Timeout", 100, 10, 2000);
-    setConfigMinMax(CONFIG_UINT32_MAPUPDATE_INSTANCED_UPDATE_THREADS,   "MapUpdate.Instanced.UpdateThreads", 2, 0, 20);
+    setConfigMinMax(CONFIG_UINT32_MAPUPDATE_THREADS,                    "MapUpdate.Threads", 0, 0, 64);
     setConfigMinMax(CONFIG_UINT32_MTCELLS_THREADS,                      "MapUpdate.Continents.MTCells.Threads", 0, 0, 20);
     setConfigMinMax(CONFIG_UINT32_MTCELLS_SAFEDISTANCE,                 "MapUpdate.Continents.MTCells.SafeDistance", 1066, 0, 34112);
     setConfigMinMax(CONFIG_UINT32_MAPUPDATE_UPDATE_PACKETS_DIFF,        "MapUpdate.UpdatePacketsDiff", 100, 1, 10000);
@@ -971,6 +987,8 @@ void World::LoadNostalriusConfig(bool reload)
     setConfig(CONFIG_UINT32_CONTINENTS_MOTIONUPDATE_THREADS,                "Continents.MotionUpdate.Threads", 0);
     setConfig(CONFIG_BOOL_TERRAIN_PRELOAD_CONTINENTS,                   "Terrain.Preload.Continents", 1);
     setConfig(CONFIG_BOOL_TERRAIN_PRELOAD_INSTANCES,                    "Terrain.Preload.Instances", 1);
+    setConfig(CONFIG_BOOL_TERRAIN_MEMORY_MAPPED,                        "Terrain.MemoryMapped", 1);
+    setConfig(CONFIG_BOOL_WORLD_DATA_SNAPSHOTS,                         "WorldData.Snapshots", 1);
     setConfig(CONFIG_UINT32_LOG_MONEY_TRADES_TRESHOLD,                  "LogMoneyTreshold", 10000);
     setConfig(CONFIG_FLOAT_DYN_RESPAWN_CHECK_RANGE,                     "DynamicRespawn.Range", -1.0f);
     setConfig(CONFIG_FLOAT_DYN_RESPAWN_MAX_REDUCTION_RATE,              "DynamicRespawn.MaxReductionRate", 0.0f);
@@ -1011,6 +1029,7 @@ void World::LoadNostalriusConfig(bool reload)
     setConfig(CONFIG_UINT32_AV_MIN_PLAYERS_IN_QUEUE,                    "Alterac.MinPlayersInQueue", 0);
     setConfig(CONFIG_UINT32_AV_INITIAL_MAX_PLAYERS,                     "Alterac.InitMaxPlayers", 0);
     setConfigMinMax(CONFIG_UINT32_ASYNC_TASKS_THREADS_COUNT,            "AsyncTasks.Threads", 1, 1, 20);
+    setConfigMinMax(CONFIG_UINT32_LOAD_THREADS,                         "Load.Threads", 4, 1, 32);
     setConfig(CONFIG_UINT32_CORPSES_UPDATE_MINUTES,                     "Corpses.UpdateMinutes", 20);
     setConfig(CONFIG_UINT32_BONES_EXPIRE_MINUTES,                       "Bones.ExpireMinutes", 60);
     setConfig(CONFIG_BOOL_CONTINENTS_INSTANCIATE,                       "Continents.Instanciate", false);
@@ -1026,6 +1045,8 @@ void World::LoadNostalriusConfig(bool reload)
     setConfig(CONFIG_UINT32_PACKET_BCAST_THREADS,                       "Network.PacketBroadcast.Threads", 0);
     setConfig(CONFIG_UINT32_PACKET_BCAST_FREQUENCY,                     "Network.PacketBroadcast.Frequency", 50);
     setConfig(CONFIG_UINT32_PBCAST_DIFF_LOWER_VISIBILITY_DISTANCE,      "Network.PacketBroadcast.ReduceVisDistance.DiffAbove", 0);
+    setConfigPos(CONFIG_FLOAT_PBCAST_FAR_DISTANCE,                      "Network.PacketBroadcast.FarDistance", 0.0f);
+    setConfigMin(CONFIG_UINT32_PBCAST_FAR_INTERVAL,                     "Network.PacketBroadcast.FarInterval", 4, 1);
 
     if (getConfig(CONFIG_BOOL_ALLOW_TWO_SIDE_INTERACTION_CHAT))
         setConfig(CONFIG_BOOL_GM_JOIN_OPPOSITE_FACTION_CHANNELS, false);
@@ -1064,6 +1085,178 @@ public:
     }
 };
 
+/// Load the world data, and the character data the world keeps in memory
+void World::LoadWorldData(bool isMapServer)
+{
+    TaskGraph loaders;
+
+    TaskGraph::TaskId pageTexts = loaders.Add("Page Texts", []() { sObjectMgr.LoadPageTexts(); });
+    TaskGraph::TaskId goInfo = loaders.Add("Game Object Templates", []() { sObjectMgr.LoadGameobjectInfo(); }, { pageTexts });
+    if (!isMapServer)
+        loaders.Add("Transport templates", []() { sTransportMgr->LoadTransportTemplates(); }, { goInfo });
+
+    // The loaders applying their entries to the higher ranks read the chains
+    TaskGraph::TaskId spellChains = loaders.Add("Spell Chain Data", []() { sSpellMgr.LoadSpellChains(); });
+    loaders.Add("Spell Elixir types", []() { sSpellMgr.LoadSpellElixirs(); });
+    loaders.Add("Spell Facing Flags", []() { sSpellMgr.LoadFacingCasterFlags(); });
+    loaders.Add("Spell Learn Skills", []() { sSpellMgr.LoadSpellLearnSkills(); }, { spellChains });
+    TaskGraph::TaskId spellLearnSpells = loaders.Add("Spell Learn Spells", []() { sSpellMgr.LoadSpellLearnSpells(); }, { spellChains });
+    loaders.Add("Spell Proc Event conditions", []() { sSpellMgr.LoadSpellProcEvents(); }, { spellChains });
+    loaders.Add("Spell Bonus Data", []() { sSpellMgr.LoadSpellBonuses(); }, { spellChains });
+    loaders.Add("Spell Proc Item Enchant", []() { sSpellMgr.LoadSpellProcItemEnchant(); }, { spellChains });
+    loaders.Add("Aggro Spells Definitions", []() { sSpellMgr.LoadSpellThreats(); }, { spellChains });
+    loaders.Add("spell target destination coordinates", []() { sSpellMgr.LoadSpellTargetPositions(); });
+    loaders.Add("SpellAffect definitions", []() { sSpellMgr.LoadSpellAffects(); });
+    loaders.Add("spell pet auras", []() { sSpellMgr.LoadSpellPetAuras(); });
+
+    TaskGraph::TaskId gossipText = loaders.Add("NPC Texts", []() { sObjectMgr.LoadGossipText(); });
+    TaskGraph::TaskId randomEnchantments = loaders.Add("Item Random Enchantments Table", []() { LoadRandomEnchantmentsTable(); });
+    TaskGraph::TaskId items = loaders.Add("Items", []() { sObjectMgr.LoadItemPrototypes(); }, { randomEnchantments, pageTexts });
+    loaders.Add("Item Texts", []() { sObjectMgr.LoadItemTexts(); });
+    TaskGraph::TaskId modelInfo = loaders.Add("Creature Model Based Info Data", []() { sObjectMgr.LoadCreatureModelInfo(); });
+    TaskGraph::TaskId equipment = loaders.Add("Equipment templates", []() { sObjectMgr.LoadEquipmentTemplates(); }, { items });
+    TaskGraph::TaskId creatureTemplates = loaders.Add("Creature templates", []() { sObjectMgr.LoadCreatureTemplates(); }, { modelInfo, equipment });
+    TaskGraph::TaskId spellScriptTarget = loaders.Add("SpellsScriptTarget", []() { sSpellMgr.LoadSpellScriptTarget(); }, { creatureTemplates, goInfo });
+    loaders.Add("ItemRequiredTarget", []() { sObjectMgr.LoadItemRequiredTarget(); }, { spellScriptTarget });
+    loaders.Add("Reputation Reward Rates", []() { sObjectMgr.LoadReputationRewardRate(); });
+    loaders.Add("Creature Reputation OnKill Data", []() { sObjectMgr.LoadReputationOnKill(); }, { creatureTemplates });
+    loaders.Add("Reputation Spillover Data", []() { sObjectMgr.LoadReputationSpilloverTemplate(); });
+    TaskGraph::TaskId pointsOfInterest = loaders.Add("Points Of Interest Data", []() { sObjectMgr.LoadPointsOfInterest(); });
+    loaders.Add("Pet Create Spells", []() { sObjectMgr.LoadPetCreateSpells(); }, { creatureTemplates });
+
+    TaskGraph::TaskId creatures = loaders.Add("Creature Data", []() { sObjectMgr.LoadCreatures(); }, { creatureTemplates });
+    loaders.Add("Creature Addon Data", []() { sObjectMgr.LoadCreatureAddons(); }, { creatures });
+    loaders.Add("Creature Groups", []() { sCreatureGroupsManager->Load(); }, { creatures });
+    // Creatures and gameobjects are added to the same cell guids of ObjectMgr
+    TaskGraph::TaskId gameobjects = loaders.Add("Gameobject Data", []() { sObjectMgr.LoadGameobjects(); }, { goInfo, creatures });
+    loaders.Add("Gameobject Requirements", []() { sObjectMgr.LoadGameobjectsRequirements(); }, { gameobjects });
+    TaskGraph::TaskId pools = loaders.Add("Objects Pooling Data", []() { sPoolMgr.LoadFromDB(); }, { gameobjects });
+    loaders.Add("Weather Data", []() { sObjectMgr.LoadWeatherZoneChances(); });
+
+    TaskGraph::TaskId quests = loaders.Add("Quests", []() { sObjectMgr.LoadQuests(); }, { items, creatureTemplates, goInfo });
+    TaskGraph::TaskId questRelations = loaders.Add("Quests Relations", []() { sObjectMgr.LoadQuestRelations(); }, { quests });
+    TaskGraph::TaskId gameEvents = loaders.Add("Game Event Data", []() { sGameEventMgr.LoadFromDB(); }, { pools, questRelations });
+    TaskGraph::TaskId conditions = loaders.Add("Conditions", []() { sObjectMgr.LoadConditions(); }, { gameEvents });
+    // The respawn loaders and the groups create the persistent states of the maps, whose
+    // pools are spawned from the pool and game event data on creation: they are loaded one
+    // after the other, after these
+    TaskGraph::TaskId creatureRespawns = loaders.Add("Creature Respawn Data", []() { sMapPersistentStateMgr.LoadCreatureRespawnTimes(); }, { creatures, pools, gameEvents });
+    TaskGraph::TaskId gameobjectRespawns = loaders.Add("Gameobject Respawn Data", []() { sMapPersistentStateMgr.LoadGameobjectRespawnTimes(); }, { gameobjects, creatureRespawns });
+    loaders.Add("SpellArea Data", []() { sSpellMgr.LoadSpellAreas(); }, { quests });
+
+    loaders.Add("AreaTrigger definitions", []() { sObjectMgr.LoadAreaTriggerTeleports(); }, { items });
+    TaskGraph::TaskId questAreaTriggers = loaders.Add("Quest Area Triggers", []() { sObjectMgr.LoadQuestAreaTriggers(); }, { quests });
+    loaders.Add("Tavern Area Triggers", []() { sObjectMgr.LoadTavernAreaTriggers(); });
+    loaders.Add("Battleground Entrance Area Triggers", []() { sObjectMgr.LoadBattlegroundEntranceTriggers(); });
+    loaders.Add("AreaTrigger script names", []() { sScriptMgr.LoadAreaTriggerScripts(); });
+    loaders.Add("event id script names", []() { sScriptMgr.LoadEventIdScripts(); });
+    loaders.Add("Graveyard-zone links", []() { sObjectMgr.LoadGraveyardZones(); });
+
+    loaders.Add("Player Create Info & Level Stats", []() { sObjectMgr.LoadPlayerInfo(); }, { items });
+    loaders.Add("Exploration BaseXP Data", []() { sObjectMgr.LoadExplorationBaseXP(); });
+    loaders.Add("Pet Name Parts", []() { sObjectMgr.LoadPetNames(); });
+    loaders.Add("pet level stats", []() { sObjectMgr.LoadPetLevelInfo(); }, { creatureTemplates });
+
+    TaskGraph::TaskIds lootStores;
+    lootStores.push_back(loaders.Add("Creature Loot Tables", []() { LoadLootTemplates_Creature(); }, { conditions }));
+    lootStores.push_back(loaders.Add("Fishing Loot Tables", []() { LoadLootTemplates_Fishing(); }, { conditions }));
+    lootStores.push_back(loaders.Add("Gameobject Loot Tables", []() { LoadLootTemplates_Gameobject(); }, { conditions }));
+    lootStores.push_back(loaders.Add("Item Loot Tables", []() { LoadLootTemplates_Item(); }, { conditions }));
+    lootStores.push_back(loaders.Add("Mail Loot Tables", []() { LoadLootTemplates_Mail(); }, { conditions }));
+    lootStores.push_back(loaders.Add("Pickpocketing Loot Tables", []() { LoadLootTemplates_Pickpocketing(); }, { conditions }));
+    lootStores.push_back(loaders.Add("Skinning Loot Tables", []() { LoadLootTemplates_Skinning(); }, { conditions }));
+    lootStores.push_back(loaders.Add("Disenchant Loot Tables", []() { LoadLootTemplates_Disenchant(); }, { conditions }));
+    TaskGraph::TaskId referenceLoot = loaders.Add("Reference Loot Tables", []() { LoadLootTemplates_Reference(); }, lootStores);
+
+    loaders.Add("Skill Discovery Table", []() { LoadSkillDiscoveryTable(); });
+    loaders.Add("Skill Extra Item Table", []() { LoadSkillExtraItemTable(); });
+    loaders.Add("Skill Fishing base level requirements", []() { sObjectMgr.LoadFishingBaseSkillLevel(); });
+    loaders.Add("Npc Text Id", []() { sObjectMgr.LoadNpcGossips(); }, { creatures, gossipText });
+
+    // The db scripts set special flags of the quests, like the quest area triggers: they are
+    // loaded one after the other
+    TaskGraph::TaskId gossipScripts = loaders.Add("Gossip scripts", []() { sScriptMgr.LoadGossipScripts(); }, { gameobjects, questAreaTriggers });
+    TaskGraph::TaskId movementScripts = loaders.Add("Waypoint scripts", []() { sScriptMgr.LoadCreatureMovementScripts(); }, { gossipScripts });
+    TaskGraph::TaskId questStartScripts = loaders.Add("Quest start scripts", []() { sScriptMgr.LoadQuestStartScripts(); }, { movementScripts });
+    TaskGraph::TaskId questEndScripts = loaders.Add("Quest end scripts", []() { sScriptMgr.LoadQuestEndScripts(); }, { questStartScripts });
+    TaskGraph::TaskId spellScripts = loaders.Add("Spell scripts", []() { sScriptMgr.LoadSpellScripts(); }, { questEndScripts });
+    TaskGraph::TaskId gameobjectScripts = loaders.Add("Gameobject scripts", []() { sScriptMgr.LoadGameObjectScripts(); }, { spellScripts });
+    TaskGraph::TaskId eventScripts = loaders.Add("Event scripts", []() { sScriptMgr.LoadEventScripts(); }, { gameobjectScripts });
+
+    TaskGraph::TaskId gossipMenus = loaders.Add("Gossip menus", []() { sObjectMgr.LoadGossipMenu(); }, { conditions, gossipText });
+    TaskGraph::TaskId gossipMenuItems = loaders.Add("Gossip menu options", []() { sObjectMgr.LoadGossipMenuItems(); }, { gossipMenus, gossipScripts, pointsOfInterest });
+    loaders.Add("Vendors", []()
+    {
+        sObjectMgr.LoadVendorTemplates();
+        sObjectMgr.LoadVendors();
+    }, { creatureTemplates });
+    loaders.Add("Trainers", []()
+    {
+        sObjectMgr.LoadTrainerTemplates();
+        sObjectMgr.LoadTrainers();
+    }, { creatureTemplates, spellLearnSpells });
+    TaskGraph::TaskId waypoints = loaders.Add("Waypoints", []() { sWaypointMgr.Load(); }, { movementScripts });
+
+    loaders.Add("Localization strings", []()
+    {
+        sObjectMgr.LoadCreatureLocales();
+        sObjectMgr.LoadGameObjectLocales();
+        sObjectMgr.LoadItemLocales();
+        sObjectMgr.LoadQuestLocales();
+        sObjectMgr.LoadGossipTextLocales();
+        sObjectMgr.LoadPageTextLocales();
+        sObjectMgr.LoadGossipMenuItemsLocales();
+        sObjectMgr.LoadPointOfInterestLocales();
+        sObjectMgr.LoadAreaLocales();
+    }, { gossipMenuItems });
+
+    loaders.Add("GameObjects for quests", []() { sObjectMgr.LoadGameObjectForQuests(); }, { referenceLoot });
+    loaders.Add("BattleMasters", []() { sBattleGroundMgr.LoadBattleMastersEntry(); });
+    loaders.Add("BattleGround event indexes", []() { sBattleGroundMgr.LoadBattleEventIndexes(); }, { gameobjects });
+    loaders.Add("GameTeleports", []() { sObjectMgr.LoadGameTele(); });
+
+    // Both load strings in the same ObjectMgr map
+    TaskGraph::TaskId scriptStrings = loaders.Add("Scripts text locales", []() { sScriptMgr.LoadDbScriptStrings(); }, { eventScripts, waypoints });
+    TaskGraph::TaskId eventAITexts = loaders.Add("CreatureEventAI Texts", []() { sEventAIMgr.LoadCreatureEventAI_Texts(false); }, { scriptStrings });
+    TaskGraph::TaskId eventAISummons = loaders.Add("CreatureEventAI Summons", []() { sEventAIMgr.LoadCreatureEventAI_Summons(false); });
+    loaders.Add("CreatureEventAI Scripts", []() { sEventAIMgr.LoadCreatureEventAI_Scripts(); }, { eventAITexts, eventAISummons, quests });
+
+    // The character data is loaded in its previous order, along the world data
+    if (!isMapServer)
+    {
+        TaskGraph::TaskId characters = loaders.Add("character database cleaner", []() { CharacterDatabaseCleaner::CleanDatabase(); }, { spellLearnSpells });
+        characters = loaders.Add("character cache data", []() { sObjectMgr.LoadPlayerCacheData(); }, { characters });
+        characters = loaders.Add("the max pet number", []() { sObjectMgr.LoadPetNumber(); }, { characters });
+        // The corpses are added to the cell guids of ObjectMgr, as the creatures and gameobjects
+        characters = loaders.Add("Player Corpses", []() { sObjectMgr.LoadCorpses(); }, { characters, creatures, gameobjects });
+        characters = loaders.Add("Auctions", []()
+        {
+            sAuctionMgr.LoadAuctionItems();
+            sAuctionMgr.LoadAuctions();
+        }, { characters, items });
+        characters = loaders.Add("Guilds", []() { sGuildMgr.LoadGuilds(); }, { characters });
+        characters = loaders.Add("Groups", []() { sObjectMgr.LoadGroups(); }, { characters, gameobjectRespawns });
+        characters = loaders.Add("ReservedNames", []() { sObjectMgr.LoadReservedPlayersNames(); }, { characters });
+        characters = loaders.Add("GM tickets and surveys", []()
+        {
+            sTicketMgr->LoadTickets();
+            sTicketMgr->LoadSurveys();
+        }, { characters });
+        loaders.Add("old mails to return", []() { sObjectMgr.ReturnOrDeleteOldMails(false); }, { characters });
+    }
+
+    // The progress bars of loaders running together would overwrite each other
+    uint32 threads = getConfig(CONFIG_UINT32_LOAD_THREADS);
+    bool showProgressBars = BarGoLink::GetOutputState();
+    if (threads > 1)
+        BarGoLink::SetOutputState(false);
+
+    loaders.Run(threads, []() { WorldDatabase.ThreadStart(); }, []() { WorldDatabase.ThreadEnd(); });
+
+    BarGoLink::SetOutputState(showProgressBars);
+    loaders.LogReport();
+}
+
 /// Initialize the World
 void World::SetInitialWorldSettings()
 {
@@ -1077,6 +1270,9 @@ void World::SetInitialWorldSettings()
     LoadConfigSettings();
     bool isMapServer = getConfig(CONFIG_BOOL_IS_MAPSERVER);
 
+    ///- Snapshots of the world tables, written at each load of the tables
+    SQLStorageSnapshot::SetDirectory(getConfig(CONFIG_BOOL_WORLD_DATA_SNAPSHOTS) ? m_dataPath + "snapshots" : "");
+
     ///- Check the existence of the map files for all races start areas.
     if (!MapManager::ExistMapAndVMap(0, -6240.32f, 331.033f) ||
             !MapManager::ExistMapAndVMap(0, -8949.95f, -132.493f) ||
@@ -1162,322 +1358,8 @@ void World::SetInitialWorldSettings()
     sObjectMgr.SetHighestGuids();                           // must be after packing instances
     sLog.outString();
 
-    sLog.outString("Loading Page Texts...");
-    sObjectMgr.LoadPageTexts();
-
-    sLog.outString("Loading Game Object Templates...");     // must be after LoadPageTexts
-    sObjectMgr.LoadGameobjectInfo();
-
-    if (!isMapServer)
-    {
-        sLog.outString("Loading Transport templates...");
-        sTransportMgr->LoadTransportTemplates();
-    }
-
-    sLog.outString("Loading Spell Chain Data...");
-    sSpellMgr.LoadSpellChains();
-
-    sLog.outString("Loading Spell Elixir types...");
-    sSpellMgr.LoadSpellElixirs();
-
-    sLog.outString("Loading Spell Facing Flags...");
-    sSpellMgr.LoadFacingCasterFlags();
-
-    sLog.outString("Loading Spell Learn Skills...");
-    sSpellMgr.LoadSpellLearnSkills();                       // must be after LoadSpellChains
-
-    sLog.outString("Loading Spell Learn Spells...");
-    sSpellMgr.LoadSpellLearnSpells();
-
-    sLog.outString("Loading Spell Proc Event conditions...");
-    sSpellMgr.LoadSpellProcEvents();
-
-    sLog.outString("Loading Spell Bonus Data...");
-    sSpellMgr.LoadSpellBonuses();
-
-    sLog.outString("Loading Spell Proc Item Enchant...");
-    sSpellMgr.LoadSpellProcItemEnchant();                   // must be after LoadSpellChains
-
-    sLog.outString("Loading Aggro Spells Definitions...");
-    sSpellMgr.LoadSpellThreats();
-
-    sLog.outString("Loading NPC Texts...");
-    sObjectMgr.LoadGossipText();
-
-    sLog.outString("Loading Item Random Enchantments Table...");
-    LoadRandomEnchantmentsTable();
-
-    sLog.outString("Loading Items...");                     // must be after LoadRandomEnchantmentsTable and LoadPageTexts
-    sObjectMgr.LoadItemPrototypes();
-
-    sLog.outString("Loading Item Texts...");
-    sObjectMgr.LoadItemTexts();
-
-    sLog.outString("Loading Creature Model Based Info Data...");
-    sObjectMgr.LoadCreatureModelInfo();
-
-    sLog.outString("Loading Equipment templates...");
-    sObjectMgr.LoadEquipmentTemplates();
-
-    sLog.outString("Loading Creature templates...");
-    sObjectMgr.LoadCreatureTemplates();
-
-    sLog.outString("Loading SpellsScriptTarget...");
-    sSpellMgr.LoadSpellScriptTarget();                      // must be after LoadCreatureTemplates and LoadGameobjectInfo
-
-    sLog.outString("Loading ItemRequiredTarget...");
-    sObjectMgr.LoadItemRequiredTarget();
-
-    sLog.outString("Loading Reputation Reward Rates...");
-    sObjectMgr.LoadReputationRewardRate();
-
-    sLog.outString("Loading Creature Reputation OnKill Data...");
-    sObjectMgr.LoadReputationOnKill();
-
-    sLog.outString("Loading Reputation Spillover Data...");
-    sObjectMgr.LoadReputationSpilloverTemplate();
-
-    sLog.outString("Loading Points Of Interest Data...");
-    sObjectMgr.LoadPointsOfInterest();
-
-    sLog.outString("Loading Pet Create Spells...");
-    sObjectMgr.LoadPetCreateSpells();
-
-    sLog.outString("Loading Creature Data...");
-    sObjectMgr.LoadCreatures();
-
-    sLog.outString("Loading Creature Addon Data...");
-    sLog.outString();
-    sObjectMgr.LoadCreatureAddons();                        // must be after LoadCreatureTemplates() and LoadCreatures()
-    sLog.outString(">>> Creature Addon Data loaded");
-    sLog.outString();
-
-    sLog.outString("Loading Creature Groups ...");
-    sCreatureGroupsManager->Load();
-
-    sLog.outString("Loading Gameobject Data...");
-    sObjectMgr.LoadGameobjects();
-
-    sLog.outString("Loading Gameobject Requirements...");
-    sObjectMgr.LoadGameobjectsRequirements();
-
-    sLog.outString("Loading Objects Pooling Data...");
-    sPoolMgr.LoadFromDB();
-
-    sLog.outString("Loading Weather Data...");
-    sObjectMgr.LoadWeatherZoneChances();
-
-    sLog.outString("Loading Quests...");
-    sObjectMgr.LoadQuests();                                // must be loaded after DBCs, creature_template, item_template, gameobject tables
-
-    sLog.outString("Loading Quests Relations...");
-    sLog.outString();
-    sObjectMgr.LoadQuestRelations();                        // must be after quest load
-    sLog.outString(">>> Quests Relations loaded");
-    sLog.outString();
-
-    sLog.outString("Loading Game Event Data...");           // must be after sPoolMgr.LoadFromDB and quests to properly load pool events and quests for events
-    sLog.outString();
-    sGameEventMgr.LoadFromDB();
-    sLog.outString(">>> Game Event Data loaded");
-    sLog.outString();
-
-    // Load Conditions
-    sLog.outString("Loading Conditions ...");
-    sObjectMgr.LoadConditions();
-
-    sLog.outString("Loading Creature Respawn Data...");     // must be after LoadCreatures()
-    sMapPersistentStateMgr.LoadCreatureRespawnTimes();
-
-    sLog.outString("Loading Gameobject Respawn Data...");   // must be after LoadGameobjects()
-    sMapPersistentStateMgr.LoadGameobjectRespawnTimes();
-
-    sLog.outString("Loading SpellArea Data...");            // must be after quest load
-    sSpellMgr.LoadSpellAreas();
-
-    sLog.outString("Loading AreaTrigger definitions...");
-    sObjectMgr.LoadAreaTriggerTeleports();                  // must be after item template load
-
-    sLog.outString("Loading Quest Area Triggers...");
-    sObjectMgr.LoadQuestAreaTriggers();                     // must be after LoadQuests
-
-    sLog.outString("Loading Tavern Area Triggers...");
-    sObjectMgr.LoadTavernAreaTriggers();
-
-    sLog.outString("Loading Battleground Entrance Area Triggers...");
-    sObjectMgr.LoadBattlegroundEntranceTriggers();
-
-    sLog.outString("Loading AreaTrigger script names...");
-    sScriptMgr.LoadAreaTriggerScripts();
-
-    sLog.outString("Loading event id script names...");
-    sScriptMgr.LoadEventIdScripts();
-
-    sLog.outString("Loading Graveyard-zone links...");
-    sObjectMgr.LoadGraveyardZones();
-
-    sLog.outString("Loading spell target destination coordinates...");
-    sSpellMgr.LoadSpellTargetPositions();
-
-    sLog.outString("Loading SpellAffect definitions...");
-    sSpellMgr.LoadSpellAffects();
-
-    sLog.outString("Loading spell pet auras...");
-    sSpellMgr.LoadSpellPetAuras();
-
-    sLog.outString("Loading Player Create Info & Level Stats...");
-    sLog.outString();
-    sObjectMgr.LoadPlayerInfo();
-    sLog.outString(">>> Player Create Info & Level Stats loaded");
-    sLog.outString();
-
-    sLog.outString("Loading Exploration BaseXP Data...");
-    sObjectMgr.LoadExplorationBaseXP();
-
-    sLog.outString("Loading Pet Name Parts...");
-    sObjectMgr.LoadPetNames();
-
-    if (!isMapServer)
-    {
-        CharacterDatabaseCleaner::CleanDatabase();
-
-        sLog.outString("Loading character cache data...");
-        sObjectMgr.LoadPlayerCacheData();
-
-        sLog.outString("Loading the max pet number...");
-        sObjectMgr.LoadPetNumber();
-    }
-
-    sLog.outString("Loading pet level stats...");
-    sObjectMgr.LoadPetLevelInfo();
-
-    if (!isMapServer)
-    {
-        sLog.outString("Loading Player Corpses...");
-        sObjectMgr.LoadCorpses();
-    }
-
-    sLog.outString("Loading Loot Tables...");
-    sLog.outString();
-    LoadLootTables();
-    sLog.outString(">>> Loot Tables loaded");
-    sLog.outString();
-
-    sLog.outString("Loading Skill Discovery Table...");
-    LoadSkillDiscoveryTable();
-
-    sLog.outString("Loading Skill Extra Item Table...");
-    LoadSkillExtraItemTable();
-
-    sLog.outString("Loading Skill Fishing base level requirements...");
-    sObjectMgr.LoadFishingBaseSkillLevel();
-
-    sLog.outString("Loading Npc Text Id...");
-    sObjectMgr.LoadNpcGossips();                            // must be after load Creature and LoadGossipText
-
-    sLog.outString("Loading Gossip scripts...");
-    sScriptMgr.LoadGossipScripts();                         // must be before gossip menu options
-
-    sLog.outString("Loading Gossip menus...");
-    sObjectMgr.LoadGossipMenu();
-
-    sLog.outString("Loading Gossip menu options...");
-    sObjectMgr.LoadGossipMenuItems();
-
-    sLog.outString("Loading Vendors...");
-    sObjectMgr.LoadVendorTemplates();                       // must be after load ItemTemplate
-    sObjectMgr.LoadVendors();                               // must be after load CreatureTemplate, VendorTemplate, and ItemTemplate
-
-    sLog.outString("Loading Trainers...");
-    sObjectMgr.LoadTrainerTemplates();                      // must be after load CreatureTemplate
-    sObjectMgr.LoadTrainers();                              // must be after load CreatureTemplate, TrainerTemplate
-
-    sLog.outString("Loading Waypoint scripts...");          // before loading from creature_movement
-    sScriptMgr.LoadCreatureMovementScripts();
-
-    sLog.outString("Loading Waypoints...");
-    sLog.outString();
-    sWaypointMgr.Load();
-
-    ///- Loading localization data
-    sLog.outString("Loading Localization strings...");
-    sObjectMgr.LoadCreatureLocales();                       // must be after CreatureInfo loading
-    sObjectMgr.LoadGameObjectLocales();                     // must be after GameobjectInfo loading
-    sObjectMgr.LoadItemLocales();                           // must be after ItemPrototypes loading
-    sObjectMgr.LoadQuestLocales();                          // must be after QuestTemplates loading
-    sObjectMgr.LoadGossipTextLocales();                     // must be after LoadGossipText
-    sObjectMgr.LoadPageTextLocales();                       // must be after PageText loading
-    sObjectMgr.LoadGossipMenuItemsLocales();                // must be after gossip menu items loading
-    sObjectMgr.LoadPointOfInterestLocales();                // must be after POI loading
-    sObjectMgr.LoadAreaLocales();
-    sLog.outString(">>> Localization strings loaded");
-    sLog.outString();
-
-    ///- Load dynamic data tables from the database
-    if (!isMapServer)
-    {
-        sLog.outString("Loading Auctions...");
-        sLog.outString();
-        sAuctionMgr.LoadAuctionItems();
-        sAuctionMgr.LoadAuctions();
-        sLog.outString(">>> Auctions loaded");
-        sLog.outString();
-
-        sLog.outString("Loading Guilds...");
-        sGuildMgr.LoadGuilds();
-
-        sLog.outString("Loading Groups...");
-        sObjectMgr.LoadGroups();
-
-        sLog.outString("Loading ReservedNames...");
-        sObjectMgr.LoadReservedPlayersNames();
-    }
-
-    sLog.outString("Loading GameObjects for quests...");
-    sObjectMgr.LoadGameObjectForQuests();
-
-    sLog.outString("Loading BattleMasters...");
-    sBattleGroundMgr.LoadBattleMastersEntry();
-
-    sLog.outString("Loading BattleGround event indexes...");
-    sBattleGroundMgr.LoadBattleEventIndexes();
-
-    sLog.outString("Loading GameTeleports...");
-    sObjectMgr.LoadGameTele();
-
-    if (!isMapServer)
-    {
-        sLog.outString("Loading GM tickets and surveys...");
-        sTicketMgr->LoadTickets();
-        sTicketMgr->LoadSurveys();
-
-        ///- Handle outdated emails (delete/return)
-        sLog.outString("Returning old mails...");
-        sObjectMgr.ReturnOrDeleteOldMails(false);
-    }
-
-    ///- Load and initialize scripts
-    sLog.outString("Loading Scripts...");
-    sLog.outString();
-    sScriptMgr.LoadQuestStartScripts();                     // must be after load Creature/Gameobject(Template/Data) and QuestTemplate
-    sScriptMgr.LoadQuestEndScripts();                       // must be after load Creature/Gameobject(Template/Data) and QuestTemplate
-    sScriptMgr.LoadSpellScripts();                          // must be after load Creature/Gameobject(Template/Data)
-    sScriptMgr.LoadGameObjectScripts();                     // must be after load Creature/Gameobject(Template/Data)
-    sScriptMgr.LoadEventScripts();                          // must be after load Creature/Gameobject(Template/Data)
-    sLog.outString(">>> Scripts loaded");
-    sLog.outString();
-
-    sLog.outString("Loading Scripts text locales...");      // must be after Load*Scripts calls
-    sScriptMgr.LoadDbScriptStrings();
-
-    sLog.outString("Loading CreatureEventAI Texts...");
-    sEventAIMgr.LoadCreatureEventAI_Texts(false);           // false, will checked in LoadCreatureEventAI_Scripts
-
-    sLog.outString("Loading CreatureEventAI Summons...");
-    sEventAIMgr.LoadCreatureEventAI_Summons(false);         // false, will checked in LoadCreatureEventAI_Scripts
-
-    sLog.outString("Loading CreatureEventAI Scripts...");
-    sEventAIMgr.LoadCreatureEventAI_Scripts();
+    ///- Load the static data, each loader as soon as the ones it depends on are done
+    LoadWorldData(isMapServer);
 
     sLog.outString("Initializing Scripts...");
     sScriptMgr.Initialize();
@@ -1522,6 +1404,9 @@ void World::SetInitialWorldSettings()
     sLog.outString("Starting Map System");
     sMapMgr.Initialize();
 
+    sLog.outString("Starting async tasks executor");
+    m_asyncTaskExecutor.Start(getConfig(CONFIG_UINT32_ASYNC_TASKS_THREADS_COUNT));
+
     ///- Initialize Battlegrounds
     sLog.outString("Starting BattleGround System");
     sBattleGroundMgr.CreateInitialBattleGrounds();
@@ -1606,6 +1491,12 @@ void World::SetInitialWorldSettings()
 
     uint32 uStartInterval = WorldTimer::getMSTimeDiff(uStartTime, WorldTimer::getMSTime());
     sLog.outString("SERVER STARTUP TIME: %i minutes %i seconds", uStartInterval / 60000, (uStartInterval % 60000) / 1000);
+
+    // To compare the world loading time with the text and binary result protocols
+    Database::QueryStats worldStats;
+    WorldDatabase.GetQueryStats(worldStats);
+    sLog.outString("World database: " UI64FMTD " queries, " UI64FMTD " rows fetched in " UI64FMTD " ms (%s results), startup in %u ms",
+        worldStats.queries, worldStats.rows, worldStats.timeMs, WorldDatabase.IsBinaryResults() ? "binary" : "text", uStartInterval);
 }
 
 void World::DetectDBCLang()
@@ -1652,30 +1543,6 @@ void World::DetectDBCLang()
     sLog.outString();
 }
 
-class WorldAsyncTasksExecutor : public ACE_Based::Runnable
-{
-public:
-    WorldAsyncTasksExecutor(int me, int total): me(me), total(total) {}
-    void run()
-    {
-        WorldDatabase.ThreadStart();
-        sWorld.HandleAsyncTasks(me, total);
-        WorldDatabase.ThreadEnd();
-    }
-protected:
-    int me;
-    int total;
-};
-
-void World::HandleAsyncTasks(int me, int total)
-{
-    for (int i = me; i < _asyncTasks.size(); i += total)
-    {
-        _asyncTasks[i]->run();
-        delete _asyncTasks[i];
-    }
-}
-
 /// Update the World !
 void World::Update(uint32 diff)
 {
@@ -1742,10 +1609,7 @@ void World::Update(uint32 diff)
 
     ///- Update objects (maps, transport, creatures,...)
     uint32 updateMapSystemTime = WorldTimer::getMSTime();
-    std::vector<ACE_Based::Thread*> asyncTaskThreads;
-    int threadsCount = getConfig(CONFIG_UINT32_ASYNC_TASKS_THREADS_COUNT);
-    for (int i = 0; i < threadsCount; ++i)
-        asyncTaskThreads.push_back(new ACE_Based::Thread(new WorldAsyncTasksExecutor(i, threadsCount)));
+    m_asyncTaskExecutor.BeginMapUpdateWindow();
 
     sMapMgr.Update(diff);
     sBattleGroundMgr.Update(diff);
@@ -1764,13 +1628,9 @@ void World::Update(uint32 diff)
         }
     }
 
+    // Only waits for the running tasks, the queued ones are kept for the next tick
     uint32 asyncWaitBegin = WorldTimer::getMSTime();
-    for (int i = 0; i < threadsCount; ++i)
-    {
-        asyncTaskThreads[i]->wait();
-        delete asyncTaskThreads[i];
-    }
-    _asyncTasks.clear();
+    m_asyncTaskExecutor.EndMapUpdateWindow();
 
     updateMapSystemTime = WorldTimer::getMSTimeDiffToNow(updateMapSystemTime);
     if (getConfig(CONFIG_UINT32_PERFLOG_SLOW_MAPSYSTEM_UPDATE) && updateMapSystemTime > getConfig(CONFIG_UINT32_PERFLOG_SLOW_MAPSYSTEM_UPDATE))
@@ -1836,11 +1696,18 @@ void World::Update(uint32 diff)
     //cleanup unused GridMap objects as well as VMaps
     if (getConfig(CONFIG_BOOL_CLEANUP_TERRAIN))
         sTerrainMgr.Update(diff);
+
+    // Counted by the global operator new, see HeapAllocationCounter
+    uint64 updateHeapAllocations = HeapAllocationCounter::GetAllocations();
+    m_updateHeapAllocationsLastTick = uint32(updateHeapAllocations - m_updateHeapAllocations);
+    m_updateHeapAllocations = updateHeapAllocations;
 }
 
 /// Send a packet to all players (except self if mentioned)
 void World::SendGlobalMessage(WorldPacket *packet, WorldSession *self, uint32 team)
 {
+    // Shared by the sockets of all the sessions
+    SharedWorldPacketPtr sharedPacket = std::make_shared<WorldPacket>(*packet);
     SessionMap::const_iterator itr;
     for (itr = m_sessions.begin(); itr != m_sessions.end(); ++itr)
     {
@@ -1849,7 +1716,7 @@ void World::SendGlobalMessage(WorldPacket *packet, WorldSession *self, uint32 te
                 itr->second->GetPlayer()->IsInWorld() &&
                 itr->second != self &&
                 (team == 0 || itr->second->GetPlayer()->GetTeam() == team))
-            itr->second->SendPacket(packet);
+            itr->second->SendPacket(sharedPacket);
     }
 }
 
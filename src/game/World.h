@@ -34,6 +34,7 @@
 #include "Nostalrius.h"
 #include "ObjectGuid.h"
 #include "MapNodes/AbstractPlayer.h"
+#include "AsyncTaskExecutor.h"
 
 #include <map>
 #include <set>
@@ -94,6 +95,8 @@ enum WorldTimers
 enum eConfigUInt32Values
 {
     CONFIG_UINT32_COMPRESSION = 0,
+    CONFIG_UINT32_COMPRESSION_POLICY,
+    CONFIG_UINT32_COMPRESSION_ADAPTIVE_MIN_SIZE,
     CONFIG_UINT32_LOGIN_QUEUE_GRACE_PERIOD_SECS,
     CONFIG_UINT32_CHARACTER_SCREEN_MAX_IDLE_TIME,
     CONFIG_UINT32_PLAYER_HARD_LIMIT,
@@ -113,6 +116,9 @@ enum eConfigUInt32Values
     CONFIG_UINT32_CORPSES_UPDATE_MINUTES,
     CONFIG_UINT32_BONES_EXPIRE_MINUTES,
     CONFIG_UINT32_ASYNC_TASKS_THREADS_COUNT,
+    CONFIG_UINT32_LOAD_THREADS,
+    CONFIG_UINT32_MMAP_ASYNC_QUEUE_SIZE,
+    CONFIG_UINT32_MMAP_PATH_CACHE_SIZE,
     CONFIG_UINT32_AV_MIN_PLAYERS_IN_QUEUE,
     CONFIG_UINT32_AV_INITIAL_MAX_PLAYERS,
     CONFIG_UINT32_INACTIVE_PLAYERS_SKIP_UPDATES,
@@ -130,7 +136,7 @@ enum eConfigUInt32Values
     CONFIG_UINT32_DYN_RESPAWN_AFFECT_LEVEL_BELOW,
     CONFIG_UINT32_MTCELLS_THREADS,
     CONFIG_UINT32_MTCELLS_SAFEDISTANCE,
-    CONFIG_UINT32_MAPUPDATE_INSTANCED_UPDATE_THREADS,
+    CONFIG_UINT32_MAPUPDATE_THREADS,
     CONFIG_UINT32_MAPUPDATE_UPDATE_PACKETS_DIFF,
     CONFIG_UINT32_MAPUPDATE_UPDATE_PLAYERS_DIFF,
     CONFIG_UINT32_MAPUPDATE_UPDATE_CELLS_DIFF,
@@ -142,6 +148,7 @@ enum eConfigUInt32Values
     CONFIG_UINT32_MAPUPDATE_TICK_LOWER_GRID_ACTIVATION_DISTANCE,
     CONFIG_UINT32_MAPUPDATE_TICK_INCREASE_GRID_ACTIVATION_DISTANCE,
     CONFIG_UINT32_PBCAST_DIFF_LOWER_VISIBILITY_DISTANCE,
+    CONFIG_UINT32_PBCAST_FAR_INTERVAL,
     CONFIG_UINT32_MAPUPDATE_MIN_GRID_ACTIVATION_DISTANCE,
     CONFIG_UINT32_CONTINENTS_MOTIONUPDATE_THREADS,
     CONFIG_UINT32_PERFLOG_SLOW_WORLD_UPDATE,
@@ -167,6 +174,7 @@ enum eConfigUInt32Values
     CONFIG_UINT32_MAP_VISIBILITYUPDATE_TIMEOUT,
     CONFIG_UINT32_INTERVAL_SAVE,
     CONFIG_UINT32_INTERVAL_GRIDCLEAN,
+    CONFIG_UINT32_GRID_PRELOAD_LOOKAHEAD,
     CONFIG_UINT32_INTERVAL_MAPUPDATE,
     CONFIG_UINT32_INTERVAL_CHANGEWEATHER,
     CONFIG_UINT32_PORT_WORLD,
@@ -367,6 +375,7 @@ enum eConfigFloatValues
     CONFIG_FLOAT_THREAT_RADIUS,
     CONFIG_FLOAT_GHOST_RUN_SPEED_WORLD,
     CONFIG_FLOAT_GHOST_RUN_SPEED_BG,
+    CONFIG_FLOAT_PBCAST_FAR_DISTANCE,
     CONFIG_FLOAT_VALUE_COUNT
 };
 
@@ -394,6 +403,8 @@ enum eConfigBoolValues
     CONFIG_BOOL_SMARTLOG_SCRIPTINFO,
     CONFIG_BOOL_TERRAIN_PRELOAD_CONTINENTS,
     CONFIG_BOOL_TERRAIN_PRELOAD_INSTANCES,
+    CONFIG_BOOL_TERRAIN_MEMORY_MAPPED,
+    CONFIG_BOOL_WORLD_DATA_SNAPSHOTS,
     CONFIG_BOOL_CLEANUP_TERRAIN,
     CONFIG_BOOL_OUTDOORPVP_EP_ENABLE,
     CONFIG_BOOL_OUTDOORPVP_SI_ENABLE,
@@ -509,13 +520,6 @@ enum RealmZone
     REALM_ZONE_CN9           = 29                           // basic-Latin at create, any at login
 };
 
-class AsyncTask
-{
-public:
-    virtual ~AsyncTask() {}
-    virtual void run() = 0;
-};
-
 struct TransactionPart
 {
     static const int MAX_TRANSACTION_ITEMS = 6;
@@ -719,6 +723,7 @@ class World
 
         static float GetRelocationLowerLimitSq()            { return m_relocation_lower_limit_sq; }
         static uint32 GetRelocationAINotifyDelay()          { return m_relocation_ai_notify_delay; }
+        static uint32 GetRelocationAIPairRecheckDelay()     { return m_relocation_ai_pair_recheck_delay; }
 
         void ProcessCliCommands();
         void QueueCliCommand(CliCommandHolder* commandHolder) { cliCmdQueue.add(commandHolder); }
@@ -741,13 +746,14 @@ class World
         uint32 GetAnticrashRearmTimer() const { return m_anticrashRearmTimer; }
 
         /**
-         * These async tasks should be added from THREADUNSAFE opcode handlers (since AddAsyncTask is *not* threadsafe)
-         * The tasks will be executed *while* maps are updated. So don't touch the mobs, pets, etc ...
+         * Map update bound async tasks (see AsyncTask::IsMapUpdateBound) are executed *while* maps are updated.
+         * So don't touch the mobs, pets, etc ...
          */
-        void AddAsyncTask(AsyncTask* task) { _asyncTasks.push_back(task); }
-        void HandleAsyncTasks(int currThreadIdx, int threadsCount);
-        typedef std::vector<AsyncTask*> AsyncTaskVect;
-        AsyncTaskVect _asyncTasks;
+        void AddAsyncTask(AsyncTask* task) { m_asyncTaskExecutor.Submit(task); }
+        AsyncTaskExecutor const& GetAsyncTaskExecutor() const { return m_asyncTaskExecutor; }
+        // Heap allocations of the world and map update threads during the last world update.
+        // Always 0 unless built with COUNT_HEAP_ALLOCATIONS.
+        uint32 GetUpdateHeapAllocationsLastTick() const { return m_updateHeapAllocationsLastTick; }
         /**
          * Database logs system
          */
@@ -825,6 +831,7 @@ class World
         LocaleConstant m_defaultDbcLocale;                     // from config for one from loaded DBC locales
         uint32 m_availableDbcLocaleMask;                       // by loaded DBC
         void DetectDBCLang();
+        void LoadWorldData(bool isMapServer);
         bool m_allowMovement;
         std::string m_motd;
         std::string m_dataPath;
@@ -840,6 +847,7 @@ class World
 
         static float  m_relocation_lower_limit_sq;
         static uint32 m_relocation_ai_notify_delay;
+        static uint32 m_relocation_ai_pair_recheck_delay;
 
         // CLI command holder to be thread safe
         ACE_Based::LockedQueue<CliCommandHolder*,ACE_Thread_Mutex> cliCmdQueue;
@@ -854,6 +862,9 @@ class World
         //used versions
         uint32      m_anticrashRearmTimer;
         ACE_Based::Thread* m_charDbWorkerThread;
+        AsyncTaskExecutor m_asyncTaskExecutor;
+        uint64 m_updateHeapAllocations;
+        uint32 m_updateHeapAllocationsLastTick;
 
         typedef std::unordered_map<uint32, ArchivedLogMessage> LogMessagesMap;
         LogMessagesMap m_logMessages;
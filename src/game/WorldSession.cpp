@@ -244,6 +244,29 @@ void WorldSession::SendPacket(WorldPacket const* packet)
     }
 }
 
+void WorldSession::SendPacket(SharedWorldPacketPtr const& packet)
+{
+    // Only the socket keeps a reference on the packet
+    if (!m_Socket || m_masterSession || _pcktWriting)
+    {
+        SendPacket(packet.get());
+        return;
+    }
+
+    if (packet->size() > 0x8000)
+    {
+        sLog.outInfo("[NETWORK] Packet %s size %u is too large. Not sent [Account %u Player %s]", LookupOpcodeName(packet->GetOpcode()), packet->size(), GetAccountId(), GetPlayerName());
+        return;
+    }
+
+    if (Player* player = GetPlayer())
+        DEBUG_UNIT_IF(packet->GetOpcode() != SMSG_MESSAGECHAT && packet->GetOpcode() != SMSG_WARDEN_DATA, player,
+            DEBUG_PACKETS_SEND, "[%s] Send packet : %u/0x%x (%s)", player->GetName(), packet->GetOpcode(), packet->GetOpcode(), LookupOpcodeName(packet->GetOpcode()));
+
+    if (m_Socket->SendPacket(packet) == -1)
+        m_Socket->CloseSocket();
+}
+
 /// Add an incoming packet to the queue
 void WorldSession::QueuePacket(WorldPacket* newPacket, NodeSession* from_node)
 {
@@ -29,6 +29,7 @@
 #include "Common.h"
 #include "SharedDefines.h"
 #include "ObjectGuid.h"
+#include "WorldPacket.h"
 #include "AuctionHouseMgr.h"
 #include "Item.h"
 #include "MapNodes/AbstractPlayer.h"
@@ -288,6 +289,8 @@ class MANGOS_DLL_SPEC WorldSession
         void SizeError(WorldPacket const& packet, uint32 size) const;
 
         void SendPacket(WorldPacket const* packet);
+        // Packet serialized once for several sessions
+        void SendPacket(SharedWorldPacketPtr const& packet);
         void SendNotification(const char *format,...) ATTR_PRINTF(2,3);
         void SendNotification(int32 string_id,...);
         void SendPetNameInvalid(uint32 error, const std::string& name);
@@ -101,6 +101,7 @@ public:
             else if (WorldTimer::getMSTimeDiff(w_lastchange, curtime) > _delaytime)
             {
                 sLog.outError("World Thread hangs, kicking out server!");
+                sLog.Flush();
                 signal(SIGSEGV, 0);
                 Master::m_handleSigvSignals = false;        // disable anticrash
                 *((uint32 volatile*)NULL) = 0;              // bang crash
@@ -551,6 +552,9 @@ bool StartDB(std::string name, DatabaseType& database, const char **migrations)
         return false;
     }
 
+    // The world database is the one loaded in bulk at startup, where the binary protocol pays off
+    database.SetBinaryResults(sConfig.GetBoolDefault((name + "Database.BinaryResults").c_str(), &database == &WorldDatabase));
+
     if (!database.CheckRequiredMigrations(migrations))
         return false;
 
@@ -633,6 +637,11 @@ void Master::_OnSignal(int s)
         #endif
             World::StopNow(SHUTDOWN_EXIT_CODE);
             break;
+        #ifndef _WIN32
+        case SIGHUP:
+            sLog.ReopenFiles();
+            break;
+        #endif
         case SIGSEGV:
             signal(SIGSEGV, 0);
             if (!m_handleSigvSignals)
@@ -644,6 +653,7 @@ void Master::_OnSignal(int s)
             sLog.outInfo("Received SIGSEGV");
             ACE_Stack_Trace st;
             sLog.outInfo("%s", st.c_str());
+            sLog.Flush();
             if (anticrashOptions & ANTICRASH_GENERATE_COREDUMP)
                 createdump();
             if (anticrashOptions & ANTICRASH_OPTION_ANNOUNCE_PLAYERS)
@@ -660,6 +670,7 @@ void Master::_OnSignal(int s)
                 sObjectAccessor.SaveAllPlayers();
                 ACE_Based::Thread::Sleep(25000); // Wait enough time to execute the SQL queries.
             }
+            sLog.Flush();
             *((int*)NULL) = 42; // Crash for real now.
             return;
     }
@@ -674,6 +685,8 @@ void Master::_HookSignals()
     signal(SIGSEGV, _OnSignal);
     #ifdef _WIN32
     signal(SIGBREAK, _OnSignal);
+    #else
+    signal(SIGHUP, _OnSignal);
     #endif
     ArmAnticrash();
 }
@@ -692,6 +705,8 @@ void Master::_UnhookSignals()
     signal(SIGSEGV, 0);
     #ifdef _WIN32
     signal(SIGBREAK, 0);
+    #else
+    signal(SIGHUP, 0);
     #endif
     m_handleSigvSignals = false;
 }
@@ -33,6 +33,7 @@
 #include "MapManager.h"
 #include "BattleGroundMgr.h"
 #include "Master.h"
+#include "Policies/MemoryManagement.h"
 
 #include "Database/DatabaseEnv.h"
 
@@ -49,6 +50,7 @@ void WorldRunnable::run()
     ///- Init new SQL thread for the world database
     WorldDatabase.ThreadStart();                                // let thread do safe mySQL requests (one connection call enough)
     sWorld.InitResultQueue();
+    HeapAllocationCounter::CountCurrentThread();
 
     Master::ArmAnticrash();
     uint32 anticrashRearmTimer = 0;
@@ -37,6 +37,7 @@
 
 #include <openssl/md5.h>
 #include <ctime>
+#include <unordered_map>
 //#include "Util.h" -- for commented utf8ToUpperOnlyLatin
 
 #include <ace/OS_NS_unistd.h>
@@ -52,6 +53,92 @@ enum AccountFlags
     ACCOUNT_FLAG_PROPASS    = 0x00800000,
 };
 
+enum LogonChallengeQueries
+{
+    LOGON_CHALLENGE_QUERY_IP_BANNED         = 0,
+    LOGON_CHALLENGE_QUERY_ACCOUNT           = 1,
+    LOGON_CHALLENGE_QUERY_ACCOUNT_BANNED    = 2,
+    LOGON_CHALLENGE_QUERY_ACCOUNT_ACCESS    = 3,
+    MAX_LOGON_CHALLENGE_QUERIES
+};
+
+enum LogonProofQueries
+{
+    LOGON_PROOF_QUERY_SESSION_KEY           = 0,
+    LOGON_PROOF_QUERY_CHARACTER_COUNTS      = 1,
+    MAX_LOGON_PROOF_QUERIES
+};
+
+enum FailedLoginQueries
+{
+    FAILED_LOGIN_QUERY_INCREMENT            = 0,
+    FAILED_LOGIN_QUERY_COUNT                = 1,
+    MAX_FAILED_LOGIN_QUERIES
+};
+
+/// Counts a wrong password of an account, and keeps what the autoban needs: the socket may be closed
+/// when the counter is read back
+class FailedLoginQueryHolder : public SqlQueryHolder
+{
+    private:
+        std::string m_login;
+        std::string m_address;
+    public:
+        FailedLoginQueryHolder(std::string const& login, std::string const& address)
+            : m_login(login), m_address(address) { }
+        std::string const& GetLogin() const { return m_login; }
+        std::string const& GetAddress() const { return m_address; }
+};
+
+/// Sockets waiting for their login queries, by session id. Only used by the reactor thread.
+typedef std::unordered_map<uint32, AuthSocket*> AuthSessionMap;
+static AuthSessionMap sAuthSessions;
+static uint32 sNextAuthSessionId = 0;
+
+/// Hands the results of the login queries (run by the database workers) to their socket,
+/// unless it has been closed meanwhile. Called by LoginDatabase.ProcessResultQueue() in the reactor thread.
+class AuthQueryCallbacks
+{
+    public:
+        void OnLogonChallengeQueries(QueryResult* /*result*/, SqlQueryHolder* holder, uint32 sessionId)
+        {
+            if (AuthSocket* socket = FindSession(sessionId))
+            {
+                socket->_HandleLogonChallengeResult(holder);
+                socket->OnRead();                           // commands received meanwhile
+            }
+            holder->DeleteAllResults();
+            delete holder;
+        }
+
+        void OnLogonProofQueries(QueryResult* /*result*/, SqlQueryHolder* holder, uint32 sessionId)
+        {
+            if (AuthSocket* socket = FindSession(sessionId))
+            {
+                socket->_HandleLogonProofResult(holder);
+                socket->OnRead();
+            }
+            holder->DeleteAllResults();
+            delete holder;
+        }
+
+        void OnFailedLoginQueries(QueryResult* /*result*/, SqlQueryHolder* holder)
+        {
+            AuthSocket::HandleFailedLoginResult(static_cast<FailedLoginQueryHolder*>(holder));
+            holder->DeleteAllResults();
+            delete holder;
+        }
+
+    private:
+        static AuthSocket* FindSession(uint32 sessionId)
+        {
+            AuthSessionMap::const_iterator itr = sAuthSessions.find(sessionId);
+            return itr != sAuthSessions.end() ? itr->second : NULL;
+        }
+};
+
+static AuthQueryCallbacks sAuthQueryCallbacks;
+
 // GCC have alternative #pragma pack(N) syntax and old gcc version not support pack(push,N), also any gcc version not support it at some paltform
 #if defined( __GNUC__ )
 #pragma pack(1)
@@ -170,6 +257,9 @@ typedef struct AuthHandler
 /// Constructor - set the N and g values for SRP6
 AuthSocket::AuthSocket() : gridSeed(0), promptPin(false), _accountId(0), _lastRealmListRequest(0)
 {
+    _sessionId = ++sNextAuthSessionId;
+    sAuthSessions[_sessionId] = this;
+
     N.SetHexStr("894B645E89E1535BBDAD5B8B290650530801B18EBFBF5E8FAB3C82872A3E9BB7");
     g.SetDword(7);
     _status = STATUS_CHALLENGE;
@@ -183,6 +273,8 @@ AuthSocket::AuthSocket() : gridSeed(0), promptPin(false), _accountId(0), _lastRe
 /// Close patch file descriptor before leaving
 AuthSocket::~AuthSocket()
 {
+    sAuthSessions.erase(_sessionId);
+
     if(patch_ != ACE_INVALID_HANDLE)
         ACE_OS::close(patch_);
 }
@@ -288,7 +380,9 @@ void AuthSocket::_SetVSFields(const std::string& rI)
     const char *v_hex, *s_hex;
     v_hex = v.AsHexStr();
     s_hex = s.AsHexStr();
-    LoginDatabase.PExecute("UPDATE account SET v = '%s', s = '%s' WHERE username = '%s'", v_hex, s_hex, _safelogin.c_str() );
+    static SqlStatementID updVS;
+    SqlStatement stmt = LoginDatabase.CreateStatement(updVS, "UPDATE account SET v = ?, s = ? WHERE username = ?");
+    stmt.PExecute(v_hex, s_hex, _login.c_str());
     OPENSSL_free((void*)v_hex);
     OPENSSL_free((void*)s_hex);
 }
@@ -374,14 +468,16 @@ bool AuthSocket::_HandleLogonChallenge()
     EndianConvert(ch->timezone_bias);
     EndianConvert(ch->ip);
 
-    ByteBuffer pkt;
-
     _login = (const char*)ch->I;
     _build = ch->build;
 
     memcpy(&_os, ch->os, sizeof(_os));
     memcpy(&_platform, ch->platform, sizeof(_platform));
 
+    _localizationName.resize(4);
+    for(int i = 0; i < 4; ++i)
+        _localizationName[i] = ch->country[4-i-1];
+
     ///- Normalize account name
     //utf8ToUpperOnlyLatin(_login); -- client already send account in expected form
 
@@ -390,28 +486,54 @@ bool AuthSocket::_HandleLogonChallenge()
     _safelogin = _login;
     LoginDatabase.escape_string(_safelogin);
 
-    pkt << (uint8) CMD_AUTH_LOGON_CHALLENGE;
-    pkt << (uint8) 0x00;
-
-    ///- Verify that this IP is not in the ip_banned table
     // No SQL injection possible (paste the IP address as passed by the socket)
     std::string address = get_remote_address();
     LoginDatabase.escape_string(address);
-    QueryResult *result = LoginDatabase.PQuery("SELECT unbandate FROM ip_banned WHERE "
+
+    ///- Fetch everything needed to answer in a single async request, the answer is sent from _HandleLogonChallengeResult
+    SqlQueryHolder* holder = new SqlQueryHolder();
+    holder->SetSize(MAX_LOGON_CHALLENGE_QUERIES);
+    holder->SetPQuery(LOGON_CHALLENGE_QUERY_IP_BANNED, "SELECT unbandate FROM ip_banned WHERE "
     //    permanent                    still banned
         "(unbandate = bandate OR unbandate > UNIX_TIMESTAMP()) AND ip = '%s'", address.c_str());
-    if (result)
+    // No SQL injection (escaped user name)
+    holder->SetPQuery(LOGON_CHALLENGE_QUERY_ACCOUNT,
+        "SELECT sha_pass_hash,id,locked,last_ip,v,s,security,email_verif FROM account WHERE username = '%s'", _safelogin.c_str());
+    holder->SetPQuery(LOGON_CHALLENGE_QUERY_ACCOUNT_BANNED, "SELECT ab.bandate,ab.unbandate FROM account_banned ab JOIN account a ON a.id = ab.id WHERE "
+        "a.username = '%s' AND ab.active = 1 AND (ab.unbandate > UNIX_TIMESTAMP() OR ab.unbandate = ab.bandate) LIMIT 1", _safelogin.c_str());
+    holder->SetPQuery(LOGON_CHALLENGE_QUERY_ACCOUNT_ACCESS, "SELECT aa.gmlevel, aa.RealmID FROM account_access aa JOIN account a ON a.id = aa.id "
+        "WHERE a.username = '%s'", _safelogin.c_str());
+
+    if (!LoginDatabase.DelayQueryHolderUnsafe(&sAuthQueryCallbacks, &AuthQueryCallbacks::OnLogonChallengeQueries, holder, _sessionId))
+    {
+        delete holder;
+        return false;
+    }
+
+    ///- Next commands are kept in the buffer until the answer is sent
+    _status = STATUS_WAITING_DB;
+    return true;
+}
+
+void AuthSocket::_HandleLogonChallengeResult(SqlQueryHolder* holder)
+{
+    ///- Session is closed unless overriden
+    _status = STATUS_CLOSED;
+
+    ByteBuffer pkt;
+    pkt << (uint8) CMD_AUTH_LOGON_CHALLENGE;
+    pkt << (uint8) 0x00;
+
+    ///- Verify that this IP is not in the ip_banned table
+    if (holder->GetResult(LOGON_CHALLENGE_QUERY_IP_BANNED))
     {
         pkt << (uint8)WOW_FAIL_BANNED;
         BASIC_LOG("[AuthChallenge] Banned ip %s tries to login!", get_remote_address().c_str());
-        delete result;
     }
     else
     {
         ///- Get the account details from the account table
-        // No SQL injection (escaped user name)
-
-        result = LoginDatabase.PQuery("SELECT sha_pass_hash,id,locked,last_ip,v,s,security,email_verif FROM account WHERE username = '%s'",_safelogin.c_str ());
+        QueryResult* result = holder->GetResult(LOGON_CHALLENGE_QUERY_ACCOUNT);
         if (result)
         {
             Field* fields = result->Fetch();
@@ -425,7 +547,7 @@ bool AuthSocket::_HandleLogonChallenge()
 				BASIC_LOG("[AuthChallenge] Account's email address requires email verification - rejecting login");
 				pkt << (uint8)WOW_FAIL_UNKNOWN_ACCOUNT;
 				send((char const*)pkt.contents(), pkt.size());
-				return true;
+				return;
 			}
 
             ///- If the IP is 'locked', check that the player comes indeed from the correct IP address
@@ -462,9 +584,7 @@ bool AuthSocket::_HandleLogonChallenge()
             {
                 uint32 account_id = fields[1].GetUInt32();
                 ///- If the account is banned, reject the logon attempt
-                QueryResult *banresult = LoginDatabase.PQuery("SELECT bandate,unbandate FROM account_banned WHERE "
-                    "id = %u AND active = 1 AND (unbandate > UNIX_TIMESTAMP() OR unbandate = bandate) LIMIT 1", account_id);
-                if (banresult)
+                if (QueryResult* banresult = holder->GetResult(LOGON_CHALLENGE_QUERY_ACCOUNT_BANNED))
                 {
                     if((*banresult)[0].GetUInt64() == (*banresult)[1].GetUInt64())
                     {
@@ -476,8 +596,6 @@ bool AuthSocket::_HandleLogonChallenge()
                         pkt << (uint8) WOW_FAIL_SUSPENDED;
                         BASIC_LOG("[AuthChallenge] Temporarily banned account %s tries to login!",_login.c_str ());
                     }
-
-                    delete banresult;
                 }
                 else
                 {
@@ -545,13 +663,8 @@ bool AuthSocket::_HandleLogonChallenge()
                         pkt << uint8(0);
                     }
 
-
-                    _localizationName.resize(4);
-                    for(int i = 0; i < 4; ++i)
-                        _localizationName[i] = ch->country[4-i-1];
-
-                    LoadAccountSecurityLevels(account_id);
-                    BASIC_LOG("[AuthChallenge] account %s is using '%c%c%c%c' locale (%u)", _login.c_str (), ch->country[3], ch->country[2], ch->country[1], ch->country[0], GetLocaleByName(_localizationName));
+                    LoadAccountSecurityLevels(holder->GetResult(LOGON_CHALLENGE_QUERY_ACCOUNT_ACCESS));
+                    BASIC_LOG("[AuthChallenge] account %s is using '%s' locale (%u)", _login.c_str (), _localizationName.c_str(), GetLocaleByName(_localizationName));
 
                     _accountId = account_id;
 
@@ -559,7 +672,6 @@ bool AuthSocket::_HandleLogonChallenge()
                     _status = STATUS_LOGON_PROOF;
                 }
             }
-            delete result;
         }
         else                                                // no account
         {
@@ -567,7 +679,6 @@ bool AuthSocket::_HandleLogonChallenge()
         }
     }
     send((char const*)pkt.contents(), pkt.size());
-    return true;
 }
 
 /// Logon Proof command handler
@@ -771,24 +882,35 @@ bool AuthSocket::_HandleLogonProof()
     {
         BASIC_LOG("User '%s' successfully authenticated", _login.c_str());
 
+        ///- Finish SRP6, the final result is sent to the client once the session key is stored (mangosd reads it)
+        _serverProof.Initialize();
+        _serverProof.UpdateBigNumbers(&A, &M, &K, NULL);
+        _serverProof.Finalize();
+
         ///- Update the sessionkey, last_ip, last login time and reset number of failed logins in the account table for this account
         // No SQL injection (escaped user name) and IP address as received by socket
         const char* K_hex = K.AsHexStr();
         const char *os = reinterpret_cast<char *>(&_os);    // no injection as there are only two possible values
-        auto result = LoginDatabase.PQuery("UPDATE account SET sessionkey = '%s', last_ip = '%s', last_login = NOW(), locale = '%u', failed_logins = 0, os = '%s' WHERE username = '%s'",
-            K_hex, get_remote_address().c_str(), GetLocaleByName(_localizationName), os, _safelogin.c_str() );
-        delete result;
+        std::string address = get_remote_address();
+        LoginDatabase.escape_string(address);
+
+        SqlQueryHolder* holder = new SqlQueryHolder();
+        holder->SetSize(MAX_LOGON_PROOF_QUERIES);
+        holder->SetPQuery(LOGON_PROOF_QUERY_SESSION_KEY, "UPDATE account SET sessionkey = '%s', last_ip = '%s', last_login = NOW(), locale = '%u', failed_logins = 0, os = '%s' WHERE username = '%s'",
+            K_hex, address.c_str(), GetLocaleByName(_localizationName), os, _safelogin.c_str() );
         OPENSSL_free((void*)K_hex);
 
-        ///- Finish SRP6 and send the final result to the client
-        sha.Initialize();
-        sha.UpdateBigNumbers(&A, &M, &K, NULL);
-        sha.Finalize();
+        ///- Prefetch the characters count of the realm list, usually requested right after
+        holder->SetPQuery(LOGON_PROOF_QUERY_CHARACTER_COUNTS, "SELECT realmid, numchars FROM realmcharacters WHERE acctid = %u", _accountId);
+        sRealmList.InvalidateCharacterCounts(_accountId);
 
-        SendProof(sha);
+        if (!LoginDatabase.DelayQueryHolderUnsafe(&sAuthQueryCallbacks, &AuthQueryCallbacks::OnLogonProofQueries, holder, _sessionId))
+        {
+            delete holder;
+            return false;
+        }
 
-        ///- Set _status to authed!
-        _status = STATUS_AUTHED;
+        _status = STATUS_WAITING_DB;
     }
     else
     {
@@ -809,41 +931,64 @@ bool AuthSocket::_HandleLogonProof()
         if(MaxWrongPassCount > 0)
         {
             //Increment number of failed logins by one and if it reaches the limit temporarily ban that account or IP
-            LoginDatabase.PExecute("UPDATE account SET failed_logins = failed_logins + 1 WHERE username = '%s'",_safelogin.c_str());
+            // The counter is read back after the increment on the same connection: the other connections may have
+            // counted wrong passwords since the logon challenge
+            FailedLoginQueryHolder* holder = new FailedLoginQueryHolder(_login, get_remote_address());
+            holder->SetSize(MAX_FAILED_LOGIN_QUERIES);
+            holder->SetPQuery(FAILED_LOGIN_QUERY_INCREMENT, "UPDATE account SET failed_logins = failed_logins + 1 WHERE id = '%u'", _accountId);
+            holder->SetPQuery(FAILED_LOGIN_QUERY_COUNT, "SELECT id, failed_logins FROM account WHERE id = '%u'", _accountId);
+
+            if (!LoginDatabase.DelayQueryHolderUnsafe(&sAuthQueryCallbacks, &AuthQueryCallbacks::OnFailedLoginQueries, holder))
+                delete holder;
+        }
+    }
+    return true;
+}
 
-            if(QueryResult *loginfail = LoginDatabase.PQuery("SELECT id, failed_logins FROM account WHERE username = '%s'", _safelogin.c_str()))
-            {
-                Field* fields = loginfail->Fetch();
-                uint32 failed_logins = fields[1].GetUInt32();
+/// Ban the account or the IP of a wrong password once the account reached WrongPass.MaxCount failed logins
+void AuthSocket::HandleFailedLoginResult(FailedLoginQueryHolder* holder)
+{
+    QueryResult* loginfail = holder->GetResult(FAILED_LOGIN_QUERY_COUNT);
+    if (!loginfail)
+        return;
 
-                if( failed_logins >= MaxWrongPassCount )
-                {
-                    uint32 WrongPassBanTime = sConfig.GetIntDefault("WrongPass.BanTime", 600);
-                    bool WrongPassBanType = sConfig.GetBoolDefault("WrongPass.BanType", false);
+    Field* fields = loginfail->Fetch();
+    uint32 failed_logins = fields[1].GetUInt32();
 
-                    if(WrongPassBanType)
-                    {
-                        uint32 acc_id = fields[0].GetUInt32();
-                        LoginDatabase.PExecute("INSERT INTO account_banned VALUES ('%u',UNIX_TIMESTAMP(),UNIX_TIMESTAMP()+'%u','MaNGOS realmd','Failed login autoban',1,1,0)",
-                            acc_id, WrongPassBanTime);
-                        BASIC_LOG("[AuthChallenge] account %s got banned for '%u' seconds because it failed to authenticate '%u' times",
-                            _login.c_str(), WrongPassBanTime, failed_logins);
-                    }
-                    else
-                    {
-                        std::string current_ip = get_remote_address();
-                        LoginDatabase.escape_string(current_ip);
-                        LoginDatabase.PExecute("INSERT INTO ip_banned VALUES ('%s',UNIX_TIMESTAMP(),UNIX_TIMESTAMP()+'%u','MaNGOS realmd','Failed login autoban')",
-                            current_ip.c_str(), WrongPassBanTime);
-                        BASIC_LOG("[AuthChallenge] IP %s got banned for '%u' seconds because account %s failed to authenticate '%u' times",
-                            current_ip.c_str(), WrongPassBanTime, _login.c_str(), failed_logins);
-                    }
-                }
-                delete loginfail;
-            }
-        }
+    uint32 MaxWrongPassCount = sConfig.GetIntDefault("WrongPass.MaxCount", 0);
+    if (failed_logins < MaxWrongPassCount)
+        return;
+
+    uint32 WrongPassBanTime = sConfig.GetIntDefault("WrongPass.BanTime", 600);
+    bool WrongPassBanType = sConfig.GetBoolDefault("WrongPass.BanType", false);
+
+    if(WrongPassBanType)
+    {
+        uint32 acc_id = fields[0].GetUInt32();
+        static SqlStatementID insAccountBan;
+        SqlStatement banStmt = LoginDatabase.CreateStatement(insAccountBan, "INSERT INTO account_banned VALUES (?,UNIX_TIMESTAMP(),UNIX_TIMESTAMP()+?,'MaNGOS realmd','Failed login autoban',1,1,0)");
+        banStmt.PExecute(acc_id, WrongPassBanTime);
+        BASIC_LOG("[AuthChallenge] account %s got banned for '%u' seconds because it failed to authenticate '%u' times",
+            holder->GetLogin().c_str(), WrongPassBanTime, failed_logins);
+    }
+    else
+    {
+        static SqlStatementID insIpBan;
+        SqlStatement banStmt = LoginDatabase.CreateStatement(insIpBan, "INSERT INTO ip_banned VALUES (?,UNIX_TIMESTAMP(),UNIX_TIMESTAMP()+?,'MaNGOS realmd','Failed login autoban')");
+        banStmt.PExecute(holder->GetAddress().c_str(), WrongPassBanTime);
+        BASIC_LOG("[AuthChallenge] IP %s got banned for '%u' seconds because account %s failed to authenticate '%u' times",
+            holder->GetAddress().c_str(), WrongPassBanTime, holder->GetLogin().c_str(), failed_logins);
     }
-    return true;
+}
+
+void AuthSocket::_HandleLogonProofResult(SqlQueryHolder* holder)
+{
+    sRealmList.SetCharacterCounts(_accountId, holder->GetResult(LOGON_PROOF_QUERY_CHARACTER_COUNTS));
+
+    SendProof(_serverProof);
+
+    ///- Set _status to authed!
+    _status = STATUS_AUTHED;
 }
 
 /// Reconnect Challenge command handler
@@ -948,6 +1093,9 @@ bool AuthSocket::_HandleReconnectProof()
         pkt << (uint8)  0x00;
         send((char const*)pkt.contents(), pkt.size());
 
+        ///- Characters may have been created or deleted since the last realm list
+        sRealmList.LoadCharacterCountsAsync(_accountId);
+
         ///- Set _status to authed!
         _status = STATUS_AUTHED;
 
@@ -1006,6 +1154,9 @@ bool AuthSocket::_HandleRealmList()
 
 void AuthSocket::LoadRealmlist(ByteBuffer &pkt)
 {
+    RealmList::CharacterCountMap characterCounts;
+    sRealmList.GetCharacterCounts(_accountId, characterCounts);
+
     switch(_build)
     {
         case 5875:                                          // 1.12.1
@@ -1017,18 +1168,8 @@ void AuthSocket::LoadRealmlist(ByteBuffer &pkt)
 
             for(RealmList::RealmMap::const_iterator  i = sRealmList.begin(); i != sRealmList.end(); ++i)
             {
-                uint8 AmountOfCharacters;
-
-                // No SQL injection. id of realm is controlled by the database.
-                QueryResult *result = LoginDatabase.PQuery( "SELECT numchars FROM realmcharacters WHERE realmid = '%d' AND acctid='%u'", i->second.m_ID, _accountId);
-                if( result )
-                {
-                    Field *fields = result->Fetch();
-                    AmountOfCharacters = fields[0].GetUInt8();
-                    delete result;
-                }
-                else
-                    AmountOfCharacters = 0;
+                RealmList::CharacterCountMap::const_iterator chars = characterCounts.find(i->second.m_ID);
+                uint8 AmountOfCharacters = chars != characterCounts.end() ? chars->second : 0;
 
                 bool ok_build = std::find(i->second.realmbuilds.begin(), i->second.realmbuilds.end(), _build) != i->second.realmbuilds.end();
 
@@ -1078,18 +1219,8 @@ void AuthSocket::LoadRealmlist(ByteBuffer &pkt)
 
             for(RealmList::RealmMap::const_iterator  i = sRealmList.begin(); i != sRealmList.end(); ++i)
             {
-                uint8 AmountOfCharacters;
-
-                // No SQL injection. id of realm is controlled by the database.
-                QueryResult *result = LoginDatabase.PQuery( "SELECT numchars FROM realmcharacters WHERE realmid = '%d' AND acctid='%u'", i->second.m_ID, _accountId);
-                if( result )
-                {
-                    Field *fields = result->Fetch();
-                    AmountOfCharacters = fields[0].GetUInt8();
-                    delete result;
-                }
-                else
-                    AmountOfCharacters = 0;
+                RealmList::CharacterCountMap::const_iterator chars = characterCounts.find(i->second.m_ID);
+                uint8 AmountOfCharacters = chars != characterCounts.end() ? chars->second : 0;
 
                 bool ok_build = std::find(i->second.realmbuilds.begin(), i->second.realmbuilds.end(), _build) != i->second.realmbuilds.end();
 
@@ -1311,10 +1442,8 @@ void AuthSocket::InitPatch()
     }
 }
 
-void AuthSocket::LoadAccountSecurityLevels(uint32 accountId)
+void AuthSocket::LoadAccountSecurityLevels(QueryResult* result)
 {
-    QueryResult* result = LoginDatabase.PQuery("SELECT gmlevel, RealmID FROM account_access WHERE id = %u",
-        accountId);
     if (!result)
         return;
 
@@ -1328,6 +1457,4 @@ void AuthSocket::LoadAccountSecurityLevels(uint32 accountId)
         else
             _accountSecurityOnRealm[realmId] = security;
     } while (result->NextRow());
-
-    delete result;
 }
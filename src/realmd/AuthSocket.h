@@ -33,6 +33,10 @@
 
 #include "BufferedSocket.h"
 
+class QueryResult;
+class SqlQueryHolder;
+class FailedLoginQueryHolder;
+
 struct PINData
 {
     uint8 salt[16];
@@ -66,6 +70,10 @@ class AuthSocket: public BufferedSocket
 
         bool _HandleLogonChallenge();
         bool _HandleLogonProof();
+        // called back once the login queries are done
+        void _HandleLogonChallengeResult(SqlQueryHolder* holder);
+        void _HandleLogonProofResult(SqlQueryHolder* holder);
+        static void HandleFailedLoginResult(FailedLoginQueryHolder* holder);
         bool _HandleReconnectChallenge();
         bool _HandleReconnectProof();
         bool _HandleRealmList();
@@ -85,6 +93,7 @@ class AuthSocket: public BufferedSocket
             STATUS_RECON_PROOF,
             STATUS_PATCH,      // unused in CMaNGOS
             STATUS_AUTHED,
+            STATUS_WAITING_DB, // commands are kept buffered until the login queries are done
             STATUS_CLOSED
         };
 
@@ -114,6 +123,8 @@ class AuthSocket: public BufferedSocket
         uint32 _platform;
         uint32 _accountId;
         uint32 _lastRealmListRequest;
+        uint32 _sessionId;
+        Sha1Hash _serverProof;
 
         // Since GetLocaleByName() is _NOT_ bijective, we have to store the locale as a string. Otherwise we can't differ
         // between enUS and enGB, which is important for the patch system
@@ -121,7 +132,7 @@ class AuthSocket: public BufferedSocket
         uint16 _build;
 
         AccountTypes GetSecurityOn(uint32 realmId) const;
-        void LoadAccountSecurityLevels(uint32 accountId);
+        void LoadAccountSecurityLevels(QueryResult* result);
 
         AccountTypes _accountDefaultSecurityLevel;
         typedef std::map<uint32, AccountTypes> AccountSecurityMap;
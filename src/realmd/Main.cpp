@@ -244,6 +244,7 @@ extern int main(int argc, char **argv)
 
     ///- Get the list of realms for the server
     sRealmList.Initialize(sConfig.GetIntDefault("RealmsStateUpdateDelay", 20));
+    sRealmList.SetCharacterCountsCacheTime(sConfig.GetIntDefault("CharacterCountsCacheTime", 60));
     if (sRealmList.size() == 0)
     {
         sLog.outError("No valid realms specified.");
@@ -322,8 +323,11 @@ extern int main(int argc, char **argv)
     //server has started up successfully => enable async DB requests
     LoginDatabase.AllowAsyncTransactions();
 
+    // the login queries results are handled between two reactor runs
+    const uint32 loopIntervalUs = 10000;
+
     // maximum counter for next ping
-    uint32 numLoops = (sConfig.GetIntDefault( "MaxPingTime", 30 ) * (MINUTE * 1000000 / 100000));
+    uint32 numLoops = (sConfig.GetIntDefault( "MaxPingTime", 30 ) * (MINUTE * 1000000 / loopIntervalUs));
     uint32 loopCounter = 0;
 
     #ifndef WIN32
@@ -333,11 +337,13 @@ extern int main(int argc, char **argv)
     while (!stopEvent)
     {
         // dont move this outside the loop, the reactor will modify it
-        ACE_Time_Value interval(0, 100000);
+        ACE_Time_Value interval(0, loopIntervalUs);
 
         if (ACE_Reactor::instance()->run_reactor_event_loop(interval) == -1)
             break;
 
+        LoginDatabase.ProcessResultQueue();
+
         if( (++loopCounter) == numLoops )
         {
             loopCounter = 0;
@@ -374,6 +380,10 @@ void OnSignal(int s)
         case SIGBREAK:
             stopEvent = true;
             break;
+        #else
+        case SIGHUP:
+            sLog.ReopenFiles();
+            break;
         #endif
     }
 
@@ -390,8 +400,9 @@ bool StartDB()
         return false;
     }
 
-    sLog.outString("Database: %s", dbstring.c_str() );
-    if(!LoginDatabase.Initialize(dbstring.c_str()))
+    int nAsyncConnections = sConfig.GetIntDefault("LoginDatabase.WorkerThreads", 2);
+    sLog.outString("Database: %s, workers: %i", dbstring.c_str(), nAsyncConnections);
+    if(!LoginDatabase.Initialize(dbstring.c_str(), 1, nAsyncConnections))
     {
         sLog.outError("Cannot connect to database");
         return false;
@@ -414,6 +425,8 @@ void HookSignals()
     signal(SIGTERM, OnSignal);
     #ifdef _WIN32
     signal(SIGBREAK, OnSignal);
+    #else
+    signal(SIGHUP, OnSignal);
     #endif
 }
 
@@ -424,6 +437,8 @@ void UnhookSignals()
     signal(SIGTERM, 0);
     #ifdef _WIN32
     signal(SIGBREAK, 0);
+    #else
+    signal(SIGHUP, 0);
     #endif
 }
 
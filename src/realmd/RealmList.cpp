@@ -66,7 +66,7 @@ RealmBuildInfo const* FindBuildInfo(uint16 _build)
     return NULL;
 }
 
-RealmList::RealmList( ) : m_UpdateInterval(0), m_NextUpdateTime(time(NULL))
+RealmList::RealmList( ) : m_UpdateInterval(0), m_NextUpdateTime(time(NULL)), m_CharacterCountsCacheTime(0), m_NextCharacterCountsPurgeTime(0)
 {
 }
 
@@ -180,3 +180,80 @@ void RealmList::UpdateRealms(bool init)
         delete result;
     }
 }
+
+void RealmList::LoadCharacterCountsAsync(uint32 accountId)
+{
+    InvalidateCharacterCounts(accountId);
+
+    LoginDatabase.AsyncPQueryUnsafe(this, &RealmList::_OnCharacterCountsLoaded, accountId,
+        "SELECT realmid, numchars FROM realmcharacters WHERE acctid = %u", accountId);
+}
+
+void RealmList::_OnCharacterCountsLoaded(QueryResult* result, uint32 accountId)
+{
+    SetCharacterCounts(accountId, result);
+    delete result;
+}
+
+/// Caches the result of "SELECT realmid, numchars FROM realmcharacters WHERE acctid = ?" (may be NULL, no character)
+void RealmList::SetCharacterCounts(uint32 accountId, QueryResult* result)
+{
+    CharacterCountMap counts;
+    ReadCharacterCounts(result, counts);
+    CacheCharacterCounts(accountId, counts);
+}
+
+void RealmList::GetCharacterCounts(uint32 accountId, CharacterCountMap& counts)
+{
+    CharacterCountsCache::const_iterator itr = m_CharacterCounts.find(accountId);
+    if (itr != m_CharacterCounts.end() && itr->second.expireTime > time(NULL))
+    {
+        counts = itr->second.counts;
+        return;
+    }
+
+    ///- Not prefetched, or not cached: one query for all the realms
+    QueryResult* result = LoginDatabase.PQuery("SELECT realmid, numchars FROM realmcharacters WHERE acctid = %u", accountId);
+    ReadCharacterCounts(result, counts);
+    delete result;
+
+    CacheCharacterCounts(accountId, counts);
+}
+
+void RealmList::ReadCharacterCounts(QueryResult* result, CharacterCountMap& counts)
+{
+    counts.clear();
+    if (!result)
+        return;
+
+    do
+    {
+        Field* fields = result->Fetch();
+        counts[fields[0].GetUInt32()] = fields[1].GetUInt8();
+    } while (result->NextRow());
+}
+
+void RealmList::CacheCharacterCounts(uint32 accountId, CharacterCountMap const& counts)
+{
+    if (!m_CharacterCountsCacheTime)
+        return;
+
+    time_t now = time(NULL);
+
+    ///- Drop the accounts which did not request the realm list in time
+    if (m_NextCharacterCountsPurgeTime <= now)
+    {
+        for (CharacterCountsCache::iterator itr = m_CharacterCounts.begin(); itr != m_CharacterCounts.end();)
+        {
+            if (itr->second.expireTime <= now)
+                itr = m_CharacterCounts.erase(itr);
+            else
+                ++itr;
+        }
+        m_NextCharacterCountsPurgeTime = now + m_CharacterCountsCacheTime;
+    }
+
+    CachedCharacterCounts& cached = m_CharacterCounts[accountId];
+    cached.counts = counts;
+    cached.expireTime = now + m_CharacterCountsCacheTime;
+}
@@ -27,6 +27,7 @@
 #define _REALMLIST_H
 
 #include "Common.h"
+#include <unordered_map>
 
 struct RealmBuildInfo
 {
@@ -55,11 +56,14 @@ struct Realm
     RealmBuildInfo realmBuildInfo;                          // build info for show version in list
 };
 
+class QueryResult;
+
 /// Storage object for the list of realms on the server
 class RealmList
 {
     public:
         typedef std::map<std::string, Realm> RealmMap;
+        typedef std::map<uint32, uint8> CharacterCountMap;  ///< realm id -> number of characters
 
         static RealmList& Instance();
 
@@ -73,13 +77,35 @@ class RealmList
         RealmMap::const_iterator begin() const { return m_realms.begin(); }
         RealmMap::const_iterator end() const { return m_realms.end(); }
         uint32 size() const { return m_realms.size(); }
+
+        /// Characters of the accounts on each realm, prefetched when they log in (see AuthSocket)
+        void SetCharacterCountsCacheTime(uint32 seconds) { m_CharacterCountsCacheTime = seconds; }
+        void LoadCharacterCountsAsync(uint32 accountId);
+        void SetCharacterCounts(uint32 accountId, QueryResult* result);
+        void InvalidateCharacterCounts(uint32 accountId) { m_CharacterCounts.erase(accountId); }
+        /// Loads synchronously the counts if they are not cached (yet)
+        void GetCharacterCounts(uint32 accountId, CharacterCountMap& counts);
     private:
+        struct CachedCharacterCounts
+        {
+            CharacterCountMap counts;
+            time_t expireTime;
+        };
+        typedef std::unordered_map<uint32, CachedCharacterCounts> CharacterCountsCache;
+
         void UpdateRealms(bool init);
+        void _OnCharacterCountsLoaded(QueryResult* result, uint32 accountId);
+        static void ReadCharacterCounts(QueryResult* result, CharacterCountMap& counts);
+        void CacheCharacterCounts(uint32 accountId, CharacterCountMap const& counts);
         void UpdateRealm( uint32 ID, const std::string& name, const std::string& address, uint32 port, uint8 icon, RealmFlags realmflags, uint8 timezone, AccountTypes allowedSecurityLevel, float popu, const std::string& builds);
     private:
         RealmMap m_realms;                                  ///< Internal map of realms
         uint32   m_UpdateInterval;
         time_t   m_NextUpdateTime;
+
+        CharacterCountsCache m_CharacterCounts;             ///< by account id
+        uint32   m_CharacterCountsCacheTime;
+        time_t   m_NextCharacterCountsPurgeTime;
 };
 
 #define sRealmList RealmList::Instance()
@@ -516,6 +516,13 @@ bool Database::RollbackTransaction()
     return true;
 }
 
+void Database::GetQueryStats(QueryStats& stats) const
+{
+    stats.queries = m_queryCount;
+    stats.rows = m_queryRows;
+    stats.timeMs = m_queryTimeMs;
+}
+
 bool Database::CheckRequiredMigrations(const char **migrations)
 {
     std::set<std::string> appliedMigrations;
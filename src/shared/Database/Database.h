@@ -30,6 +30,7 @@
 #include <ace/TSS_T.h>
 #include <ace/Atomic_Op.h>
 #include "SqlPreparedStatement.h"
+#include <atomic>
 
 class SqlTransaction;
 class SqlResultQueue;
@@ -200,6 +201,8 @@ class MANGOS_DLL_SPEC Database
             bool DelayQueryHolderUnsafe(Class *object, void (Class::*method)(QueryResult*, SqlQueryHolder*), SqlQueryHolder *holder);
         template<class Class, typename ParamType1>
             bool DelayQueryHolder(Class *object, void (Class::*method)(QueryResult*, SqlQueryHolder*, ParamType1), SqlQueryHolder *holder, ParamType1 param1);
+        template<class Class, typename ParamType1>
+            bool DelayQueryHolderUnsafe(Class *object, void (Class::*method)(QueryResult*, SqlQueryHolder*, ParamType1), SqlQueryHolder *holder, ParamType1 param1);
 
         bool Execute(const char *sql);
         bool PExecute(const char *format,...) ATTR_PRINTF(2,3);
@@ -236,6 +239,22 @@ class MANGOS_DLL_SPEC Database
         bool CheckRequiredMigrations(const char **migrations);
         uint32 GetPingIntervall() { return m_pingIntervallms; }
 
+        // fetch the query results with the binary protocol when the DBMS supports it: numeric columns
+        // are received in their native type, not as text. Worth it for large results only (one more
+        // round trip per query), so mostly for the world database, loaded at startup
+        void SetBinaryResults(bool enable) { m_bBinaryResults = enable; }
+        bool IsBinaryResults() const { return m_bBinaryResults; }
+
+        // statistics of the queries returning results, sync and async
+        struct QueryStats
+        {
+            uint64 queries;
+            uint64 rows;
+            uint64 timeMs;                                  // execution and transfer of the results
+        };
+        void GetQueryStats(QueryStats& stats) const;
+        void AddQueryStats(uint64 rows, uint32 timeMs) { ++m_queryCount; m_queryRows += rows; m_queryTimeMs += timeMs; }
+
         //function to ping database connections
         void Ping();
 
@@ -251,7 +270,8 @@ class MANGOS_DLL_SPEC Database
         void StopServer();
     protected:
         Database() : m_pAsyncConn(NULL), m_pResultQueue(NULL), m_threadsBodies(NULL), m_delayThreads(NULL), m_numAsyncWorkers(0), m_delayQueue(new SqlQueue()),
-            m_logSQL(false), m_pingIntervallms(0), m_nQueryConnPoolSize(1), m_bAllowAsyncTransactions(false), m_iStmtIndex(-1)
+            m_logSQL(false), m_pingIntervallms(0), m_nQueryConnPoolSize(1), m_bAllowAsyncTransactions(false), m_bBinaryResults(false), m_iStmtIndex(-1),
+            m_queryCount(0), m_queryRows(0), m_queryTimeMs(0)
         {
             m_nQueryCounter = -1;
         }
@@ -316,6 +336,7 @@ class MANGOS_DLL_SPEC Database
         ACE_Based::Thread** m_delayThreads;                   ///< Pointer to executer thread
 
         bool m_bAllowAsyncTransactions;                      ///< flag which specifies if async transactions are enabled
+        bool m_bBinaryResults;                               ///< flag which specifies if results are fetched with the binary protocol
 
         //PREPARED STATEMENT REGISTRY
         typedef ACE_Thread_Mutex LOCK_TYPE;
@@ -333,5 +354,9 @@ class MANGOS_DLL_SPEC Database
         bool m_logSQL;
         std::string m_logsDir;
         uint32 m_pingIntervallms;
+
+        std::atomic<uint64> m_queryCount;
+        std::atomic<uint64> m_queryRows;
+        std::atomic<uint64> m_queryTimeMs;
 };
 #endif
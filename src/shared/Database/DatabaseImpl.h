@@ -233,6 +233,15 @@ Database::DelayQueryHolder(Class *object, void (Class::*method)(QueryResult*, Sq
     ASYNC_DELAYHOLDER_BODY(holder)
     return holder->Execute(new MaNGOS::QueryCallback<Class, SqlQueryHolder*, ParamType1>(object, method, (QueryResult*)NULL, holder, param1), this, m_pResultQueue);
 }
+template<class Class, typename ParamType1>
+bool
+Database::DelayQueryHolderUnsafe(Class *object, void (Class::*method)(QueryResult*, SqlQueryHolder*, ParamType1), SqlQueryHolder *holder, ParamType1 param1)
+{
+    ASYNC_DELAYHOLDER_BODY(holder)
+    MaNGOS::QueryCallback<Class, SqlQueryHolder*, ParamType1> *cb = new MaNGOS::QueryCallback<Class, SqlQueryHolder*, ParamType1>(object, method, (QueryResult*)NULL, holder, param1);
+    cb->threadSafe = false;
+    return holder->Execute(cb, this, m_pResultQueue);
+}
 
 #undef ASYNC_QUERY_BODY
 #undef ASYNC_PQUERY_BODY
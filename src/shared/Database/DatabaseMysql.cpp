@@ -235,19 +235,85 @@ bool MySQLConnection::_Query(const char *sql, MYSQL_RES **pResult, MYSQL_FIELD *
     return true;
 }
 
-QueryResult* MySQLConnection::Query(const char *sql)
+bool MySQLConnection::_QueryBinary(const char *sql, QueryResult **pResult)
 {
-    MYSQL_RES *result = NULL;
-    MYSQL_FIELD *fields = NULL;
-    uint64 rowCount = 0;
-    uint32 fieldCount = 0;
+    // only the SELECT queries are prepared, others (SHOW ...) may not be supported
+    const char* keyword = sql;
+    while (isspace(static_cast<unsigned char>(*keyword)))
+        ++keyword;
+    if (strnicmp(keyword, "SELECT", 6) != 0)
+        return false;
 
-    if(!_Query(sql,&result,&fields,&rowCount,&fieldCount))
-        return NULL;
+    if (!mMysql)
+        return false;
 
-    QueryResultMysql *queryResult = new QueryResultMysql(result, fields, rowCount, fieldCount);
+    MYSQL_STMT *stmt = mysql_stmt_init(mMysql);
+    if (!stmt)
+        return false;
+
+    uint32 _s = WorldTimer::getMSTime();
+
+    // errors are reported by the text protocol, which also handles the reconnections
+    if (mysql_stmt_prepare(stmt, sql, strlen(sql)))
+    {
+        mysql_stmt_close(stmt);
+        return false;
+    }
+
+    MYSQL_RES *metadata = mysql_stmt_result_metadata(stmt);
+    if (!metadata)
+    {
+        mysql_stmt_close(stmt);
+        return false;
+    }
+
+    QueryResultMysqlBinary *queryResult = NULL;
+    if (!mysql_stmt_execute(stmt))
+        queryResult = new QueryResultMysqlBinary(stmt, metadata, mysql_stmt_field_count(stmt));
+
+    mysql_free_result(metadata);
+    mysql_stmt_close(stmt);
+
+    if (!queryResult || !queryResult->IsValid())
+    {
+        delete queryResult;
+        return false;
+    }
+
+    DEBUG_FILTER_LOG(LOG_FILTER_SQL_TEXT, "[%u ms] SQL (binary): %s", WorldTimer::getMSTimeDiff(_s,WorldTimer::getMSTime()), sql);
+
+    if (!queryResult->GetRowCount())
+    {
+        delete queryResult;
+        *pResult = NULL;
+        return true;
+    }
 
     queryResult->NextRow();
+    *pResult = queryResult;
+    return true;
+}
+
+QueryResult* MySQLConnection::Query(const char *sql)
+{
+    uint32 _s = WorldTimer::getMSTime();
+
+    QueryResult *queryResult = NULL;
+    if (!m_db.IsBinaryResults() || !_QueryBinary(sql, &queryResult))
+    {
+        MYSQL_RES *result = NULL;
+        MYSQL_FIELD *fields = NULL;
+        uint64 rowCount = 0;
+        uint32 fieldCount = 0;
+
+        if(_Query(sql,&result,&fields,&rowCount,&fieldCount))
+        {
+            queryResult = new QueryResultMysql(result, fields, rowCount, fieldCount);
+            queryResult->NextRow();
+        }
+    }
+
+    m_db.AddQueryStats(queryResult ? queryResult->GetRowCount() : 0, WorldTimer::getMSTimeDiff(_s, WorldTimer::getMSTime()));
     return queryResult;
 }
 
@@ -95,6 +95,8 @@ class MANGOS_DLL_SPEC MySQLConnection : public SqlConnection
     private:
         bool _TransactionCmd(const char *sql);
         bool _Query(const char *sql, MYSQL_RES **pResult, MYSQL_FIELD **pFields, uint64* pRowCount, uint32* pFieldCount);
+        //returns false if the query can not be executed as a prepared statement, without logging any error
+        bool _QueryBinary(const char *sql, QueryResult **pResult);
 
         MYSQL *mMysql;
 };
@@ -122,16 +122,22 @@ QueryResult* PostgreSQLConnection::Query(const char *sql)
     if (!mPGconn)
         return NULL;
 
+    uint32 _s = WorldTimer::getMSTime();
+
     PGresult* result = NULL;
     uint64 rowCount = 0;
     uint32 fieldCount = 0;
 
     if(!_Query(sql,&result,&rowCount,&fieldCount))
+    {
+        m_db.AddQueryStats(0, WorldTimer::getMSTimeDiff(_s, WorldTimer::getMSTime()));
         return NULL;
+    }
 
     QueryResultPostgre * queryResult = new QueryResultPostgre(result, rowCount, fieldCount);
 
     queryResult->NextRow();
+    m_db.AddQueryStats(rowCount, WorldTimer::getMSTimeDiff(_s, WorldTimer::getMSTime()));
     return queryResult;
 }
 
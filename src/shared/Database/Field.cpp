@@ -20,3 +20,34 @@
  */
 
 //#include "DatabaseEnv.h"
+#include "Field.h"
+
+const char* Field::FormatBinaryValue() const
+{
+    switch (mStorage)
+    {
+        case STORAGE_INTEGER:
+            if (mUnsigned)
+                snprintf(mText, sizeof(mText), UI64FMTD, static_cast<uint64>(mData.integer));
+            else
+                snprintf(mText, sizeof(mText), SI64FMTD, mData.integer);
+            break;
+        case STORAGE_FLOAT:
+            // shortest text giving back the same float, as the text protocol does
+            snprintf(mText, sizeof(mText), "%.6g", mData.single);
+            if (static_cast<float>(atof(mText)) != mData.single)
+                snprintf(mText, sizeof(mText), "%.9g", mData.single);
+            break;
+        case STORAGE_DOUBLE:
+            for (int precision = 15; precision <= 17; ++precision)
+            {
+                snprintf(mText, sizeof(mText), "%.*g", precision, mData.real);
+                if (atof(mText) == mData.real)
+                    break;
+            }
+            break;
+        default:
+            return mValue;
+    }
+    return mText;
+}
@@ -37,28 +37,42 @@ class Field
             DB_TYPE_BOOL    = 0x04
         };
 
-        Field() : mValue(NULL), mType(DB_TYPE_UNKNOWN) {}
-        Field(const char* value, enum DataTypes type) : mValue(value), mType(type) {}
+        Field() : mValue(NULL), mType(DB_TYPE_UNKNOWN), mStorage(STORAGE_TEXT), mUnsigned(false) { mData.integer = 0; }
+        Field(const char* value, enum DataTypes type) : mValue(value), mType(type), mStorage(STORAGE_TEXT), mUnsigned(false) { mData.integer = 0; }
 
         ~Field() {}
 
         enum DataTypes GetType() const { return mType; }
-        bool IsNULL() const { return mValue == NULL; }
+        bool IsNULL() const { return mStorage == STORAGE_TEXT && mValue == NULL; }
 
-        const char *GetString() const { return mValue; }
+        const char *GetString() const { return mStorage == STORAGE_TEXT ? mValue : FormatBinaryValue(); }
         std::string GetCppString() const
         {
-            return mValue ? mValue : "";                    // std::string s = 0 have undefine result in C++
+            const char* value = GetString();
+            return value ? value : "";                      // std::string s = 0 have undefine result in C++
         }
-        float GetFloat() const { return mValue ? static_cast<float>(atof(mValue)) : 0.0f; }
-        bool GetBool() const { return mValue ? atoi(mValue) > 0 : false; }
-        int32 GetInt32() const { return mValue ? static_cast<int32>(atol(mValue)) : int32(0); }
-        uint8 GetUInt8() const { return mValue ? static_cast<uint8>(atol(mValue)) : uint8(0); }
-        uint16 GetUInt16() const { return mValue ? static_cast<uint16>(atol(mValue)) : uint16(0); }
-        int16 GetInt16() const { return mValue ? static_cast<int16>(atol(mValue)) : int16(0); }
-        uint32 GetUInt32() const { return mValue ? static_cast<uint32>(atol(mValue)) : uint32(0); }
+        float GetFloat() const
+        {
+            if (mStorage != STORAGE_TEXT)
+                return static_cast<float>(GetBinaryReal());
+            return mValue ? static_cast<float>(atof(mValue)) : 0.0f;
+        }
+        bool GetBool() const
+        {
+            if (mStorage != STORAGE_TEXT)
+                return GetBinaryInteger() > 0;
+            return mValue ? atoi(mValue) > 0 : false;
+        }
+        int32 GetInt32() const { return static_cast<int32>(GetInteger()); }
+        uint8 GetUInt8() const { return static_cast<uint8>(GetInteger()); }
+        uint16 GetUInt16() const { return static_cast<uint16>(GetInteger()); }
+        int16 GetInt16() const { return static_cast<int16>(GetInteger()); }
+        uint32 GetUInt32() const { return static_cast<uint32>(GetInteger()); }
         uint64 GetUInt64() const
         {
+            if (mStorage != STORAGE_TEXT)
+                return static_cast<uint64>(GetBinaryInteger());
+
             uint64 value = 0;
             if(!mValue || sscanf(mValue,UI64FMTD,&value) == -1)
                 return 0;
@@ -69,13 +83,62 @@ class Field
         void SetType(enum DataTypes type) { mType = type; }
         //no need for memory allocations to store resultset field strings
         //all we need is to cache pointers returned by different DBMS APIs
-        void SetValue(const char* value) { mValue = value; };
+        void SetValue(const char* value) { mStorage = STORAGE_TEXT; mValue = value; };
+        //values of the DBMS APIs returning native types (binary protocol) are stored as is,
+        //the getters only convert them to the requested type, without any parsing
+        void SetInteger(int64 value, bool isUnsigned) { mStorage = STORAGE_INTEGER; mData.integer = value; mUnsigned = isUnsigned; }
+        void SetFloat(float value) { mStorage = STORAGE_FLOAT; mData.single = value; }
+        void SetDouble(double value) { mStorage = STORAGE_DOUBLE; mData.real = value; }
 
     private:
         Field(Field const&);
         Field& operator=(Field const&);
 
+        enum StorageTypes
+        {
+            STORAGE_TEXT,
+            STORAGE_INTEGER,
+            STORAGE_FLOAT,
+            STORAGE_DOUBLE
+        };
+
+        int64 GetInteger() const
+        {
+            if (mStorage != STORAGE_TEXT)
+                return GetBinaryInteger();
+            return mValue ? atol(mValue) : 0;
+        }
+        int64 GetBinaryInteger() const
+        {
+            switch (mStorage)
+            {
+                case STORAGE_FLOAT:  return static_cast<int64>(mData.single);
+                case STORAGE_DOUBLE: return static_cast<int64>(mData.real);
+                default:             return mData.integer;
+            }
+        }
+        double GetBinaryReal() const
+        {
+            switch (mStorage)
+            {
+                case STORAGE_FLOAT:  return mData.single;
+                case STORAGE_DOUBLE: return mData.real;
+                default:             return mUnsigned ? static_cast<double>(static_cast<uint64>(mData.integer)) : static_cast<double>(mData.integer);
+            }
+        }
+        // Text of a binary value, formatted in mText
+        const char* FormatBinaryValue() const;
+
         const char* mValue;
         enum DataTypes mType;
+        StorageTypes mStorage;
+        bool mUnsigned;
+        union
+        {
+            int64 integer;
+            float single;
+            double real;
+        } mData;
+        mutable char mText[32];
 };
 #endif
@@ -75,7 +75,7 @@ void QueryResultMysql::EndQuery()
     }
 }
 
-enum Field::DataTypes QueryResultMysql::ConvertNativeType(enum_field_types mysqlType) const
+enum Field::DataTypes QueryResultMysql::ConvertNativeType(enum_field_types mysqlType)
 {
     switch (mysqlType)
     {
@@ -105,4 +105,177 @@ enum Field::DataTypes QueryResultMysql::ConvertNativeType(enum_field_types mysql
             return Field::DB_TYPE_UNKNOWN;
     }
 }
+
+QueryResultMysqlBinary::QueryResultMysqlBinary(MYSQL_STMT *stmt, MYSQL_RES *metadata, uint32 fieldCount) :
+    QueryResult(0, fieldCount), mNextRow(0), mValid(false)
+{
+    mCurrentRow = new Field[mFieldCount];
+    mColumns.resize(mFieldCount);
+
+    MYSQL_FIELD *fields = mysql_fetch_fields(metadata);
+    for (uint32 i = 0; i < mFieldCount; i++)
+    {
+        mCurrentRow[i].SetType(QueryResultMysql::ConvertNativeType(fields[i].type));
+
+        Column& column = mColumns[i];
+        column.isUnsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+        switch (fields[i].type)
+        {
+            case MYSQL_TYPE_TINY:
+            case MYSQL_TYPE_SHORT:
+            case MYSQL_TYPE_LONG:
+            case MYSQL_TYPE_INT24:
+            case MYSQL_TYPE_LONGLONG:
+                column.storage = COLUMN_INTEGER;
+                break;
+            case MYSQL_TYPE_FLOAT:
+                column.storage = COLUMN_FLOAT;
+                break;
+            case MYSQL_TYPE_DOUBLE:
+                column.storage = COLUMN_DOUBLE;
+                break;
+            default:
+                // decimals, dates, strings and blobs are converted to text by the client library,
+                // so that they are read exactly as with the text protocol
+                column.storage = COLUMN_STRING;
+                column.buffer.resize(std::min<unsigned long>(fields[i].length, 64) + 1);
+                break;
+        }
+    }
+
+    mValid = FetchRows(stmt);
+}
+
+QueryResultMysqlBinary::~QueryResultMysqlBinary()
+{
+    EndQuery();
+}
+
+bool QueryResultMysqlBinary::FetchRows(MYSQL_STMT *stmt)
+{
+    std::vector<MYSQL_BIND> binds(mFieldCount);
+    std::vector<Cell> row(mFieldCount);
+    std::vector<my_bool> nulls(mFieldCount);
+    std::vector<my_bool> errors(mFieldCount);
+    std::vector<unsigned long> lengths(mFieldCount);
+
+    memset(&binds[0], 0, sizeof(MYSQL_BIND) * mFieldCount);
+    for (uint32 i = 0; i < mFieldCount; i++)
+    {
+        MYSQL_BIND& bind = binds[i];
+        Column& column = mColumns[i];
+        bind.is_null = &nulls[i];
+        bind.error = &errors[i];
+        bind.length = &lengths[i];
+        bind.is_unsigned = column.isUnsigned;
+        switch (column.storage)
+        {
+            case COLUMN_INTEGER:
+                bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                bind.buffer = &row[i].integer;
+                break;
+            case COLUMN_FLOAT:
+                bind.buffer_type = MYSQL_TYPE_FLOAT;
+                bind.buffer = &row[i].single;
+                break;
+            case COLUMN_DOUBLE:
+                bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                bind.buffer = &row[i].real;
+                break;
+            case COLUMN_STRING:
+                bind.buffer_type = MYSQL_TYPE_STRING;
+                bind.buffer = &column.buffer[0];
+                bind.buffer_length = column.buffer.size();
+                break;
+        }
+    }
+
+    if (mysql_stmt_bind_result(stmt, &binds[0]))
+        return false;
+
+    for (;;)
+    {
+        int status = mysql_stmt_fetch(stmt);
+        if (status == MYSQL_NO_DATA)
+            break;
+        if (status == 1)
+            return false;
+
+        bool rebind = false;
+        for (uint32 i = 0; i < mFieldCount; i++)
+        {
+            Column& column = mColumns[i];
+            if (column.storage == COLUMN_STRING && !nulls[i])
+            {
+                // the buffer is grown to the longest value of the column, which is then fetched again
+                if (status == MYSQL_DATA_TRUNCATED && lengths[i] >= column.buffer.size())
+                {
+                    column.buffer.resize(lengths[i] + 1);
+                    binds[i].buffer = &column.buffer[0];
+                    binds[i].buffer_length = column.buffer.size();
+                    if (mysql_stmt_fetch_column(stmt, &binds[i], i, 0))
+                        return false;
+                    rebind = true;
+                }
+
+                row[i].stringOffset = mStrings.size();
+                mStrings.insert(mStrings.end(), column.buffer.begin(), column.buffer.begin() + lengths[i]);
+                mStrings.push_back('\0');
+            }
+
+            mCells.push_back(row[i]);
+            mNulls.push_back(nulls[i]);
+        }
+
+        if (rebind && mysql_stmt_bind_result(stmt, &binds[0]))
+            return false;
+
+        ++mRowCount;
+    }
+
+    return true;
+}
+
+bool QueryResultMysqlBinary::NextRow()
+{
+    if (!mCurrentRow)
+        return false;
+
+    if (mNextRow >= mRowCount)
+    {
+        EndQuery();
+        return false;
+    }
+
+    size_t first = size_t(mNextRow++) * mFieldCount;
+    for (uint32 i = 0; i < mFieldCount; i++)
+    {
+        Cell const& cell = mCells[first + i];
+        Field& field = mCurrentRow[i];
+        if (mNulls[first + i])
+        {
+            field.SetValue(NULL);
+            continue;
+        }
+
+        switch (mColumns[i].storage)
+        {
+            case COLUMN_INTEGER: field.SetInteger(cell.integer, mColumns[i].isUnsigned); break;
+            case COLUMN_FLOAT:   field.SetFloat(cell.single); break;
+            case COLUMN_DOUBLE:  field.SetDouble(cell.real); break;
+            case COLUMN_STRING:  field.SetValue(&mStrings[cell.stringOffset]); break;
+        }
+    }
+
+    return true;
+}
+
+void QueryResultMysqlBinary::EndQuery()
+{
+    if (mCurrentRow)
+    {
+        delete [] mCurrentRow;
+        mCurrentRow = 0;
+    }
+}
 #endif
@@ -42,11 +42,68 @@ class QueryResultMysql : public QueryResult
 
         bool NextRow();
 
+        static enum Field::DataTypes ConvertNativeType(enum_field_types mysqlType);
+
     private:
-        enum Field::DataTypes ConvertNativeType(enum_field_types mysqlType) const;
         void EndQuery();
 
         MYSQL_RES *mResult;
 };
+
+/**
+ * Result of a query executed with the binary protocol (prepared statement).
+ * Integer and floating point columns are received in their native type and stored
+ * as is in the fields: reading them does not parse any text. The rows are fetched
+ * when the result is created, so that the statement is closed while the connection
+ * is still locked by the caller.
+ */
+class QueryResultMysqlBinary : public QueryResult
+{
+    public:
+        // Fetches all the rows of an executed statement
+        QueryResultMysqlBinary(MYSQL_STMT *stmt, MYSQL_RES *metadata, uint32 fieldCount);
+
+        ~QueryResultMysqlBinary();
+
+        bool NextRow();
+
+        // False if the rows could not be fetched
+        bool IsValid() const { return mValid; }
+
+    private:
+        enum ColumnStorage
+        {
+            COLUMN_INTEGER,
+            COLUMN_FLOAT,
+            COLUMN_DOUBLE,
+            COLUMN_STRING
+        };
+
+        struct Column
+        {
+            ColumnStorage storage;
+            bool isUnsigned;
+            std::vector<char> buffer;                       // value of the fetched row, strings only
+        };
+
+        // Value of a column in mCells: strings are stored in mStrings
+        union Cell
+        {
+            int64 integer;
+            float single;
+            double real;
+            uint64 stringOffset;
+        };
+
+        bool FetchRows(MYSQL_STMT *stmt);
+        void EndQuery();
+
+        std::vector<Column> mColumns;
+        std::vector<Cell> mCells;                           // row after row
+        std::vector<uint8> mNulls;
+        std::vector<char> mStrings;
+        uint64 mNextRow;
+        bool mValid;
+};
 #endif
 #endif
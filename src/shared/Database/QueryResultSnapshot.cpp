@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "QueryResultSnapshot.h"
+#include "Log.h"
+
+#include <ace/OS_NS_fcntl.h>
+#include <ace/OS_NS_sys_mman.h>
+#include <ace/OS_NS_unistd.h>
+
+uint32 const QueryResultSnapshot::Version;
+uint64 const QueryResultSnapshot::NullCell;
+
+QueryResultSnapshot* QueryResultSnapshot::Open(std::string const& fileName, uint64 contentHash)
+{
+    ACE_HANDLE handle = ACE_OS::open(fileName.c_str(), O_RDONLY);
+    if (handle == ACE_INVALID_HANDLE)
+        return nullptr;
+
+    ACE_OFF_T fileSize = ACE_OS::filesize(handle);
+    void* mapping = MAP_FAILED;
+    if (fileSize >= ACE_OFF_T(sizeof(QueryResultSnapshotHeader)))
+        mapping = ACE_OS::mmap(0, size_t(fileSize), PROT_READ, ACE_MAP_PRIVATE, handle);
+    ACE_OS::close(handle);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    char* data = static_cast<char*>(mapping);
+    uint64 size = uint64(fileSize);
+    QueryResultSnapshotHeader const* header = reinterpret_cast<QueryResultSnapshotHeader const*>(data);
+    uint64 cellsCount = header->rowCount * header->fieldCount;
+
+    // Stale or foreign snapshots are ignored, as well as truncated files
+    bool valid = memcmp(header->magic, "SQLQ", 4) == 0 &&
+                 header->version == Version &&
+                 header->contentHash == contentHash &&
+                 header->rowCount > 0 &&
+                 header->fieldCount > 0 &&
+                 header->cellsOffset == ((sizeof(QueryResultSnapshotHeader) + header->fieldCount + 7) & ~uint64(7)) &&
+                 header->cellsOffset + cellsCount * sizeof(uint64) == header->stringsOffset &&
+                 header->stringsOffset + header->stringsSize == size &&
+                 header->stringsSize > 0 && data[size - 1] == 0;
+
+    uint64 const* cells = valid ? reinterpret_cast<uint64 const*>(data + header->cellsOffset) : nullptr;
+    for (uint64 i = 0; valid && i < cellsCount; ++i)
+        valid = cells[i] == NullCell || cells[i] < header->stringsSize;
+
+    if (!valid)
+    {
+        ACE_OS::munmap(mapping, size_t(fileSize));
+        return nullptr;
+    }
+
+    return new QueryResultSnapshot(data, size_t(fileSize), header);
+}
+
+QueryResultSnapshot::QueryResultSnapshot(char* data, size_t size, QueryResultSnapshotHeader const* header) :
+    QueryResult(header->rowCount, header->fieldCount), mData(data), mSize(size), mNextRow(0)
+{
+    mCells = reinterpret_cast<uint64 const*>(data + header->cellsOffset);
+    mStrings = data + header->stringsOffset;
+
+    mCurrentRow = new Field[mFieldCount];
+    uint8 const* types = reinterpret_cast<uint8 const*>(data + sizeof(QueryResultSnapshotHeader));
+    for (uint32 i = 0; i < mFieldCount; ++i)
+        mCurrentRow[i].SetType(Field::DataTypes(types[i]));
+
+    // As the database results, on the first row
+    NextRow();
+}
+
+QueryResultSnapshot::~QueryResultSnapshot()
+{
+    EndQuery();
+}
+
+bool QueryResultSnapshot::NextRow()
+{
+    if (!mData)
+        return false;
+
+    if (mNextRow >= mRowCount)
+    {
+        EndQuery();
+        return false;
+    }
+
+    uint64 const* row = mCells + mNextRow * mFieldCount;
+    for (uint32 i = 0; i < mFieldCount; ++i)
+        mCurrentRow[i].SetValue(row[i] == NullCell ? nullptr : mStrings + row[i]);
+    ++mNextRow;
+
+    return true;
+}
+
+void QueryResultSnapshot::EndQuery()
+{
+    if (mCurrentRow)
+    {
+        delete [] mCurrentRow;
+        mCurrentRow = nullptr;
+    }
+
+    if (mData)
+    {
+        ACE_OS::munmap(mData, mSize);
+        mData = nullptr;
+    }
+}
+
+bool QueryResultSnapshot::Save(std::string const& fileName, uint64 contentHash, QueryResult* result)
+{
+    uint32 fieldCount = result->GetFieldCount();
+    std::vector<uint8> types(fieldCount);
+    for (uint32 i = 0; i < fieldCount; ++i)
+        types[i] = uint8((*result)[i].GetType());
+
+    // The values are kept as text, as received with the text protocol
+    std::vector<uint64> cells;
+    cells.reserve(result->GetRowCount() * fieldCount);
+    std::vector<char> strings;
+    do
+    {
+        Field* fields = result->Fetch();
+        for (uint32 i = 0; i < fieldCount; ++i)
+        {
+            char const* value = fields[i].GetString();
+            if (!value)
+            {
+                cells.push_back(NullCell);
+                continue;
+            }
+            cells.push_back(strings.size());
+            strings.insert(strings.end(), value, value + strlen(value) + 1);
+        }
+    }
+    while (result->NextRow());
+    // Never empty, so that the last byte of a valid file is always an ending '\0'
+    strings.push_back(0);
+
+    QueryResultSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "SQLQ", 4);
+    header.version = Version;
+    header.contentHash = contentHash;
+    header.rowCount = cells.size() / fieldCount;
+    header.fieldCount = fieldCount;
+    header.cellsOffset = (sizeof(header) + fieldCount + 7) & ~uint64(7);
+    header.stringsOffset = header.cellsOffset + cells.size() * sizeof(uint64);
+    header.stringsSize = strings.size();
+
+    // Written aside then renamed, so that a crash never leaves a partial snapshot
+    std::string tmpFileName = fileName + ".tmp";
+    FILE* file = fopen(tmpFileName.c_str(), "wb");
+    if (!file)
+    {
+        sLog.outError("QueryResultSnapshot: cannot write '%s'", tmpFileName.c_str());
+        return false;
+    }
+
+    static char const padding[8] = { 0 };
+    uint64 typesEnd = sizeof(header) + fieldCount;
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(&types[0], fieldCount, 1, file) == 1 &&
+                   (header.cellsOffset == typesEnd || fwrite(padding, size_t(header.cellsOffset - typesEnd), 1, file) == 1) &&
+                   fwrite(&cells[0], sizeof(uint64), cells.size(), file) == cells.size() &&
+                   fwrite(&strings[0], strings.size(), 1, file) == 1;
+    written = fclose(file) == 0 && written;
+
+    remove(fileName.c_str());
+    if (!written || rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+    {
+        sLog.outError("QueryResultSnapshot: cannot write '%s'", fileName.c_str());
+        remove(tmpFileName.c_str());
+        return false;
+    }
+    return true;
+}
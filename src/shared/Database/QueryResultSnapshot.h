@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUERYRESULT_SNAPSHOT_H
+#define QUERYRESULT_SNAPSHOT_H
+
+#include "Common.h"
+#include "QueryResult.h"
+
+/**
+ * Result of a query read back from its snapshot, for the loaders building their own containers
+ * from queries. The file is memory mapped, and the fields point in it: reading the rows neither
+ * queries the database nor allocates anything.
+ *
+ * File layout, all in the byte order of the server that wrote it:
+ *   QueryResultSnapshotHeader
+ *   field types                            (uint8 each)
+ *   cells                                  (aligned on 8 bytes, row after row, offset in the strings or NullCell)
+ *   strings                                (each with its ending '\0')
+ */
+struct QueryResultSnapshotHeader
+{
+    char magic[4];
+    uint32 version;
+    uint64 contentHash;
+    uint64 rowCount;
+    uint32 fieldCount;
+    uint32 reserved;
+    uint64 cellsOffset;
+    uint64 stringsOffset;
+    uint64 stringsSize;
+};
+
+class QueryResultSnapshot : public QueryResult
+{
+    public:
+        // The snapshot mapped, positioned on its first row. NULL if the file does not exist,
+        // or was not written from the same content.
+        static QueryResultSnapshot* Open(std::string const& fileName, uint64 contentHash);
+
+        // Writes the rows of the result, from its current row to its end
+        static bool Save(std::string const& fileName, uint64 contentHash, QueryResult* result);
+
+        ~QueryResultSnapshot();
+
+        bool NextRow();
+
+        static uint32 const Version = 1;
+
+    private:
+        QueryResultSnapshot(char* data, size_t size, QueryResultSnapshotHeader const* header);
+
+        void EndQuery();
+
+        static uint64 const NullCell = ~uint64(0);
+
+        char* mData;
+        size_t mSize;
+        uint64 const* mCells;
+        char const* mStrings;
+        uint64 mNextRow;
+};
+
+#endif
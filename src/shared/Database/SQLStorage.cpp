@@ -17,6 +17,13 @@
  */
 
 #include "SQLStorage.h"
+#include "SQLStorageSnapshot.h"
+#include "Log.h"
+
+#include <ace/OS_NS_fcntl.h>
+#include <ace/OS_NS_sys_mman.h>
+#include <ace/OS_NS_sys_stat.h>
+#include <ace/OS_NS_unistd.h>
 
 // -----------------------------------  SQLStorageBase  ---------------------------------------- //
 
@@ -30,7 +37,9 @@ SQLStorageBase::SQLStorageBase() :
     m_recordCount(0),
     m_maxEntry(0),
     m_recordSize(0),
-    m_data(nullptr)
+    m_data(nullptr),
+    m_mappedData(nullptr),
+    m_mappedSize(0)
 {}
 
 void SQLStorageBase::Initialize(const char* tableName, const char* entry_field, const char* src_format, const char* dst_format)
@@ -82,7 +91,12 @@ void SQLStorageBase::Free()
             case FT_STRING:
             {
                 for (uint32 recordItr = 0; recordItr < m_recordCount; ++recordItr)
-                    delete[] *(char**)((char*)(m_data + (recordItr * m_recordSize)) + offset);
+                {
+                    // The strings of a snapshot stay in its mapping
+                    char* value = *(char**)((char*)(m_data + (recordItr * m_recordSize)) + offset);
+                    if (!IsInSnapshot(value))
+                        delete[] value;
+                }
 
                 offset += sizeof(char*);
                 break;
@@ -115,11 +129,217 @@ void SQLStorageBase::Free()
                 break;
         }
     }
-    delete[] m_data;
+    if (m_mappedData)
+        ACE_OS::munmap(m_mappedData, m_mappedSize);
+    else
+        delete[] m_data;
     m_data = nullptr;
+    m_mappedData = nullptr;
+    m_mappedSize = 0;
     m_recordCount = 0;
 }
 
+void SQLStorageBase::GetStringFieldOffsets(std::vector<uint32>& offsets) const
+{
+    uint32 offset = 0;
+    for (uint32 x = 0; x < m_dstFieldCount; ++x)
+    {
+        switch (m_dst_format[x])
+        {
+            case FT_LOGIC:
+                offset += sizeof(bool);
+                break;
+            case FT_STRING:
+            case FT_NA_POINTER:
+                offsets.push_back(offset);
+                offset += sizeof(char*);
+                break;
+            case FT_NA:
+            case FT_INT:
+                offset += sizeof(uint32);
+                break;
+            case FT_BYTE:
+            case FT_NA_BYTE:
+                offset += sizeof(char);
+                break;
+            case FT_FLOAT:
+            case FT_NA_FLOAT:
+                offset += sizeof(float);
+                break;
+            case FT_64BITINT:
+                offset += sizeof(uint64);
+                break;
+            default:
+                assert(false && "unknown format character");
+                break;
+        }
+    }
+}
+
+bool SQLStorageBase::LoadSnapshot(uint64 contentHash, uint32 recordSize)
+{
+    std::string fileName = SQLStorageSnapshot::GetFileName(m_tableName);
+    ACE_HANDLE handle = ACE_OS::open(fileName.c_str(), O_RDONLY);
+    if (handle == ACE_INVALID_HANDLE)
+        return false;
+
+    // Private writable mapping: the records are fixed up, and later corrected by the loaders,
+    // in copy-on-write pages. The mapping stays valid once the file is closed.
+    ACE_OFF_T fileSize = ACE_OS::filesize(handle);
+    void* mapping = MAP_FAILED;
+    if (fileSize >= ACE_OFF_T(sizeof(SQLStorageSnapshotHeader)))
+        mapping = ACE_OS::mmap(0, size_t(fileSize), PROT_READ | PROT_WRITE, ACE_MAP_PRIVATE, handle);
+    ACE_OS::close(handle);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    char* data = static_cast<char*>(mapping);
+    uint64 size = uint64(fileSize);
+    SQLStorageSnapshotHeader const* header = reinterpret_cast<SQLStorageSnapshotHeader const*>(data);
+    uint32 srcFormatSize = m_srcFieldCount + 1;
+    uint32 dstFormatSize = m_dstFieldCount + 1;
+    uint64 formatsEnd = sizeof(SQLStorageSnapshotHeader) + srcFormatSize + dstFormatSize;
+
+    // Stale or foreign snapshots are ignored, as well as truncated files
+    bool valid = memcmp(header->magic, "SQLS", 4) == 0 &&
+                 header->version == SQLStorageSnapshot::Version &&
+                 header->contentHash == contentHash &&
+                 header->pointerSize == sizeof(char*) &&
+                 header->recordSize == recordSize &&
+                 header->srcFormatSize == srcFormatSize &&
+                 header->dstFormatSize == dstFormatSize &&
+                 formatsEnd <= size &&
+                 memcmp(data + sizeof(SQLStorageSnapshotHeader), m_src_format, srcFormatSize) == 0 &&
+                 memcmp(data + sizeof(SQLStorageSnapshotHeader) + srcFormatSize, m_dst_format, dstFormatSize) == 0 &&
+                 header->idsOffset >= formatsEnd &&
+                 header->idsOffset + uint64(header->recordCount) * sizeof(uint32) <= header->recordsOffset &&
+                 header->recordsOffset % 8 == 0 &&
+                 header->recordsOffset + uint64(header->recordCount) * recordSize <= header->stringsOffset &&
+                 header->stringsOffset + header->stringsSize == size &&
+                 header->stringsSize > 0 && data[size - 1] == 0;
+
+    uint32 const* ids = valid ? reinterpret_cast<uint32 const*>(data + header->idsOffset) : nullptr;
+    for (uint32 i = 0; valid && i < header->recordCount; ++i)
+        valid = ids[i] < header->maxEntry;
+
+    std::vector<uint32> stringFields;
+    GetStringFieldOffsets(stringFields);
+    char* records = data + header->recordsOffset;
+    for (uint32 i = 0; valid && i < header->recordCount; ++i)
+    {
+        for (std::vector<uint32>::const_iterator itr = stringFields.begin(); valid && itr != stringFields.end(); ++itr)
+        {
+            size_t stringOffset;
+            memcpy(&stringOffset, records + i * recordSize + *itr, sizeof(stringOffset));
+            valid = stringOffset < header->stringsSize;
+        }
+    }
+
+    if (!valid)
+    {
+        ACE_OS::munmap(mapping, size_t(fileSize));
+        return false;
+    }
+
+    // Index of the records, over the mapped records
+    prepareToLoad(header->maxEntry, 0, recordSize);
+    delete[] m_data;
+    m_data = records;
+    m_mappedData = data;
+    m_mappedSize = size_t(fileSize);
+    for (uint32 i = 0; i < header->recordCount; ++i)
+        createRecord(ids[i]);
+
+    // The string fields point in the mapped strings, the ones replaced later by the loaders are
+    // the only ones freed with the records
+    char* strings = data + header->stringsOffset;
+    for (uint32 i = 0; i < m_recordCount; ++i)
+    {
+        char* record = m_data + i * m_recordSize;
+        for (std::vector<uint32>::const_iterator itr = stringFields.begin(); itr != stringFields.end(); ++itr)
+        {
+            size_t stringOffset;
+            memcpy(&stringOffset, record + *itr, sizeof(stringOffset));
+            char* value = strings + stringOffset;
+            memcpy(record + *itr, &value, sizeof(value));
+        }
+    }
+
+    return true;
+}
+
+void SQLStorageBase::SaveSnapshot(uint64 contentHash, std::vector<uint32> const& recordIds) const
+{
+    MANGOS_ASSERT(recordIds.size() == m_recordCount);
+
+    std::vector<uint32> stringFields;
+    GetStringFieldOffsets(stringFields);
+
+    // String fields hold the offsets of their strings
+    std::vector<char> records(m_data, m_data + m_recordCount * m_recordSize);
+    std::vector<char> strings;
+    for (uint32 i = 0; i < m_recordCount; ++i)
+    {
+        char* record = &records[i * m_recordSize];
+        for (std::vector<uint32>::const_iterator itr = stringFields.begin(); itr != stringFields.end(); ++itr)
+        {
+            char const* value;
+            memcpy(&value, record + *itr, sizeof(value));
+            if (!value)
+                value = "";
+            size_t stringOffset = strings.size();
+            strings.insert(strings.end(), value, value + strlen(value) + 1);
+            memcpy(record + *itr, &stringOffset, sizeof(stringOffset));
+        }
+    }
+    // Never empty, so that the last byte of a valid file is always an ending '\0'
+    strings.push_back(0);
+
+    SQLStorageSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "SQLS", 4);
+    header.version = SQLStorageSnapshot::Version;
+    header.contentHash = contentHash;
+    header.pointerSize = sizeof(char*);
+    header.recordSize = m_recordSize;
+    header.recordCount = m_recordCount;
+    header.maxEntry = m_maxEntry;
+    header.srcFormatSize = m_srcFieldCount + 1;
+    header.dstFormatSize = m_dstFieldCount + 1;
+    header.idsOffset = sizeof(header) + header.srcFormatSize + header.dstFormatSize;
+    header.recordsOffset = (header.idsOffset + m_recordCount * sizeof(uint32) + 7) & ~uint64(7);
+    header.stringsOffset = header.recordsOffset + records.size();
+    header.stringsSize = strings.size();
+
+    // Written aside then renamed, so that a crash never leaves a partial snapshot
+    std::string fileName = SQLStorageSnapshot::GetFileName(m_tableName);
+    std::string tmpFileName = fileName + ".tmp";
+    FILE* file = fopen(tmpFileName.c_str(), "wb");
+    if (!file)
+    {
+        sLog.outError("SQLStorageSnapshot: cannot write '%s'", tmpFileName.c_str());
+        return;
+    }
+
+    static char const padding[8] = { 0 };
+    uint64 idsEnd = header.idsOffset + m_recordCount * sizeof(uint32);
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(m_src_format, header.srcFormatSize, 1, file) == 1 &&
+                   fwrite(m_dst_format, header.dstFormatSize, 1, file) == 1 &&
+                   (recordIds.empty() || fwrite(&recordIds[0], sizeof(uint32), recordIds.size(), file) == recordIds.size()) &&
+                   (header.recordsOffset == idsEnd || fwrite(padding, size_t(header.recordsOffset - idsEnd), 1, file) == 1) &&
+                   (records.empty() || fwrite(&records[0], records.size(), 1, file) == 1) &&
+                   fwrite(&strings[0], strings.size(), 1, file) == 1;
+    written = fclose(file) == 0 && written;
+
+    remove(fileName.c_str());
+    if (!written || rename(tmpFileName.c_str(), fileName.c_str()) != 0)
+    {
+        sLog.outError("SQLStorageSnapshot: cannot write '%s'", fileName.c_str());
+        remove(tmpFileName.c_str());
+    }
+}
+
 // -----------------------------------  SQLStorage  -------------------------------------------- //
 
 void SQLStorage::EraseEntry(uint32 id)
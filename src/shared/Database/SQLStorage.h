@@ -23,6 +23,8 @@
 #include "Database/DatabaseEnv.h"
 #include "DBCFileLoader.h"
 
+#include <vector>
+
 class SQLStorageBase
 {
         template<class DerivedLoader, class StorageClass> friend class SQLStorageLoaderBase;
@@ -80,8 +82,14 @@ class SQLStorageBase
         virtual void JustCreatedRecord(uint32 recordId, char* record) = 0;
         virtual void Free();
 
+        // Replaces the records by the ones of the snapshot, if it was taken from the same content
+        bool LoadSnapshot(uint64 contentHash, uint32 recordSize);
+        void SaveSnapshot(uint64 contentHash, std::vector<uint32> const& recordIds) const;
+
     private:
         char* createRecord(uint32 recordId);
+        void GetStringFieldOffsets(std::vector<uint32>& offsets) const;
+        bool IsInSnapshot(char const* p) const { return m_mappedData && p >= m_mappedData && p < m_mappedData + m_mappedSize; }
 
         // Information about the table
         const char* m_tableName;
@@ -98,6 +106,10 @@ class SQLStorageBase
 
         // Data Storage
         char* m_data;
+
+        // Snapshot holding m_data, when the records come from a snapshot
+        char* m_mappedData;
+        size_t m_mappedSize;
 };
 
 class SQLStorage : public SQLStorageBase
@@ -265,6 +277,8 @@ class SQLStorageLoaderBase
         template<class S, class D>
         void default_fill(uint32 field_pos, S src, D& dst);
         void default_fill_to_str(uint32 field_pos, char const* src, char*& dst);
+        // Changes when the conversions give other values from the same table content
+        uint32 snapshot_salt();
 
         // trap, no body
         template<class D>
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "SQLStorageSnapshot.h"
+#include "QueryResultSnapshot.h"
+#include "Database/DatabaseEnv.h"
+#include "Log.h"
+
+#include <ace/OS_NS_sys_stat.h>
+
+std::string SQLStorageSnapshot::m_directory;
+
+void SQLStorageSnapshot::SetDirectory(std::string const& directory)
+{
+    m_directory = directory;
+    if (m_directory.empty())
+        return;
+
+    if (m_directory.at(m_directory.length() - 1) != '/' && m_directory.at(m_directory.length() - 1) != '\\')
+        m_directory.append("/");
+
+    ACE_stat st;
+    if (ACE_OS::stat(m_directory.c_str(), &st) != 0 && ACE_OS::mkdir(m_directory.c_str()) != 0)
+    {
+        sLog.outError("SQLStorageSnapshot: cannot create the snapshot directory '%s', snapshots are disabled.", m_directory.c_str());
+        m_directory.clear();
+    }
+}
+
+std::string SQLStorageSnapshot::GetFileName(char const* table)
+{
+    return m_directory + table + ".snapshot";
+}
+
+// 64 bits FNV-1a
+static void HashBytes(uint64& hash, void const* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<uint8 const*>(data)[i];
+        hash *= UI64LIT(1099511628211);
+    }
+}
+
+uint64 SQLStorageSnapshot::GetContentHash(char const* tables, uint32 salt)
+{
+    // The checksums are computed by the server, without sending the rows
+    QueryResult* result = WorldDatabase.PQuery("CHECKSUM TABLE %s EXTENDED", tables);
+    if (!result)
+        return 0;
+
+    uint64 hash = UI64LIT(14695981039346656037);
+    do
+    {
+        // NULL for a missing table
+        Field* fields = result->Fetch();
+        if (fields[1].IsNULL())
+        {
+            delete result;
+            return 0;
+        }
+
+        uint64 checksum = fields[1].GetUInt64();
+        HashBytes(hash, &checksum, sizeof(checksum));
+    }
+    while (result->NextRow());
+    delete result;
+
+    HashBytes(hash, &salt, sizeof(salt));
+    return hash;
+}
+
+QueryResult* SQLStorageSnapshot::Query(char const* name, char const* tables, char const* sql)
+{
+    uint64 contentHash = 0;
+    if (IsEnabled())
+    {
+        uint64 sqlHash = UI64LIT(14695981039346656037);
+        HashBytes(sqlHash, sql, strlen(sql));
+        contentHash = GetContentHash(tables, uint32(sqlHash ^ (sqlHash >> 32)));
+    }
+    if (!contentHash)
+        return WorldDatabase.Query(sql);
+
+    std::string fileName = m_directory + name + ".query.snapshot";
+    if (QueryResult* result = QueryResultSnapshot::Open(fileName, contentHash))
+    {
+        sLog.outString("Query %s loaded from its snapshot", name);
+        return result;
+    }
+
+    QueryResult* result = WorldDatabase.Query(sql);
+    if (!result)
+        return nullptr;
+
+    // The rows are read back from the snapshot written, as at the next startup
+    bool saved = QueryResultSnapshot::Save(fileName, contentHash, result);
+    delete result;
+    if (saved)
+        if (QueryResult* snapshot = QueryResultSnapshot::Open(fileName, contentHash))
+            return snapshot;
+
+    return WorldDatabase.Query(sql);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SQLSTORAGE_SNAPSHOT_H
+#define SQLSTORAGE_SNAPSHOT_H
+
+#include "Common.h"
+
+class QueryResult;
+
+/**
+ * Binary snapshots of the SQLStorage tables. A snapshot holds the records of a table as
+ * they are right after the SQL load, and is written after each successful load. At the
+ * next load, the snapshot is memory mapped back into the storage, instead of querying
+ * the table, when it was taken from the same table content: same checksum of the table,
+ * and same conversion salt of the loader.
+ *
+ * File layout, all in the byte order and pointer size of the server that wrote it:
+ *   SQLStorageSnapshotHeader
+ *   source format, destination format      (each with its ending '\0')
+ *   record ids                             (uint32 each)
+ *   records                                (aligned on 8 bytes, string fields hold offsets in the strings)
+ *   strings                                (each with its ending '\0')
+ * Once mapped, the string fields point in the strings of the snapshot.
+ *
+ * The loaders building their own containers from queries read the rows of the queries from
+ * their snapshot instead, see QueryResultSnapshot.
+ */
+struct SQLStorageSnapshotHeader
+{
+    char magic[4];
+    uint32 version;
+    uint64 contentHash;
+    uint32 pointerSize;
+    uint32 recordSize;
+    uint32 recordCount;
+    uint32 maxEntry;
+    uint32 srcFormatSize;
+    uint32 dstFormatSize;
+    uint64 idsOffset;
+    uint64 recordsOffset;
+    uint64 stringsOffset;
+    uint64 stringsSize;
+};
+
+class SQLStorageSnapshot
+{
+    public:
+        // Directory of the snapshot files, empty to disable the snapshots
+        static void SetDirectory(std::string const& directory);
+        static bool IsEnabled() { return !m_directory.empty(); }
+
+        static std::string GetFileName(char const* table);
+
+        // Hash of the content of the tables (comma separated), mixed with the conversion salt of its loader.
+        // 0 when the database cannot compute it: the snapshot is not used then.
+        static uint64 GetContentHash(char const* tables, uint32 salt);
+
+        // Result of a world database query reading the given tables, from the snapshot 'name' when it
+        // was taken from the same content and query. Otherwise the query is run, and its snapshot written.
+        static QueryResult* Query(char const* name, char const* tables, char const* sql);
+
+        static uint32 const Version = 1;
+
+    private:
+        static std::string m_directory;
+};
+
+#endif
@@ -26,6 +26,7 @@
 #include "Util.h"
 #include "ByteBuffer.h"
 #include "ProgressBar.h"
+#include "LogWriter.h"
 
 #include <stdarg.h>
 #include <fstream>
@@ -57,7 +58,8 @@ LogFilterData logFilterData[LOG_FILTER_COUNT] =
 
 Log::Log() :
     logfile(nullptr), gmLogfile(nullptr), dberLogfile(nullptr),
-    wardenLogfile(nullptr), honorLogfile(nullptr), m_colored(false), m_includeTime(false), m_gmlog_per_account(false)
+    wardenLogfile(nullptr), honorLogfile(nullptr), m_writer(nullptr), m_reopenRequested(false),
+    m_colored(false), m_includeTime(false), m_gmlog_per_account(false)
 {
     for (int i = 0; i < LOG_MAX_FILES; ++i)
     {
@@ -67,6 +69,44 @@ Log::Log() :
     Initialize();
 }
 
+Log::~Log()
+{
+    // Lines still queued are written before the files are closed
+    delete m_writer;
+    m_writer = nullptr;
+
+    if( logfile != nullptr )
+        fclose(logfile);
+    logfile = nullptr;
+
+    if( gmLogfile != nullptr )
+        fclose(gmLogfile);
+    gmLogfile = nullptr;
+
+    if( dberLogfile != nullptr )
+        fclose(dberLogfile);
+    dberLogfile = nullptr;
+
+    if (worldLogfile != nullptr)
+        fclose(worldLogfile);
+    worldLogfile = nullptr;
+
+    if (nostalriusLogFile != nullptr)
+        fclose(nostalriusLogFile);
+    nostalriusLogFile = nullptr;
+
+    if (honorLogfile != nullptr)
+        fclose(honorLogfile);
+    honorLogfile = nullptr;
+
+    for (int i = 0; i < LOG_MAX_FILES; ++i)
+        if (logFiles[i] != nullptr)
+        {
+            fclose(logFiles[i]);
+            logFiles[i] = nullptr;
+        }
+}
+
 void Log::InitColors(const std::string& str)
 {
     if (str.empty())
@@ -258,6 +298,19 @@ void Log::Initialize()
 
     m_logsTimestamp = "_" + GetTimestampStr();
 
+    // Initialized again once the config is loaded: the previous writer writes its lines before it stops
+    delete m_writer;
+    m_writer = nullptr;
+    m_filePaths.clear();
+    if (sConfig.GetBoolDefault("LogAsync.Enable", true))
+    {
+        uint32 bufferSize = sConfig.GetIntDefault("LogAsync.BufferSize", 256) * 1024;
+        uint32 flushInterval = sConfig.GetIntDefault("LogAsync.FlushInterval", 100);
+        LogWriter::OverflowPolicy policy = sConfig.GetIntDefault("LogAsync.Overflow", LogWriter::LOG_OVERFLOW_BLOCK) == LogWriter::LOG_OVERFLOW_DROP ?
+            LogWriter::LOG_OVERFLOW_DROP : LogWriter::LOG_OVERFLOW_BLOCK;
+        m_writer = new LogWriter(bufferSize, flushInterval, policy);
+    }
+
     /// Open specific log files
     logfile = openLogFile("LogFile","LogTimestamp","w");
 
@@ -349,7 +402,15 @@ FILE* Log::openLogFile(char const* configFileName,char const* configTimeStampFla
             logfn += m_logsTimestamp;
     }
 
-    return fopen((m_logsDir+logfn).c_str(), mode);
+    std::string path = m_logsDir + logfn;
+    FILE* file = fopen(path.c_str(), mode);
+    if (!file)
+        return nullptr;
+
+    m_filePaths.push_back(std::make_pair(file, path));
+    if (m_writer)
+        m_writer->AddFile(file, path);
+    return file;
 }
 
 FILE* Log::openGmlogPerAccount(uint32 account)
@@ -362,6 +423,83 @@ FILE* Log::openGmlogPerAccount(uint32 account)
     return fopen(namebuf, "a");
 }
 
+void Log::outFile(FILE* file, bool timestamp, char const* prefix, char const* format, va_list ap)
+{
+    char buffer[4096];
+    std::size_t size = timestamp ? formatTimestamp(buffer, sizeof(buffer)) : 0;
+    std::size_t prefixSize = strlen(prefix);
+    memcpy(buffer + size, prefix, prefixSize);
+    size += prefixSize;
+
+    va_list copy;
+    va_copy(copy, ap);
+    int length = vsnprintf(buffer + size, sizeof(buffer) - size, format, copy);
+    va_end(copy);
+    if (length < 0)
+        return;
+
+    // Keeps room for the end of line
+    if (size + length + 1 < sizeof(buffer))
+    {
+        buffer[size + length] = '\n';
+        writeFile(file, buffer, size + length + 1);
+        return;
+    }
+
+    std::string line(buffer, size);
+    line.resize(size + length + 1);
+    vsnprintf(&line[size], length + 1, format, ap);
+    line[size + length] = '\n';
+    writeFile(file, line.data(), line.size());
+}
+
+void Log::outFileString(FILE* file, char const* str)
+{
+    char buffer[32];
+    std::string line(buffer, formatTimestamp(buffer, sizeof(buffer)));
+    line += str;
+    line += '\n';
+    writeFile(file, line.data(), line.size());
+}
+
+void Log::writeFile(FILE* file, char const* line, std::size_t size)
+{
+    if (m_writer)
+    {
+        m_writer->Write(file, line, size);
+        return;
+    }
+
+    if (m_reopenRequested.exchange(false))
+        for (std::vector<std::pair<FILE*, std::string> >::const_iterator itr = m_filePaths.begin(); itr != m_filePaths.end(); ++itr)
+            LogWriter::ReopenFile(itr->first, itr->second);
+
+    fwrite(line, 1, size, file);
+    fflush(file);
+}
+
+void Log::ReopenFiles()
+{
+    if (m_writer)
+        m_writer->RequestReopen();
+    else
+        m_reopenRequested = true;
+}
+
+void Log::Flush()
+{
+    if (m_writer)
+        m_writer->FlushNow();
+}
+
+std::size_t Log::formatTimestamp(char* buffer, std::size_t size)
+{
+    time_t t = time(nullptr);
+    tm* aTm = localtime(&t);
+    int length = snprintf(buffer, size, "%-4d-%02d-%02d %02d:%02d:%02d ",aTm->tm_year+1900,aTm->tm_mon+1,aTm->tm_mday,aTm->tm_hour,aTm->tm_min,aTm->tm_sec);
+    return length < 0 ? 0 : std::min<std::size_t>(length, size - 1);
+}
+
 void Log::outTimestamp(FILE* file)
 {
     time_t t = time(nullptr);
@@ -409,11 +547,7 @@ void Log::outString()
         outTime(stdout);
     printf( "\n" );
     if (logfile)
-    {
-        outTimestamp(logfile);
-        fprintf(logfile, "\n" );
-        fflush(logfile);
-    }
+        outFileString(logfile, "");
 
     fflush(stdout);
 }
@@ -442,14 +576,9 @@ void Log::outString( const char * str, ... )
 
     if (logfile)
     {
-        outTimestamp(logfile);
-
         va_start(ap, str);
-        vfprintf(logfile, str, ap);
-        fprintf(logfile, "\n" );
+        outFile(logfile, true, "", str, ap);
         va_end(ap);
-
-        fflush(logfile);
     }
 
     fflush(stdout);
@@ -467,15 +596,9 @@ void Log::outInfo( const char * str, ...)
     printf ("\n");
     if (nostalriusLogFile)
     {
-        outTimestamp(nostalriusLogFile);
-
         va_start(ap, str);
-        vfprintf(nostalriusLogFile, str, ap);
-        fprintf(nostalriusLogFile, "\n");
-        fflush(nostalriusLogFile);
+        outFile(nostalriusLogFile, true, "", str, ap);
         va_end(ap);
-
-        fflush(nostalriusLogFile);
     }
     fflush(stdout);
 }
@@ -508,17 +631,10 @@ void Log::outHonor(const char *str, ...)
 
     if (honorLogfile)
     {
-        outTimestamp(honorLogfile);
-        fprintf(honorLogfile, "%s", "");
-
         va_list ap;
-
         va_start(ap, str);
-        vfprintf(honorLogfile, str, ap);
+        outFile(honorLogfile, true, "", str, ap);
         va_end(ap);
-
-        fprintf(honorLogfile, "\n" );
-        fflush(honorLogfile);
     }
 }
 
@@ -530,17 +646,10 @@ void Log::out(LogFile type, const char* str, ...)
 
     if (logFiles[type])
     {
-        if (timestampPrefix[type])
-            outTimestamp(logFiles[type]);
-
         va_list ap;
         va_start(ap, str);
-        vfprintf(logFiles[type], str, ap);
-        fprintf(logFiles[type], "\n");
-        fflush(logFiles[type]);
+        outFile(logFiles[type], timestampPrefix[type], "", str, ap);
         va_end(ap);
-
-        fflush(logFiles[type]);
     }
     fflush(stdout);
 }
@@ -568,15 +677,9 @@ void Log::outError( const char * err, ... )
     fprintf( stderr, "\n" );
     if (logfile)
     {
-        outTimestamp(logfile);
-        fprintf(logfile, "ERROR:" );
-
         va_start(ap, err);
-        vfprintf(logfile, err, ap);
+        outFile(logfile, true, "ERROR:", err, ap);
         va_end(ap);
-
-        fprintf(logfile, "\n" );
-        fflush(logfile);
     }
 
     fflush(stderr);
@@ -590,18 +693,10 @@ void Log::outErrorDb()
     fprintf( stderr, "\n" );
 
     if (logfile)
-    {
-        outTimestamp(logfile);
-        fprintf(logfile, "ERROR:\n" );
-        fflush(logfile);
-    }
+        outFileString(logfile, "ERROR:");
 
     if (dberLogfile)
-    {
-        outTimestamp(dberLogfile);
-        fprintf(dberLogfile, "\n" );
-        fflush(dberLogfile);
-    }
+        outFileString(dberLogfile, "");
 
     fflush(stderr);
 }
@@ -630,28 +725,16 @@ void Log::outErrorDb( const char * err, ... )
 
     if (logfile)
     {
-        outTimestamp(logfile);
-        fprintf(logfile, "ERROR:" );
-
         va_start(ap, err);
-        vfprintf(logfile, err, ap);
+        outFile(logfile, true, "ERROR:", err, ap);
         va_end(ap);
-
-        fprintf(logfile, "\n" );
-        fflush(logfile);
     }
 
     if (dberLogfile)
     {
-        outTimestamp(dberLogfile);
-
-        va_list ap;
         va_start(ap, err);
-        vfprintf(dberLogfile, err, ap);
+        outFile(dberLogfile, true, "", err, ap);
         va_end(ap);
-
-        fprintf(dberLogfile, "\n" );
-        fflush(dberLogfile);
     }
 
     fflush(stderr);
@@ -684,12 +767,9 @@ void Log::outBasic( const char * str, ... )
     if (logfile && m_logFileLevel >= LOG_LVL_BASIC)
     {
         va_list ap;
-        outTimestamp(logfile);
         va_start(ap, str);
-        vfprintf(logfile, str, ap);
-        fprintf(logfile, "\n" );
+        outFile(logfile, true, "", str, ap);
         va_end(ap);
-        fflush(logfile);
     }
 
     fflush(stdout);
@@ -722,15 +802,10 @@ void Log::outDetail( const char * str, ... )
 
     if (logfile && m_logFileLevel >= LOG_LVL_DETAIL)
     {
-        outTimestamp(logfile);
-
         va_list ap;
         va_start(ap, str);
-        vfprintf(logfile, str, ap);
+        outFile(logfile, true, "", str, ap);
         va_end(ap);
-
-        fprintf(logfile, "\n" );
-        fflush(logfile);
     }
 
     fflush(stdout);
@@ -762,15 +837,10 @@ void Log::outDebug( const char * str, ... )
 
     if (logfile && m_logFileLevel >= LOG_LVL_DEBUG)
     {
-        outTimestamp(logfile);
-
         va_list ap;
         va_start(ap, str);
-        vfprintf(logfile, str, ap);
+        outFile(logfile, true, "", str, ap);
         va_end(ap);
-
-        fprintf(logfile, "\n" );
-        fflush(logfile);
     }
 
     fflush(stdout);
@@ -800,15 +870,10 @@ void Log::outWarden(const char *wrd, ...)
 
     if (wardenLogfile)
     {
-        outTimestamp(wardenLogfile);
-
         va_list ap;
         va_start(ap, wrd);
-        vfprintf(wardenLogfile, wrd, ap);
+        outFile(wardenLogfile, true, "", wrd, ap);
         va_end(ap);
-
-        fprintf(wardenLogfile, "\n");
-        fflush(wardenLogfile);
     }
 
     fflush(stdout);
@@ -841,12 +906,9 @@ void Log::outCommand( uint32 account, const char * str, ... )
     if (logfile && m_logFileLevel >= LOG_LVL_DETAIL)
     {
         va_list ap;
-        outTimestamp(logfile);
         va_start(ap, str);
-        vfprintf(logfile, str, ap);
-        fprintf(logfile, "\n" );
+        outFile(logfile, true, "", str, ap);
         va_end(ap);
-        fflush(logfile);
     }
 
     if (m_gmlog_per_account)
@@ -865,12 +927,9 @@ void Log::outCommand( uint32 account, const char * str, ... )
     else if (gmLogfile)
     {
         va_list ap;
-        outTimestamp(gmLogfile);
         va_start(ap, str);
-        vfprintf(gmLogfile, str, ap);
-        fprintf(gmLogfile, "\n" );
+        outFile(gmLogfile, true, "", str, ap);
         va_end(ap);
-        fflush(gmLogfile);
     }
 
     fflush(stdout);
@@ -881,23 +940,33 @@ void Log::outWorldPacketDump( uint64 socket, uint32 opcode, char const* opcodeNa
     if (!worldLogfile)
         return;
 
-    outTimestamp(worldLogfile);
-
-    fprintf(worldLogfile,"\n%s:\nSOCKET: %llu\nLENGTH: %zu\nOPCODE: %s (0x%.4X)\nDATA:\n",
+    // Written at once, the dump must not be mixed with the other lines
+    char buffer[256];
+    std::size_t size = formatTimestamp(buffer, sizeof(buffer));
+    std::string dump(buffer, size);
+    snprintf(buffer, sizeof(buffer), "\n%s:\nSOCKET: %llu\nLENGTH: %zu\nOPCODE: %s (0x%.4X)\nDATA:\n",
         incoming ? "CLIENT" : "SERVER",
         socket, packet->size(), opcodeName, opcode);
+    dump += buffer;
 
+    static char const hexDigits[] = "0123456789ABCDEF";
+    dump.reserve(dump.size() + packet->size() * 3 + packet->size() / 16 + 3);
     size_t p = 0;
     while (p < packet->size())
     {
         for (size_t j = 0; j < 16 && p < packet->size(); ++j)
-            fprintf(worldLogfile, "%.2X ", (*packet)[p++]);
+        {
+            uint8 value = (*packet)[p++];
+            dump += hexDigits[value >> 4];
+            dump += hexDigits[value & 0x0F];
+            dump += ' ';
+        }
 
-        fprintf(worldLogfile, "\n");
+        dump += '\n';
     }
 
-    fprintf(worldLogfile, "\n\n");
-    fflush(worldLogfile);
+    dump += "\n\n";
+    writeFile(worldLogfile, dump.data(), dump.size());
 }
 
 void Log::WaitBeforeContinueIfNeed()
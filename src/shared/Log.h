@@ -24,9 +24,14 @@
 
 #include "Common.h"
 #include "Policies/Singleton.h"
+#include <atomic>
+#include <cstdarg>
+#include <utility>
+#include <vector>
 
 class Config;
 class ByteBuffer;
+class LogWriter;
 
 enum LogLevel
 {
@@ -123,39 +128,8 @@ class Log : public MaNGOS::Singleton<Log, MaNGOS::ClassLevelLockable<Log, ACE_Th
     friend class MaNGOS::OperatorNew<Log>;
     Log();
 
-    ~Log()
-    {
-        if( logfile != nullptr )
-            fclose(logfile);
-        logfile = nullptr;
-
-        if( gmLogfile != nullptr )
-            fclose(gmLogfile);
-        gmLogfile = nullptr;
-
-        if( dberLogfile != nullptr )
-            fclose(dberLogfile);
-        dberLogfile = nullptr;
-
-        if (worldLogfile != nullptr)
-            fclose(worldLogfile);
-        worldLogfile = nullptr;
-
-        if (nostalriusLogFile != nullptr)
-            fclose(nostalriusLogFile);
-        nostalriusLogFile = nullptr;
-
-        if (honorLogfile != nullptr)
-            fclose(honorLogfile);
-        honorLogfile = nullptr;
-
-        for (int i = 0; i < LOG_MAX_FILES; ++i)
-            if (logFiles[i] != nullptr)
-            {
-                fclose(logFiles[i]);
-                logFiles[i] = nullptr;
-            }
-    }
+    ~Log();
+
     public:
         void Initialize();
         void InitColors(const std::string& init_str);
@@ -201,6 +175,12 @@ class Log : public MaNGOS::Singleton<Log, MaNGOS::ClassLevelLockable<Log, ACE_Th
 
         static void WaitBeforeContinueIfNeed();
 
+        // Reopens the log files at their path, after an external rotation. Async signal safe:
+        // only requests the reopen, done by the writer thread (or at the next write without it).
+        void ReopenFiles();
+        // Writes the lines queued for the log writer thread. Crash handlers.
+        void Flush();
+
         std::list<uint32> m_smartlogExtraEntries;
         std::list<uint32> m_smartlogExtraGuids;
 
@@ -208,6 +188,12 @@ class Log : public MaNGOS::Singleton<Log, MaNGOS::ClassLevelLockable<Log, ACE_Th
         FILE* openLogFile(char const* configFileName,char const* configTimeStampFlag, char const* mode);
         FILE* openGmlogPerAccount(uint32 account);
 
+        // Formats the whole line (timestamp, prefix, message and end of line) before writing it
+        void outFile(FILE* file, bool timestamp, char const* prefix, char const* format, va_list ap);
+        void outFileString(FILE* file, char const* str);
+        void writeFile(FILE* file, char const* line, std::size_t size);
+        static std::size_t formatTimestamp(char* buffer, std::size_t size);
+
         FILE* logfile;
         FILE* gmLogfile;
         FILE* dberLogfile;
@@ -218,6 +204,10 @@ class Log : public MaNGOS::Singleton<Log, MaNGOS::ClassLevelLockable<Log, ACE_Th
         FILE* logFiles[LOG_MAX_FILES];
         bool  timestampPrefix[LOG_MAX_FILES];
 
+        LogWriter* m_writer;                                // null when the files are written by the logging threads
+        std::vector<std::pair<FILE*, std::string> > m_filePaths;
+        std::atomic<bool> m_reopenRequested;
+
         bool m_bIsChatLogFileActivated;
 
         // log/console control
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "LogWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    // Header of a line in a thread buffer, followed by the line itself. A header without file
+    // marks the end of the buffer, skipped by the writer.
+    struct RecordHeader
+    {
+        FILE* file;
+        uint64 sequence;
+        uint32 size;
+        uint32 unused;
+    };
+
+    std::size_t const RECORD_ALIGN = 8;
+
+    std::size_t AlignRecord(std::size_t size)
+    {
+        return (size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+    }
+
+    std::atomic<uint32> s_nextWriterId(1);
+}
+
+// Single producer (the logging thread), single consumer (the drain) ring. Positions only grow,
+// the offset in 'data' is position % capacity. A record never wraps: when it does not fit before
+// the end of the buffer, the end is skipped.
+struct LogWriter::Buffer
+{
+    explicit Buffer(uint32 size) : data(new char[size]), capacity(size), head(0), tail(0), closed(false) {}
+
+    std::unique_ptr<char[]> data;
+    uint32 const capacity;
+    std::atomic<uint64> head;                               // written by the logging thread
+    std::atomic<uint64> tail;                               // written by the drain
+    std::atomic<bool> closed;                               // the logging thread exited, no more lines
+};
+
+struct LogWriter::ThreadBuffer
+{
+    ThreadBuffer() : writerId(0) {}
+    ~ThreadBuffer()
+    {
+        if (buffer)
+            buffer->closed.store(true, std::memory_order_release);
+    }
+
+    uint32 writerId;
+    std::shared_ptr<Buffer> buffer;
+};
+
+struct LogWriter::Record
+{
+    uint64 sequence;
+    FILE* file;
+    std::size_t offset;                                     // in m_batch
+    std::size_t size;
+};
+
+thread_local LogWriter::ThreadBuffer LogWriter::t_threadBuffer;
+
+LogWriter::LogWriter(uint32 bufferSize, uint32 flushIntervalMs, OverflowPolicy policy) :
+    m_id(s_nextWriterId++),
+    m_bufferSize(std::max<uint32>(AlignRecord(bufferSize), 4096)),
+    m_flushIntervalMs(std::max<uint32>(flushIntervalMs, 1)),
+    m_policy(policy),
+    m_nextSequence(0), m_written(0), m_dropped(0), m_direct(0), m_batches(0),
+    m_stop(false), m_wakeRequested(false), m_reopenRequested(false)
+{
+    m_thread = std::thread(&LogWriter::Work, this);
+}
+
+LogWriter::~LogWriter()
+{
+    m_stop = true;
+    Wake();
+    m_thread.join();
+
+    if (uint64 dropped = m_dropped)
+        fprintf(stderr, "LogWriter: %llu log lines dropped, buffers were full.\n", (unsigned long long)dropped);
+}
+
+void LogWriter::Write(FILE* file, char const* line, std::size_t size)
+{
+    // Long lines (packet dumps) would fill the buffers at once
+    if (AlignRecord(sizeof(RecordHeader) + size) > m_bufferSize / 4)
+    {
+        ++m_direct;
+        fwrite(line, 1, size, file);
+        fflush(file);
+        return;
+    }
+
+    Buffer* buffer = GetThreadBuffer();
+    while (!Push(*buffer, file, line, size))
+    {
+        if (m_policy == LOG_OVERFLOW_DROP || m_stop)
+        {
+            ++m_dropped;
+            return;
+        }
+
+        Wake();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void LogWriter::AddFile(FILE* file, std::string const& path)
+{
+    std::lock_guard<std::mutex> guard(m_filesLock);
+    m_files.push_back(std::make_pair(file, path));
+}
+
+void LogWriter::FlushNow()
+{
+    // The writer thread may be the one crashing, with the lock: give up after a few ms
+    std::unique_lock<std::mutex> guard(m_drainLock, std::defer_lock);
+    for (int i = 0; i < 50 && !guard.try_lock(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    if (guard.owns_lock())
+        Drain();
+}
+
+void LogWriter::GetStats(Stats& stats) const
+{
+    stats.written = m_written;
+    stats.dropped = m_dropped;
+    stats.direct = m_direct;
+    stats.batches = m_batches;
+}
+
+bool LogWriter::ReopenFile(FILE* file, std::string const& path)
+{
+    // freopen closes the file even when it fails
+    if (FILE* check = fopen(path.c_str(), "a"))
+        fclose(check);
+    else
+        return false;
+
+    fflush(file);
+    return freopen(path.c_str(), "a", file) != NULL;
+}
+
+LogWriter::Buffer* LogWriter::GetThreadBuffer()
+{
+    ThreadBuffer& threadBuffer = t_threadBuffer;
+    if (threadBuffer.writerId != m_id)
+    {
+        if (threadBuffer.buffer)
+            threadBuffer.buffer->closed.store(true, std::memory_order_release);
+
+        threadBuffer.buffer = std::make_shared<Buffer>(m_bufferSize);
+        threadBuffer.writerId = m_id;
+
+        std::lock_guard<std::mutex> guard(m_buffersLock);
+        m_buffers.push_back(threadBuffer.buffer);
+    }
+
+    return threadBuffer.buffer.get();
+}
+
+void LogWriter::Wake()
+{
+    m_wakeRequested = true;
+    m_wake.notify_one();
+}
+
+bool LogWriter::Push(Buffer& buffer, FILE* file, char const* line, std::size_t size)
+{
+    std::size_t const needed = AlignRecord(sizeof(RecordHeader) + size);
+    uint64 head = buffer.head.load(std::memory_order_relaxed);
+    std::size_t offset = head % buffer.capacity;
+    std::size_t const contiguous = buffer.capacity - offset;
+    std::size_t const total = contiguous < needed ? contiguous + needed : needed;
+    if (total > buffer.capacity - (head - buffer.tail.load(std::memory_order_acquire)))
+        return false;
+
+    if (contiguous < needed)
+    {
+        if (contiguous >= sizeof(RecordHeader))
+        {
+            RecordHeader const end = { NULL, 0, 0, 0 };
+            memcpy(buffer.data.get() + offset, &end, sizeof(end));
+        }
+        head += contiguous;
+        offset = 0;
+    }
+
+    RecordHeader const header = { file, m_nextSequence++, uint32(size), 0 };
+    memcpy(buffer.data.get() + offset, &header, sizeof(header));
+    memcpy(buffer.data.get() + offset + sizeof(header), line, size);
+    buffer.head.store(head + needed, std::memory_order_release);
+
+    // Do not wait for the flush interval when the buffer is getting full
+    if (head + needed - buffer.tail.load(std::memory_order_relaxed) > buffer.capacity / 2 && !m_wakeRequested)
+        Wake();
+
+    return true;
+}
+
+void LogWriter::Work()
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> guard(m_wakeLock);
+            m_wake.wait_for(guard, std::chrono::milliseconds(m_flushIntervalMs), [this] { return m_wakeRequested.load(); });
+        }
+        m_wakeRequested = false;
+        bool const stop = m_stop;
+
+        {
+            std::lock_guard<std::mutex> guard(m_drainLock);
+            Drain();
+        }
+
+        if (m_reopenRequested.exchange(false))
+            ReopenFiles();
+
+        // The last drain is done after the stop request, nothing is written after it
+        if (stop)
+            break;
+    }
+}
+
+void LogWriter::Drain()
+{
+    std::vector<std::shared_ptr<Buffer> > buffers;
+    {
+        std::lock_guard<std::mutex> guard(m_buffersLock);
+        buffers = m_buffers;
+    }
+
+    m_batch.clear();
+    m_records.clear();
+    bool closedBuffers = false;
+    for (std::vector<std::shared_ptr<Buffer> >::const_iterator itr = buffers.begin(); itr != buffers.end(); ++itr)
+    {
+        Buffer& buffer = **itr;
+        // Read before the head: once closed, the head does not move anymore
+        bool const closed = buffer.closed.load(std::memory_order_acquire);
+        uint64 tail = buffer.tail.load(std::memory_order_relaxed);
+        uint64 const head = buffer.head.load(std::memory_order_acquire);
+        while (tail < head)
+        {
+            std::size_t const offset = tail % buffer.capacity;
+            std::size_t const contiguous = buffer.capacity - offset;
+            if (contiguous < sizeof(RecordHeader))
+            {
+                tail += contiguous;
+                continue;
+            }
+
+            RecordHeader header;
+            memcpy(&header, buffer.data.get() + offset, sizeof(header));
+            if (!header.file)
+            {
+                tail += contiguous;
+                continue;
+            }
+
+            char const* line = buffer.data.get() + offset + sizeof(header);
+            Record const record = { header.sequence, header.file, m_batch.size(), header.size };
+            m_batch.insert(m_batch.end(), line, line + header.size);
+            m_records.push_back(record);
+            tail += AlignRecord(sizeof(header) + header.size);
+        }
+        buffer.tail.store(tail, std::memory_order_release);
+        closedBuffers |= closed;
+    }
+
+    if (closedBuffers)
+    {
+        std::lock_guard<std::mutex> guard(m_buffersLock);
+        m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), [](std::shared_ptr<Buffer> const& buffer)
+        {
+            return buffer->closed.load(std::memory_order_acquire) && buffer->tail == buffer->head;
+        }), m_buffers.end());
+    }
+
+    if (m_records.empty())
+        return;
+
+    std::sort(m_records.begin(), m_records.end(), [](Record const& a, Record const& b) { return a.sequence < b.sequence; });
+
+    std::vector<FILE*> files;
+    for (std::vector<Record>::const_iterator itr = m_records.begin(); itr != m_records.end(); ++itr)
+    {
+        fwrite(&m_batch[itr->offset], 1, itr->size, itr->file);
+        if (std::find(files.begin(), files.end(), itr->file) == files.end())
+            files.push_back(itr->file);
+    }
+    for (std::vector<FILE*>::const_iterator itr = files.begin(); itr != files.end(); ++itr)
+        fflush(*itr);
+
+    m_written += m_records.size();
+    ++m_batches;
+}
+
+void LogWriter::ReopenFiles()
+{
+    std::lock_guard<std::mutex> guard(m_filesLock);
+    for (std::vector<std::pair<FILE*, std::string> >::const_iterator itr = m_files.begin(); itr != m_files.end(); ++itr)
+        if (!ReopenFile(itr->first, itr->second))
+            fprintf(stderr, "LogWriter: unable to reopen log file %s.\n", itr->second.c_str());
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_LOG_WRITER_H
+#define MANGOS_LOG_WRITER_H
+
+#include "Platform/Define.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Background writer of the log files. A thread writing logs formats its lines itself, and
+ * pushes them without lock in a ring buffer of its own. The writer thread drains the buffers
+ * of all the threads every flush interval (or sooner when one is half full), writes the lines
+ * in the order they were logged, and flushes each file once per batch.
+ *
+ * The files are only written by the writer thread, which also reopens them when asked to,
+ * after an external rotation.
+ */
+class LogWriter
+{
+    public:
+        enum OverflowPolicy
+        {
+            LOG_OVERFLOW_DROP   = 0,                        // the line is lost
+            LOG_OVERFLOW_BLOCK  = 1                         // the logging thread waits for the writer
+        };
+
+        struct Stats
+        {
+            uint64 written;
+            uint64 dropped;
+            uint64 direct;                                  // too long for the buffers, written by the logging thread
+            uint64 batches;
+        };
+
+        // bufferSize is the size of the buffer of each logging thread, in bytes
+        LogWriter(uint32 bufferSize, uint32 flushIntervalMs, OverflowPolicy policy);
+        // Writes the lines left, then stops the writer thread
+        ~LogWriter();
+
+        // Logging threads. 'line' is complete, with its end of line.
+        void Write(FILE* file, char const* line, std::size_t size);
+
+        // The files are reopened at 'path' by the writer thread, at its next batch
+        void AddFile(FILE* file, std::string const& path);
+        // Async signal safe: only requests the writer thread to reopen the files
+        void RequestReopen() { m_reopenRequested = true; m_wakeRequested = true; }
+
+        // Writes the queued lines from the calling thread, without waiting for the writer
+        // thread more than a few ms. Used by the crash handlers, before the process dies.
+        void FlushNow();
+
+        void GetStats(Stats& stats) const;
+
+        // Reopens the file at 'path', keeping the same FILE object. Fails without closing it
+        // if the path cannot be opened.
+        static bool ReopenFile(FILE* file, std::string const& path);
+
+    private:
+        LogWriter(LogWriter const&);
+        LogWriter& operator=(LogWriter const&);
+
+        struct Buffer;
+        struct ThreadBuffer;
+        struct Record;
+
+        Buffer* GetThreadBuffer();
+        void Wake();
+        bool Push(Buffer& buffer, FILE* file, char const* line, std::size_t size);
+        void Work();
+        // Writes the lines queued in all the buffers. Called with m_drainLock.
+        void Drain();
+        void ReopenFiles();
+
+        static thread_local ThreadBuffer t_threadBuffer;
+
+        uint32 const m_id;                                  // identifies the writer in the thread buffers, never reused
+        uint32 const m_bufferSize;
+        uint32 const m_flushIntervalMs;
+        OverflowPolicy const m_policy;
+
+        std::mutex m_buffersLock;                           // m_buffers list, not its content
+        std::vector<std::shared_ptr<Buffer> > m_buffers;
+        std::mutex m_drainLock;
+        std::vector<char> m_batch;                          // lines of a drain, with m_drainLock
+        std::vector<Record> m_records;
+
+        std::mutex m_filesLock;
+        std::vector<std::pair<FILE*, std::string> > m_files;
+
+        std::atomic<uint64> m_nextSequence;
+        std::atomic<uint64> m_written;
+        std::atomic<uint64> m_dropped;
+        std::atomic<uint64> m_direct;
+        std::atomic<uint64> m_batches;
+
+        std::atomic<bool> m_stop;
+        std::atomic<bool> m_wakeRequested;
+        std::atomic<bool> m_reopenRequested;
+        std::mutex m_wakeLock;
+        std::condition_variable m_wake;
+        std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ScratchArena.h"
+#include <atomic>
+
+#define SCRATCH_ARENA_FIRST_CHUNK_SIZE  (16 * 1024)
+
+namespace
+{
+    std::atomic<uint64> s_heapAllocations(0);
+    std::atomic<uint64> s_reservedBytes(0);
+}
+
+ScratchArena::Scope::Scope() : m_arena(ScratchArena::Instance())
+{
+    ++m_arena.m_depth;
+}
+
+ScratchArena::Scope::~Scope()
+{
+    if (--m_arena.m_depth == 0)
+        m_arena.Rewind();
+}
+
+ScratchArena& ScratchArena::Instance()
+{
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+ScratchArena::~ScratchArena()
+{
+    for (std::vector<Chunk>::iterator itr = m_chunks.begin(); itr != m_chunks.end(); ++itr)
+    {
+        s_reservedBytes -= itr->size;
+        ::operator delete(itr->data);
+    }
+}
+
+void* ScratchArena::Allocate(std::size_t size, std::size_t alignment)
+{
+    if (m_current < m_chunks.size())
+    {
+        Chunk const& chunk = m_chunks[m_current];
+        std::size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= chunk.size)
+        {
+            m_offset = offset + size;
+            return chunk.data + offset;
+        }
+
+        // Next chunk large enough. The chunks skipped are used again after the rewind.
+        while (++m_current < m_chunks.size() && m_chunks[m_current].size < size)
+            ;
+    }
+
+    if (m_current >= m_chunks.size())
+    {
+        // Chunks are allocated aligned for any type, each twice as large as the previous one
+        std::size_t chunkSize = m_chunks.empty() ? SCRATCH_ARENA_FIRST_CHUNK_SIZE : m_chunks.back().size * 2;
+        while (chunkSize < size)
+            chunkSize *= 2;
+
+        Chunk chunk;
+        chunk.data = static_cast<char*>(::operator new(chunkSize));
+        chunk.size = chunkSize;
+        m_chunks.push_back(chunk);
+        m_current = m_chunks.size() - 1;
+        ++s_heapAllocations;
+        s_reservedBytes += chunkSize;
+    }
+
+    m_offset = size;
+    return m_chunks[m_current].data;
+}
+
+void ScratchArena::Deallocate(void* ptr, std::size_t size)
+{
+    // Vectors growing give their previous buffer back right after the allocation of the new
+    // one, so only a buffer freed without any allocation since can be reused.
+    if (m_current < m_chunks.size() && static_cast<char*>(ptr) + size == m_chunks[m_current].data + m_offset)
+        m_offset -= size;
+}
+
+uint64 ScratchArena::GetHeapAllocations()
+{
+    return s_heapAllocations;
+}
+
+uint64 ScratchArena::GetReservedBytes()
+{
+    return s_reservedBytes;
+}
+
+void ScratchArena::CountHeapAllocation()
+{
+    ++s_heapAllocations;
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_SCRATCHARENA_H
+#define MANGOS_SCRATCHARENA_H
+
+#include "Platform/Define.h"
+#include <cstddef>
+#include <list>
+#include <new>
+#include <vector>
+
+/**
+ * Per thread bump allocator for the short lived containers of an update: the lists filled
+ * by the grid searchers, the objects of a cell to update... The memory is taken from chunks
+ * kept by the thread from one update to the next, and is given back all at once when the
+ * outermost Scope of the thread ends. Nested scopes do not rewind: a container of an outer
+ * scope may still grow inside them.
+ *
+ * The containers using it must be created inside a Scope, not outlive it, and stay on the
+ * thread that created them. Created outside of any scope, they use the heap.
+ */
+class ScratchArena
+{
+    public:
+        class Scope
+        {
+            public:
+                Scope();
+                ~Scope();
+
+            private:
+                Scope(Scope const&);
+                Scope& operator=(Scope const&);
+
+                ScratchArena& m_arena;
+        };
+
+        // Arena of the calling thread
+        static ScratchArena& Instance();
+
+        bool IsActive() const { return m_depth != 0; }
+
+        void* Allocate(std::size_t size, std::size_t alignment);
+        // Only the last allocation is actually given back, the others wait for the end of the scope
+        void Deallocate(void* ptr, std::size_t size);
+
+        // All threads: chunks allocated, and allocations of scratch containers outside of any scope
+        static uint64 GetHeapAllocations();
+        static uint64 GetReservedBytes();
+        static void CountHeapAllocation();
+
+    private:
+        struct Chunk
+        {
+            char* data;
+            std::size_t size;
+        };
+
+        ScratchArena() : m_current(0), m_offset(0), m_depth(0) {}
+        ~ScratchArena();
+        ScratchArena(ScratchArena const&);
+        ScratchArena& operator=(ScratchArena const&);
+
+        void Rewind() { m_current = 0; m_offset = 0; }
+
+        std::vector<Chunk> m_chunks;                        // kept for the next scopes
+        std::size_t m_current;                              // chunk being filled
+        std::size_t m_offset;                               // in the current chunk
+        uint32 m_depth;                                     // scopes open
+};
+
+template<class T>
+class ScratchAllocator
+{
+    public:
+        typedef T value_type;
+
+        ScratchAllocator() : m_arena(&ScratchArena::Instance())
+        {
+            if (!m_arena->IsActive())
+                m_arena = nullptr;
+        }
+        template<class U>
+        ScratchAllocator(ScratchAllocator<U> const& other) : m_arena(other.GetArena()) {}
+
+        T* allocate(std::size_t count)
+        {
+            if (m_arena)
+                return static_cast<T*>(m_arena->Allocate(count * sizeof(T), alignof(T)));
+
+            ScratchArena::CountHeapAllocation();
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, std::size_t count)
+        {
+            if (m_arena)
+                m_arena->Deallocate(ptr, count * sizeof(T));
+            else
+                ::operator delete(ptr);
+        }
+
+        ScratchArena* GetArena() const { return m_arena; }
+
+    private:
+        ScratchArena* m_arena;                              // NULL outside of any scope
+};
+
+template<class T, class U>
+inline bool operator==(ScratchAllocator<T> const& a, ScratchAllocator<U> const& b) { return a.GetArena() == b.GetArena(); }
+template<class T, class U>
+inline bool operator!=(ScratchAllocator<T> const& a, ScratchAllocator<U> const& b) { return a.GetArena() != b.GetArena(); }
+
+template<class T> using ScratchVector = std::vector<T, ScratchAllocator<T> >;
+template<class T> using ScratchList = std::list<T, ScratchAllocator<T> >;
+
+#endif
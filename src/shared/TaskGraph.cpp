@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "TaskGraph.h"
+#include "Log.h"
+#include "Errors.h"
+
+#include <algorithm>
+
+TaskGraph::TaskId TaskGraph::Add(char const* name, Task const& task, TaskIds const& dependencies)
+{
+    TaskId id = m_nodes.size();
+    std::unique_ptr<Node> node(new Node());
+    node->name = name;
+    node->task = task;
+    node->dependencies = dependencies;
+    for (TaskIds::const_iterator itr = dependencies.begin(); itr != dependencies.end(); ++itr)
+    {
+        MANGOS_ASSERT(*itr < id);
+        m_nodes[*itr]->dependents.push_back(id);
+    }
+    node->remaining = dependencies.size();
+    m_nodes.push_back(std::move(node));
+    return id;
+}
+
+void TaskGraph::Execute(TaskId id, ThreadPool* pool, ThreadPool::TaskGroup* group)
+{
+    Node& node = *m_nodes[id];
+    sLog.outString("Loading %s...", node.name.c_str());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    node.task();
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    node.startMs = std::chrono::duration_cast<std::chrono::milliseconds>(start - m_start).count();
+    node.durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    if (!pool)
+        return;
+
+    // The last dependency done releases the dependent
+    for (TaskIds::const_iterator itr = node.dependents.begin(); itr != node.dependents.end(); ++itr)
+    {
+        TaskId dependent = *itr;
+        if (--m_nodes[dependent]->remaining == 0)
+            pool->Submit([this, dependent, pool, group]() { Execute(dependent, pool, group); }, group);
+    }
+}
+
+void TaskGraph::Run(uint32 threads, ThreadPool::ThreadHook const& onThreadStart, ThreadPool::ThreadHook const& onThreadEnd)
+{
+    m_threads = std::max<uint32>(threads, 1);
+    m_start = std::chrono::steady_clock::now();
+
+    if (m_threads == 1)
+    {
+        for (TaskId id = 0; id < m_nodes.size(); ++id)
+            Execute(id, nullptr, nullptr);
+    }
+    else
+    {
+        ThreadPool pool(m_threads - 1, onThreadStart, onThreadEnd);
+        ThreadPool::TaskGroup group;
+        for (TaskId id = 0; id < m_nodes.size(); ++id)
+        {
+            if (m_nodes[id]->dependencies.empty())
+                pool.Submit([this, id, &pool, &group]() { Execute(id, &pool, &group); }, &group);
+        }
+        pool.Wait(group);
+    }
+
+    m_elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+TaskGraph::TaskIds TaskGraph::GetCriticalPath() const
+{
+    TaskIds path;
+    if (m_nodes.empty())
+        return path;
+
+    // Ids are in a valid order: the dependencies of a task are done computing before it
+    std::vector<uint32> finishMs(m_nodes.size());
+    std::vector<TaskId> previous(m_nodes.size());
+    TaskId last = 0;
+    for (TaskId id = 0; id < m_nodes.size(); ++id)
+    {
+        Node const& node = *m_nodes[id];
+        uint32 startMs = 0;
+        previous[id] = id;
+        for (TaskIds::const_iterator itr = node.dependencies.begin(); itr != node.dependencies.end(); ++itr)
+        {
+            if (finishMs[*itr] >= startMs)
+            {
+                startMs = finishMs[*itr];
+                previous[id] = *itr;
+            }
+        }
+        finishMs[id] = startMs + node.durationMs;
+        if (finishMs[id] > finishMs[last])
+            last = id;
+    }
+
+    for (TaskId id = last;; id = previous[id])
+    {
+        path.push_back(id);
+        if (previous[id] == id)
+            break;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+void TaskGraph::LogReport() const
+{
+    uint32 totalMs = 0;
+    for (std::size_t i = 0; i < m_nodes.size(); ++i)
+        totalMs += m_nodes[i]->durationMs;
+
+    TaskIds path = GetCriticalPath();
+    uint32 pathMs = 0;
+    for (TaskIds::const_iterator itr = path.begin(); itr != path.end(); ++itr)
+        pathMs += m_nodes[*itr]->durationMs;
+
+    sLog.outString(">> Ran %u tasks in %u ms on %u threads (%u ms one after the other), critical path %u ms:",
+        uint32(m_nodes.size()), m_elapsedMs, m_threads, totalMs, pathMs);
+    for (TaskIds::const_iterator itr = path.begin(); itr != path.end(); ++itr)
+    {
+        Node const& node = *m_nodes[*itr];
+        sLog.outString("   %6u ms  %s (started at %u ms)", node.durationMs, node.name.c_str(), node.startMs);
+    }
+    sLog.outString();
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_TASKGRAPH_H
+#define MANGOS_TASKGRAPH_H
+
+#include "Platform/Define.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Tasks run once, each as soon as the tasks it depends on are done, on a ThreadPool.
+ * Dependencies can only be given on tasks already added, so the adding order is always
+ * a valid order and there is no cycle. The tasks are timed, for the report of the
+ * critical path: the chain of dependencies that took the longest, below which the
+ * run cannot go whatever the count of threads.
+ */
+class TaskGraph
+{
+    public:
+        typedef std::function<void()> Task;
+        typedef uint32 TaskId;
+        typedef std::vector<TaskId> TaskIds;
+
+        TaskGraph() : m_elapsedMs(0), m_threads(0) {}
+
+        TaskId Add(char const* name, Task const& task, TaskIds const& dependencies = TaskIds());
+
+        // With one thread, the tasks run in the adding order on the calling thread. Otherwise the
+        // calling thread takes part in the run, with threads - 1 workers.
+        void Run(uint32 threads, ThreadPool::ThreadHook const& onThreadStart = ThreadPool::ThreadHook(),
+                 ThreadPool::ThreadHook const& onThreadEnd = ThreadPool::ThreadHook());
+
+        // Durations of the run and its critical path, then the tasks of the path
+        void LogReport() const;
+
+        std::size_t GetTaskCount() const { return m_nodes.size(); }
+        uint32 GetElapsedMs() const { return m_elapsedMs; }
+        // Tasks of the longest chain of dependencies, first to last
+        TaskIds GetCriticalPath() const;
+
+    private:
+        struct Node
+        {
+            Node() : remaining(0), startMs(0), durationMs(0) {}
+
+            std::string name;
+            Task task;
+            TaskIds dependencies;
+            TaskIds dependents;
+            std::atomic<uint32> remaining;                  // dependencies not done yet
+            uint32 startMs;                                 // since the beginning of the run
+            uint32 durationMs;
+        };
+
+        void Execute(TaskId id, ThreadPool* pool, ThreadPool::TaskGroup* group);
+
+        std::vector<std::unique_ptr<Node> > m_nodes;
+        std::chrono::steady_clock::time_point m_start;
+        uint32 m_elapsedMs;
+        uint32 m_threads;
+};
+
+#endif
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ThreadPool.h"
+
+namespace
+{
+    // Pool and worker index of the calling thread
+    thread_local ThreadPool const* t_currentPool = nullptr;
+    thread_local int t_currentWorker = -1;
+}
+
+bool ThreadPool::TaskGroup::WaitFor(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    return m_cond.wait_for(guard, timeout, [this] { return m_pending.load() == 0; });
+}
+
+void ThreadPool::TaskGroup::Done()
+{
+    // Decrement under the lock: a waiter may destroy the group as soon as it
+    // observes zero pending tasks and gets the lock.
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (--m_pending == 0)
+        m_cond.notify_all();
+}
+
+ThreadPool::ThreadPool(std::size_t threads, ThreadHook const& onThreadStart, ThreadHook const& onThreadEnd)
+    : m_onThreadStart(onThreadStart), m_onThreadEnd(onThreadEnd), m_stop(false), m_queued(0), m_nextWorker(0)
+{
+    for (std::size_t i = 0; i < threads; ++i)
+        m_workers.emplace_back(new Worker());
+
+    // Start threads only once all deques exist, since workers steal from each other
+    for (std::size_t i = 0; i < threads; ++i)
+        m_workers[i]->thread = std::thread(&ThreadPool::Work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    Stop();
+}
+
+std::size_t ThreadPool::GetDefaultThreadCount()
+{
+    std::size_t count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
+
+int ThreadPool::GetCurrentWorkerIndex() const
+{
+    return t_currentPool == this ? t_currentWorker : -1;
+}
+
+void ThreadPool::Submit(Task const& task, TaskGroup* group)
+{
+    if (group)
+        group->Add();
+
+    // No worker: behave as a synchronous executor
+    if (m_workers.empty())
+    {
+        QueuedTask queued = { task, group };
+        Execute(queued);
+        return;
+    }
+
+    // Tasks spawned from a worker stay local (cache-hot), others are spread
+    int current = GetCurrentWorkerIndex();
+    std::size_t index = current >= 0 ? std::size_t(current) : m_nextWorker++ % m_workers.size();
+    {
+        std::lock_guard<std::mutex> guard(m_workers[index]->lock);
+        QueuedTask queued = { task, group };
+        m_workers[index]->tasks.push_back(queued);
+    }
+    ++m_queued;
+
+    std::lock_guard<std::mutex> guard(m_sleepLock);
+    m_sleepCond.notify_one();
+}
+
+void ThreadPool::Wait(TaskGroup& group)
+{
+    while (!group.IsDone())
+    {
+        if (RunPendingTask())
+            continue;
+        group.WaitFor(std::chrono::milliseconds(1));
+    }
+    // Synchronize with the last Done() before the caller releases the group
+    std::lock_guard<std::mutex> guard(group.m_lock);
+}
+
+void ThreadPool::WaitGroupTasks(TaskGroup& group)
+{
+    while (!group.IsDone())
+    {
+        QueuedTask task;
+        if (TakeGroupTask(group, task))
+        {
+            Execute(task);
+            continue;
+        }
+        group.WaitFor(std::chrono::milliseconds(1));
+    }
+    // Synchronize with the last Done() before the caller releases the group
+    std::lock_guard<std::mutex> guard(group.m_lock);
+}
+
+bool ThreadPool::RunPendingTask()
+{
+    if (!m_queued.load())
+        return false;
+
+    int current = GetCurrentWorkerIndex();
+    QueuedTask task;
+    if (current >= 0)
+    {
+        if (!PopTask(current, task) && !StealTask(current, task))
+            return false;
+    }
+    else if (!StealTask(m_workers.size(), task))
+        return false;
+
+    Execute(task);
+    return true;
+}
+
+void ThreadPool::Stop()
+{
+    if (m_stop)
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(m_sleepLock);
+        m_stop = true;
+        m_sleepCond.notify_all();
+    }
+
+    for (auto& worker : m_workers)
+        if (worker->thread.joinable())
+            worker->thread.join();
+}
+
+ThreadPool::Stats ThreadPool::GetStats() const
+{
+    Stats stats = { 0, 0 };
+    for (auto const& worker : m_workers)
+    {
+        stats.executed += worker->executed.load();
+        stats.stolen += worker->stolen.load();
+    }
+    return stats;
+}
+
+void ThreadPool::Work(std::size_t index)
+{
+    t_currentPool = this;
+    t_currentWorker = int(index);
+
+    if (m_onThreadStart)
+        m_onThreadStart();
+
+    while (true)
+    {
+        QueuedTask task;
+        if (PopTask(index, task) || StealTask(index, task))
+        {
+            Execute(task);
+            ++m_workers[index]->executed;
+            continue;
+        }
+
+        // Pending tasks are drained before stopping, so no group is left waiting forever
+        std::unique_lock<std::mutex> guard(m_sleepLock);
+        if (m_stop && !m_queued.load())
+            break;
+        m_sleepCond.wait(guard, [this] { return m_stop || m_queued.load() > 0; });
+    }
+
+    if (m_onThreadEnd)
+        m_onThreadEnd();
+
+    t_currentPool = nullptr;
+    t_currentWorker = -1;
+}
+
+bool ThreadPool::PopTask(std::size_t index, QueuedTask& out)
+{
+    Worker& worker = *m_workers[index];
+    std::lock_guard<std::mutex> guard(worker.lock);
+    if (worker.tasks.empty())
+        return false;
+
+    out = worker.tasks.front();
+    worker.tasks.pop_front();
+    --m_queued;
+    return true;
+}
+
+bool ThreadPool::StealTask(std::size_t thief, QueuedTask& out)
+{
+    std::size_t const count = m_workers.size();
+    // Start right after the thief so that victims are spread evenly
+    for (std::size_t i = 1; i <= count; ++i)
+    {
+        std::size_t victimIndex = (thief + i) % count;
+        if (victimIndex == thief)
+            continue;
+
+        Worker& victim = *m_workers[victimIndex];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (victim.tasks.empty())
+            continue;
+
+        out = victim.tasks.back();
+        victim.tasks.pop_back();
+        --m_queued;
+        if (thief < count)
+            ++m_workers[thief]->stolen;
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::TakeGroupTask(TaskGroup const& group, QueuedTask& out)
+{
+    if (!m_queued.load())
+        return false;
+
+    for (auto& worker : m_workers)
+    {
+        std::lock_guard<std::mutex> guard(worker->lock);
+        for (std::deque<QueuedTask>::iterator itr = worker->tasks.begin(); itr != worker->tasks.end(); ++itr)
+        {
+            if (itr->group != &group)
+                continue;
+
+            out = *itr;
+            worker->tasks.erase(itr);
+            --m_queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Execute(QueuedTask& task)
+{
+    task.task();
+    if (task.group)
+        task.group->Done();
+}
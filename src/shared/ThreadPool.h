@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2016-2017 Elysium Project <https://github.com/elysium-project>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MANGOS_THREADPOOL_H
+#define MANGOS_THREADPOOL_H
+
+#include "Platform/Define.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Long-lived pool of worker threads. Every worker owns a deque of tasks:
+ * it consumes its own deque from the front, and steals from the back of the
+ * other workers' deques when it runs dry. Tasks are grouped in TaskGroups,
+ * which act as a barrier for the thread that submitted them.
+ */
+class ThreadPool
+{
+    public:
+        typedef std::function<void()> Task;
+        typedef std::function<void()> ThreadHook;
+
+        class TaskGroup
+        {
+            public:
+                TaskGroup() : m_pending(0) {}
+
+                bool IsDone() const { return m_pending.load() == 0; }
+                uint32 GetPending() const { return m_pending.load(); }
+
+                // Blocks until all tasks are done or the timeout expires
+                bool WaitFor(std::chrono::milliseconds timeout);
+            private:
+                friend class ThreadPool;
+                TaskGroup(TaskGroup const&);
+                TaskGroup& operator=(TaskGroup const&);
+
+                void Add() { ++m_pending; }
+                void Done();
+
+                std::atomic<uint32> m_pending;
+                std::mutex m_lock;
+                std::condition_variable m_cond;
+        };
+
+        struct Stats
+        {
+            uint64 executed;
+            uint64 stolen;
+        };
+
+        ThreadPool(std::size_t threads, ThreadHook const& onThreadStart = ThreadHook(), ThreadHook const& onThreadEnd = ThreadHook());
+        ~ThreadPool();
+
+        void Submit(Task const& task, TaskGroup* group = nullptr);
+
+        // Blocks until the group is done. The calling thread executes pending
+        // tasks meanwhile, so waiting from inside a worker can never deadlock.
+        void Wait(TaskGroup& group);
+        // Same, but only the pending tasks of the group are executed meanwhile: the caller never
+        // runs the tasks of the other submitters (other maps ...) in the middle of its own work.
+        void WaitGroupTasks(TaskGroup& group);
+
+        // Executes one pending task on the calling thread, if there is any.
+        bool RunPendingTask();
+
+        void Stop();
+
+        std::size_t GetThreadCount() const { return m_workers.size(); }
+        std::size_t GetQueuedCount() const { return m_queued.load(); }
+        Stats GetStats() const;
+
+        // Index of the calling thread in this pool, -1 for foreign threads
+        int GetCurrentWorkerIndex() const;
+
+        static std::size_t GetDefaultThreadCount();
+
+    private:
+        ThreadPool(ThreadPool const&);
+        ThreadPool& operator=(ThreadPool const&);
+
+        struct QueuedTask
+        {
+            Task task;
+            TaskGroup* group;
+        };
+
+        struct Worker
+        {
+            Worker() : executed(0), stolen(0) {}
+
+            std::mutex lock;
+            std::deque<QueuedTask> tasks;
+            std::thread thread;
+            std::atomic<uint64> executed;
+            std::atomic<uint64> stolen;
+        };
+
+        void Work(std::size_t index);
+        bool PopTask(std::size_t index, QueuedTask& out);
+        bool StealTask(std::size_t thief, QueuedTask& out);
+        bool TakeGroupTask(TaskGroup const& group, QueuedTask& out);
+        void Execute(QueuedTask& task);
+
+        std::vector<std::unique_ptr<Worker> > m_workers;
+        ThreadHook m_onThreadStart;
+        ThreadHook m_onThreadEnd;
+
+        std::atomic_bool m_stop;
+        std::atomic<std::size_t> m_queued;
+        std::atomic<std::size_t> m_nextWorker;
+
+        std::mutex m_sleepLock;
+        std::condition_variable m_sleepCond;
+};
+
+#endif
@@ -15,6 +15,7 @@
 #include <dbghelp.h>
 #include "WheatyExceptionReport.h"
 #include "revision.h"
+#include "Log.h"
 #define CrashFolder _T("Crashs")
 //#pragma comment(linker, "/defaultlib:dbghelp.lib")
 
@@ -69,6 +70,9 @@ WheatyExceptionReport::~WheatyExceptionReport( )
 LONG WINAPI WheatyExceptionReport::WheatyUnhandledExceptionFilter(
 PEXCEPTION_POINTERS pExceptionInfo )
 {
+    // The lines queued for the log writer thread are the last ones before the crash
+    sLog.Flush();
+
     TCHAR module_folder_name[MAX_PATH];
     GetModuleFileName( 0, module_folder_name, MAX_PATH );
     TCHAR* pos = _tcsrchr(module_folder_name, '\\');
@@ -24,6 +24,7 @@
 
 #include "Common.h"
 #include "ByteBuffer.h"
+#include <memory>
 
 // Note: m_opcode and size stored in platfom dependent format
 // ignore endianess until send, and converted at receive
@@ -69,4 +70,9 @@ class WorldPacket : public ByteBuffer
         uint16 m_opcode;
         uint32 m_recvdTime;
 };
+
+// Packet sent to several sockets. Serialized once: the sockets only write their own header,
+// and keep a reference on the packet until its content is written.
+typedef std::shared_ptr<WorldPacket const> SharedWorldPacketPtr;
+
 #endif